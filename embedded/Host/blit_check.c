@@ -0,0 +1,376 @@
+/**
+ ******************************************************************************
+ * @file    blit_check.c
+ * @author  PeleAB
+ * @brief   Host tool: conformance of the blitter backends
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: blit_check
+ *
+ * Every backend (software, and DMA2D on the emulation in host_dma2d.c) must:
+ *  - produce the hand-computed pixels of the conversion rules in blit.h,
+ *  - match the software backend bit for bit on every format pair, on odd
+ *    sizes, padded strides and unaligned surfaces, without writing outside
+ *    the destination rectangle,
+ *  - take aligned non-L8 same-size work itself instead of falling back
+ *    (DMA2D), and finish pending work before a software fallback reads it,
+ *  - reject invalid surfaces.
+ * Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "blit.h"
+#include "pixel_lut.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define CANVAS_BYTES                        (80 * 1024)
+#define GUARD_BYTE                          0xA5
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t pad;                           /**< Bytes added to the packed stride */
+    uint16_t shift;                         /**< Byte offset of the first pixel */
+} geom_t;
+
+static const geom_t geoms[] = {
+    { 1, 1, 0, 0 },
+    { 7, 3, 0, 0 },
+    { 33, 17, 12, 4 },
+    { 64, 8, 4, 8 },
+    { 31, 5, 5, 1 },                        /* unaligned: DMA2D falls back for 16/32-bit */
+    { 130, 9, 2, 2 },
+};
+
+static const char *const fmt_names[BLIT_FMT_COUNT] = {
+    "ARGB8888", "RGB888", "RGB565", "ARGB4444", "L8",
+};
+
+static const blit_backend_t *const backends[] = { &blit_backend_sw, &blit_backend_dma2d };
+
+static uint8_t src_mem[CANVAS_BYTES];
+static uint8_t bg_mem[CANVAS_BYTES];
+static uint8_t dst_mem[CANVAS_BYTES];
+static uint8_t ref_mem[CANVAS_BYTES];
+
+/* ========================================================================= */
+/* HELPERS                                                                   */
+/* ========================================================================= */
+
+static void make_surface(blit_surface_t *s, uint8_t *mem, blit_format_t format, const geom_t *g)
+{
+    s->data = mem + g->shift;
+    s->stride = (uint32_t)g->width * blit_format_bpp(format) + g->pad;
+    s->width = g->width;
+    s->height = g->height;
+    s->format = format;
+}
+
+static void fill_random(uint8_t *mem, uint32_t seed)
+{
+    for (size_t i = 0; i < CANVAS_BYTES; i++) {
+        seed = seed * 1664525U + 1013904223U;
+        mem[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+static void reset_dst(void)
+{
+    memset(dst_mem, GUARD_BYTE, sizeof(dst_mem));
+    memset(ref_mem, GUARD_BYTE, sizeof(ref_mem));
+}
+
+/** @brief Same geometry as @p s, in ref_mem */
+static blit_surface_t ref_of(const blit_surface_t *s)
+{
+    blit_surface_t r = *s;
+
+    r.data = ref_mem + ((uint8_t *)s->data - dst_mem);
+    return r;
+}
+
+static int report(const char *backend, const char *what, int cases, int failed)
+{
+    printf("   %-9s %-34s %4d cases  %s\n", backend, what, cases, failed ? "MISMATCH" : "ok");
+    return failed;
+}
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+/** @brief One pixel through blit_convert, compared with hand-computed bytes */
+typedef struct {
+    blit_format_t from;
+    uint8_t in[4];
+    blit_format_t to;
+    uint8_t out[4];
+} px_case_t;
+
+static const px_case_t px_cases[] = {
+    { BLIT_FMT_RGB565,   { 0x00, 0xF8 },             BLIT_FMT_ARGB8888, { 0x00, 0x00, 0xFF, 0xFF } },
+    { BLIT_FMT_RGB565,   { 0xE0, 0x07 },             BLIT_FMT_RGB888,   { 0x00, 0xFF, 0x00 } },
+    { BLIT_FMT_RGB565,   { 0x41, 0x08 },             BLIT_FMT_ARGB8888, { 0x08, 0x08, 0x08, 0xFF } },
+    { BLIT_FMT_RGB888,   { 0x12, 0x34, 0x56 },       BLIT_FMT_ARGB8888, { 0x56, 0x34, 0x12, 0xFF } },
+    { BLIT_FMT_RGB888,   { 0x12, 0x34, 0x56 },       BLIT_FMT_RGB565,   { 0xAA, 0x11 } },
+    { BLIT_FMT_ARGB4444, { 0x0A, 0x8F },             BLIT_FMT_ARGB8888, { 0xAA, 0x00, 0xFF, 0x88 } },
+    { BLIT_FMT_ARGB8888, { 0x40, 0x80, 0xFF, 0x80 }, BLIT_FMT_ARGB4444, { 0x84, 0x8F } },
+    { BLIT_FMT_ARGB8888, { 0x40, 0x80, 0xFF, 0x80 }, BLIT_FMT_RGB888,   { 0xFF, 0x80, 0x40 } },
+    { BLIT_FMT_RGB888,   { 0xFF, 0x00, 0x00 },       BLIT_FMT_L8,       { 76 } },
+    { BLIT_FMT_RGB565,   { 0xE0, 0x07 },             BLIT_FMT_L8,       { 150 } },
+    { BLIT_FMT_L8,       { 200 },                    BLIT_FMT_RGB565,   { 0x59, 0xCE } },
+};
+
+static int check_pixels(const char *name)
+{
+    int failed = 0;
+    int n = (int)(sizeof(px_cases) / sizeof(px_cases[0]));
+    uint32_t in_words[1], out_words[2];     /* aligned for the 32-bit formats */
+    uint8_t *in = (uint8_t *)in_words;
+    uint8_t *out = (uint8_t *)out_words;
+
+    for (int i = 0; i < n; i++) {
+        const px_case_t *c = &px_cases[i];
+        uint32_t bpp = blit_format_bpp(c->to);
+        blit_surface_t src = { in, 4, 1, 1, c->from };
+        blit_surface_t dst = { out, 4, 1, 1, c->to };
+
+        memcpy(in, c->in, sizeof(in_words));
+        memset(out, GUARD_BYTE, sizeof(out_words));
+        if (blit_convert(&dst, &src) != BLIT_OK || blit_wait() != BLIT_OK ||
+            memcmp(out, c->out, bpp) != 0 || out[bpp] != GUARD_BYTE) {
+            printf("   %s -> %s: got %02x %02x %02x %02x\n", fmt_names[c->from], fmt_names[c->to],
+                   out[0], out[1], out[2], out[3]);
+            failed++;
+        }
+    }
+
+    /* Fill color encoding, blend equation, nearest sampling */
+    {
+        static const uint8_t wide[4 * 3] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+        static const uint8_t fg_px[4] = { 0x00, 0x00, 0xFF, 0x80 };    /* ARGB8888 0x80FF0000 */
+        uint32_t fg[1];
+        uint8_t bg[3] = { 0x00, 0x00, 0xFF };           /* RGB888 blue */
+        blit_surface_t s_fg = { fg, 4, 1, 1, BLIT_FMT_ARGB8888 };
+        blit_surface_t s_bg = { bg, 3, 1, 1, BLIT_FMT_RGB888 };
+        blit_surface_t s_wide = { (void *)wide, 12, 4, 1, BLIT_FMT_RGB888 };
+        blit_surface_t d888 = { out, 8, 2, 1, BLIT_FMT_RGB888 };
+        blit_surface_t d565 = { out, 4, 1, 1, BLIT_FMT_RGB565 };
+        static const uint8_t half[3] = { 0x80, 0x00, 0x7F };
+        static const uint8_t none[3] = { 0x00, 0x00, 0xFF };
+        static const uint8_t picked[6] = { 1, 2, 3, 7, 8, 9 };
+
+        memcpy(fg, fg_px, sizeof(fg));
+
+        failed += blit_fill(&d565, 0xFF123456U) != BLIT_OK || blit_wait() != BLIT_OK ||
+                  out[0] != 0xAA || out[1] != 0x11;
+        d888.width = 1;
+        failed += blit_fill(&d888, 0xFF123456U) != BLIT_OK || blit_wait() != BLIT_OK ||
+                  out[0] != 0x12 || out[1] != 0x34 || out[2] != 0x56;
+        failed += blit_blend(&d888, &s_fg, &s_bg, 255) != BLIT_OK || blit_wait() != BLIT_OK ||
+                  memcmp(out, half, 3) != 0;
+        failed += blit_blend(&d888, &s_fg, &s_bg, 0) != BLIT_OK || blit_wait() != BLIT_OK ||
+                  memcmp(out, none, 3) != 0;
+        d888.width = 2;
+        failed += blit_scale_copy(&d888, &s_wide) != BLIT_OK || blit_wait() != BLIT_OK ||
+                  memcmp(out, picked, 6) != 0;
+        n += 5;
+    }
+    return report(name, "known pixels", n, failed);
+}
+
+/** @brief blit_convert / blit_scale_copy against the software backend */
+static int check_copy(const char *name, int scaled)
+{
+    int cases = 0, failed = 0;
+
+    for (int sf = 0; sf < BLIT_FMT_COUNT; sf++) {
+        for (int df = 0; df < BLIT_FMT_COUNT; df++) {
+            for (size_t g = 0; g < sizeof(geoms) / sizeof(geoms[0]); g++) {
+                geom_t sg = geoms[g];
+                blit_surface_t src, dst, ref;
+
+                if (scaled) {
+                    /* Down by 2 and a half, up by 3 */
+                    sg.width = (uint16_t)((g & 1U) ? sg.width * 5 / 2 + 1 : (sg.width + 2) / 3);
+                    sg.height = (uint16_t)((g & 1U) ? sg.height * 2 + 1 : (sg.height + 2) / 3);
+                }
+                make_surface(&src, src_mem, (blit_format_t)sf, &sg);
+                make_surface(&dst, dst_mem, (blit_format_t)df, &geoms[g]);
+                ref = ref_of(&dst);
+                reset_dst();
+
+                int ret = scaled ? blit_scale_copy(&dst, &src) : blit_convert(&dst, &src);
+                ret |= blit_wait();
+                if (scaled) {
+                    (void)blit_backend_sw.scale_copy(&ref, &src);
+                } else {
+                    (void)blit_backend_sw.convert(&ref, &src);
+                }
+                cases++;
+                if (ret != BLIT_OK || memcmp(dst_mem, ref_mem, CANVAS_BYTES) != 0) {
+                    printf("   %s %s -> %s %ux%u differs\n", scaled ? "scale" : "convert",
+                           fmt_names[sf], fmt_names[df], dst.width, dst.height);
+                    failed++;
+                }
+            }
+        }
+    }
+    return report(name, scaled ? "blit_scale_copy vs software" : "blit_convert vs software",
+                  cases, failed);
+}
+
+static int check_fill_blend(const char *name)
+{
+    static const uint32_t colors[] = { 0x00000000U, 0xFF123456U, 0x80FF8040U, 0x0F0F0F0FU };
+    static const uint8_t alphas[] = { 0, 77, 128, 255 };
+    int cases = 0, failed = 0;
+
+    for (int df = 0; df < BLIT_FMT_COUNT; df++) {
+        for (size_t g = 0; g < sizeof(geoms) / sizeof(geoms[0]); g++) {
+            blit_surface_t dst, ref, fg, bg;
+
+            make_surface(&dst, dst_mem, (blit_format_t)df, &geoms[g]);
+            ref = ref_of(&dst);
+            for (size_t c = 0; c < sizeof(colors) / sizeof(colors[0]); c++) {
+                reset_dst();
+                int ret = blit_fill(&dst, colors[c]);
+                ret |= blit_wait();
+                (void)blit_backend_sw.fill(&ref, colors[c]);
+                cases++;
+                if (ret != BLIT_OK || memcmp(dst_mem, ref_mem, CANVAS_BYTES) != 0) {
+                    printf("   fill %s %08x %ux%u differs\n", fmt_names[df],
+                           (unsigned int)colors[c], dst.width, dst.height);
+                    failed++;
+                }
+            }
+            for (int ff = 0; ff < BLIT_FMT_COUNT; ff++) {
+                make_surface(&fg, src_mem, (blit_format_t)ff, &geoms[g]);
+                make_surface(&bg, bg_mem, (blit_format_t)((ff + df) % BLIT_FMT_COUNT), &geoms[g]);
+                for (size_t a = 0; a < sizeof(alphas); a++) {
+                    reset_dst();
+                    int ret = blit_blend(&dst, &fg, &bg, alphas[a]);
+                    ret |= blit_wait();
+                    (void)blit_backend_sw.blend(&ref, &fg, &bg, alphas[a]);
+                    cases++;
+                    if (ret != BLIT_OK || memcmp(dst_mem, ref_mem, CANVAS_BYTES) != 0) {
+                        printf("   blend %s over %s -> %s alpha %u differs\n", fmt_names[ff],
+                               fmt_names[bg.format], fmt_names[df], alphas[a]);
+                        failed++;
+                    }
+                }
+            }
+        }
+    }
+    return report(name, "blit_fill / blit_blend vs software", cases, failed);
+}
+
+/**
+ * @brief Work the backend must do itself, and ordering with the fallback
+ */
+static int check_offload(const blit_backend_t *b)
+{
+    static const geom_t g = { 40, 6, 8, 0 };
+    int cases = 0, failed = 0;
+    blit_surface_t src, dst, gray, ref;
+
+    if (b == &blit_backend_sw) {
+        return 0;
+    }
+    for (int sf = 0; sf < BLIT_FMT_L8; sf++) {
+        for (int df = 0; df < BLIT_FMT_L8; df++) {
+            make_surface(&src, src_mem, (blit_format_t)sf, &g);
+            make_surface(&dst, dst_mem, (blit_format_t)df, &g);
+            cases += 2;
+            failed += b->convert(&dst, &src) != BLIT_OK || b->wait() != BLIT_OK;
+            failed += b->fill(&dst, 0x80402010U) != BLIT_OK || b->wait() != BLIT_OK;
+        }
+    }
+
+    /* Fill still in flight when the software fallback reads it */
+    make_surface(&dst, dst_mem, BLIT_FMT_RGB565, &g);
+    make_surface(&gray, bg_mem, BLIT_FMT_L8, &g);
+    ref = gray;
+    ref.data = ref_mem;
+    memset(ref_mem, 0, sizeof(ref_mem));
+    memset(bg_mem, 0, sizeof(bg_mem));
+    cases++;
+    failed += blit_fill(&dst, 0xFFFFFFFFU) != BLIT_OK || blit_convert(&gray, &dst) != BLIT_OK ||
+              blit_wait() != BLIT_OK;
+    (void)blit_backend_sw.fill(&ref, 0xFFFFFFFFU);
+    failed += memcmp(bg_mem, ref_mem, sizeof(ref_mem)) != 0;
+
+    return report(b->name, "offloaded without fallback", cases, failed);
+}
+
+static int check_args(const char *name)
+{
+    uint8_t px[16];
+    blit_surface_t ok = { px, 4, 2, 2, BLIT_FMT_RGB565 };
+    blit_surface_t null_data = { NULL, 4, 2, 2, BLIT_FMT_RGB565 };
+    blit_surface_t short_stride = { px, 3, 2, 2, BLIT_FMT_RGB565 };
+    blit_surface_t empty = { px, 4, 0, 2, BLIT_FMT_RGB565 };
+    blit_surface_t bad_format = { px, 8, 2, 2, BLIT_FMT_COUNT };
+    blit_surface_t smaller = { px, 4, 1, 2, BLIT_FMT_RGB565 };
+    blit_surface_t sub;
+    int failed = 0;
+
+    failed += blit_fill(&null_data, 0) != BLIT_ERR_ARG;
+    failed += blit_fill(&short_stride, 0) != BLIT_ERR_ARG;
+    failed += blit_fill(&empty, 0) != BLIT_ERR_ARG;
+    failed += blit_fill(&bad_format, 0) != BLIT_ERR_ARG;
+    failed += blit_fill(NULL, 0) != BLIT_ERR_ARG;
+    failed += blit_convert(&ok, &smaller) != BLIT_ERR_ARG;
+    failed += blit_blend(&ok, &ok, &smaller, 255) != BLIT_ERR_ARG;
+    failed += blit_sub_surface(&ok, 1, 0, 2, 1, &sub) != BLIT_ERR_ARG;
+    failed += blit_sub_surface(&ok, 1, 1, 1, 1, &sub) != BLIT_OK || sub.data != px + 6;
+    failed += blit_wait() != BLIT_OK;
+    return report(name, "argument checks", 10, failed);
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(void)
+{
+    int failed = 0;
+
+    pixel_lut_init();
+    printf("Blitter backends against the conversion rules and the software backend:\n");
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        const blit_backend_t *b = backends[i];
+
+        fill_random(src_mem, 1);
+        fill_random(bg_mem, 2);
+        if (blit_init(b) != BLIT_OK || blit_get_backend() != b) {
+            printf("   %-9s init failed\n", b->name);
+            failed++;
+            continue;
+        }
+        failed += check_pixels(b->name);
+        failed += check_copy(b->name, 0);
+        failed += check_copy(b->name, 1);
+        failed += check_fill_blend(b->name);
+        failed += check_offload(b);
+        failed += check_args(b->name);
+    }
+
+    printf("%d failed\n", failed);
+    return failed;
+}
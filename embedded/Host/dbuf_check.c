@@ -0,0 +1,281 @@
+/**
+ ******************************************************************************
+ * @file    dbuf_check.c
+ * @author  PeleAB
+ * @brief   Host tool: stress the camera double buffer handoff against a
+ *          simulated DCMIPP and frame interrupt
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: dbuf_check
+ *
+ * A simulated pipe starts each frame into its current buffer, ends it and
+ * flips to the other buffer, and raises the frame event
+ * (frame_dbuf_on_frame_event, as the DCMIPP interrupt does). Its suspend
+ * hook only drops the capture request, as on the board: the frame under way
+ * still ends. A simulated main loop acquires frames, holds them for a random
+ * time and releases them; all of these are interleaved at random. The
+ * acquired frame must be complete and the latest one, and the held buffer
+ * must never be written while it is held. In the latency variant the frame
+ * interrupt can be late, so the next capture may start before the event of
+ * the previous frame is handled. Every frame must be accounted for as
+ * consumed, dropped or still ready.
+ * Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "frame_dbuf.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define FRAME_BYTES                         64U
+#define STRESS_STEPS                        200000U
+#define MAX_HOLD                            5U      /**< Main loop turns a frame is held for */
+
+static uint8_t buffers[FRAME_DBUF_COUNT][FRAME_BYTES];
+static frame_dbuf_t db;
+static uint32_t rng_state = 1U;
+
+static uint32_t rnd(uint32_t n)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (rng_state >> 8) % n;
+}
+
+static int report(const char *name, int ok)
+{
+    printf("   %-34s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/* ========================================================================= */
+/* SIMULATED PIPE                                                            */
+/* ========================================================================= */
+
+typedef struct {
+    int latency;                            /**< Frame interrupt may run after the next start */
+    int capturing;                          /**< Capture request set */
+    int active;                             /**< Frame under way into target */
+    int event_pending;                      /**< Frame ended, interrupt not run yet */
+    uint32_t target;                        /**< Buffer the hardware writes next */
+    uint32_t frames;                        /**< Frames started */
+    uint32_t suspends;
+    uint32_t resumes;
+    uint32_t deferred;                      /**< Acquires deferred to a pending event */
+} sim_pipe_t;
+
+static sim_pipe_t pipe;
+
+static int sim_suspend(void *arg)
+{
+    (void)arg;
+    /* Non-blocking, as CAM_NNPipe_Suspend */
+    pipe.capturing = 0;
+    pipe.suspends++;
+    return 0;
+}
+
+static int sim_resume(void *arg)
+{
+    (void)arg;
+    pipe.capturing = 1;
+    pipe.resumes++;
+    return 0;
+}
+
+static int sim_frame_pending(void *arg)
+{
+    (void)arg;
+    pipe.deferred += (uint32_t)pipe.event_pending;
+    return pipe.event_pending;
+}
+
+/**
+ * @brief Frame start: the first half of the buffer gets the new frame
+ * @return Buffer written, -1 if none
+ */
+static int sim_start(void)
+{
+    if (pipe.active || !pipe.capturing || (pipe.event_pending && !pipe.latency)) {
+        return -1;
+    }
+    pipe.active = 1;
+    pipe.frames++;
+    memset(buffers[pipe.target], (int)(pipe.frames & 0xFFU), FRAME_BYTES / 2U);
+    memcpy(buffers[pipe.target], &pipe.frames, sizeof(pipe.frames));
+    return (int)pipe.target;
+}
+
+/**
+ * @brief Frame end: the second half is written and the event raised
+ * @return Buffer written, -1 if none
+ */
+static int sim_end(void)
+{
+    const int written = (int)pipe.target;
+
+    /* The interrupt always runs within a frame time */
+    if (!pipe.active || pipe.event_pending) {
+        return -1;
+    }
+    pipe.active = 0;
+    memset(buffers[pipe.target] + FRAME_BYTES / 2U, (int)(pipe.frames & 0xFFU), FRAME_BYTES / 2U);
+    pipe.target ^= 1U;
+    pipe.event_pending = 1;
+    return written;
+}
+
+static void sim_interrupt(void)
+{
+    if (pipe.event_pending) {
+        pipe.event_pending = 0;
+        frame_dbuf_on_frame_event(&db);
+    }
+}
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+/**
+ * @brief Frame number stored in a buffer, and whether the whole buffer is
+ *        that one frame
+ */
+static int frame_intact(const uint8_t *pFrame, uint32_t *pNumber)
+{
+    memcpy(pNumber, pFrame, sizeof(*pNumber));
+    for (uint32_t i = sizeof(*pNumber); i < FRAME_BYTES; i++) {
+        if (pFrame[i] != (uint8_t)(*pNumber & 0xFFU)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_stress(int latency)
+{
+    const frame_dbuf_hooks_t hooks = { sim_suspend, sim_resume, sim_frame_pending, NULL };
+    frame_dbuf_stats_t stats;
+    uint8_t *held = NULL;
+    uint8_t copy[FRAME_BYTES];
+    uint32_t hold = 0, held_number = 0, overwrites = 0, acquired = 0, torn = 0, stale = 0;
+    int ok;
+
+    memset(&pipe, 0, sizeof(pipe));
+    memset(buffers, 0, sizeof(buffers));
+    pipe.latency = latency;
+    pipe.capturing = 1;
+    rng_state = latency ? 7U : 3U;
+    (void)frame_dbuf_init(&db, buffers[0], buffers[1], &hooks);
+
+    for (uint32_t step = 0; step < STRESS_STEPS; step++) {
+        const uint32_t event = rnd(4);
+        int written = -1;
+
+        if (event == 0) {
+            written = sim_start();
+        } else if (event == 1) {
+            written = sim_end();
+        } else if (event == 2) {
+            sim_interrupt();
+        } else if (!held) {
+            uint32_t sequence = 0;
+
+            held = frame_dbuf_acquire(&db, &sequence);
+            if (held) {
+                acquired++;
+                hold = rnd(MAX_HOLD + 1U);
+                /* Complete, numbered as announced, and the newest one */
+                torn += !frame_intact(held, &held_number);
+                stale += (held_number != sequence || sequence != db.sequence);
+                memcpy(copy, held, FRAME_BYTES);
+            }
+        } else if (hold > 0) {
+            hold--;
+        } else {
+            /* Still what was acquired, then handed back */
+            if (memcmp(copy, held, FRAME_BYTES) != 0) {
+                overwrites++;
+            }
+            (void)frame_dbuf_release(&db);
+            held = NULL;
+        }
+
+        if (held && written >= 0 && buffers[written] == held) {
+            overwrites++;
+        }
+    }
+
+    frame_dbuf_get_stats(&db, &stats);
+    ok = (torn == 0 && stale == 0 && overwrites == 0 && acquired > STRESS_STEPS / 40U &&
+          stats.stalls > 0 && pipe.resumes == pipe.suspends - (db.suspended ? 1U : 0U));
+    /* Every frame accounted for */
+    ok &= (stats.frames_captured == pipe.frames - (pipe.active ? 1U : 0U) - (uint32_t)pipe.event_pending &&
+           stats.frames_captured == stats.frames_consumed + stats.frames_dropped +
+                                    (db.ready_index != FRAME_DBUF_NONE ? 1U : 0U));
+    /* Acquires raced with frame events */
+    ok &= (pipe.deferred > 0);
+    printf("   %u frames, %u acquired, %u dropped, %u stalls, %u deferred\n",
+           (unsigned int)stats.frames_captured, (unsigned int)stats.frames_consumed,
+           (unsigned int)stats.frames_dropped, (unsigned int)stats.stalls,
+           (unsigned int)pipe.deferred);
+    return report(latency ? "late interrupt, held never written" : "held buffer never written", ok);
+}
+
+static int check_rejects(void)
+{
+    const frame_dbuf_hooks_t hooks = { sim_suspend, sim_resume, sim_frame_pending, NULL };
+    uint32_t sequence = 0;
+    int ok = 1;
+
+    ok &= (frame_dbuf_init(&db, buffers[0], buffers[0], NULL) != 0);
+    ok &= (frame_dbuf_init(&db, buffers[0], buffers[1], NULL) == 0);
+    ok &= (frame_dbuf_acquire(&db, &sequence) == NULL);    /* Nothing captured */
+    ok &= (frame_dbuf_release(&db) != 0);                  /* Nothing held */
+    frame_dbuf_on_frame_event(&db);
+    frame_dbuf_on_frame_event(&db);
+    ok &= (frame_dbuf_acquire(&db, &sequence) == buffers[1] && sequence == 2U);
+    frame_dbuf_on_frame_event(&db);                        /* Into buffer 0 */
+    ok &= (frame_dbuf_acquire(&db, &sequence) == NULL);    /* One held at a time */
+    ok &= (frame_dbuf_release(&db) == 0);
+    ok &= (frame_dbuf_acquire(&db, &sequence) == buffers[0] && sequence == 3U);
+
+    /* A pending frame event defers the acquire, capture request restored */
+    memset(&pipe, 0, sizeof(pipe));
+    pipe.capturing = 1;
+    ok &= (frame_dbuf_init(&db, buffers[0], buffers[1], &hooks) == 0);
+    frame_dbuf_on_frame_event(&db);
+    pipe.event_pending = 1;
+    ok &= (frame_dbuf_acquire(&db, &sequence) == NULL && pipe.capturing && !db.suspended);
+    pipe.event_pending = 0;
+    frame_dbuf_on_frame_event(&db);
+    ok &= (frame_dbuf_acquire(&db, &sequence) == buffers[1] && sequence == 2U);
+    ok &= (!pipe.capturing && db.suspended);               /* Stops after the current frame */
+    ok &= (frame_dbuf_release(&db) == 0 && pipe.capturing && !db.suspended);
+    return report("one frame held at a time", ok);
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("Camera double buffer against a simulated pipe and frame interrupt:\n");
+    failed += !check_stress(0);
+    failed += !check_stress(1);
+    failed += !check_rejects();
+
+    printf("%d failed\n", failed);
+    return failed;
+}
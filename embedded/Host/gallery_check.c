@@ -0,0 +1,289 @@
+/**
+ ******************************************************************************
+ * @file    gallery_check.c
+ * @author  PeleAB
+ * @brief   Host tool: compare the face gallery search with a brute-force
+ *          reference
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: gallery_check
+ *
+ * face_gallery_search (Src/face_gallery.c) runs on random galleries whose
+ * template count is below, at and above a multiple of the block size, with
+ * the templates of an identity spread over several blocks. Every match must
+ * hold the best cosine of its identity computed in double precision over
+ * the raw embeddings (within SCORE_TOL, Q7_SCORE_TOL for int8 templates),
+ * matches must be distinct and best first, and the k-th score must be the
+ * reference's k-th, for the query as is and normalized with
+ * face_gallery_normalize then searched with face_gallery_search_unit.
+ * Both storage formats run every case. Identical
+ * templates of two identities must rank in enrollment order. An empty
+ * gallery, a zero query, k = 0, a zero embedding and a full gallery are
+ * rejected. The Makefile builds it twice: gallery_check on the scalar dot
+ * products, gallery_check_mve with -DHOST_MVE_EMULATION on the Helium
+ * emulation (stubs/arm_mve_emul.h).
+ * Exit status is the number of failed cases.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "face_gallery.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define MAX_TEMPLATES                       64
+#define MAX_IDENTITIES                      16
+#define MAX_K                               8
+#define SCORE_TOL                           1e-5
+#define Q7_SCORE_TOL                        0.01    /**< int8 query and templates */
+
+typedef struct {
+    const char *name;
+    uint32_t templates;
+    uint32_t identities;                    /**< Template t belongs to (t * 7) % identities */
+    uint32_t k;
+} gallery_case_t;
+
+static const gallery_case_t gallery_cases[] = {
+    { "one template", 1, 1, 1 },
+    { "three templates, top 3", 3, 3, 3 },
+    { "one full block", 4, 2, 1 },
+    { "block and a half", 6, 4, 8 },
+    { "37 templates, top 1", 37, 9, 1 },
+    { "37 templates, top 5", 37, 9, 5 },
+    { "k above identities", 20, 5, 8 },
+    { "64 templates, top 8", 64, 16, 8 },
+};
+
+static float32_t storage[FACE_GALLERY_STORAGE_FLOATS(MAX_TEMPLATES)];
+static int8_t storage_q7[FACE_GALLERY_STORAGE_Q7(MAX_TEMPLATES)];
+static float32_t scale_q7[MAX_TEMPLATES];
+static uint16_t owner[MAX_TEMPLATES];
+static float32_t raw[MAX_TEMPLATES][EMBEDDING_SIZE];
+
+static uint32_t rng_state = 1U;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+/* ========================================================================= */
+/* REFERENCE                                                                 */
+/* ========================================================================= */
+
+static double ref_cosine(const float32_t *a, const float32_t *b)
+{
+    double dot = 0.0, na = 0.0, nb = 0.0;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        dot += (double)a[d] * b[d];
+        na += (double)a[d] * a[d];
+        nb += (double)b[d] * b[d];
+    }
+    return dot / sqrt(na * nb);
+}
+
+/**
+ * @brief Best cosine of each identity, and those scores sorted best first
+ */
+static void ref_search(const gallery_case_t *c, const float32_t *query,
+                       double *pBest, double *pSorted)
+{
+    for (uint32_t i = 0; i < c->identities; i++) {
+        pBest[i] = -2.0;
+    }
+    for (uint32_t t = 0; t < c->templates; t++) {
+        const uint32_t id = (t * 7U) % c->identities;
+        const double s = ref_cosine(query, raw[t]);
+
+        if (s > pBest[id]) {
+            pBest[id] = s;
+        }
+    }
+    memcpy(pSorted, pBest, c->identities * sizeof(double));
+    for (uint32_t i = 1; i < c->identities; i++) {
+        for (uint32_t j = i; j > 0 && pSorted[j] > pSorted[j - 1]; j--) {
+            const double tmp = pSorted[j];
+
+            pSorted[j] = pSorted[j - 1];
+            pSorted[j - 1] = tmp;
+        }
+    }
+}
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+static int init(face_gallery_t *pGallery, int q7, uint32_t capacity)
+{
+    return q7 ? face_gallery_init_q7(pGallery, storage_q7, scale_q7, owner, capacity) :
+                face_gallery_init(pGallery, storage, owner, capacity);
+}
+
+/**
+ * @brief Matches against the reference: count, scores, order, one per identity
+ */
+static int check_matches(const gallery_case_t *c, const face_gallery_match_t *match, uint32_t nb,
+                         const double *best, const double *sorted, double tol)
+{
+    const uint32_t want = (c->k < c->identities) ? c->k : c->identities;
+    int ok = (nb == want);
+
+    for (uint32_t i = 0; i < nb && i < want; i++) {
+        if (match[i].identity >= c->identities ||
+            fabs(match[i].score - best[match[i].identity]) > tol ||
+            fabs(match[i].score - sorted[i]) > tol ||
+            (i > 0 && match[i].score > match[i - 1].score)) {
+            ok = 0;
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (match[j].identity == match[i].identity) {
+                ok = 0;
+            }
+        }
+    }
+    return ok;
+}
+
+static int check_case(const gallery_case_t *c, uint32_t seed, int q7)
+{
+    const double tol = q7 ? Q7_SCORE_TOL : SCORE_TOL;
+    face_gallery_t gallery;
+    face_gallery_match_t match[MAX_K];
+    float32_t query[EMBEDDING_SIZE];
+    float32_t unit[EMBEDDING_SIZE];
+    double best[MAX_IDENTITIES], sorted[MAX_IDENTITIES];
+    int ok = 1;
+
+    rng_state = seed;
+    (void)init(&gallery, q7, c->templates);
+    for (uint32_t t = 0; t < c->templates; t++) {
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            raw[t][d] = rnd() * (1.0f + (float)t);
+        }
+        if (face_gallery_add(&gallery, (uint16_t)((t * 7U) % c->identities), raw[t]) != (int)t + 1) {
+            ok = 0;
+        }
+    }
+    /* Close to one template, so the top scores are well apart from noise */
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        query[d] = raw[c->templates / 2U][d] + 2.0f * rnd();
+    }
+
+    ref_search(c, query, best, sorted);
+    ok &= check_matches(c, match, face_gallery_search(&gallery, query, match, c->k),
+                        best, sorted, tol);
+    /* Same query normalized first, dot products only */
+    (void)face_gallery_normalize(query, unit);
+    ok &= check_matches(c, match, face_gallery_search_unit(&gallery, unit, match, c->k),
+                        best, sorted, tol);
+
+    printf("   %-26s %2u templates %2u identities  top %u  %s\n", c->name,
+           (unsigned int)c->templates, (unsigned int)c->identities, (unsigned int)c->k,
+           ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static int check_ties(int q7)
+{
+    face_gallery_t gallery;
+    face_gallery_match_t match[3];
+    float32_t query[EMBEDDING_SIZE];
+    int ok = 1;
+
+    rng_state = 5U;
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        raw[0][d] = rnd();
+        raw[1][d] = rnd();
+        query[d] = raw[0][d];
+    }
+    /* Identity 2 enrolled first with the same template as identity 1 */
+    (void)init(&gallery, q7, 3);
+    (void)face_gallery_add(&gallery, 2, raw[0]);
+    (void)face_gallery_add(&gallery, 3, raw[1]);
+    (void)face_gallery_add(&gallery, 1, raw[0]);
+    if (face_gallery_search(&gallery, query, match, 3) != 3 ||
+        match[0].identity != 2 || match[1].identity != 1 || match[2].identity != 3 ||
+        match[0].score != match[1].score) {
+        ok = 0;
+    }
+    printf("   %-26s %s\n", "equal scores", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static int check_rejects(int q7)
+{
+    face_gallery_t gallery;
+    face_gallery_match_t match[2];
+    float32_t zero[EMBEDDING_SIZE] = { 0.0f };
+    int ok = 1;
+
+    if (init(&gallery, q7, 0) == 0 ||
+        face_gallery_init(&gallery, NULL, owner, 2) == 0 ||
+        face_gallery_init_q7(&gallery, storage_q7, NULL, owner, 2) == 0 ||
+        init(&gallery, q7, 2) != 0) {
+        ok = 0;
+    }
+    if (face_gallery_search(&gallery, raw[0], match, 2) != 0) {
+        ok = 0; /* Empty */
+    }
+    if (face_gallery_add(&gallery, 0, zero) >= 0 ||
+        face_gallery_add(&gallery, 0, raw[0]) != 1 ||
+        face_gallery_add(&gallery, 1, raw[1]) != 2 ||
+        face_gallery_add(&gallery, 1, raw[2]) >= 0) {
+        ok = 0; /* Zero embedding, then full */
+    }
+    if (face_gallery_identity_count(&gallery, 0) != 1 || face_gallery_identity_count(&gallery, 1) != 1) {
+        ok = 0;
+    }
+    if (face_gallery_search(&gallery, zero, match, 2) != 0 ||
+        face_gallery_search(&gallery, raw[0], match, 0) != 0) {
+        ok = 0; /* Zero query, k = 0 */
+    }
+    face_gallery_reset(&gallery);
+    if (face_gallery_search(&gallery, raw[0], match, 2) != 0) {
+        ok = 0;
+    }
+    printf("   %-26s %s\n", "rejected inputs", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    for (int q7 = 0; q7 < 2; q7++) {
+#ifdef HOST_MVE_EMULATION
+        printf("Face gallery search (Helium), %s templates, against the reference:\n",
+               q7 ? "int8" : "float");
+#else
+        printf("Face gallery search (scalar), %s templates, against the reference:\n",
+               q7 ? "int8" : "float");
+#endif
+        for (size_t c = 0; c < sizeof(gallery_cases) / sizeof(gallery_cases[0]); c++) {
+            failed += !check_case(&gallery_cases[c], 11U + (uint32_t)c, q7);
+        }
+        failed += !check_ties(q7);
+        failed += !check_rejects(q7);
+    }
+
+    printf("%d failed\n", failed);
+    return failed;
+}
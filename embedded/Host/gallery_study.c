@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ * @file    gallery_study.c
+ * @author  PeleAB
+ * @brief   Host tool: ranking of the int8 face gallery against the float one
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: gallery_study [-e embeddings.bin -g per_identity] [-t templates]
+ *                      [-n identities]
+ *
+ * Enrolls the same embeddings in a float and an int8 gallery, searches both
+ * with every other embedding and reports how often the int8 ranking differs
+ * from the float one: top-1 identity, top-5 set, top-1 score, and the
+ * verification decision at FACE_SIMILARITY_THRESHOLD. When the embeddings
+ * are labelled, the identification rate of both is printed too.
+ *
+ * -e reads recorded embeddings: raw floats, EMBEDDING_SIZE per face, as
+ * written by trace_decode -e from a board capture. Each run of -g
+ * consecutive faces is one person (record the people one after the other).
+ * The first -t faces of each person are enrolled (default 3), the others
+ * are the queries. Without -e, -n synthetic identities (default 500) are
+ * generated with 8 faces each, at a within-person cosine of about 0.6.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "app_constants.h"
+#include "face_gallery.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define STUDY_TOP_K                         5
+#define SYNTH_PER_IDENTITY                  8
+#define SYNTH_NOISE                         0.8f    /**< Noise norm, center norm 1 */
+
+static uint32_t rng_state = 3U;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+/* ========================================================================= */
+/* EMBEDDINGS                                                                */
+/* ========================================================================= */
+
+static void normalize(float32_t *v, float32_t norm_wanted)
+{
+    float32_t norm = 0.0f;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        norm += v[d] * v[d];
+    }
+    norm = norm_wanted / sqrtf(norm);
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        v[d] *= norm;
+    }
+}
+
+static float32_t *make_synthetic(uint32_t identities, uint32_t per_identity)
+{
+    float32_t *emb = malloc((size_t)identities * per_identity * EMBEDDING_SIZE * sizeof(float32_t));
+    float32_t center[EMBEDDING_SIZE];
+    float32_t noise[EMBEDDING_SIZE];
+
+    if (!emb) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < identities; i++) {
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            center[d] = rnd();
+        }
+        normalize(center, 1.0f);
+        for (uint32_t f = 0; f < per_identity; f++) {
+            float32_t *e = &emb[((size_t)i * per_identity + f) * EMBEDDING_SIZE];
+
+            for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+                noise[d] = rnd();
+            }
+            normalize(noise, SYNTH_NOISE);
+            for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+                e[d] = center[d] + noise[d];
+            }
+        }
+    }
+    return emb;
+}
+
+static float32_t *load_recorded(const char *path, uint32_t *pFaces)
+{
+    FILE *f = fopen(path, "rb");
+    float32_t *emb;
+    long size;
+
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *pFaces = (uint32_t)(size / (long)(EMBEDDING_SIZE * sizeof(float32_t)));
+    emb = malloc((size_t)*pFaces * EMBEDDING_SIZE * sizeof(float32_t) + 1U);
+    if (emb && fread(emb, EMBEDDING_SIZE * sizeof(float32_t), *pFaces, f) != *pFaces) {
+        free(emb);
+        emb = NULL;
+    }
+    fclose(f);
+    return emb;
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    uint32_t per_identity = 0;
+    uint32_t enrolled = 3;
+    uint32_t identities = 500;
+    uint32_t faces;
+    float32_t *emb;
+    float32_t *storage;
+    int8_t *storage_q7;
+    float32_t *scale_q7;
+    uint16_t *owner;
+    uint16_t *owner_q7;
+    face_gallery_t gallery, gallery_q7;
+    uint32_t queries = 0, top1_same = 0, decision_flips = 0, top1_ok[2] = { 0, 0 };
+    double overlap = 0.0, diff_sum = 0.0, diff_max = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            per_identity = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            enrolled = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            identities = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-e embeddings.bin -g per_identity] [-t templates]"
+                            " [-n identities]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (path) {
+        emb = load_recorded(path, &faces);
+        if (!emb || per_identity == 0 || faces < per_identity) {
+            fprintf(stderr, "%s: need -g and at least one person of embeddings\n", path);
+            free(emb);
+            return 1;
+        }
+        identities = faces / per_identity;
+    } else {
+        per_identity = SYNTH_PER_IDENTITY;
+        emb = make_synthetic(identities, per_identity);
+        if (!emb) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+    if (enrolled == 0 || enrolled >= per_identity || identities == 0 || identities > 65535U) {
+        fprintf(stderr, "need 0 < templates < faces per identity, and 1 to 65535 identities\n");
+        free(emb);
+        return 2;
+    }
+
+    faces = identities * enrolled;
+    storage = malloc(FACE_GALLERY_STORAGE_FLOATS(faces) * sizeof(float32_t));
+    storage_q7 = malloc(FACE_GALLERY_STORAGE_Q7(faces));
+    scale_q7 = malloc(faces * sizeof(float32_t));
+    owner = malloc(faces * sizeof(uint16_t));
+    owner_q7 = malloc(faces * sizeof(uint16_t));
+    if (!storage || !storage_q7 || !scale_q7 || !owner || !owner_q7 ||
+        face_gallery_init(&gallery, storage, owner, faces) != 0 ||
+        face_gallery_init_q7(&gallery_q7, storage_q7, scale_q7, owner_q7, faces) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < identities; i++) {
+        for (uint32_t f = 0; f < enrolled; f++) {
+            const float32_t *e = &emb[((size_t)i * per_identity + f) * EMBEDDING_SIZE];
+
+            (void)face_gallery_add(&gallery, (uint16_t)i, e);
+            (void)face_gallery_add(&gallery_q7, (uint16_t)i, e);
+        }
+    }
+
+    for (uint32_t i = 0; i < identities; i++) {
+        for (uint32_t f = enrolled; f < per_identity; f++) {
+            const float32_t *q = &emb[((size_t)i * per_identity + f) * EMBEDDING_SIZE];
+            face_gallery_match_t m[STUDY_TOP_K], m_q7[STUDY_TOP_K];
+            const uint32_t nb = face_gallery_search(&gallery, q, m, STUDY_TOP_K);
+            const uint32_t nb_q7 = face_gallery_search(&gallery_q7, q, m_q7, STUDY_TOP_K);
+            uint32_t common = 0;
+            double diff;
+
+            if (nb == 0 || nb != nb_q7) {
+                continue; /* Zero embedding */
+            }
+            queries++;
+            top1_same += (m[0].identity == m_q7[0].identity);
+            top1_ok[0] += (m[0].identity == i);
+            top1_ok[1] += (m_q7[0].identity == i);
+            decision_flips += ((m[0].score >= FACE_SIMILARITY_THRESHOLD) !=
+                               (m_q7[0].score >= FACE_SIMILARITY_THRESHOLD));
+            for (uint32_t a = 0; a < nb; a++) {
+                for (uint32_t b = 0; b < nb; b++) {
+                    common += (m[a].identity == m_q7[b].identity);
+                }
+            }
+            overlap += (double)common / nb;
+            diff = fabs((double)m[0].score - m_q7[0].score);
+            diff_sum += diff;
+            if (diff > diff_max) {
+                diff_max = diff;
+            }
+        }
+    }
+
+    printf("int8 against float gallery, %s: %u identities x %u templates, %u queries\n",
+           path ? path : "synthetic", (unsigned int)identities, (unsigned int)enrolled,
+           (unsigned int)queries);
+    if (queries == 0) {
+        return 1;
+    }
+    printf("   top-1 identity identical       %6.2f %%\n", 100.0 * top1_same / queries);
+    printf("   top-%u set overlap              %6.2f %%\n", (unsigned int)STUDY_TOP_K,
+           100.0 * overlap / queries);
+    printf("   top-1 score difference          mean %.5f, max %.5f\n", diff_sum / queries, diff_max);
+    printf("   decision flips at %.2f          %u\n", (double)FACE_SIMILARITY_THRESHOLD,
+           (unsigned int)decision_flips);
+    printf("   identification rate            float %6.2f %%, int8 %6.2f %%\n",
+           100.0 * top1_ok[0] / queries, 100.0 * top1_ok[1] / queries);
+    printf("   template memory                float %u KB, int8 %u KB\n",
+           (unsigned int)(FACE_GALLERY_STORAGE_FLOATS(faces) * sizeof(float32_t) / 1024U),
+           (unsigned int)((FACE_GALLERY_STORAGE_Q7(faces) + faces * sizeof(float32_t)) / 1024U));
+
+    free(storage);
+    free(storage_q7);
+    free(scale_q7);
+    free(owner);
+    free(owner_q7);
+    free(emb);
+    return 0;
+}
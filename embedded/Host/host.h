@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file    host.h
+ * @author  PeleAB
+ * @brief   Host (Linux) build: platform, NPU and pipeline entry points
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * The host build runs the firmware CPU stages unchanged. Camera frames are
+ * pushed by the caller, and NPU inference is replaced by copying canned output
+ * tensors into the network output buffers (zero NPU latency).
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ll_aton_NN_interface.h"
+#include "app_config.h"
+#include "app_frame_processing.h"
+
+/* ========================================================================= */
+/* PLATFORM (host_platform.c)                                                */
+/* ========================================================================= */
+
+/** @brief Display pipe frame size reported by the host CAM_Init() */
+#define HOST_CAMERA_WIDTH                   800U
+#define HOST_CAMERA_HEIGHT                  480U
+
+/**
+ * @brief Push one camera frame as if DCMIPP had completed it
+ * @param nn_rgb NN pipe frame, NN_WIDTH x NN_HEIGHT RGB888 (tightly packed),
+ *        written to the capture buffer at DCMIPP_OUT_NN_PITCH like DCMIPP does
+ * @param display565 Display pipe frame, RGB565 at the size reported by
+ *        CAM_Init(), or NULL to keep the previous one
+ * @return 0 on success, negative if the NN pipe was not started or is stopped
+ *         on a held buffer
+ */
+int host_camera_push_frame(const uint8_t *nn_rgb, const uint16_t *display565);
+
+/**
+ * @brief Capture every byte sent on COM1 into @p file (NULL to stop)
+ * @note  The capture can be decoded with trace_decode
+ */
+void host_uart_capture(FILE *file);
+
+/**
+ * @brief Get the number of bytes sent on COM1 so far
+ */
+uint64_t host_uart_bytes(void);
+
+/**
+ * @brief Get the current state of an LED (1 = on)
+ */
+int host_led_state(uint32_t led);
+
+/* ========================================================================= */
+/* NPU (host_npu.c)                                                          */
+/* ========================================================================= */
+
+/**
+ * @brief Fill the output buffers of a finished inference
+ * @param inst Network that ran
+ * @param inputs Input buffer descriptors (NULL-name terminated)
+ * @param outputs Output buffer descriptors (NULL-name terminated)
+ * @param arg User argument given to host_npu_set_output_source()
+ * @return 0 on success, negative on error (outputs are then zeroed)
+ */
+typedef int (*host_npu_output_fn_t)(const NN_Instance_TypeDef *inst,
+                                    const LL_Buffer_InfoTypeDef *inputs,
+                                    const LL_Buffer_InfoTypeDef *outputs,
+                                    void *arg);
+
+/**
+ * @brief Replace the canned tensor source (NULL restores the default)
+ */
+void host_npu_set_output_source(host_npu_output_fn_t fn, void *arg);
+
+/**
+ * @brief Number of times LL_ATON_RT_RunEpochBlock() reports LL_ATON_RT_WFE
+ *        before each inference completes (default 1)
+ */
+void host_npu_set_wait_polls(uint32_t polls);
+
+/**
+ * @brief Load canned outputs from "<dir>/<network>_out<N>.bin"
+ * @param dir Directory holding the tensor files
+ * @return Number of files loaded, negative if a file has the wrong size
+ * @note  Outputs without a file are returned as zeros
+ */
+int host_npu_load_dir(const char *dir);
+
+/**
+ * @brief Write "<dir>/<network>_out<N>.bin" for every output of @p inst
+ * @param dir Destination directory
+ * @param inst Network instance
+ * @param data Output tensors in buffer order, each LL_Buffer_len() bytes
+ * @return 0 on success, negative on I/O error
+ */
+int host_npu_save_outputs(const char *dir, const NN_Instance_TypeDef *inst,
+                          const uint8_t *const *data);
+
+/* ========================================================================= */
+/* PIPELINE (host_pipeline.c)                                                */
+/* ========================================================================= */
+
+/**
+ * @brief One face as left by the pipeline after recognition
+ */
+typedef struct {
+    float score;                            /**< Similarity, or 0.05 if skipped for low confidence */
+    float x_center;                         /**< Normalized box center */
+    float y_center;
+    float width;                            /**< Normalized box size */
+    float height;
+    uint32_t nb_kps;                        /**< Landmarks decoded, 0 below the detection threshold */
+    float kps[AI_PD_MODEL_PP_NB_KEYPOINTS][2]; /**< Normalized landmarks (x, y) */
+} host_face_t;
+
+/**
+ * @brief Observable outcome of one frame
+ */
+typedef struct {
+    uint32_t face_nb;                       /**< Faces after NMS */
+    host_face_t faces[AI_PD_MODEL_PP_MAX_BOXES_LIMIT];
+    float best_similarity;                  /**< Similarity of the best recognized face */
+    uint8_t face_detected;                  /**< A face was recognized this frame */
+    uint8_t target_this_frame;              /**< A face was above the similarity threshold */
+    uint8_t target_detected;                /**< Voting result (3 of the last 5 frames) */
+    uint8_t face_verified;                  /**< Verification state driving the LEDs */
+    pipeline_timing_t timing;               /**< Per-stage profiler ticks */
+} host_frame_result_t;
+
+/**
+ * @brief Run the firmware init sequence up to the first frame
+ * @return 0 on success, negative on error
+ */
+int host_pipeline_init(void);
+
+/**
+ * @brief Stage the next face for recognition while the NPU embeds the current
+ *        one (1, the firmware default) or only once it is done (0)
+ */
+void host_pipeline_set_overlap(int overlap);
+
+/**
+ * @brief Run the six firmware pipeline stages on the last pushed frame
+ * @return 0 on success, negative if a stage failed
+ */
+int host_pipeline_run_frame(void);
+
+/**
+ * @brief Read the outcome of the last host_pipeline_run_frame()
+ */
+void host_pipeline_get_result(host_frame_result_t *res);
+
+/* ========================================================================= */
+/* REPLAY SEQUENCES (make_tensors -s, replay)                                */
+/* ========================================================================= */
+/*
+ * <seq>/enroll.bin                    embeddings enrolled before frame 0
+ *                                     (EMBEDDING_SIZE floats each, optional)
+ * <seq>/golden.txt                    expected results, written by replay -r
+ * <seq>/NNNN/nn_rgb.bin               NN pipe frame, 128x128 RGB888
+ * <seq>/NNNN/display.bin              display frame, RGB565 (optional,
+ *                                     defaults to the dummy test image)
+ * <seq>/NNNN/face_detection_out<N>.bin  detection outputs in buffer order
+ * <seq>/NNNN/face_recognition_out0.bin  one embedding per recognition run of
+ *                                     the frame, in run order (optional)
+ */
+
+#define REPLAY_ENROLL_FILE                  "enroll.bin"
+#define REPLAY_GOLDEN_FILE                  "golden.txt"
+#define REPLAY_NN_RGB_FILE                  "nn_rgb.bin"
+#define REPLAY_DISPLAY_FILE                 "display.bin"
+#define REPLAY_EMBEDDINGS_FILE              "face_recognition_out0.bin"
+#define REPLAY_FRAME_DIR_FMT                "%s/%04u"
+
+#endif /* HOST_H */
@@ -0,0 +1,628 @@
+/**
+ ******************************************************************************
+ * @file    host_bench.c
+ * @author  PeleAB
+ * @brief   Host benchmark: firmware pipeline and CPU kernels on canned tensors
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: host_bench [-t tensor_dir] [-n frames] [-k kernel_iterations]
+ *                   [-c uart_capture.bin]
+ *
+ * 1. Runs the firmware frame path (app_process_frame in main.c) on the dummy
+ *    test image with NPU outputs taken from tensor_dir, then prints the
+ *    per-stage profile. The canned embedding is enrolled first so the
+ *    recognition and voting paths are exercised.
+ * 2. Times the CPU kernels in isolation on the same data.
+ * 3. Times the CenterFace decode and NMS on synthetic heatmaps with many
+ *    cells above the threshold, next to the original decoder (pd_pp_ref.c),
+ *    then compares the threshold and 3x3 peak decode modes.
+ * 4. Times the face gallery top-K search on 100, 1k and 10k identities,
+ *    with float and int8 templates, next to one cosine similarity per
+ *    template.
+ *
+ * Detection and recognition stage times exclude NPU inference (canned
+ * tensors complete on the first poll); they measure the CPU work around it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "nn_runner.h"
+#include "app_config.h"
+#include "app_constants.h"
+#include "app_postprocess.h"
+#include "blit.h"
+#include "crop_img.h"
+#include "dummy_dual_buffer.h"
+#include "face_utils.h"
+#include "pd_pp_ref.h"
+#include "pipeline_profiler.h"
+#include "stm32n6570_discovery.h"
+#include "target_embedding.h"
+#include "warp_ref.h"
+
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_detection);
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_recognition);
+
+/* ========================================================================= */
+/* KERNEL TIMING                                                             */
+/* ========================================================================= */
+
+typedef struct {
+    uint64_t total;
+    uint32_t best;
+    uint32_t runs;
+} kernel_time_t;
+
+#define KERNEL_TIME(t, body) \
+    do { \
+        uint32_t t0_ = profiler_now(); \
+        body; \
+        uint32_t dt_ = profiler_now() - t0_; \
+        (t)->total += dt_; \
+        (t)->runs++; \
+        if ((t)->runs == 1 || dt_ < (t)->best) { \
+            (t)->best = dt_; \
+        } \
+    } while (0)
+
+static void kernel_print(const char *name, const kernel_time_t *t)
+{
+    double ns_per_tick = 1e9 / (double)profiler_tick_rate();
+
+    printf("   %-34s %10.1f %10.1f\n", name,
+           (double)t->best * ns_per_tick / 1000.0,
+           (double)t->total * ns_per_tick / 1000.0 / (double)(t->runs ? t->runs : 1));
+}
+
+static void bench_kernels(uint32_t iterations)
+{
+    static uint8_t nn_rgb_copy[NN_WIDTH * NN_HEIGHT * NN_BPP];
+    static float32_t chw[NN_WIDTH * NN_HEIGHT * NN_BPP];
+    static uint8_t face[FACE_RECOGNITION_WIDTH * FACE_RECOGNITION_HEIGHT * NN_BPP];
+    static float32_t face_chw[FACE_RECOGNITION_WIDTH * FACE_RECOGNITION_HEIGHT * NN_BPP];
+    static pd_model_pp_static_param_t pp_params;
+    static pd_postprocess_out_t pp_out;
+    const LL_Buffer_InfoTypeDef *out_info = LL_ATON_Output_Buffers_Info_face_detection();
+    void *pp_in[4];
+    float emb[EMBEDDING_SIZE];
+    face_gallery_match_t match;
+    float dummy_sink = 0.0f;
+    kernel_time_t t_pp = {0}, t_crop = {0}, t_fused = {0}, t_sim = {0};
+    kernel_time_t t_warp[2][2] = {{{0}}};   /* [nearest, bilinear][fixed point, float reference] */
+    kernel_time_t t_chw[2][2] = {{{0}}};    /* [shape][optimized, ref] */
+    kernel_time_t t_norm[2][3] = {{{0}}};   /* [shape][optimized, ref, table] */
+    kernel_time_t t_gray = {0};
+    static uint8_t gray[320 * 240];
+    const blit_surface_t gray_src = {
+        .data = (void *)dummy_test_img_buffer, .stride = HOST_CAMERA_WIDTH * 2,
+        .width = 640, .height = 480, .format = BLIT_FMT_RGB565,
+    };
+    const blit_surface_t gray_dst = {
+        .data = gray, .stride = 320, .width = 320, .height = 240, .format = BLIT_FMT_L8,
+    };
+    static const uint16_t chw_side[2] = { NN_WIDTH, FACE_RECOGNITION_WIDTH };
+
+    memcpy(nn_rgb_copy, dummy_test_nn_rgb, sizeof(nn_rgb_copy));
+    for (uint32_t i = 0; i < 4; i++) {
+        pp_in[i] = LL_Buffer_addr_start(&out_info[i]);
+    }
+    for (uint32_t i = 0; i < EMBEDDING_SIZE; i++) {
+        emb[i] = (float)((i * 37U) % 11U) - 5.0f;
+    }
+
+    /* Refresh the canned detection outputs (the pipeline reuses the arena) */
+    RunNetworkSync(&NN_Instance_face_detection);
+    app_postprocess_init(&pp_params);
+
+    for (uint32_t it = 0; it < iterations; it++) {
+        for (uint32_t s = 0; s < 2; s++) {
+            uint16_t side = chw_side[s];
+
+            KERNEL_TIME(&t_chw[s][0], img_rgb_to_chw_float(nn_rgb_copy, chw, side * NN_BPP, side, side));
+            KERNEL_TIME(&t_chw[s][1], img_rgb_to_chw_float_ref(nn_rgb_copy, chw, side * NN_BPP, side, side));
+            KERNEL_TIME(&t_norm[s][0], img_rgb_to_chw_float_norm(nn_rgb_copy, chw, side * NN_BPP, side, side));
+            KERNEL_TIME(&t_norm[s][1], img_rgb_to_chw_float_norm_ref(nn_rgb_copy, chw, side * NN_BPP, side, side));
+            KERNEL_TIME(&t_norm[s][2], img_rgb_to_chw_float_norm_lut(nn_rgb_copy, chw, side * NN_BPP, side, side));
+        }
+        KERNEL_TIME(&t_pp, app_postprocess_run(pp_in, 4, &pp_out, &pp_params));
+        KERNEL_TIME(&t_crop, img_crop_align565_to_888((uint8_t *)dummy_test_img_buffer,
+                                                      HOST_CAMERA_WIDTH, face,
+                                                      HOST_CAMERA_WIDTH, HOST_CAMERA_HEIGHT,
+                                                      FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT,
+                                                      409.0f, 261.0f, 176.0f, 176.0f,
+                                                      370.0f, 230.0f, 450.0f, 232.0f));
+        img_rgb_to_chw_float_norm(face, face_chw, FACE_RECOGNITION_WIDTH * NN_BPP,
+                                  FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT);
+        for (uint32_t m = 0; m < 2; m++) {
+            img_sample_t sample = m ? IMG_SAMPLE_BILINEAR : IMG_SAMPLE_NEAREST;
+
+            KERNEL_TIME(&t_warp[m][0], img_warp_align((const uint8_t *)dummy_test_img_buffer,
+                                                      HOST_CAMERA_WIDTH * 2, IMG_FORMAT_RGB565,
+                                                      HOST_CAMERA_WIDTH, HOST_CAMERA_HEIGHT, face,
+                                                      FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT,
+                                                      sample, 409.0f, 261.0f, 176.0f, 176.0f,
+                                                      370.0f, 230.0f, 450.0f, 232.0f));
+            KERNEL_TIME(&t_warp[m][1], warp_ref_align((const uint8_t *)dummy_test_img_buffer,
+                                                      HOST_CAMERA_WIDTH * 2, IMG_FORMAT_RGB565,
+                                                      HOST_CAMERA_WIDTH, HOST_CAMERA_HEIGHT, face,
+                                                      FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT,
+                                                      sample, 409.0f, 261.0f, 176.0f, 176.0f,
+                                                      370.0f, 230.0f, 450.0f, 232.0f));
+        }
+        KERNEL_TIME(&t_fused, img_crop_align565_to_chw_float_norm((uint8_t *)dummy_test_img_buffer,
+                                                                  HOST_CAMERA_WIDTH, face_chw,
+                                                                  HOST_CAMERA_WIDTH, HOST_CAMERA_HEIGHT,
+                                                                  FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT,
+                                                                  409.0f, 261.0f, 176.0f, 176.0f,
+                                                                  370.0f, 230.0f, 450.0f, 232.0f));
+        KERNEL_TIME(&t_gray, { (void)blit_scale_copy(&gray_dst, &gray_src); (void)blit_wait(); });
+        KERNEL_TIME(&t_sim, dummy_sink += (float)embeddings_bank_search(emb, &match, 1));
+    }
+
+    printf("CPU kernels, %u iterations (us):\n", (unsigned int)iterations);
+    printf("   %-34s %10s %10s\n", "kernel", "best", "mean");
+    for (uint32_t s = 0; s < 2; s++) {
+        char name[48];
+
+        snprintf(name, sizeof(name), "img_rgb_to_chw_float %ux%u", chw_side[s], chw_side[s]);
+        kernel_print(name, &t_chw[s][0]);
+        snprintf(name, sizeof(name), "  reference");
+        kernel_print(name, &t_chw[s][1]);
+        snprintf(name, sizeof(name), "img_rgb_to_chw_float_norm %ux%u", chw_side[s], chw_side[s]);
+        kernel_print(name, &t_norm[s][0]);
+        snprintf(name, sizeof(name), "  reference");
+        kernel_print(name, &t_norm[s][1]);
+        snprintf(name, sizeof(name), "  table (pixel_lut_norm)");
+        kernel_print(name, &t_norm[s][2]);
+    }
+    kernel_print("app_postprocess_run", &t_pp);
+    kernel_print("img_crop_align565_to_888", &t_crop);
+    kernel_print("img_warp_align 565 nearest", &t_warp[0][0]);
+    kernel_print("  float reference", &t_warp[0][1]);
+    kernel_print("img_warp_align 565 bilinear", &t_warp[1][0]);
+    kernel_print("  float reference", &t_warp[1][1]);
+    kernel_print("img_crop_align565_to_chw_float_norm", &t_fused);
+    kernel_print("blit_scale_copy 565 to L8 320x240", &t_gray);
+    kernel_print("embeddings_bank_search, enrolled", &t_sim);
+    printf("   (%u boxes after NMS, checksum %.3f)\n", (unsigned int)pp_out.box_nb,
+           (double)(chw[1000] + face_chw[1000] + dummy_sink));
+}
+
+/* ========================================================================= */
+/* DETECTION POST-PROCESSING                                                 */
+/* ========================================================================= */
+
+#define PP_BENCH_MAX_CELLS                  (64 * 64)
+
+static float32_t pp_scale[PP_BENCH_MAX_CELLS * 2];
+static float32_t pp_offset[PP_BENCH_MAX_CELLS * 2];
+static float32_t pp_lms[PP_BENCH_MAX_CELLS * AI_PD_MODEL_PP_NB_KEYPOINTS * 2];
+static float32_t pp_heatmap[PP_BENCH_MAX_CELLS];
+static pd_pp_box_t pp_boxes[PP_BENCH_MAX_CELLS];
+static pd_pp_point_t pp_kps[PP_BENCH_MAX_CELLS][AI_PD_MODEL_PP_NB_KEYPOINTS];
+static pd_pp_candidate_t pp_cand[PP_BENCH_MAX_CELLS];
+static pd_pp_nms_box_t pp_nms[PP_BENCH_MAX_CELLS];
+
+static uint32_t pp_rng;
+
+static float32_t pp_rnd(void)
+{
+    pp_rng = pp_rng * 1664525U + 1013904223U;
+    return (float32_t)(pp_rng >> 8) / 16777216.0f;
+}
+
+/**
+ * @brief Cluttered scene: a fraction @p dense of the cells above the
+ *        threshold, boxes a few cells wide so that most of them overlap
+ */
+static uint32_t pp_bench_outputs(uint32_t grid, float32_t dense)
+{
+    uint32_t above = 0;
+
+    pp_rng = 2024U;
+    for (uint32_t i = 0; i < grid * grid; i++) {
+        pp_heatmap[i] = (pp_rnd() < dense) ? 0.5f + 0.5f * pp_rnd() : 0.4f * pp_rnd();
+        above += pp_heatmap[i] > AI_PD_MODEL_PP_CONF_THRESHOLD;
+        pp_scale[i * 2 + 0] = 1.0f + 1.5f * pp_rnd();
+        pp_scale[i * 2 + 1] = 1.0f + 1.5f * pp_rnd();
+        pp_offset[i * 2 + 0] = pp_rnd();
+        pp_offset[i * 2 + 1] = pp_rnd();
+    }
+    for (uint32_t i = 0; i < grid * grid * AI_PD_MODEL_PP_NB_KEYPOINTS * 2; i++) {
+        pp_lms[i] = pp_rnd();
+    }
+    return above;
+}
+
+static void bench_detection_pp(uint32_t iterations)
+{
+    static const uint32_t grids[2] = { 32, 64 };
+    static const float32_t density[2] = { 0.1f, 0.5f };
+    pd_model_pp_in_t in = { pp_scale, pp_lms, pp_heatmap, pp_offset };
+    pd_postprocess_out_t out = { pp_boxes, 0 };
+    uint32_t kept[2] = { 0, 0 };
+    uint32_t with_kps = 0;
+
+    for (uint32_t i = 0; i < PP_BENCH_MAX_CELLS; i++) {
+        pp_boxes[i].pKps = pp_kps[i];
+    }
+
+    printf("\nCenterFace decode and NMS, synthetic heatmaps, %u iterations (us):\n",
+           (unsigned int)iterations);
+    printf("   %-34s %10s %10s\n", "grid, cells above threshold", "best", "mean");
+    printf("   (the original takes the first max_boxes_limit cells in raster order)\n");
+    for (uint32_t g = 0; g < 2; g++) {
+        for (uint32_t d = 0; d < 2; d++) {
+            uint32_t above = pp_bench_outputs(grids[g], density[d]);
+            pd_model_pp_static_param_t param = {
+                .width = grids[g] * 4U, .height = grids[g] * 4U,
+                .nb_keypoints = AI_PD_MODEL_PP_NB_KEYPOINTS,
+                .conf_threshold = AI_PD_MODEL_PP_CONF_THRESHOLD,
+                .iou_threshold = AI_PD_MODEL_PP_IOU_THRESHOLD,
+                .nb_total_boxes = grids[g] * grids[g],
+                .grid_width = grids[g], .grid_height = grids[g], .stride = 4.0f,
+                .pTmpBuff = pp_cand, .pTmpNmsBuff = pp_nms,
+            };
+
+            /* The application limit, then every cell above the threshold */
+            for (uint32_t l = 0; l < 2; l++) {
+                kernel_time_t t[3] = {{0}};
+                char name[48];
+
+                param.max_boxes_limit = l ? param.nb_total_boxes : AI_PD_MODEL_PP_MAX_BOXES_LIMIT;
+                (void)pd_model_pp_reset(&param);
+                for (uint32_t it = 0; it < iterations; it++) {
+                    param.kps_conf_threshold = 0.0f;
+                    KERNEL_TIME(&t[0], pd_model_pp_process(&in, &out, &param));
+                    kept[0] = out.box_nb;
+                    param.kps_conf_threshold = FACE_DETECTION_CONFIDENCE_THRESHOLD;
+                    KERNEL_TIME(&t[2], pd_model_pp_process(&in, &out, &param));
+                    KERNEL_TIME(&t[1], pd_pp_ref_process(&in, &out, &param));
+                    kept[1] = out.box_nb;
+                }
+                /* Landmark sets decoded: every candidate before NMS (previous
+                 * decoder), every kept box, kept boxes above the threshold */
+                (void)pd_model_pp_process(&in, &out, &param);
+                with_kps = 0;
+                for (uint32_t b = 0; b < out.box_nb; b++) {
+                    with_kps += pp_boxes[b].nb_kps > 0;
+                }
+                snprintf(name, sizeof(name), "%ux%u, %u above, limit %u", (unsigned int)grids[g],
+                         (unsigned int)grids[g], (unsigned int)above,
+                         (unsigned int)param.max_boxes_limit);
+                kernel_print(name, &t[0]);
+                snprintf(name, sizeof(name), "  landmarks from %.2f",
+                         (double)FACE_DETECTION_CONFIDENCE_THRESHOLD);
+                kernel_print(name, &t[2]);
+                kernel_print("  original", &t[1]);
+                printf("   %-34s %u boxes, original %u; landmark sets %u before NMS, %u after,"
+                       " %u from %.2f\n", "", (unsigned int)kept[0], (unsigned int)kept[1],
+                       (unsigned int)(above < param.max_boxes_limit ? above : param.max_boxes_limit),
+                       (unsigned int)kept[0], (unsigned int)with_kps,
+                       (double)FACE_DETECTION_CONFIDENCE_THRESHOLD);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Scene of @p nfaces faces: a 5x5 blob of decreasing scores around
+ *        each face center, every cell of a blob decoding to about the same box
+ */
+static void pp_bench_faces(uint32_t grid, uint32_t nfaces)
+{
+    (void)pp_bench_outputs(grid, 0.0f);
+    for (uint32_t f = 0; f < nfaces; f++) {
+        float32_t cx = 2.0f + pp_rnd() * (float32_t)(grid - 4);
+        float32_t cy = 2.0f + pp_rnd() * (float32_t)(grid - 4);
+        float32_t s = 1.5f + pp_rnd();
+
+        for (int dy = -2; dy <= 2; dy++) {
+            for (int dx = -2; dx <= 2; dx++) {
+                int gx = (int)cx + dx, gy = (int)cy + dy;
+                uint32_t i = (uint32_t)gy * grid + (uint32_t)gx;
+                float32_t score = 0.92f - 0.1f * (float32_t)(abs(dx) > abs(dy) ? abs(dx) : abs(dy)) +
+                                  0.02f * pp_rnd();
+
+                if (score <= pp_heatmap[i]) {
+                    continue;
+                }
+                pp_heatmap[i] = score;
+                pp_scale[i * 2 + 0] = s;
+                pp_scale[i * 2 + 1] = s;
+                pp_offset[i * 2 + 0] = cy - (float32_t)gy - 0.5f;
+                pp_offset[i * 2 + 1] = cx - (float32_t)gx - 0.5f;
+            }
+        }
+    }
+}
+
+static void bench_detection_modes(uint32_t iterations)
+{
+    static const struct {
+        uint32_t grid, faces;               /**< faces 0: noise, half the cells above */
+    } scenes[3] = { { 32, 8 }, { 64, 24 }, { 64, 0 } };
+    static const char *const mode_names[2] = { "threshold", "peaks" };
+    pd_model_pp_in_t in = { pp_scale, pp_lms, pp_heatmap, pp_offset };
+    pd_postprocess_out_t out = { pp_boxes, 0 };
+
+    printf("\nCenterFace decode modes, every candidate kept, %u iterations (us):\n",
+           (unsigned int)iterations);
+    printf("   %-34s %10s %10s\n", "scene, mode", "best", "mean");
+    for (uint32_t sc = 0; sc < 3; sc++) {
+        const uint32_t grid = scenes[sc].grid;
+        uint32_t count[2][2];
+
+        if (scenes[sc].faces) {
+            pp_bench_faces(grid, scenes[sc].faces);
+        } else {
+            (void)pp_bench_outputs(grid, 0.5f);
+        }
+        for (uint32_t m = 0; m < 2; m++) {
+            pd_model_pp_static_param_t param = {
+                .width = grid * 4U, .height = grid * 4U,
+                .nb_keypoints = AI_PD_MODEL_PP_NB_KEYPOINTS,
+                .conf_threshold = AI_PD_MODEL_PP_CONF_THRESHOLD,
+                .iou_threshold = 2.0f,
+                .nb_total_boxes = grid * grid, .max_boxes_limit = grid * grid,
+                .grid_width = grid, .grid_height = grid, .stride = 4.0f,
+                .pTmpBuff = pp_cand, .pTmpNmsBuff = pp_nms, .decode_mode = m,
+            };
+            kernel_time_t t = {0};
+            char name[48];
+
+            /* No IoU reaches 2: NMS keeps every candidate */
+            (void)pd_model_pp_reset(&param);
+            (void)pd_model_pp_process(&in, &out, &param);
+            count[m][0] = out.box_nb;
+
+            param.iou_threshold = AI_PD_MODEL_PP_IOU_THRESHOLD;
+            for (uint32_t it = 0; it < iterations; it++) {
+                KERNEL_TIME(&t, pd_model_pp_process(&in, &out, &param));
+            }
+            count[m][1] = out.box_nb;
+
+            if (scenes[sc].faces) {
+                snprintf(name, sizeof(name), "%ux%u %u faces, %s", (unsigned int)grid,
+                         (unsigned int)grid, (unsigned int)scenes[sc].faces, mode_names[m]);
+            } else {
+                snprintf(name, sizeof(name), "%ux%u noise, %s", (unsigned int)grid,
+                         (unsigned int)grid, mode_names[m]);
+            }
+            kernel_print(name, &t);
+            printf("   %-34s %u candidates, %u boxes\n", "", (unsigned int)count[m][0],
+                   (unsigned int)count[m][1]);
+        }
+    }
+}
+
+/* ========================================================================= */
+/* FACE GALLERY                                                              */
+/* ========================================================================= */
+
+#define GALLERY_BENCH_TEMPLATES             3       /**< Templates per identity */
+#define GALLERY_BENCH_TOP_K                 5
+
+static uint32_t gallery_rng;
+
+static float32_t gallery_rnd(void)
+{
+    gallery_rng = gallery_rng * 1664525U + 1013904223U;
+    return (float32_t)(gallery_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+/**
+ * @brief Fill both galleries with @p identities random identities and time
+ *        their search, next to one embedding_cosine_similarity() call per
+ *        template
+ *
+ * The query is a noisy copy of one template, so the top match is known.
+ */
+static void gallery_bench_run(face_gallery_t *gallery, face_gallery_t *gallery_q7,
+                              float32_t *rows, uint32_t identities, uint32_t runs)
+{
+    const uint32_t n = identities * GALLERY_BENCH_TEMPLATES;
+    const uint16_t expected = (uint16_t)(identities / 3U);
+    face_gallery_match_t match[GALLERY_BENCH_TOP_K];
+    face_gallery_match_t match_q7[GALLERY_BENCH_TOP_K];
+    float32_t query[EMBEDDING_SIZE];
+    kernel_time_t t_search = {0}, t_search_q7 = {0}, t_cosine = {0};
+    uint32_t nb = 0, nb_q7 = 0;
+    float32_t best = -2.0f;
+    uint32_t best_t = 0;
+    char name[48];
+
+    gallery_rng = 77U;
+    for (uint32_t t = 0; t < n; t++) {
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            rows[t * EMBEDDING_SIZE + d] = gallery_rnd();
+        }
+        (void)face_gallery_add(gallery, (uint16_t)(t / GALLERY_BENCH_TEMPLATES),
+                               &rows[t * EMBEDDING_SIZE]);
+        (void)face_gallery_add(gallery_q7, (uint16_t)(t / GALLERY_BENCH_TEMPLATES),
+                               &rows[t * EMBEDDING_SIZE]);
+    }
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        query[d] = rows[(expected * GALLERY_BENCH_TEMPLATES + 1U) * EMBEDDING_SIZE + d] +
+                   0.5f * gallery_rnd();
+    }
+
+    for (uint32_t it = 0; it < runs; it++) {
+        KERNEL_TIME(&t_search, nb = face_gallery_search(gallery, query, match, GALLERY_BENCH_TOP_K));
+        KERNEL_TIME(&t_search_q7, nb_q7 = face_gallery_search(gallery_q7, query, match_q7,
+                                                              GALLERY_BENCH_TOP_K));
+        KERNEL_TIME(&t_cosine, {
+            best = -2.0f;
+            for (uint32_t t = 0; t < n; t++) {
+                const float32_t c = embedding_cosine_similarity(query, &rows[t * EMBEDDING_SIZE],
+                                                                EMBEDDING_SIZE);
+                if (c > best) {
+                    best = c;
+                    best_t = t;
+                }
+            }
+        });
+    }
+
+    snprintf(name, sizeof(name), "%u, face_gallery_search", (unsigned int)identities);
+    kernel_print(name, &t_search);
+    snprintf(name, sizeof(name), "  int8 templates");
+    kernel_print(name, &t_search_q7);
+    snprintf(name, sizeof(name), "  cosine per template");
+    kernel_print(name, &t_cosine);
+    printf("   %-34s top %u %.4f, int8 top %u %.4f, cosine top %u %.4f (expected %u)\n", "",
+           (unsigned int)(nb ? match[0].identity : 0xFFFFU), (double)(nb ? match[0].score : 0.0f),
+           (unsigned int)(nb_q7 ? match_q7[0].identity : 0xFFFFU),
+           (double)(nb_q7 ? match_q7[0].score : 0.0f),
+           (unsigned int)(best_t / GALLERY_BENCH_TEMPLATES), (double)best, (unsigned int)expected);
+    printf("   %-34s %u KB float, %u KB int8\n", "",
+           (unsigned int)(FACE_GALLERY_STORAGE_FLOATS(n) * sizeof(float32_t) / 1024U),
+           (unsigned int)((FACE_GALLERY_STORAGE_Q7(n) + n * sizeof(float32_t)) / 1024U));
+}
+
+/**
+ * @brief Top-K search over 100, 1k and 10k identities, float and int8
+ */
+static void bench_gallery(uint32_t iterations)
+{
+    static const uint32_t identities[3] = { 100, 1000, 10000 };
+
+    printf("\nFace gallery search, %u templates per identity, top %u (us):\n",
+           (unsigned int)GALLERY_BENCH_TEMPLATES, (unsigned int)GALLERY_BENCH_TOP_K);
+    printf("   %-34s %10s %10s\n", "identities", "best", "mean");
+    for (uint32_t s = 0; s < 3; s++) {
+        const uint32_t n = identities[s] * GALLERY_BENCH_TEMPLATES;
+        const uint32_t runs = (iterations * 100U / identities[s] > 10U) ?
+                              iterations * 100U / identities[s] : 10U;
+        float32_t *storage = malloc(FACE_GALLERY_STORAGE_FLOATS(n) * sizeof(float32_t));
+        float32_t *rows = malloc((size_t)n * EMBEDDING_SIZE * sizeof(float32_t));
+        uint16_t *owner = malloc(n * sizeof(uint16_t));
+        int8_t *storage_q7 = malloc(FACE_GALLERY_STORAGE_Q7(n));
+        float32_t *scale_q7 = malloc(n * sizeof(float32_t));
+        uint16_t *owner_q7 = malloc(n * sizeof(uint16_t));
+        face_gallery_t gallery, gallery_q7;
+
+        if (!storage || !rows || !owner || !storage_q7 || !scale_q7 || !owner_q7 ||
+            face_gallery_init(&gallery, storage, owner, n) != 0 ||
+            face_gallery_init_q7(&gallery_q7, storage_q7, scale_q7, owner_q7, n) != 0) {
+            printf("   %u identities: out of memory\n", (unsigned int)identities[s]);
+        } else {
+            gallery_bench_run(&gallery, &gallery_q7, rows, identities[s], runs);
+        }
+        free(storage);
+        free(rows);
+        free(owner);
+        free(storage_q7);
+        free(scale_q7);
+        free(owner_q7);
+    }
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+static int enroll_canned_embedding(const char *dir)
+{
+    char path[512];
+    float emb[EMBEDDING_SIZE];
+    FILE *f;
+    size_t got;
+
+    snprintf(path, sizeof(path), "%s/face_recognition_out0.bin", dir);
+    f = fopen(path, "rb");
+    if (!f) {
+        return -1;
+    }
+    got = fread(emb, sizeof(float), EMBEDDING_SIZE, f);
+    fclose(f);
+    if (got != EMBEDDING_SIZE) {
+        return -2;
+    }
+    return embeddings_bank_add(emb);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = "build/tensors";
+    const char *capture_path = NULL;
+    uint32_t frames = 200;
+    uint32_t iterations = 1000;
+    uint32_t failed = 0;
+    FILE *capture = NULL;
+    int loaded;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            frames = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-t tensor_dir] [-n frames] [-k kernel_iterations]"
+                            " [-c uart_capture.bin]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    loaded = host_npu_load_dir(dir);
+    if (loaded <= 0) {
+        fprintf(stderr, "no canned tensors in %s (run make_tensors first)\n", dir);
+        return 1;
+    }
+    if (capture_path) {
+        capture = fopen(capture_path, "wb");
+        if (!capture) {
+            perror(capture_path);
+            return 1;
+        }
+        host_uart_capture(capture);
+    }
+
+    if (host_pipeline_init() != 0) {
+        fprintf(stderr, "pipeline init failed\n");
+        return 1;
+    }
+    if (enroll_canned_embedding(dir) < 0) {
+        printf("No canned embedding enrolled: similarities will be 0\n");
+    }
+
+    for (uint32_t f = 0; f < frames; f++) {
+        host_camera_push_frame(dummy_test_nn_rgb, dummy_test_img_buffer);
+        if (host_pipeline_run_frame() != 0) {
+            failed++;
+        }
+    }
+
+    printf("\nPipeline, %u frames (%u failed), %u tensor files from %s\n",
+           (unsigned int)frames, (unsigned int)failed, (unsigned int)loaded, dir);
+    profiler_report();
+    printf("   UART bytes: %llu, LED1=%d LED2=%d\n\n", (unsigned long long)host_uart_bytes(),
+           host_led_state(LED1), host_led_state(LED2));
+
+    bench_kernels(iterations);
+    bench_detection_pp(iterations);
+    bench_detection_modes(iterations);
+    bench_gallery(iterations);
+
+    if (capture) {
+        host_uart_capture(NULL);
+        fclose(capture);
+    }
+    return 0;
+}
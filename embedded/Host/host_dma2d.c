@@ -0,0 +1,276 @@
+/**
+ ******************************************************************************
+ * @file    host_dma2d.c
+ * @author  PeleAB
+ * @brief   Host (Linux) emulation of the DMA2D HAL subset used by blit_dma2d.c
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Models the register level behaviour the driver relies on: the start calls
+ * only latch the configuration, and the pixels are moved when the transfer
+ * is polled, so a caller reading the destination before blit_wait() sees
+ * stale data as it would on the board. Pixel format conversion follows the
+ * reference manual: narrow channels expand by repeating their top bits, the
+ * output converter truncates, RedBlueSwap and byte/pixel line offsets apply
+ * per layer. Blending uses the DMA2D alpha blender equations.
+ */
+
+#include "host_hal.h"
+
+/* ========================================================================= */
+/* EMULATED STATE                                                            */
+/* ========================================================================= */
+
+/** @brief Registers latched by a start call */
+typedef struct {
+    int pending;
+    DMA2D_InitTypeDef init;
+    DMA2D_LayerCfgTypeDef layer[2];
+    uintptr_t fg;                           /**< FGMAR (R2M: color) */
+    uintptr_t bg;                           /**< BGMAR */
+    uintptr_t dst;                          /**< OMAR */
+    uint32_t width;
+    uint32_t height;
+} host_dma2d_job_t;
+
+static host_dma2d_job_t dma2d_job;
+
+static uint32_t dma2d_bpp(uint32_t mode)
+{
+    switch (mode) {
+    case DMA2D_INPUT_ARGB8888: return 4U;
+    case DMA2D_INPUT_RGB888:   return 3U;
+    default:                   return 2U;
+    }
+}
+
+static uint32_t dma2d_swap_rb(uint32_t argb)
+{
+    return (argb & 0xFF00FF00U) | ((argb >> 16) & 0xFFU) | ((argb & 0xFFU) << 16);
+}
+
+/* Input and output color mode codes are the same for these four formats */
+static uint32_t dma2d_read(const uint8_t *p, uint32_t mode)
+{
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+    uint32_t r, g, b;
+
+    switch (mode) {
+    case DMA2D_INPUT_ARGB8888:
+        return v | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    case DMA2D_INPUT_RGB888:
+        return 0xFF000000U | v | ((uint32_t)p[2] << 16);
+    case DMA2D_INPUT_RGB565:
+        r = v >> 11;
+        g = (v >> 5) & 0x3FU;
+        b = v & 0x1FU;
+        return 0xFF000000U | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+    default: /* ARGB4444 */
+        return (((v >> 12) & 0xFU) * 0x11U << 24) | (((v >> 8) & 0xFU) * 0x11U << 16) |
+               (((v >> 4) & 0xFU) * 0x11U << 8) | ((v & 0xFU) * 0x11U);
+    }
+}
+
+static void dma2d_write(uint8_t *p, uint32_t mode, uint32_t argb)
+{
+    uint32_t v;
+
+    switch (mode) {
+    case DMA2D_OUTPUT_ARGB8888:
+        v = argb;
+        break;
+    case DMA2D_OUTPUT_RGB888:
+        p[0] = (uint8_t)argb;
+        p[1] = (uint8_t)(argb >> 8);
+        p[2] = (uint8_t)(argb >> 16);
+        return;
+    case DMA2D_OUTPUT_RGB565:
+        v = (((argb >> 19) & 0x1FU) << 11) | (((argb >> 10) & 0x3FU) << 5) | ((argb >> 3) & 0x1FU);
+        break;
+    default: /* ARGB4444 */
+        v = ((argb >> 28) << 12) | (((argb >> 20) & 0xFU) << 8) | (((argb >> 12) & 0xFU) << 4) |
+            ((argb >> 4) & 0xFU);
+        break;
+    }
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    if (mode == DMA2D_OUTPUT_ARGB8888) {
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+}
+
+/** @brief Bytes from one line to the next for a line offset register */
+static uint32_t dma2d_pitch(uint32_t offset, uint32_t bpp)
+{
+    uint32_t line = dma2d_job.width * bpp;
+
+    return line + ((dma2d_job.init.LineOffsetMode == DMA2D_LOM_BYTES) ? offset : offset * bpp);
+}
+
+/** @brief Foreground or background pixel through its PFC (swap and alpha) */
+static uint32_t dma2d_layer_px(const DMA2D_LayerCfgTypeDef *cfg, uintptr_t base,
+                               uint32_t x, uint32_t y)
+{
+    uint32_t bpp = dma2d_bpp(cfg->InputColorMode);
+    const uint8_t *p = (const uint8_t *)base + y * dma2d_pitch(cfg->InputOffset, bpp) + x * bpp;
+    uint32_t c = dma2d_read(p, cfg->InputColorMode);
+    uint32_t a = c >> 24;
+
+    if (cfg->RedBlueSwap == DMA2D_RB_SWAP) {
+        c = dma2d_swap_rb(c);
+    }
+    if (cfg->AlphaMode == DMA2D_REPLACE_ALPHA) {
+        a = cfg->InputAlpha & 0xFFU;
+    } else if (cfg->AlphaMode == DMA2D_COMBINE_ALPHA) {
+        a = a * (cfg->InputAlpha & 0xFFU) / 255U;
+    }
+    return (a << 24) | (c & 0x00FFFFFFU);
+}
+
+static uint32_t dma2d_blend(uint32_t cf, uint32_t cb)
+{
+    uint32_t af = cf >> 24;
+    uint32_t ab = cb >> 24;
+    uint32_t am = af * ab / 255U;
+    uint32_t ao = af + ab - am;
+    uint32_t out = ao << 24;
+
+    if (ao != 0U) {
+        for (uint32_t sh = 0; sh < 24U; sh += 8U) {
+            out |= ((((cf >> sh) & 0xFFU) * af + ((cb >> sh) & 0xFFU) * ab -
+                     ((cb >> sh) & 0xFFU) * am) / ao) << sh;
+        }
+    }
+    return out;
+}
+
+/** @brief Run the latched transfer */
+static void dma2d_run(void)
+{
+    const host_dma2d_job_t *j = &dma2d_job;
+    uint32_t obpp = dma2d_bpp(j->init.ColorMode);
+    uint32_t opitch = dma2d_pitch(j->init.OutputOffset, obpp);
+
+    for (uint32_t y = 0; y < j->height; y++) {
+        uint8_t *d = (uint8_t *)j->dst + y * opitch;
+
+        for (uint32_t x = 0; x < j->width; x++, d += obpp) {
+            uint32_t c;
+
+            if (j->init.Mode == DMA2D_R2M) {
+                /* OCOLR already holds the output format: written as is */
+                uint32_t v = (uint32_t)j->fg;
+                memcpy(d, &v, obpp);
+                continue;
+            }
+            c = dma2d_layer_px(&j->layer[DMA2D_FOREGROUND_LAYER], j->fg, x, y);
+            if (j->init.Mode == DMA2D_M2M_BLEND) {
+                c = dma2d_blend(c, dma2d_layer_px(&j->layer[DMA2D_BACKGROUND_LAYER], j->bg, x, y));
+            }
+            if (j->init.RedBlueSwap == DMA2D_RB_SWAP) {
+                c = dma2d_swap_rb(c);
+            }
+            dma2d_write(d, j->init.ColorMode, c);
+        }
+    }
+}
+
+/* ========================================================================= */
+/* HAL API                                                                   */
+/* ========================================================================= */
+
+HAL_StatusTypeDef HAL_DMA2D_Init(DMA2D_HandleTypeDef *hdma2d)
+{
+    if (!hdma2d || dma2d_job.pending) {
+        return HAL_BUSY;
+    }
+    hdma2d->ErrorCode = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA2D_ConfigLayer(DMA2D_HandleTypeDef *hdma2d, uint32_t LayerIdx)
+{
+    if (!hdma2d || LayerIdx > DMA2D_FOREGROUND_LAYER || dma2d_job.pending) {
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef dma2d_start(DMA2D_HandleTypeDef *hdma2d, uintptr_t fg, uintptr_t bg,
+                                     uintptr_t dst, uint32_t width, uint32_t height)
+{
+    uint32_t color = (uint32_t)fg;
+
+    if (dma2d_job.pending) {
+        return HAL_BUSY;
+    }
+    dma2d_job.init = hdma2d->Init;
+    dma2d_job.layer[0] = hdma2d->LayerCfg[0];
+    dma2d_job.layer[1] = hdma2d->LayerCfg[1];
+    if (hdma2d->Init.Mode == DMA2D_R2M) {
+        /* As HAL_DMA2D_Start: ARGB8888 argument converted to OCOLR */
+        switch (hdma2d->Init.ColorMode) {
+        case DMA2D_OUTPUT_RGB888:
+            color &= 0x00FFFFFFU;
+            break;
+        case DMA2D_OUTPUT_RGB565:
+            color = (((color >> 19) & 0x1FU) << 11) | (((color >> 10) & 0x3FU) << 5) | ((color >> 3) & 0x1FU);
+            break;
+        case DMA2D_OUTPUT_ARGB4444:
+            color = ((color >> 28) << 12) | (((color >> 20) & 0xFU) << 8) |
+                    (((color >> 12) & 0xFU) << 4) | ((color >> 4) & 0xFU);
+            break;
+        default:
+            break;
+        }
+        fg = color;
+    }
+    dma2d_job.fg = fg;
+    dma2d_job.bg = bg;
+    dma2d_job.dst = dst;
+    dma2d_job.width = width;
+    dma2d_job.height = height;
+    dma2d_job.pending = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA2D_Start(DMA2D_HandleTypeDef *hdma2d, uintptr_t pdata, uintptr_t DstAddress,
+                                  uint32_t Width, uint32_t Height)
+{
+    return dma2d_start(hdma2d, pdata, 0, DstAddress, Width, Height);
+}
+
+HAL_StatusTypeDef HAL_DMA2D_BlendingStart(DMA2D_HandleTypeDef *hdma2d, uintptr_t SrcAddress1,
+                                          uintptr_t SrcAddress2, uintptr_t DstAddress,
+                                          uint32_t Width, uint32_t Height)
+{
+    return dma2d_start(hdma2d, SrcAddress1, SrcAddress2, DstAddress, Width, Height);
+}
+
+HAL_StatusTypeDef HAL_DMA2D_PollForTransfer(DMA2D_HandleTypeDef *hdma2d, uint32_t Timeout)
+{
+    (void)hdma2d;
+    (void)Timeout;
+    if (dma2d_job.pending) {
+        dma2d_run();
+        dma2d_job.pending = 0;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA2D_Abort(DMA2D_HandleTypeDef *hdma2d)
+{
+    (void)hdma2d;
+    dma2d_job.pending = 0;
+    return HAL_OK;
+}
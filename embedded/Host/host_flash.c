@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file    host_flash.c
+ * @author  PeleAB
+ * @brief   Host (Linux) stand-in for the NOR flash behind the gallery store
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "host_flash.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ========================================================================= */
+/* EMULATED STATE                                                            */
+/* ========================================================================= */
+
+static uint8_t *flash_base;
+static uint32_t flash_size;
+static uint32_t flash_ops;
+static uint32_t flash_erases;
+static int cut_armed;
+static int cut_done;
+static uint32_t cut_op;
+static uint32_t cut_bytes;
+
+/**
+ * @brief Bytes of the current call that land, counting it; 0 after a cut
+ */
+static uint32_t flash_budget(uint32_t size)
+{
+    const uint32_t op = flash_ops++;
+
+    if (cut_done) {
+        return 0;
+    }
+    if (cut_armed && op == cut_op) {
+        cut_done = 1;
+        return (cut_bytes < size) ? cut_bytes : size;
+    }
+    return size;
+}
+
+/* ========================================================================= */
+/* BACKEND                                                                   */
+/* ========================================================================= */
+
+static const uint8_t *host_flash_map(uint32_t size)
+{
+    if (!flash_base && host_flash_open(NULL, size) != 0) {
+        return NULL;
+    }
+    return (size <= flash_size) ? flash_base : NULL;
+}
+
+static int host_flash_erase(uint32_t offset)
+{
+    uint32_t n;
+
+    if (offset % GALLERY_STORE_SECTOR_SIZE != 0 || offset >= flash_size) {
+        return -1;
+    }
+    n = flash_budget(GALLERY_STORE_SECTOR_SIZE);
+    memset(flash_base + offset, 0xFF, n);
+    flash_erases += (n == GALLERY_STORE_SECTOR_SIZE);
+    return (n == GALLERY_STORE_SECTOR_SIZE) ? 0 : -1;
+}
+
+static int host_flash_program(uint32_t offset, const void *pData, uint32_t size)
+{
+    const uint8_t *src = pData;
+    uint32_t n;
+
+    if (offset > flash_size || size > flash_size - offset) {
+        return -1;
+    }
+    n = flash_budget(size);
+    for (uint32_t i = 0; i < n; i++) {
+        flash_base[offset + i] &= src[i];
+    }
+    return (n == size) ? 0 : -1;
+}
+
+const gallery_flash_t gallery_flash_host = {
+    .name = "host",
+    .map = host_flash_map,
+    .erase = host_flash_erase,
+    .program = host_flash_program,
+};
+
+/* ========================================================================= */
+/* CONTROL                                                                   */
+/* ========================================================================= */
+
+int host_flash_open(const char *path, uint32_t size)
+{
+    void *p;
+
+    host_flash_close();
+    if (path) {
+        const int fd = open(path, O_RDWR | O_CREAT, 0644);
+        struct stat st;
+
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return -1;
+        }
+        /* Extend with erased bytes */
+        for (off_t at = st.st_size; at < (off_t)size; ) {
+            uint8_t erased[4096];
+            const size_t n = ((off_t)size - at < (off_t)sizeof(erased)) ? (size_t)((off_t)size - at) :
+                                                                        sizeof(erased);
+
+            memset(erased, 0xFF, sizeof(erased));
+            if (pwrite(fd, erased, n, at) != (ssize_t)n) {
+                close(fd);
+                return -1;
+            }
+            at += (off_t)n;
+        }
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    } else {
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+            memset(p, 0xFF, size);
+        }
+    }
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    flash_base = p;
+    flash_size = size;
+    flash_ops = 0;
+    flash_erases = 0;
+    return 0;
+}
+
+void host_flash_close(void)
+{
+    if (flash_base) {
+        munmap(flash_base, flash_size);
+        flash_base = NULL;
+        flash_size = 0;
+    }
+}
+
+void host_flash_power_cut(uint32_t op, uint32_t bytes)
+{
+    cut_armed = 1;
+    cut_done = 0;
+    cut_op = op;
+    cut_bytes = bytes;
+}
+
+void host_flash_power_on(void)
+{
+    cut_armed = 0;
+    cut_done = 0;
+}
+
+int host_flash_is_cut(void)
+{
+    return cut_done;
+}
+
+uint32_t host_flash_ops(void)
+{
+    return flash_ops;
+}
+
+uint32_t host_flash_erases(void)
+{
+    return flash_erases;
+}
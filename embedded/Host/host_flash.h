@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @file    host_flash.h
+ * @author  PeleAB
+ * @brief   Host (Linux) stand-in for the NOR flash behind the gallery store
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * gallery_flash_host (gallery_store.h) backs the region with an mmap'd file, or anonymous
+ * memory, read in place like the XSPI memory-mapped window. Erase sets a
+ * sector to 0xFF and program ANDs the bytes in, as on NOR. A power cut can be
+ * armed on any erase or program call: only the first bytes of that call land,
+ * in address order, and every later call fails without effect until
+ * host_flash_power_on().
+ */
+
+#ifndef HOST_FLASH_H
+#define HOST_FLASH_H
+
+#include <stdint.h>
+#include "gallery_store.h"
+
+/**
+ * @brief Back the flash with a file (kept across runs), or with erased
+ *        anonymous memory if @p path is NULL
+ * @param size Region size; a new or shorter file is extended with 0xFF
+ * @return 0 on success, negative on error
+ * @note  Without a call, the first map() opens anonymous memory
+ */
+int host_flash_open(const char *path, uint32_t size);
+
+/** @brief Unmap the region (a reboot, for a file) */
+void host_flash_close(void);
+
+/**
+ * @brief Cut the power during an erase or program call
+ * @param op Call number, counted from 0 by host_flash_ops()
+ * @param bytes Bytes of that call that land
+ */
+void host_flash_power_cut(uint32_t op, uint32_t bytes);
+
+/** @brief Disarm the cut and bring the flash back */
+void host_flash_power_on(void);
+
+/** @brief 1 once an armed cut has happened */
+int host_flash_is_cut(void);
+
+/** @brief Erase and program calls since the region was opened */
+uint32_t host_flash_ops(void);
+
+/** @brief Sectors erased since the region was opened */
+uint32_t host_flash_erases(void);
+
+#endif /* HOST_FLASH_H */
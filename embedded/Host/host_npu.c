@@ -0,0 +1,452 @@
+/**
+ ******************************************************************************
+ * @file    host_npu.c
+ * @author  PeleAB
+ * @brief   Host (Linux) stand-in for the NPU runtime
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Buffer descriptors mirror Models/face_detection.c and face_recognition.c:
+ * same names, offsets, shapes and types, with each network's activation
+ * arena in host memory instead of NPU RAM. As on target, the detection
+ * outputs alias the start of the input buffer. With DETECTION_INPUT_UINT8_HWC
+ * the detection input is instead a user-allocated uint8 HWC tensor bound with
+ * LL_ATON_Set_User_Input_Buffer_face_detection(), as generated with
+ * --no-inputs-allocation. RECOGNITION_INPUT_USER_BUFFERS does the same for the
+ * recognition input, which stays float CHW.
+ *
+ * The LL_ATON_RT_* calls that nn_runner.c makes are implemented here, so the
+ * firmware scheduler runs unchanged. Each inference starts an epoch block and
+ * has to be waited for a configurable number of times (host_npu_set_wait_polls,
+ * 1 by default: it completes on the first RunNetworkAsync_Poll() after its
+ * start), then fills the outputs from the output source: canned tensors by
+ * default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "ll_aton_runtime.h"
+
+/* ========================================================================= */
+/* BUFFER DESCRIPTORS                                                        */
+/* ========================================================================= */
+
+#define HOST_NPU_MAX_OUTPUTS                4
+
+#define FD_ARENA_SIZE                       196672U
+#define FR_ARENA_SIZE                       150592U
+
+static uint8_t fd_arena[FD_ARENA_SIZE] __attribute__((aligned(32)));
+static uint8_t fr_arena[FR_ARENA_SIZE] __attribute__((aligned(32)));
+
+static const uint32_t fd_in_shape[] = { 1, 128, 128, 3 };
+static const uint32_t fd_in_mem_shape[] = { 1, 3, 128, 128 };
+static const uint32_t fd_shape_2[] = { 1, 32, 2, 32 };
+static const uint32_t fd_mem_shape_2[] = { 1, 32, 32, 2 };
+static const uint32_t fd_shape_10[] = { 1, 32, 10, 32 };
+static const uint32_t fd_mem_shape_10[] = { 1, 32, 32, 10 };
+static const uint32_t fd_shape_1[] = { 1, 32, 1, 32 };
+static const uint32_t fd_mem_shape_1[] = { 1, 32, 32, 1 };
+
+static const uint32_t fr_in_shape[] = { 1, 112, 112, 3 };
+static const uint32_t fr_in_mem_shape[] = { 1, 3, 112, 112 };
+static const uint32_t fr_out_shape[] = { 1, 1, 128, 1 };
+static const uint32_t fr_out_mem_shape[] = { 1, 128 };
+
+#define HOST_NPU_FLOAT_BUFFER(nm, arena, start, end, ms, mnd, cp, sh) \
+    { \
+        .name = (nm), \
+        .addr_base = { .p = (arena) }, \
+        .offset_start = (start), \
+        .offset_end = (end), \
+        .offset_limit = (end) + 64U, \
+        .batch = 1, \
+        .mem_shape = (ms), \
+        .mem_ndims = (mnd), \
+        .chpos = (cp), \
+        .type = DataType_FLOAT, \
+        .nbits = 32, \
+        .ndims = 4, \
+        .shape = (sh), \
+    }
+
+#ifdef DETECTION_INPUT_UINT8_HWC
+static unsigned char *fd_user_input;        /**< Bound input, read through addr_base */
+
+static const LL_Buffer_InfoTypeDef fd_inputs[] = {
+    {
+        .name = "Input_0_out_0",
+        .addr_base = { .p = (unsigned char *)&fd_user_input },
+        .offset_start = 0,
+        .offset_end = 49152,
+        .offset_limit = 49152 + 64U,
+        .is_user_allocated = 1,
+        .batch = 1,
+        .mem_shape = fd_in_shape,
+        .mem_ndims = 4,
+        .chpos = CHPos_Last,
+        .type = DataType_UINT8,
+        .nbits = 8,
+        .ndims = 4,
+        .shape = fd_in_shape,
+    },
+    { .name = NULL },
+};
+#else
+static const LL_Buffer_InfoTypeDef fd_inputs[] = {
+    HOST_NPU_FLOAT_BUFFER("Input_0_out_0", fd_arena, 0, 196608, fd_in_mem_shape, 4, CHPos_First, fd_in_shape),
+    { .name = NULL },
+};
+#endif
+
+/* Same order as the generated network: scale, landmarks, heatmap, offset */
+static const LL_Buffer_InfoTypeDef fd_outputs[] = {
+    HOST_NPU_FLOAT_BUFFER("Transpose_290_out_0", fd_arena, 98304, 106496, fd_mem_shape_2, 4, CHPos_First, fd_shape_2),
+    HOST_NPU_FLOAT_BUFFER("Transpose_282_out_0", fd_arena, 0, 40960, fd_mem_shape_10, 4, CHPos_First, fd_shape_10),
+    HOST_NPU_FLOAT_BUFFER("Transpose_297_out_0", fd_arena, 40960, 45056, fd_mem_shape_1, 4, CHPos_First, fd_shape_1),
+    HOST_NPU_FLOAT_BUFFER("Transpose_286_out_0", fd_arena, 90112, 98304, fd_mem_shape_2, 4, CHPos_First, fd_shape_2),
+    { .name = NULL },
+};
+
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+static unsigned char *fr_user_input;        /**< Bound input, read through addr_base */
+
+static const LL_Buffer_InfoTypeDef fr_inputs[] = {
+    {
+        .name = "Input_0_out_0",
+        .addr_base = { .p = (unsigned char *)&fr_user_input },
+        .offset_start = 0,
+        .offset_end = 150528,
+        .offset_limit = 150528 + 64U,
+        .is_user_allocated = 1,
+        .batch = 1,
+        .mem_shape = fr_in_mem_shape,
+        .mem_ndims = 4,
+        .chpos = CHPos_First,
+        .type = DataType_FLOAT,
+        .nbits = 32,
+        .ndims = 4,
+        .shape = fr_in_shape,
+    },
+    { .name = NULL },
+};
+#else
+static const LL_Buffer_InfoTypeDef fr_inputs[] = {
+    HOST_NPU_FLOAT_BUFFER("Input_0_out_0", fr_arena, 0, 150528, fr_in_mem_shape, 4, CHPos_First, fr_in_shape),
+    { .name = NULL },
+};
+#endif
+
+static const LL_Buffer_InfoTypeDef fr_outputs[] = {
+    HOST_NPU_FLOAT_BUFFER("BatchNormalization_289_out_0", fr_arena, 0, 512, fr_out_mem_shape, 2, CHPos_UNDEFINED, fr_out_shape),
+    { .name = NULL },
+};
+
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_detection);
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_recognition);
+
+NN_Instance_TypeDef NN_Instance_face_detection = { .network_name = "face_detection" };
+NN_Instance_TypeDef NN_Instance_face_recognition = { .network_name = "face_recognition" };
+
+const LL_Buffer_InfoTypeDef *LL_ATON_Input_Buffers_Info_face_detection(void)
+{
+    return fd_inputs;
+}
+
+const LL_Buffer_InfoTypeDef *LL_ATON_Output_Buffers_Info_face_detection(void)
+{
+    return fd_outputs;
+}
+
+const LL_Buffer_InfoTypeDef *LL_ATON_Input_Buffers_Info_face_recognition(void)
+{
+    return fr_inputs;
+}
+
+const LL_Buffer_InfoTypeDef *LL_ATON_Output_Buffers_Info_face_recognition(void)
+{
+    return fr_outputs;
+}
+
+LL_ATON_User_IO_Result_t LL_ATON_Set_User_Input_Buffer_face_detection(uint32_t num, void *buffer, uint32_t size)
+{
+#ifdef DETECTION_INPUT_UINT8_HWC
+    if (num != 0) {
+        return LL_ATON_User_IO_WRONG_INDEX;
+    }
+    if (size < LL_Buffer_len(&fd_inputs[0])) {
+        return LL_ATON_User_IO_WRONG_SIZE;
+    }
+    fd_user_input = buffer;
+    return LL_ATON_User_IO_NOERROR;
+#else
+    (void)num;
+    (void)buffer;
+    (void)size;
+    return LL_ATON_User_IO_WRONG_INDEX;
+#endif
+}
+
+void *LL_ATON_Get_User_Input_Buffer_face_detection(uint32_t num)
+{
+#ifdef DETECTION_INPUT_UINT8_HWC
+    return (num == 0) ? fd_user_input : NULL;
+#else
+    (void)num;
+    return NULL;
+#endif
+}
+
+LL_ATON_User_IO_Result_t LL_ATON_Set_User_Input_Buffer_face_recognition(uint32_t num, void *buffer, uint32_t size)
+{
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+    if (num != 0) {
+        return LL_ATON_User_IO_WRONG_INDEX;
+    }
+    if (size < LL_Buffer_len(&fr_inputs[0])) {
+        return LL_ATON_User_IO_WRONG_SIZE;
+    }
+    fr_user_input = buffer;
+    return LL_ATON_User_IO_NOERROR;
+#else
+    (void)num;
+    (void)buffer;
+    (void)size;
+    return LL_ATON_User_IO_WRONG_INDEX;
+#endif
+}
+
+void *LL_ATON_Get_User_Input_Buffer_face_recognition(uint32_t num)
+{
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+    return (num == 0) ? fr_user_input : NULL;
+#else
+    (void)num;
+    return NULL;
+#endif
+}
+
+/* ========================================================================= */
+/* CANNED OUTPUTS                                                            */
+/* ========================================================================= */
+
+typedef struct {
+    NN_Instance_TypeDef *inst;
+    const LL_Buffer_InfoTypeDef *inputs;
+    const LL_Buffer_InfoTypeDef *outputs;
+    uint8_t *canned[HOST_NPU_MAX_OUTPUTS];  /**< Loaded tensors, NULL = zeros */
+} host_network_t;
+
+static host_network_t networks[] = {
+    { &NN_Instance_face_detection, fd_inputs, fd_outputs, { NULL } },
+    { &NN_Instance_face_recognition, fr_inputs, fr_outputs, { NULL } },
+};
+
+#define NETWORK_COUNT                       (sizeof(networks) / sizeof(networks[0]))
+
+static host_npu_output_fn_t output_fn;
+static void *output_arg;
+
+static host_network_t *find_network(const NN_Instance_TypeDef *inst)
+{
+    for (uint32_t n = 0; n < NETWORK_COUNT; n++) {
+        if (networks[n].inst == inst) {
+            return &networks[n];
+        }
+    }
+    return NULL;
+}
+
+static void output_path(char *path, size_t size, const char *dir,
+                        const NN_Instance_TypeDef *inst, uint32_t index)
+{
+    snprintf(path, size, "%s/%s_out%u.bin", dir, inst->network_name, (unsigned int)index);
+}
+
+/**
+ * @brief Default output source: copy the loaded tensors
+ */
+static int canned_outputs(const NN_Instance_TypeDef *inst, const LL_Buffer_InfoTypeDef *inputs,
+                          const LL_Buffer_InfoTypeDef *outputs, void *arg)
+{
+    host_network_t *net = find_network(inst);
+
+    (void)inputs;
+    (void)arg;
+
+    if (!net) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < HOST_NPU_MAX_OUTPUTS && outputs[i].name != NULL; i++) {
+        if (net->canned[i]) {
+            memcpy(LL_Buffer_addr_start(&outputs[i]), net->canned[i], LL_Buffer_len(&outputs[i]));
+        } else {
+            memset(LL_Buffer_addr_start(&outputs[i]), 0, LL_Buffer_len(&outputs[i]));
+        }
+    }
+    return 0;
+}
+
+void host_npu_set_output_source(host_npu_output_fn_t fn, void *arg)
+{
+    output_fn = fn;
+    output_arg = arg;
+}
+
+int host_npu_load_dir(const char *dir)
+{
+    int loaded = 0;
+
+    for (uint32_t n = 0; n < NETWORK_COUNT; n++) {
+        host_network_t *net = &networks[n];
+
+        for (uint32_t i = 0; i < HOST_NPU_MAX_OUTPUTS && net->outputs[i].name != NULL; i++) {
+            uint32_t len = LL_Buffer_len(&net->outputs[i]);
+            char path[512];
+            FILE *f;
+            size_t got;
+
+            output_path(path, sizeof(path), dir, net->inst, i);
+            f = fopen(path, "rb");
+            if (!f) {
+                continue;
+            }
+            if (!net->canned[i]) {
+                net->canned[i] = malloc(len);
+                if (!net->canned[i]) {
+                    fclose(f);
+                    return -1;
+                }
+            }
+            got = fread(net->canned[i], 1, len, f);
+            fclose(f);
+            if (got != len) {
+                fprintf(stderr, "%s: expected %u bytes, got %u\n", path,
+                        (unsigned int)len, (unsigned int)got);
+                return -2;
+            }
+            loaded++;
+        }
+    }
+
+    return loaded;
+}
+
+int host_npu_save_outputs(const char *dir, const NN_Instance_TypeDef *inst,
+                          const uint8_t *const *data)
+{
+    host_network_t *net = find_network(inst);
+
+    if (!net) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < HOST_NPU_MAX_OUTPUTS && net->outputs[i].name != NULL; i++) {
+        char path[512];
+        FILE *f;
+        size_t put;
+
+        output_path(path, sizeof(path), dir, inst, i);
+        f = fopen(path, "wb");
+        if (!f) {
+            perror(path);
+            return -2;
+        }
+        put = fwrite(data[i], 1, LL_Buffer_len(&net->outputs[i]), f);
+        fclose(f);
+        if (put != LL_Buffer_len(&net->outputs[i])) {
+            return -3;
+        }
+    }
+    return 0;
+}
+
+/* ========================================================================= */
+/* RUNTIME                                                                   */
+/* ========================================================================= */
+
+static uint32_t wait_polls = 1U;
+
+void host_npu_set_wait_polls(uint32_t polls)
+{
+    wait_polls = polls;
+}
+
+void LL_ATON_RT_RuntimeInit(void)
+{
+}
+
+void LL_ATON_RT_RuntimeDeInit(void)
+{
+}
+
+/**
+ * @brief Complete an inference: fill the outputs from the output source
+ */
+static void host_npu_infer(NN_Instance_TypeDef *inst)
+{
+    host_network_t *net = find_network(inst);
+    host_npu_output_fn_t fn = output_fn ? output_fn : canned_outputs;
+
+    inst->inferences++;
+    if (!net) {
+        return;
+    }
+    if (fn(inst, net->inputs, net->outputs, output_arg) != 0) {
+        for (uint32_t i = 0; i < HOST_NPU_MAX_OUTPUTS && net->outputs[i].name != NULL; i++) {
+            memset(LL_Buffer_addr_start(&net->outputs[i]), 0, LL_Buffer_len(&net->outputs[i]));
+        }
+    }
+}
+
+void LL_ATON_RT_Init_Network(NN_Instance_TypeDef *nn_instance)
+{
+    nn_instance->initialized = 1;
+    nn_instance->running = 1;
+    nn_instance->steps_left = 2U * wait_polls;
+    nn_instance->inits++;
+}
+
+void LL_ATON_RT_DeInit_Network(NN_Instance_TypeDef *nn_instance)
+{
+    nn_instance->initialized = 0;
+    nn_instance->running = 0;
+}
+
+void LL_ATON_RT_Reset_Network(NN_Instance_TypeDef *nn_instance)
+{
+    if (!nn_instance->initialized) {
+        return;
+    }
+    nn_instance->running = 1;
+    nn_instance->steps_left = 2U * wait_polls;
+    nn_instance->resets++;
+}
+
+/**
+ * @brief Each wait is one epoch block that starts (NO_WFE) and is still
+ *        running on the next call (WFE); the call after the last wait runs
+ *        the inference and reports DONE
+ */
+LL_ATON_RT_RetValues_t LL_ATON_RT_RunEpochBlock(NN_Instance_TypeDef *nn_instance)
+{
+    if (!nn_instance->running) {
+        return LL_ATON_RT_DONE;
+    }
+    if (nn_instance->steps_left > 0) {
+        return (nn_instance->steps_left-- % 2U == 0) ? LL_ATON_RT_NO_WFE : LL_ATON_RT_WFE;
+    }
+    host_npu_infer(nn_instance);
+    nn_instance->running = 0;
+    return LL_ATON_RT_DONE;
+}
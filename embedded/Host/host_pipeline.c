@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * @file    host_pipeline.c
+ * @author  PeleAB
+ * @brief   Host (Linux) entry points into the firmware main loop stages
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * The pipeline stages are static in main.c, so main.c is compiled as part of
+ * this file rather than copied: the host runs exactly the firmware frame path
+ * (app_init, app_pipeline_start, app_process_frame) minus the endless loop.
+ */
+
+#define main firmware_main
+#include "../Src/main.c"
+#undef main
+
+#include "host.h"
+
+/* ========================================================================= */
+/* PRIVATE DATA                                                              */
+/* ========================================================================= */
+
+static uint32_t host_pitch_nn;
+static uint32_t host_boot_time;
+
+/* ========================================================================= */
+/* IMPLEMENTATION FUNCTIONS                                                  */
+/* ========================================================================= */
+
+int host_pipeline_init(void)
+{
+    int ret = app_init(&g_app_ctx);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = app_pipeline_start(&g_app_ctx, &host_pitch_nn);
+    if (ret < 0) {
+        return ret;
+    }
+
+    host_boot_time = HAL_GetTick();
+    return 0;
+}
+
+void host_pipeline_set_overlap(int overlap)
+{
+    g_app_ctx.recognition_overlap = (overlap != 0);
+}
+
+int host_pipeline_run_frame(void)
+{
+    return app_process_frame(&g_app_ctx, host_pitch_nn, host_boot_time);
+}
+
+void host_pipeline_get_result(host_frame_result_t *res)
+{
+    const app_context_t *ctx = &g_app_ctx;
+    const pd_pp_box_t *boxes = (const pd_pp_box_t *)ctx->pp_output.pOutData;
+
+    memset(res, 0, sizeof(*res));
+    res->face_nb = ctx->pp_output.box_nb;
+    for (uint32_t i = 0; i < res->face_nb && i < AI_PD_MODEL_PP_MAX_BOXES_LIMIT; i++) {
+        host_face_t *f = &res->faces[i];
+
+        f->score = boxes[i].prob;
+        f->x_center = boxes[i].x_center;
+        f->y_center = boxes[i].y_center;
+        f->width = boxes[i].width;
+        f->height = boxes[i].height;
+        f->nb_kps = boxes[i].nb_kps;
+        for (uint32_t k = 0; k < f->nb_kps && k < AI_PD_MODEL_PP_NB_KEYPOINTS; k++) {
+            f->kps[k][0] = boxes[i].pKps[k].x;
+            f->kps[k][1] = boxes[i].pKps[k].y;
+        }
+    }
+
+    res->best_similarity = ctx->current_similarity;
+    res->face_detected = ctx->face_detected;
+    res->target_this_frame = ctx->target_detection_history[(ctx->history_index + 4U) % 5U];
+    res->target_detected = ctx->target_detected;
+    res->face_verified = ctx->face_verified;
+    res->timing = ctx->timing;
+}
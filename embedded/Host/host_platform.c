@@ -0,0 +1,355 @@
+/**
+ ******************************************************************************
+ * @file    host_platform.c
+ * @author  PeleAB
+ * @brief   Host (Linux) stand-ins for HAL, BSP, LCD and camera services
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Time comes from CLOCK_MONOTONIC. UART output is counted and can be captured
+ * to a file; the CRC unit is emulated in software with the reset
+ * configuration used by the enhanced PC stream. Drawing calls are no-ops.
+ *
+ * The camera has no thread of its own: host_camera_push_frame() writes a
+ * frame into the buffer DCMIPP would fill next and raises the frame event,
+ * so the firmware double-buffer handoff runs unchanged.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "app_config.h"
+#include "app_constants.h"
+#include "app_cam.h"
+#include "app_system.h"
+#include "frame_dbuf.h"
+#include "stm32n6570_discovery.h"
+#include "stm32_lcd.h"
+
+/* ========================================================================= */
+/* CORE                                                                      */
+/* ========================================================================= */
+
+uint32_t SystemCoreClock = 800000000UL;
+
+uint32_t HAL_GetTick(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U);
+}
+
+void HAL_Delay(uint32_t ms)
+{
+    struct timespec ts = { .tv_sec = ms / 1000U, .tv_nsec = (long)(ms % 1000U) * 1000000L };
+
+    nanosleep(&ts, NULL);
+}
+
+void App_SystemInit(void)
+{
+}
+
+/* ========================================================================= */
+/* BSP: LEDS, BUTTON, COM                                                    */
+/* ========================================================================= */
+
+UART_HandleTypeDef hcom_uart[COMn];
+
+static int led_state[LEDn];
+static FILE *uart_capture;
+static uint64_t uart_bytes;
+
+int32_t BSP_LED_Init(Led_TypeDef led)
+{
+    led_state[led] = 0;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LED_On(Led_TypeDef led)
+{
+    led_state[led] = 1;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LED_Off(Led_TypeDef led)
+{
+    led_state[led] = 0;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LED_Toggle(Led_TypeDef led)
+{
+    led_state[led] ^= 1;
+    return BSP_ERROR_NONE;
+}
+
+int host_led_state(uint32_t led)
+{
+    return (led < LEDn) ? led_state[led] : 0;
+}
+
+int32_t BSP_PB_Init(Button_TypeDef button, ButtonMode_TypeDef mode)
+{
+    (void)button;
+    (void)mode;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_PB_GetState(Button_TypeDef button)
+{
+    (void)button;
+    return 0;
+}
+
+int32_t BSP_COM_Init(COM_TypeDef com, MX_UART_InitTypeDef *init)
+{
+    (void)com;
+    (void)init;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_COM_SelectLogPort(COM_TypeDef com)
+{
+    (void)com;
+    return BSP_ERROR_NONE;
+}
+
+void host_uart_capture(FILE *file)
+{
+    uart_capture = file;
+}
+
+uint64_t host_uart_bytes(void)
+{
+    return uart_bytes;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data,
+                                    uint16_t size, uint32_t timeout)
+{
+    (void)huart;
+    (void)timeout;
+
+    uart_bytes += size;
+    if (uart_capture) {
+        fwrite(data, 1, size, uart_capture);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data,
+                                   uint16_t size, uint32_t timeout)
+{
+    (void)huart;
+    (void)data;
+    (void)size;
+    (void)timeout;
+    return HAL_TIMEOUT;
+}
+
+/* ========================================================================= */
+/* CRC                                                                       */
+/* ========================================================================= */
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc)
+{
+    (void)hcrc;
+    return HAL_OK;
+}
+
+/**
+ * @brief CRC unit emulation: polynomial 0x04C11DB7, init 0xFFFFFFFF, 32-bit
+ *        words fed MSB first, no input or output inversion
+ */
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t *data, uint32_t words)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+
+    (void)hcrc;
+
+    for (uint32_t i = 0; i < words; i++) {
+        uint32_t w;
+
+        memcpy(&w, &data[i], sizeof(w));
+        crc ^= w;
+        for (int bit = 0; bit < 32; bit++) {
+            crc = (crc & 0x80000000U) ? (crc << 1) ^ 0x04C11DB7U : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* ========================================================================= */
+/* LCD                                                                       */
+/* ========================================================================= */
+
+sFONT Font20 = { .table = NULL, .Width = 14, .Height = 20 };
+LTDC_HandleTypeDef hlcd_ltdc;
+const LCD_UTILS_Drv_t LCD_Driver;
+
+static sFONT *lcd_font = &Font20;
+
+int32_t BSP_LCD_Init(uint32_t instance, uint32_t orientation)
+{
+    (void)instance;
+    (void)orientation;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LCD_ConfigLayer(uint32_t instance, uint32_t layer, BSP_LCD_LayerConfig_t *config)
+{
+    (void)instance;
+    (void)layer;
+    (void)config;
+    return BSP_ERROR_NONE;
+}
+
+HAL_StatusTypeDef HAL_LTDC_SetAddress_NoReload(LTDC_HandleTypeDef *hltdc, uint32_t address, uint32_t layer)
+{
+    (void)hltdc;
+    (void)address;
+    (void)layer;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_LTDC_ReloadLayer(LTDC_HandleTypeDef *hltdc, uint32_t type, uint32_t layer)
+{
+    (void)hltdc;
+    (void)type;
+    (void)layer;
+    return HAL_OK;
+}
+
+void UTIL_LCD_SetFuncDriver(const LCD_UTILS_Drv_t *driver) { (void)driver; }
+void UTIL_LCD_SetLayer(uint32_t layer) { (void)layer; }
+void UTIL_LCD_SetFont(sFONT *font) { lcd_font = font; }
+sFONT *UTIL_LCD_GetFont(void) { return lcd_font; }
+void UTIL_LCD_SetTextColor(uint32_t color) { (void)color; }
+void UTIL_LCD_SetBackColor(uint32_t color) { (void)color; }
+void UTIL_LCD_Clear(uint32_t color) { (void)color; }
+
+void UTIL_LCD_FillRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t color)
+{
+    (void)x; (void)y; (void)width; (void)height; (void)color;
+}
+
+void UTIL_LCD_DrawRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t color)
+{
+    (void)x; (void)y; (void)width; (void)height; (void)color;
+}
+
+void UTIL_LCD_DrawLine(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t color)
+{
+    (void)x1; (void)y1; (void)x2; (void)y2; (void)color;
+}
+
+void UTIL_LCD_SetPixel(uint32_t x, uint32_t y, uint32_t color)
+{
+    (void)x; (void)y; (void)color;
+}
+
+void UTIL_LCD_DisplayStringAt(uint32_t x, uint32_t y, uint8_t *text, Text_AlignModeTypdef mode)
+{
+    (void)x; (void)y; (void)text; (void)mode;
+}
+
+void UTIL_LCD_DisplayStringAtLine(uint32_t line, uint8_t *text)
+{
+    (void)line; (void)text;
+}
+
+/* ========================================================================= */
+/* CAMERA                                                                    */
+/* ========================================================================= */
+
+static frame_dbuf_t *nn_pipe;
+static uint8_t *display_pipe;
+static uint32_t nn_pitch;
+static uint32_t display_width;
+static uint32_t display_height;
+
+void CAM_Init(uint32_t *lcd_bg_width, uint32_t *lcd_bg_height, uint32_t *pitch_nn)
+{
+    display_width = HOST_CAMERA_WIDTH;
+    display_height = HOST_CAMERA_HEIGHT;
+    nn_pitch = DCMIPP_OUT_NN_PITCH;
+
+    *lcd_bg_width = display_width;
+    *lcd_bg_height = display_height;
+    *pitch_nn = nn_pitch;
+}
+
+void CAM_DeInit(void)
+{
+    nn_pipe = NULL;
+    display_pipe = NULL;
+}
+
+void CAM_Start(void)
+{
+}
+
+void CAM_DisplayPipe_Start(uint8_t *display_pipe_dst, uint32_t cam_mode)
+{
+    (void)cam_mode;
+    display_pipe = display_pipe_dst;
+}
+
+void CAM_DisplayPipe_Stop(void)
+{
+}
+
+void CAM_NNPipe_Start(uint8_t *nn_pipe_dst, uint32_t cam_mode)
+{
+    (void)nn_pipe_dst;
+    (void)cam_mode;
+}
+
+void CAM_NNPipe_DoubleBufferStart(frame_dbuf_t *dbuf, uint8_t *buf0, uint8_t *buf1)
+{
+    frame_dbuf_init(dbuf, buf0, buf1, NULL);
+    nn_pipe = dbuf;
+}
+
+void CAM_IspUpdate(void)
+{
+}
+
+int host_camera_push_frame(const uint8_t *nn_rgb, const uint16_t *display565)
+{
+    uint8_t *dst;
+
+    if (!nn_pipe) {
+        return -1;
+    }
+    /* Stopped, as DCMIPP would be, rather than write into the held buffer */
+    if (nn_pipe->suspended && nn_pipe->hw_index == nn_pipe->held_index) {
+        return -1;
+    }
+
+    if (display565 && display_pipe) {
+        memcpy(display_pipe, display565, (size_t)display_width * display_height * 2U);
+    }
+
+    /* Row padding gets a pattern no kernel should ever read */
+    dst = nn_pipe->buffers[nn_pipe->hw_index];
+    for (uint32_t y = 0; y < NN_HEIGHT; y++) {
+        memcpy(dst + y * nn_pitch, nn_rgb + y * NN_WIDTH * NN_BPP, NN_WIDTH * NN_BPP);
+        memset(dst + y * nn_pitch + NN_WIDTH * NN_BPP, 0xA5, nn_pitch - NN_WIDTH * NN_BPP);
+    }
+    frame_dbuf_on_frame_event(nn_pipe);
+
+    return 0;
+}
@@ -0,0 +1,298 @@
+/**
+ ******************************************************************************
+ * @file    index_build.c
+ * @author  PeleAB
+ * @brief   Host tools: offline build of a gallery index image
+ ******************************************************************************
+ *
+ * The coarse centroids come from spherical k-means on the unit templates
+ * (assignment by the largest dot product, centroid = normalized mean), so
+ * that the device probes lists with the same dot product. The residual of
+ * each template to its centroid is split into sub-vectors, and each
+ * sub-space gets its own k-means (Euclidean) of GALLERY_INDEX_CODES
+ * sub-centroids. Both train on an evenly strided sample of the templates;
+ * empty clusters keep their previous center. Everything is deterministic.
+ */
+
+#include "index_build.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "app_constants.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define COARSE_TRAIN_PER_LIST               32U
+#define COARSE_ITERATIONS                   10U
+#define PQ_TRAIN_PER_CODE                   32U
+#define PQ_ITERATIONS                       8U
+
+/* ========================================================================= */
+/* K-MEANS                                                                   */
+/* ========================================================================= */
+
+static float32_t dot(const float32_t *a, const float32_t *b, uint32_t n)
+{
+    float32_t acc = 0.0f;
+
+    for (uint32_t d = 0; d < n; d++) {
+        acc += a[d] * b[d];
+    }
+    return acc;
+}
+
+static float32_t dist2(const float32_t *a, const float32_t *b, uint32_t n)
+{
+    float32_t acc = 0.0f;
+
+    for (uint32_t d = 0; d < n; d++) {
+        const float32_t e = a[d] - b[d];
+
+        acc += e * e;
+    }
+    return acc;
+}
+
+/**
+ * @brief Nearest center: largest dot product (spherical) or smallest distance
+ */
+static uint32_t nearest(const float32_t *v, const float32_t *pCenters, uint32_t centers,
+                        uint32_t n, int spherical)
+{
+    uint32_t best = 0;
+    float32_t best_value = 0.0f;
+
+    for (uint32_t c = 0; c < centers; c++) {
+        const float32_t value = spherical ? -dot(v, &pCenters[c * n], n) : dist2(v, &pCenters[c * n], n);
+
+        if (c == 0 || value < best_value) {
+            best = c;
+            best_value = value;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief k-means of the @p count vectors at pData (@p stride floats apart,
+ *        n used), on at most @p train of them
+ */
+static int kmeans(const float32_t *pData, uint32_t count, uint32_t stride, uint32_t n,
+                  float32_t *pCenters, uint32_t centers, uint32_t train, uint32_t iterations,
+                  int spherical)
+{
+    const uint32_t samples = (count < train) ? count : train;
+    double *sum = malloc((size_t)centers * n * sizeof(double));
+    uint32_t *members = malloc(centers * sizeof(uint32_t));
+
+    if (!sum || !members) {
+        free(sum);
+        free(members);
+        return -1;
+    }
+    /* Evenly spaced samples as the first centers */
+    for (uint32_t c = 0; c < centers; c++) {
+        const uint64_t s = ((uint64_t)c * samples / centers) % samples;
+
+        memcpy(&pCenters[c * n], &pData[(s * count / samples) * stride], n * sizeof(float32_t));
+    }
+    for (uint32_t it = 0; it < iterations; it++) {
+        memset(sum, 0, (size_t)centers * n * sizeof(double));
+        memset(members, 0, centers * sizeof(uint32_t));
+        for (uint32_t s = 0; s < samples; s++) {
+            const float32_t *v = &pData[((uint64_t)s * count / samples) * stride];
+            const uint32_t c = nearest(v, pCenters, centers, n, spherical);
+
+            for (uint32_t d = 0; d < n; d++) {
+                sum[c * n + d] += v[d];
+            }
+            members[c]++;
+        }
+        for (uint32_t c = 0; c < centers; c++) {
+            double norm = 0.0;
+
+            if (members[c] == 0) {
+                continue;
+            }
+            for (uint32_t d = 0; d < n; d++) {
+                norm += sum[c * n + d] * sum[c * n + d];
+            }
+            norm = spherical ? sqrt(norm) : members[c];
+            for (uint32_t d = 0; d < n; d++) {
+                pCenters[c * n + d] = (norm > 0.0) ? (float32_t)(sum[c * n + d] / norm) : 0.0f;
+            }
+        }
+    }
+    free(sum);
+    free(members);
+    return 0;
+}
+
+/* ========================================================================= */
+/* IMAGE                                                                     */
+/* ========================================================================= */
+
+/* Same CRC-32 as config_manager_calculate_crc */
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t table[256];
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c & 1) ? (c >> 1) ^ PROTOCOL_CRC32_POLYNOMIAL : c >> 1;
+        }
+        table[i] = c;
+    }
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xFFU];
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static uint32_t align4(uint32_t offset)
+{
+    return (offset + 3U) & ~3U;
+}
+
+/** @brief Work buffers of one build */
+typedef struct {
+    float32_t *unit;                        /**< Unit templates */
+    float32_t *residual;                    /**< Template minus its centroid */
+    uint32_t *list;                         /**< List of each template */
+    uint32_t *order;                        /**< Templates in image order */
+    uint32_t *fill;                         /**< List starts */
+} build_work_t;
+
+/**
+ * @brief Train, encode and lay out every section after the header
+ */
+static int build_sections(const gallery_index_header_t *pHeader, const float32_t *pEmb,
+                          const uint16_t *pIdentity, build_work_t *w, uint8_t *image)
+{
+    const uint32_t lists = pHeader->lists;
+    const uint32_t templates = pHeader->templates;
+    float32_t *centroids = (float32_t *)(image + pHeader->centroids);
+    float32_t *codebooks = (float32_t *)(image + pHeader->codebooks);
+
+    for (uint32_t t = 0; t < templates; t++) {
+        if (face_gallery_normalize(&pEmb[(size_t)t * EMBEDDING_SIZE],
+                                   &w->unit[(size_t)t * EMBEDDING_SIZE]) == 0.0f) {
+            return -1;
+        }
+    }
+
+    /* Coarse centroids and lists */
+    if (kmeans(w->unit, templates, EMBEDDING_SIZE, EMBEDDING_SIZE, centroids, lists,
+               lists * COARSE_TRAIN_PER_LIST, COARSE_ITERATIONS, 1) != 0) {
+        return -1;
+    }
+    for (uint32_t t = 0; t < templates; t++) {
+        const float32_t *u = &w->unit[(size_t)t * EMBEDDING_SIZE];
+        const float32_t *c;
+
+        w->list[t] = nearest(u, centroids, lists, EMBEDDING_SIZE, 1);
+        c = &centroids[w->list[t] * EMBEDDING_SIZE];
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            w->residual[(size_t)t * EMBEDDING_SIZE + d] = u[d] - c[d];
+        }
+        w->fill[w->list[t] + 1U]++;
+    }
+
+    /* Sub-centroids of each slice of the residuals */
+    for (uint32_t m = 0; m < GALLERY_INDEX_SUBSPACES; m++) {
+        if (kmeans(&w->residual[m * GALLERY_INDEX_SUBDIM], templates, EMBEDDING_SIZE, GALLERY_INDEX_SUBDIM,
+                   &codebooks[m * GALLERY_INDEX_CODES * GALLERY_INDEX_SUBDIM], GALLERY_INDEX_CODES,
+                   GALLERY_INDEX_CODES * PQ_TRAIN_PER_CODE, PQ_ITERATIONS, 0) != 0) {
+            return -1;
+        }
+    }
+
+    /* Templates in list order, enrollment order within a list */
+    for (uint32_t l = 0; l < lists; l++) {
+        w->fill[l + 1U] += w->fill[l];
+    }
+    memcpy(image + pHeader->list_start, w->fill, (lists + 1U) * sizeof(uint32_t));
+    for (uint32_t t = 0; t < templates; t++) {
+        w->order[w->fill[w->list[t]]++] = t;
+    }
+    for (uint32_t i = 0; i < templates; i++) {
+        const uint32_t t = w->order[i];
+        uint8_t *pCode = image + pHeader->codes + i * GALLERY_INDEX_SUBSPACES;
+        float32_t scale;
+
+        for (uint32_t m = 0; m < GALLERY_INDEX_SUBSPACES; m++) {
+            pCode[m] = (uint8_t)nearest(&w->residual[(size_t)t * EMBEDDING_SIZE + m * GALLERY_INDEX_SUBDIM],
+                                        &codebooks[m * GALLERY_INDEX_CODES * GALLERY_INDEX_SUBDIM],
+                                        GALLERY_INDEX_CODES, GALLERY_INDEX_SUBDIM, 0);
+        }
+        memcpy(image + pHeader->identity + i * sizeof(uint16_t), &pIdentity[t], sizeof(uint16_t));
+        /* As face_gallery_add on int8 templates */
+        scale = face_gallery_quantize(&pEmb[(size_t)t * EMBEDDING_SIZE],
+                                      (int8_t *)(image + pHeader->rows) + (size_t)i * EMBEDDING_SIZE);
+        memcpy(image + pHeader->scale + i * sizeof(float32_t), &scale, sizeof(float32_t));
+    }
+    return 0;
+}
+
+uint8_t *index_build(const float32_t *pEmb, const uint16_t *pIdentity, uint32_t templates,
+                     uint32_t lists, uint32_t *pSize)
+{
+    gallery_index_header_t h;
+    build_work_t w;
+    uint8_t *image;
+
+    if (!pEmb || !pIdentity || !pSize || templates == 0 || templates > UINT32_MAX / 256U) {
+        return NULL;
+    }
+    if (lists == 0) {
+        lists = (uint32_t)lrint(sqrt((double)templates));
+    }
+    if (lists > templates) {
+        lists = templates;
+    }
+    if (lists > GALLERY_INDEX_MAX_LISTS) {
+        lists = GALLERY_INDEX_MAX_LISTS;
+    }
+
+    memset(&h, 0, sizeof(h));
+    h.magic = GALLERY_INDEX_MAGIC;
+    h.version = GALLERY_INDEX_VERSION;
+    h.lists = lists;
+    h.templates = templates;
+    h.centroids = sizeof(h);
+    h.codebooks = h.centroids + lists * EMBEDDING_SIZE * sizeof(float32_t);
+    h.list_start = h.codebooks + GALLERY_INDEX_SUBSPACES * GALLERY_INDEX_CODES *
+                                 GALLERY_INDEX_SUBDIM * sizeof(float32_t);
+    h.codes = h.list_start + (lists + 1U) * sizeof(uint32_t);
+    h.identity = align4(h.codes + templates * GALLERY_INDEX_SUBSPACES);
+    h.scale = align4(h.identity + templates * sizeof(uint16_t));
+    h.rows = h.scale + templates * sizeof(float32_t);
+    h.size = align4(h.rows + templates * EMBEDDING_SIZE);
+
+    w.unit = malloc((size_t)templates * EMBEDDING_SIZE * sizeof(float32_t));
+    w.residual = malloc((size_t)templates * EMBEDDING_SIZE * sizeof(float32_t));
+    w.list = malloc(templates * sizeof(uint32_t));
+    w.order = malloc(templates * sizeof(uint32_t));
+    w.fill = calloc(lists + 1U, sizeof(uint32_t));
+    image = calloc(1, h.size);
+    if (!w.unit || !w.residual || !w.list || !w.order || !w.fill || !image ||
+        build_sections(&h, pEmb, pIdentity, &w, image) != 0) {
+        free(image);
+        image = NULL;
+    } else {
+        h.crc = crc32(image + sizeof(h), h.size - sizeof(h));
+        memcpy(image, &h, sizeof(h));
+        *pSize = h.size;
+    }
+    free(w.unit);
+    free(w.residual);
+    free(w.list);
+    free(w.order);
+    free(w.fill);
+    return image;
+}
@@ -0,0 +1,26 @@
+/**
+ ******************************************************************************
+ * @file    index_build.h
+ * @author  PeleAB
+ * @brief   Host tools: offline build of a gallery index image
+ ******************************************************************************
+ */
+
+#ifndef HOST_INDEX_BUILD_H
+#define HOST_INDEX_BUILD_H
+
+#include "gallery_index.h"
+
+/**
+ * @brief Train the coarse centroids and sub-centroids on the templates
+ *        (k-means) and write the image that gallery_index_open reads
+ * @param pEmb templates x EMBEDDING_SIZE floats, any norm, none zero
+ * @param pIdentity Owner of each template
+ * @param lists Coarse centroids, 0 for about the square root of templates
+ * @param pSize Image bytes
+ * @return Image (malloc), NULL on error
+ */
+uint8_t *index_build(const float32_t *pEmb, const uint16_t *pIdentity, uint32_t templates,
+                     uint32_t lists, uint32_t *pSize);
+
+#endif /* HOST_INDEX_BUILD_H */
@@ -0,0 +1,303 @@
+/**
+ ******************************************************************************
+ * @file    index_check.c
+ * @author  PeleAB
+ * @brief   Host tool: gallery index checks against the exhaustive int8 search
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: index_check
+ *
+ * Images are built with index_build (index_build.c) from random identities
+ * and searched with gallery_index (Src/gallery_index.c). When every list is
+ * probed and the gallery is no larger than the shortlist, the matches must
+ * be exactly those of face_gallery_search on an int8 gallery holding the
+ * same templates, scores included, and open must note their identity
+ * range. On a larger gallery, probing every list
+ * must still find the exhaustive top-1 for queries near a template, and a
+ * search spread over steps of any budget must end as the one-call search.
+ * Images that are truncated, corrupt or inconsistent are rejected, as are
+ * a zero query and k = 0; the probe count is clipped to the lists.
+ * Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gallery_index.h"
+#include "index_build.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define SMALL_TEMPLATES                     40U
+#define SMALL_IDENTITIES                    10U
+#define SMALL_LISTS                         4U
+#define LARGE_IDENTITIES                    1000U
+#define LARGE_PER_IDENTITY                  3U
+#define LARGE_QUERIES                       200U
+#define MAX_K                               8U
+
+static const uint32_t step_budgets[] = { 1, 13, 100, 1000 };
+
+static gallery_index_search_t search;
+static uint32_t rng_state = 1U;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+static int report(const char *name, int ok)
+{
+    printf("   %-34s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/**
+ * @brief Identities of random centers, each template the center plus noise
+ */
+static void make_templates(float32_t *pEmb, uint16_t *pIdentity, uint32_t identities,
+                           uint32_t per_identity)
+{
+    for (uint32_t i = 0; i < identities; i++) {
+        float32_t center[EMBEDDING_SIZE];
+
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            center[d] = rnd();
+        }
+        for (uint32_t f = 0; f < per_identity; f++) {
+            const uint32_t t = i * per_identity + f;
+
+            for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+                pEmb[t * EMBEDDING_SIZE + d] = center[d] + 0.5f * rnd();
+            }
+            pIdentity[t] = (uint16_t)i;
+        }
+    }
+}
+
+/**
+ * @brief Unit query near template @p t
+ */
+static void make_query(const float32_t *pEmb, uint32_t t, float32_t noise, float32_t *pQuery)
+{
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        pQuery[d] = pEmb[t * EMBEDDING_SIZE + d] + noise * rnd();
+    }
+    (void)face_gallery_normalize(pQuery, pQuery);
+}
+
+static int same_matches(const face_gallery_match_t *a, uint32_t nb_a,
+                        const face_gallery_match_t *b, uint32_t nb_b)
+{
+    if (nb_a != nb_b) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < nb_a; i++) {
+        if (a[i].identity != b[i].identity || a[i].score != b[i].score) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+static int check_small(void)
+{
+    float32_t emb[SMALL_TEMPLATES * EMBEDDING_SIZE];
+    uint16_t identity[SMALL_TEMPLATES];
+    int8_t rows[FACE_GALLERY_STORAGE_Q7(SMALL_TEMPLATES)];
+    float32_t scale[SMALL_TEMPLATES];
+    uint16_t owner[SMALL_TEMPLATES];
+    face_gallery_t gallery;
+    gallery_index_t index;
+    uint32_t size;
+    uint8_t *image;
+    int ok = 1;
+
+    rng_state = 3U;
+    make_templates(emb, identity, SMALL_IDENTITIES, SMALL_TEMPLATES / SMALL_IDENTITIES);
+    image = index_build(emb, identity, SMALL_TEMPLATES, SMALL_LISTS, &size);
+    (void)face_gallery_init_q7(&gallery, rows, scale, owner, SMALL_TEMPLATES);
+    for (uint32_t t = 0; t < SMALL_TEMPLATES; t++) {
+        (void)face_gallery_add(&gallery, identity[t], &emb[t * EMBEDDING_SIZE]);
+    }
+    if (!image || gallery_index_open(&index, image, size) != GALLERY_INDEX_OK ||
+        index.lists != SMALL_LISTS || index.templates != SMALL_TEMPLATES ||
+        index.identity_min != 0 || index.identity_max != SMALL_IDENTITIES - 1U) {
+        free(image);
+        return report("all lists, exhaustive int8", 0);
+    }
+
+    for (uint32_t q = 0; q < 2U * SMALL_TEMPLATES; q++) {
+        face_gallery_match_t m[MAX_K], ref[MAX_K];
+        float32_t query[EMBEDDING_SIZE];
+        /* Near a template, then unrelated */
+        const float32_t noise = (q < SMALL_TEMPLATES) ? 0.5f : 100.0f;
+
+        make_query(emb, q % SMALL_TEMPLATES, noise, query);
+        for (uint32_t k = 1; k <= MAX_K; k += 3) {
+            const uint32_t nb = gallery_index_search(&index, &search, query, SMALL_LISTS, m, k);
+
+            ok &= same_matches(m, nb, ref, face_gallery_search(&gallery, query, ref, k));
+            ok &= (search.scanned == SMALL_TEMPLATES);
+        }
+    }
+    free(image);
+    return report("all lists, exhaustive int8", ok);
+}
+
+/**
+ * @return Number of failed cases
+ */
+static int check_large(void)
+{
+    const uint32_t templates = LARGE_IDENTITIES * LARGE_PER_IDENTITY;
+    float32_t *emb = malloc(templates * EMBEDDING_SIZE * sizeof(float32_t));
+    uint16_t *identity = malloc(templates * sizeof(uint16_t));
+    int8_t *rows = malloc(FACE_GALLERY_STORAGE_Q7(templates));
+    float32_t *scale = malloc(templates * sizeof(float32_t));
+    uint16_t *owner = malloc(templates * sizeof(uint16_t));
+    face_gallery_t gallery;
+    gallery_index_t index;
+    uint32_t size = 0;
+    uint8_t *image = NULL;
+    int found = 1, steps = 1;
+
+    if (emb && identity && rows && scale && owner) {
+        rng_state = 5U;
+        make_templates(emb, identity, LARGE_IDENTITIES, LARGE_PER_IDENTITY);
+        image = index_build(emb, identity, templates, 0, &size);
+        (void)face_gallery_init_q7(&gallery, rows, scale, owner, templates);
+        for (uint32_t t = 0; t < templates; t++) {
+            (void)face_gallery_add(&gallery, identity[t], &emb[t * EMBEDDING_SIZE]);
+        }
+    }
+    if (!image || gallery_index_open(&index, image, size) != GALLERY_INDEX_OK) {
+        found = steps = 0;
+    }
+
+    for (uint32_t q = 0; q < LARGE_QUERIES && found && steps; q++) {
+        face_gallery_match_t m[MAX_K], ref[MAX_K], once[MAX_K];
+        float32_t query[EMBEDDING_SIZE];
+        uint32_t nb, nb_once, scanned;
+
+        make_query(emb, (q * 7919U) % templates, 0.5f, query);
+        /* Every list: only the codes decide the shortlist */
+        nb = gallery_index_search(&index, &search, query, GALLERY_INDEX_MAX_PROBES, m, 1);
+        found &= (index.lists <= GALLERY_INDEX_MAX_PROBES && search.scanned == templates &&
+                  same_matches(m, nb, ref, face_gallery_search(&gallery, query, ref, 1)));
+
+        nb_once = gallery_index_search(&index, &search, query, 4, once, MAX_K);
+        scanned = search.scanned;
+        for (size_t b = 0; b < sizeof(step_budgets) / sizeof(step_budgets[0]); b++) {
+            uint32_t calls = 0;
+
+            (void)gallery_index_search_begin(&index, &search, query, 4);
+            while (gallery_index_search_step(&index, &search, step_budgets[b])) {
+                calls++;
+            }
+            nb = gallery_index_search_end(&index, &search, m, MAX_K);
+            steps &= same_matches(m, nb, once, nb_once) && search.scanned == scanned &&
+                     calls + 1U >= scanned / step_budgets[b];
+        }
+    }
+    free(emb);
+    free(identity);
+    free(rows);
+    free(scale);
+    free(owner);
+    free(image);
+    return !report("all lists, exhaustive top-1", found) + !report("steps of any budget", steps);
+}
+
+static int check_rejects(void)
+{
+    float32_t emb[SMALL_TEMPLATES * EMBEDDING_SIZE];
+    uint16_t identity[SMALL_TEMPLATES];
+    float32_t zero[EMBEDDING_SIZE] = { 0.0f };
+    face_gallery_match_t m[MAX_K];
+    gallery_index_t index;
+    gallery_index_header_t *h;
+    uint32_t size;
+    uint8_t *image;
+    uint8_t *copy;
+    int ok = 1;
+
+    rng_state = 7U;
+    make_templates(emb, identity, SMALL_IDENTITIES, SMALL_TEMPLATES / SMALL_IDENTITIES);
+    image = index_build(emb, identity, SMALL_TEMPLATES, SMALL_LISTS, &size);
+    copy = malloc(size + 4U);
+    if (!image || !copy) {
+        free(image);
+        free(copy);
+        return report("rejected inputs", 0);
+    }
+    h = (gallery_index_header_t *)copy;
+
+    /* Truncated, misaligned, no image */
+    memcpy(copy, image, size);
+    ok &= (gallery_index_open(&index, copy, size - 4U) != GALLERY_INDEX_OK);
+    ok &= (gallery_index_open(&index, copy, sizeof(gallery_index_header_t) - 1U) != GALLERY_INDEX_OK);
+    ok &= (gallery_index_open(&index, NULL, size) != GALLERY_INDEX_OK);
+    memcpy(copy + 2, image, size);
+    ok &= (gallery_index_open(&index, copy + 2, size) != GALLERY_INDEX_OK);
+    /* One bit of a template row, then of the magic, then a section past the end */
+    memcpy(copy, image, size);
+    copy[size - 1U] ^= 1U;
+    ok &= (gallery_index_open(&index, copy, size) == GALLERY_INDEX_ERR_IMAGE);
+    memcpy(copy, image, size);
+    h->magic ^= 1U;
+    ok &= (gallery_index_open(&index, copy, size) == GALLERY_INDEX_ERR_IMAGE);
+    memcpy(copy, image, size);
+    h->rows = size - 4U;
+    ok &= (gallery_index_open(&index, copy, size) == GALLERY_INDEX_ERR_IMAGE);
+    memcpy(copy, image, size);
+    h->lists = 0;
+    ok &= (gallery_index_open(&index, copy, size) == GALLERY_INDEX_ERR_IMAGE);
+    /* Searching a rejected image finds nothing */
+    ok &= (gallery_index_search(&index, &search, &emb[0], SMALL_LISTS, m, MAX_K) == 0);
+
+    /* Zero query, k = 0, probes clipped to 1 and to the lists */
+    memcpy(copy, image, size);
+    ok &= (gallery_index_open(&index, copy, size) == GALLERY_INDEX_OK);
+    ok &= (gallery_index_search_begin(&index, &search, zero, 1) == GALLERY_INDEX_ERR_ARG);
+    ok &= (gallery_index_search(&index, &search, zero, SMALL_LISTS, m, MAX_K) == 0);
+    ok &= (gallery_index_search(&index, &search, &emb[0], SMALL_LISTS, m, 0) == 0);
+    (void)gallery_index_search(&index, &search, &emb[0], 0, m, MAX_K);
+    ok &= (search.probes == 1);
+    (void)gallery_index_search(&index, &search, &emb[0], 1000, m, MAX_K);
+    ok &= (search.probes == SMALL_LISTS && search.scanned == SMALL_TEMPLATES);
+
+    free(image);
+    free(copy);
+    return report("rejected inputs", ok);
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("Gallery index against the exhaustive int8 search:\n");
+    failed += !check_small();
+    failed += check_large();
+    failed += !check_rejects();
+
+    printf("%d failed\n", failed);
+    return failed;
+}
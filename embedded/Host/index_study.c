@@ -0,0 +1,355 @@
+/**
+ ******************************************************************************
+ * @file    index_study.c
+ * @author  PeleAB
+ * @brief   Host tool: build a gallery index image offline, and measure its
+ *          recall and search time against the exhaustive search
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: index_study [-e embeddings.bin -g per_identity] [-t templates]
+ *                    [-n identities] [-l lists] [-q queries] [-b base]
+ *                    [-o index.bin]
+ *
+ * The embeddings are read or generated as by gallery_study: -e recorded
+ * faces, -g per person, the first -t of each enrolled (default 3); without
+ * -e, -n synthetic identities (default 10000) of 8 faces each. The enrolled
+ * ones are indexed with -l lists (default about the square root of the
+ * template count) by index_build, and -o writes the image for the board,
+ * with the identities numbered from -b (default 0).
+ *
+ * Up to -q of the other faces (default 1000, spread over the identities)
+ * are then searched exhaustively, in a float gallery (face_gallery_search_unit)
+ * and an int8 one (face_gallery_search), and with the index at 1 to
+ * GALLERY_INDEX_MAX_PROBES probes. For each probe count the tool prints
+ * recall@1 (the index top-1 identity is the exhaustive int8 one), the
+ * identification rate, the templates scored from their codes, and the mean
+ * search time.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "face_gallery.h"
+#include "gallery_index.h"
+#include "index_build.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define SYNTH_PER_IDENTITY                  8
+#define SYNTH_NOISE                         0.8f    /**< Noise norm, center norm 1 */
+#define STUDY_TOP_K                         5
+
+static const uint32_t study_probes[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+static gallery_index_search_t search;
+static uint32_t rng_state = 3U;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* ========================================================================= */
+/* EMBEDDINGS                                                                */
+/* ========================================================================= */
+
+static void normalize(float32_t *v, float32_t norm_wanted)
+{
+    float32_t norm = 0.0f;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        norm += v[d] * v[d];
+    }
+    norm = norm_wanted / sqrtf(norm);
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        v[d] *= norm;
+    }
+}
+
+/* Same identities as gallery_study */
+static float32_t *make_synthetic(uint32_t identities, uint32_t per_identity)
+{
+    float32_t *emb = malloc((size_t)identities * per_identity * EMBEDDING_SIZE * sizeof(float32_t));
+    float32_t center[EMBEDDING_SIZE];
+    float32_t noise[EMBEDDING_SIZE];
+
+    if (!emb) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < identities; i++) {
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            center[d] = rnd();
+        }
+        normalize(center, 1.0f);
+        for (uint32_t f = 0; f < per_identity; f++) {
+            float32_t *e = &emb[((size_t)i * per_identity + f) * EMBEDDING_SIZE];
+
+            for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+                noise[d] = rnd();
+            }
+            normalize(noise, SYNTH_NOISE);
+            for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+                e[d] = center[d] + noise[d];
+            }
+        }
+    }
+    return emb;
+}
+
+static float32_t *load_recorded(const char *path, uint32_t *pFaces)
+{
+    FILE *f = fopen(path, "rb");
+    float32_t *emb;
+    long size;
+
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *pFaces = (uint32_t)(size / (long)(EMBEDDING_SIZE * sizeof(float32_t)));
+    emb = malloc((size_t)*pFaces * EMBEDDING_SIZE * sizeof(float32_t) + 1U);
+    if (emb && fread(emb, EMBEDDING_SIZE * sizeof(float32_t), *pFaces, f) != *pFaces) {
+        free(emb);
+        emb = NULL;
+    }
+    fclose(f);
+    return emb;
+}
+
+static int write_image(const char *path, const uint8_t *image, uint32_t size)
+{
+    FILE *f = fopen(path, "wb");
+    int ok;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    ok = (fwrite(image, 1, size, f) == size);
+    ok &= (fclose(f) == 0);
+    return ok ? 0 : -1;
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    const char *out = NULL;
+    uint32_t per_identity = 0;
+    uint32_t enrolled = 3;
+    uint32_t identities = 10000;
+    uint32_t lists = 0;
+    uint32_t max_queries = 1000;
+    uint32_t base = 0;
+    uint32_t faces, templates, queries, size;
+    float32_t *emb, *pool, *storage, *scale_q7;
+    int8_t *storage_q7;
+    uint16_t *owner, *owner_q7, *identity;
+    uint32_t *query_face;
+    face_gallery_t gallery, gallery_q7;
+    gallery_index_t index;
+    uint8_t *image;
+    uint16_t *exact_top1;
+    uint32_t exact_ok = 0;
+    double t0, t_build, t_float, t_q7;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            per_identity = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            enrolled = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            identities = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lists = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            max_queries = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            base = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-e embeddings.bin -g per_identity] [-t templates]"
+                            " [-n identities] [-l lists] [-q queries] [-b base] [-o index.bin]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (path) {
+        pool = load_recorded(path, &faces);
+        if (!pool || per_identity == 0 || faces < per_identity) {
+            fprintf(stderr, "%s: need -g and at least one person of embeddings\n", path);
+            free(pool);
+            return 1;
+        }
+        identities = faces / per_identity;
+    } else {
+        per_identity = SYNTH_PER_IDENTITY;
+        pool = make_synthetic(identities, per_identity);
+        if (!pool) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+    if (enrolled == 0 || enrolled >= per_identity || identities == 0 ||
+        base + identities > 65536U || max_queries == 0) {
+        fprintf(stderr, "need 0 < templates < faces per identity, 1 to 65536 - base identities"
+                        " and queries\n");
+        free(pool);
+        return 2;
+    }
+
+    /* Enrolled faces, in identity order, and the queries among the others */
+    templates = identities * enrolled;
+    queries = identities * (per_identity - enrolled);
+    if (queries > max_queries) {
+        queries = max_queries;
+    }
+    emb = malloc((size_t)templates * EMBEDDING_SIZE * sizeof(float32_t));
+    identity = malloc(templates * sizeof(uint16_t));
+    query_face = malloc(queries * sizeof(uint32_t));
+    exact_top1 = malloc(queries * sizeof(uint16_t));
+    storage = malloc(FACE_GALLERY_STORAGE_FLOATS(templates) * sizeof(float32_t));
+    storage_q7 = malloc(FACE_GALLERY_STORAGE_Q7(templates));
+    scale_q7 = malloc(templates * sizeof(float32_t));
+    owner = malloc(templates * sizeof(uint16_t));
+    owner_q7 = malloc(templates * sizeof(uint16_t));
+    if (!emb || !identity || !query_face || !exact_top1 || !storage || !storage_q7 || !scale_q7 ||
+        !owner || !owner_q7 ||
+        face_gallery_init(&gallery, storage, owner, templates) != 0 ||
+        face_gallery_init_q7(&gallery_q7, storage_q7, scale_q7, owner_q7, templates) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < identities; i++) {
+        for (uint32_t f = 0; f < enrolled; f++) {
+            const float32_t *e = &pool[((size_t)i * per_identity + f) * EMBEDDING_SIZE];
+
+            memcpy(&emb[((size_t)i * enrolled + f) * EMBEDDING_SIZE], e, EMBEDDING_SIZE * sizeof(float32_t));
+            identity[i * enrolled + f] = (uint16_t)(base + i);
+            (void)face_gallery_add(&gallery, (uint16_t)(base + i), e);
+            (void)face_gallery_add(&gallery_q7, (uint16_t)(base + i), e);
+        }
+    }
+    for (uint32_t q = 0; q < queries; q++) {
+        const uint32_t n = (uint32_t)((uint64_t)q * identities * (per_identity - enrolled) / queries);
+
+        query_face[q] = (n / (per_identity - enrolled)) * per_identity + enrolled +
+                        n % (per_identity - enrolled);
+    }
+
+    t0 = now_us();
+    image = index_build(emb, identity, templates, lists, &size);
+    t_build = now_us() - t0;
+    if (!image || gallery_index_open(&index, image, size) != GALLERY_INDEX_OK) {
+        fprintf(stderr, "index build failed (zero embedding?)\n");
+        return 1;
+    }
+    if (out && write_image(out, image, size) != 0) {
+        fprintf(stderr, "%s: write failed\n", out);
+        return 1;
+    }
+
+    printf("Gallery index, %s: %u identities x %u templates, %u lists, %u queries\n",
+           path ? path : "synthetic", (unsigned int)identities, (unsigned int)enrolled,
+           (unsigned int)index.lists, (unsigned int)queries);
+    printf("   build                          %.1f s\n", t_build / 1e6);
+    printf("   image                          %u KB: codes %u KB, int8 rows %u KB\n",
+           (unsigned int)(size / 1024U), (unsigned int)(templates * GALLERY_INDEX_SUBSPACES / 1024U),
+           (unsigned int)((templates * (EMBEDDING_SIZE + sizeof(float32_t))) / 1024U));
+    if (out) {
+        printf("   written to                     %s\n", out);
+    }
+
+    /* Exhaustive searches: the reference top-1, and their time */
+    t_float = t_q7 = 0.0;
+    for (uint32_t q = 0; q < queries; q++) {
+        const uint32_t face = query_face[q];
+        float32_t unit[EMBEDDING_SIZE];
+        face_gallery_match_t m[STUDY_TOP_K];
+
+        (void)face_gallery_normalize(&pool[(size_t)face * EMBEDDING_SIZE], unit);
+        t0 = now_us();
+        (void)face_gallery_search_unit(&gallery, unit, m, STUDY_TOP_K);
+        t_float += now_us() - t0;
+        t0 = now_us();
+        exact_top1[q] = (face_gallery_search(&gallery_q7, unit, m, STUDY_TOP_K) > 0) ? m[0].identity : 0xFFFF;
+        t_q7 += now_us() - t0;
+        exact_ok += (exact_top1[q] == base + face / per_identity);
+    }
+    printf("   exhaustive, float              %8.1f us, identification %6.2f %%\n",
+           t_float / queries, 100.0 * exact_ok / queries);
+    printf("   exhaustive, int8               %8.1f us\n", t_q7 / queries);
+
+    for (size_t p = 0; p < sizeof(study_probes) / sizeof(study_probes[0]); p++) {
+        const uint32_t probes = study_probes[p];
+        uint32_t same = 0, ok = 0;
+        double scanned = 0.0, t_index = 0.0;
+
+        if (p > 0 && study_probes[p - 1] >= index.lists) {
+            break;
+        }
+        for (uint32_t q = 0; q < queries; q++) {
+            const uint32_t face = query_face[q];
+            float32_t unit[EMBEDDING_SIZE];
+            face_gallery_match_t m[STUDY_TOP_K];
+            uint32_t nb;
+
+            (void)face_gallery_normalize(&pool[(size_t)face * EMBEDDING_SIZE], unit);
+            t0 = now_us();
+            nb = gallery_index_search(&index, &search, unit, probes, m, STUDY_TOP_K);
+            t_index += now_us() - t0;
+            scanned += search.scanned;
+            same += (nb > 0 && m[0].identity == exact_top1[q]);
+            ok += (nb > 0 && m[0].identity == base + face / per_identity);
+        }
+        printf("   index, %2u probes                %8.1f us, recall@1 %6.2f %%, identification %6.2f %%,"
+               " scanned %5.2f %%\n", (unsigned int)search.probes, t_index / queries,
+               100.0 * same / queries, 100.0 * ok / queries, 100.0 * scanned / queries / templates);
+    }
+
+    free(image);
+    free(emb);
+    free(identity);
+    free(query_face);
+    free(exact_top1);
+    free(storage);
+    free(storage_q7);
+    free(scale_q7);
+    free(owner);
+    free(owner_q7);
+    free(pool);
+    return 0;
+}
@@ -0,0 +1,323 @@
+/**
+ ******************************************************************************
+ * @file    kernel_check.c
+ * @author  PeleAB
+ * @brief   Host tool: compare optimized image kernels with their references
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: kernel_check
+ *
+ * crop_img.c is built with -DHOST_MVE_EMULATION, so its Helium paths run
+ * on top of stubs/arm_mve_emul.h. Every optimized kernel is run on the
+ * detection (128x128) and recognition (112x112) shapes and on odd widths and
+ * padded strides that exercise the predicated tails, and must match the
+ * scalar reference bit for bit without writing outside its output.
+ * The fused crop + normalize kernel must match the two-pass path
+ * (img_crop_align565_to_888 then img_rgb_to_chw_float_norm_ref) on faces of
+ * several sizes and angles taken from the 800x480 test image.
+ * The fixed-point warp engine (img_warp_align) is compared with the float
+ * reference in warp_ref.c for both source formats and sampling modes:
+ * nearest may pick a neighbouring pixel where the float position lies within
+ * rounding of a pixel edge, bilinear may differ by its 8-bit weights.
+ * The RGB888 crop must not depend on the source pitch: the NN frame is also
+ * read from a padded copy (odd pitch, padding filled with a marker).
+ * The pixel_lut tables must hold exactly what the arithmetic they replace
+ * computes, and the table-driven normalization must match the reference.
+ * Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "crop_img.h"
+#include "dummy_dual_buffer.h"
+#include "pixel_lut.h"
+#include "warp_ref.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define GUARD_FLOATS                        8
+#define GUARD_VALUE                         -12345.0f
+#define PADDED_STRIDE                       (128 * 3 + 13)
+
+#define WARP_NEAREST_MAX_MOVED_PCT          1.0     /**< Pixels sampled from a neighbour */
+#define WARP_BILINEAR_MAX_DIFF              2       /**< Per channel, 8-bit levels */
+#define WARP_BILINEAR_MAX_MEAN_DIFF         0.25
+
+typedef void (*chw_kernel_t)(uint8_t *src_image, float32_t *dst_img,
+                             const uint32_t src_stride, const uint16_t width,
+                             const uint16_t height);
+
+typedef struct {
+    const char *name;
+    chw_kernel_t kernel;
+    chw_kernel_t reference;
+} chw_case_t;
+
+typedef struct {
+    uint16_t width, height;
+    uint32_t stride;
+} shape_t;
+
+static const chw_case_t chw_cases[] = {
+    { "img_rgb_to_chw_float", img_rgb_to_chw_float, img_rgb_to_chw_float_ref },
+    { "img_rgb_to_chw_float_norm", img_rgb_to_chw_float_norm, img_rgb_to_chw_float_norm_ref },
+    { "img_rgb_to_chw_float_norm_lut", img_rgb_to_chw_float_norm_lut, img_rgb_to_chw_float_norm_ref },
+};
+
+/** @brief Aligned crop: box center and size, eyes (display pixels), output size */
+typedef struct {
+    float cx, cy, w, h, lx, ly, rx, ry;
+    uint16_t dst_width, dst_height;
+} align_case_t;
+
+static const align_case_t align_cases[] = {
+    { 409.0f, 261.0f, 176.0f, 176.0f, 370.0f, 230.0f, 450.0f, 232.0f, 112, 112 },
+    { 409.0f, 261.0f, 176.0f, 176.0f, 370.0f, 250.0f, 450.0f, 215.0f, 112, 112 },
+    { 30.0f, 20.0f, 120.0f, 90.0f, 10.0f, 10.0f, 50.0f, 40.0f, 112, 112 },
+    { 790.0f, 470.0f, 64.0f, 64.0f, 780.0f, 470.0f, 800.0f, 465.0f, 67, 45 },
+};
+
+static const shape_t shapes[] = {
+    { 128, 128, 128 * 3 },
+    { 112, 112, 112 * 3 },
+    { 1, 1, 3 },
+    { 3, 2, 16 },
+    { 13, 5, 13 * 3 },
+    { 30, 7, 96 },
+    { 125, 9, 384 },            /* DCMIPP pads odd widths to a 16-byte pitch */
+    { 127, 4, 384 },
+    { 99, 3, 304 },
+};
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+static int check_chw(const chw_case_t *c, const shape_t *s, const uint8_t *src)
+{
+    size_t n = (size_t)s->width * s->height * 3;
+    float32_t *got = malloc((n + GUARD_FLOATS) * sizeof(float32_t));
+    float32_t *exp = malloc(n * sizeof(float32_t));
+    int ok;
+
+    if (!got || !exp) {
+        return 0;
+    }
+    for (size_t i = 0; i < n + GUARD_FLOATS; i++) {
+        got[i] = GUARD_VALUE;
+    }
+
+    c->kernel((uint8_t *)src, got, s->stride, s->width, s->height);
+    c->reference((uint8_t *)src, exp, s->stride, s->width, s->height);
+
+    ok = memcmp(got, exp, n * sizeof(float32_t)) == 0;
+    for (size_t i = n; i < n + GUARD_FLOATS; i++) {
+        ok &= (got[i] == GUARD_VALUE);
+    }
+
+    printf("   %-30s %4ux%-4u stride %4u  %s\n", c->name, (unsigned int)s->width,
+           (unsigned int)s->height, (unsigned int)s->stride, ok ? "ok" : "MISMATCH");
+    free(got);
+    free(exp);
+    return ok;
+}
+
+/** @brief Every table entry against the arithmetic it stands for */
+static int check_lut(void)
+{
+    uint8_t row[256 * 3];
+    float32_t norm[256 * 3];
+    int ok = 1;
+
+    for (uint32_t v = 0; v < 256U; v++) {
+        row[v * 3] = row[v * 3 + 1] = row[v * 3 + 2] = (uint8_t)v;
+    }
+    img_rgb_to_chw_float_norm_ref(row, norm, sizeof(row), 256, 1);
+    ok &= memcmp(pixel_lut_norm, norm, sizeof(pixel_lut_norm)) == 0;
+
+    for (uint32_t v = 0; v < 64U; v++) {
+        uint32_t g8 = (v << 2) | (v >> 4);
+
+        ok &= pixel_lut_565_g[v] == (uint8_t)(v << 2);
+        ok &= pixel_lut_gray_g[v] == 59U * g8;
+        if (v < 32U) {
+            uint32_t rb8 = (v << 3) | (v >> 2);
+
+            ok &= pixel_lut_565_r[v] == (uint8_t)(v << 3);
+            ok &= pixel_lut_gray_r[v] == 30U * rb8;
+            ok &= pixel_lut_gray_b[v] == 11U * rb8;
+        }
+    }
+
+    printf("   %-30s %s\n", "pixel_lut tables", ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+static int check_align(const align_case_t *a)
+{
+    size_t n = (size_t)a->dst_width * a->dst_height * 3;
+    uint8_t *crop = malloc(n);
+    float32_t *got = malloc((n + GUARD_FLOATS) * sizeof(float32_t));
+    float32_t *exp = malloc(n * sizeof(float32_t));
+    int ok;
+
+    if (!crop || !got || !exp) {
+        return 0;
+    }
+    for (size_t i = 0; i < n + GUARD_FLOATS; i++) {
+        got[i] = GUARD_VALUE;
+    }
+
+    img_crop_align565_to_888((uint8_t *)dummy_test_img_buffer, 800, crop, 800, 480,
+                             a->dst_width, a->dst_height, a->cx, a->cy, a->w, a->h,
+                             a->lx, a->ly, a->rx, a->ry);
+    img_rgb_to_chw_float_norm_ref(crop, exp, a->dst_width * 3, a->dst_width, a->dst_height);
+    img_crop_align565_to_chw_float_norm((uint8_t *)dummy_test_img_buffer, 800, got, 800, 480,
+                                        a->dst_width, a->dst_height, a->cx, a->cy, a->w, a->h,
+                                        a->lx, a->ly, a->rx, a->ry);
+
+    ok = memcmp(got, exp, n * sizeof(float32_t)) == 0;
+    for (size_t i = n; i < n + GUARD_FLOATS; i++) {
+        ok &= (got[i] == GUARD_VALUE);
+    }
+
+    printf("   %-28s %4ux%-4u at %4.0f,%-4.0f  %s\n", "img_crop_align565_to_chw_norm",
+           (unsigned int)a->dst_width, (unsigned int)a->dst_height, (double)a->cx, (double)a->cy,
+           ok ? "ok" : "MISMATCH");
+    free(crop);
+    free(got);
+    free(exp);
+    return ok;
+}
+
+static int check_warp(const align_case_t *a, img_format_t format, img_sample_t sample)
+{
+    size_t n = (size_t)a->dst_width * a->dst_height * 3;
+    uint8_t *got = malloc(n);
+    uint8_t *exp = malloc(n);
+    /* RGB888 cases use the 128x128 NN frame with the box scaled to it */
+    const int rgb = (format == IMG_FORMAT_RGB888);
+    const float k = rgb ? 128.0f / 800.0f : 1.0f;
+    const float ky = rgb ? 128.0f / 480.0f : 1.0f;
+    const uint8_t *src = rgb ? dummy_test_nn_rgb : (const uint8_t *)dummy_test_img_buffer;
+    const uint16_t sw = rgb ? 128 : 800, sh = rgb ? 128 : 480;
+    const uint32_t stride = rgb ? 128 * 3 : 800 * 2;
+    uint32_t moved = 0, max_diff = 0;
+    uint64_t sum_diff = 0;
+    double moved_pct, mean_diff;
+    int ok;
+
+    if (!got || !exp) {
+        return 0;
+    }
+    img_warp_align(src, stride, format, sw, sh, got, a->dst_width, a->dst_height, sample,
+                   a->cx * k, a->cy * ky, a->w * k, a->h * ky,
+                   a->lx * k, a->ly * ky, a->rx * k, a->ry * ky);
+    warp_ref_align(src, stride, format, sw, sh, exp, a->dst_width, a->dst_height, sample,
+                   a->cx * k, a->cy * ky, a->w * k, a->h * ky,
+                   a->lx * k, a->ly * ky, a->rx * k, a->ry * ky);
+
+    for (size_t i = 0; i < n; i += 3) {
+        uint32_t pixel_moved = 0;
+
+        for (size_t c = 0; c < 3; c++) {
+            uint32_t d = (uint32_t)abs((int)got[i + c] - (int)exp[i + c]);
+            sum_diff += d;
+            max_diff = (d > max_diff) ? d : max_diff;
+            pixel_moved |= (d != 0);
+        }
+        moved += pixel_moved;
+    }
+    moved_pct = 100.0 * moved / (double)(n / 3);
+    mean_diff = (double)sum_diff / (double)n;
+
+    if (sample == IMG_SAMPLE_NEAREST) {
+        ok = moved_pct <= WARP_NEAREST_MAX_MOVED_PCT;
+    } else {
+        ok = max_diff <= WARP_BILINEAR_MAX_DIFF && mean_diff <= WARP_BILINEAR_MAX_MEAN_DIFF;
+    }
+
+    if (rgb) {
+        /* Same crop from a padded copy of the frame */
+        static uint8_t padded[128 * PADDED_STRIDE];
+        uint8_t *alt = malloc(n);
+
+        memset(padded, 0xA5, sizeof(padded));
+        for (uint32_t y = 0; y < 128; y++) {
+            memcpy(padded + y * PADDED_STRIDE, src + y * stride, stride);
+        }
+        if (alt) {
+            img_warp_align(padded, PADDED_STRIDE, format, sw, sh, alt, a->dst_width, a->dst_height,
+                           sample, a->cx * k, a->cy * ky, a->w * k, a->h * ky,
+                           a->lx * k, a->ly * ky, a->rx * k, a->ry * ky);
+            if (memcmp(alt, got, n) != 0) {
+                printf("   warp %-6s %-8s stride %u differs from packed\n", "RGB888",
+                       (sample == IMG_SAMPLE_NEAREST) ? "nearest" : "bilinear", PADDED_STRIDE);
+                ok = 0;
+            }
+        }
+        free(alt);
+    }
+
+    printf("   warp %-6s %-8s %4ux%-4u at %4.0f,%-4.0f  moved %5.2f%%  max %3u  mean %.3f  %s\n",
+           rgb ? "RGB888" : "RGB565", (sample == IMG_SAMPLE_NEAREST) ? "nearest" : "bilinear",
+           (unsigned int)a->dst_width, (unsigned int)a->dst_height, (double)a->cx, (double)a->cy,
+           moved_pct, (unsigned int)max_diff, mean_diff, ok ? "ok" : "INACCURATE");
+    free(got);
+    free(exp);
+    return ok;
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(void)
+{
+    static uint8_t src[128 * 128 * 3];
+    int failed = 0;
+
+    /* Test image for the real shapes; every byte value appears in the rest */
+    memcpy(src, dummy_test_nn_rgb, sizeof(src));
+    for (uint32_t i = 0; i < 4096; i++) {
+        src[i] = (uint8_t)(i * 37U + (i >> 8));
+    }
+
+    pixel_lut_init();
+
+    printf("Optimized kernels against references:\n");
+    failed += !check_lut();
+    for (size_t c = 0; c < sizeof(chw_cases) / sizeof(chw_cases[0]); c++) {
+        for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+            failed += !check_chw(&chw_cases[c], &shapes[s], src);
+        }
+    }
+
+    for (size_t a = 0; a < sizeof(align_cases) / sizeof(align_cases[0]); a++) {
+        failed += !check_align(&align_cases[a]);
+    }
+
+    printf("Fixed-point warp against the float reference:\n");
+    for (size_t a = 0; a < sizeof(align_cases) / sizeof(align_cases[0]); a++) {
+        for (int f = IMG_FORMAT_RGB888; f <= IMG_FORMAT_RGB565; f++) {
+            failed += !check_warp(&align_cases[a], (img_format_t)f, IMG_SAMPLE_NEAREST);
+            failed += !check_warp(&align_cases[a], (img_format_t)f, IMG_SAMPLE_BILINEAR);
+        }
+    }
+
+    printf("%d failed\n", failed);
+    return failed;
+}
@@ -0,0 +1,285 @@
+/**
+ ******************************************************************************
+ * @file    make_tensors.c
+ * @author  PeleAB
+ * @brief   Host tool: generate canned NPU output tensors for the host build
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: make_tensors <dir> [faces]
+ *        make_tensors -s <seq_dir> [frames]
+ *
+ * The first form writes face_detection_out0..3.bin and
+ * face_recognition_out0.bin in the layout of the generated networks, for
+ * host_bench. Detection outputs describe up to MAX_FACES CenterFace
+ * detections: a heatmap peak plus four weaker neighbours per face (so NMS has
+ * work to do), with scale, offset and landmark values that decode back to the
+ * listed boxes. Face 0 is placed where the dummy test image has its face.
+ *
+ * The second form writes a replay sequence (layout in host.h) in which the
+ * target face moves, a second face and a low-confidence face come and go,
+ * and the target identity alternates between matching and not matching the
+ * enrolled embedding every SEQ_IDENTITY_FRAMES frames, so every recognition
+ * and voting branch is reached.
+ *
+ * Tensors dumped from the board (same file names and sizes) can be used
+ * instead for bit-exact post-processing checks.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "host.h"
+#include "dummy_dual_buffer.h"
+#include "target_embedding.h"
+
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_detection);
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_recognition);
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define GRID                                32
+#define STRIDE                              4.0f
+#define NB_KEYPOINTS                        5
+#define MAX_FACES                           4
+
+#define SEQ_DEFAULT_FRAMES                  48
+#define SEQ_PERIOD                          12      /**< Face layout cycle */
+#define SEQ_IDENTITY_FRAMES                 12      /**< Frames per match / no-match block */
+
+/** @brief Synthetic face: center and size in NN input pixels, peak score */
+typedef struct {
+    float cx, cy, size, score;
+} synth_face_t;
+
+static const synth_face_t faces[MAX_FACES] = {
+    { 65.4f, 69.6f, 44.0f, 0.95f },         /* dummy test image face */
+    { 24.0f, 30.0f, 24.0f, 0.90f },
+    { 100.0f, 28.0f, 20.0f, 0.85f },
+    { 104.0f, 100.0f, 28.0f, 0.80f },
+};
+
+/** @brief Landmarks relative to the box (x, y): eyes, nose, mouth corners */
+static const float landmarks[NB_KEYPOINTS][2] = {
+    { 0.30f, 0.38f }, { 0.70f, 0.38f }, { 0.50f, 0.58f }, { 0.35f, 0.78f }, { 0.65f, 0.78f },
+};
+
+static float scale[GRID * GRID * 2];
+static float lms[GRID * GRID * NB_KEYPOINTS * 2];
+static float heatmap[GRID * GRID];
+static float offset[GRID * GRID * 2];
+static float embeddings[MAX_FACES][EMBEDDING_SIZE];
+
+static const uint8_t *const fd_data[] = {
+    (const uint8_t *)scale, (const uint8_t *)lms,
+    (const uint8_t *)heatmap, (const uint8_t *)offset,
+};
+
+/* ========================================================================= */
+/* GENERATION                                                                */
+/* ========================================================================= */
+
+static void put_cell(const synth_face_t *f, int gx, int gy, float score)
+{
+    int idx = gy * GRID + gx;
+    float s = logf(f->size / STRIDE);
+
+    if (gx < 0 || gy < 0 || gx >= GRID || gy >= GRID || heatmap[idx] >= score) {
+        return;
+    }
+
+    heatmap[idx] = score;
+    scale[idx * 2 + 0] = s;
+    scale[idx * 2 + 1] = s;
+    /* Offsets point every cell of the face at the same center */
+    offset[idx * 2 + 0] = f->cy / STRIDE - (float)gy - 0.5f;
+    offset[idx * 2 + 1] = f->cx / STRIDE - (float)gx - 0.5f;
+    for (int j = 0; j < NB_KEYPOINTS; j++) {
+        lms[idx * NB_KEYPOINTS * 2 + j * 2 + 0] = landmarks[j][1];
+        lms[idx * NB_KEYPOINTS * 2 + j * 2 + 1] = landmarks[j][0];
+    }
+}
+
+static void make_detection(const synth_face_t *list, int nfaces)
+{
+    memset(scale, 0, sizeof(scale));
+    memset(lms, 0, sizeof(lms));
+    memset(offset, 0, sizeof(offset));
+    for (int i = 0; i < GRID * GRID; i++) {
+        heatmap[i] = 0.01f;
+    }
+    for (int i = 0; i < nfaces; i++) {
+        const synth_face_t *f = &list[i];
+        int gx = (int)(f->cx / STRIDE);
+        int gy = (int)(f->cy / STRIDE);
+        float side = (f->score < 0.6f) ? f->score : 0.60f;
+
+        put_cell(f, gx, gy, f->score);
+        put_cell(f, gx - 1, gy, side);
+        put_cell(f, gx + 1, gy, side);
+        put_cell(f, gx, gy - 1, side);
+        put_cell(f, gx, gy + 1, side);
+    }
+}
+
+/**
+ * @brief Deterministic unit embedding; @p noise blends in a second pattern
+ */
+static void make_embedding(float *emb, uint32_t identity, float noise)
+{
+    float norm = 0.0f;
+
+    for (int i = 0; i < EMBEDDING_SIZE; i++) {
+        float base = sinf(0.37f * (float)(i + 1) * (float)(identity + 1)) +
+                     0.25f * cosf(1.7f * (float)i + (float)identity);
+        emb[i] = base + noise * sinf(2.9f * (float)i + 0.5f);
+        norm += emb[i] * emb[i];
+    }
+    norm = sqrtf(norm);
+    for (int i = 0; i < EMBEDDING_SIZE; i++) {
+        emb[i] /= norm;
+    }
+}
+
+static int write_file(const char *dir, const char *name, const void *data, size_t size)
+{
+    char path[512];
+    FILE *f;
+    size_t put;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    put = fwrite(data, 1, size, f);
+    fclose(f);
+    return (put == size) ? 0 : -1;
+}
+
+static int make_dir(const char *path)
+{
+    if (mkdir(path, 0777) != 0 && errno != EEXIST) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+/* ========================================================================= */
+/* OUTPUT MODES                                                              */
+/* ========================================================================= */
+
+static int write_canned(const char *dir, int nfaces)
+{
+    const uint8_t *fr_data[] = { (const uint8_t *)embeddings[0] };
+
+    make_detection(faces, nfaces);
+    make_embedding(embeddings[0], 0, 0.0f);
+
+    if (host_npu_save_outputs(dir, &NN_Instance_face_detection, fd_data) != 0 ||
+        host_npu_save_outputs(dir, &NN_Instance_face_recognition, fr_data) != 0) {
+        return -1;
+    }
+
+    printf("Wrote %d synthetic face(s) to %s\n", nfaces, dir);
+    return 0;
+}
+
+static int write_sequence(const char *seq, uint32_t frames)
+{
+    float enrolled[EMBEDDING_SIZE];
+
+    if (make_dir(seq) != 0) {
+        return -1;
+    }
+    make_embedding(enrolled, 0, 0.0f);
+    if (write_file(seq, REPLAY_ENROLL_FILE, enrolled, sizeof(enrolled)) != 0) {
+        return -1;
+    }
+
+    for (uint32_t f = 0; f < frames; f++) {
+        uint32_t phase = f % SEQ_PERIOD;
+        int matching = ((f / SEQ_IDENTITY_FRAMES) % 2U) == 0;
+        synth_face_t list[MAX_FACES];
+        int nfaces = 0;
+        int recognized = 0;
+        char dir[512];
+
+        if (phase != SEQ_PERIOD - 1) {
+            list[nfaces] = faces[0];
+            list[nfaces].cx += 4.0f * sinf(0.3f * (float)f);
+            list[nfaces].cy += 3.0f * cosf(0.25f * (float)f);
+            list[nfaces].size += 4.0f * sinf(0.2f * (float)f);
+            nfaces++;
+            /* Same person with some noise, or somebody else */
+            make_embedding(embeddings[recognized++], matching ? 0 : 7, matching ? 0.3f : 0.0f);
+        }
+        if (phase >= 4 && phase <= 7) {
+            list[nfaces++] = faces[2];
+            make_embedding(embeddings[recognized++], 3, 0.0f);
+        }
+        if (phase == 9) {
+            /* Above the decode threshold, below the recognition threshold */
+            list[nfaces] = faces[3];
+            list[nfaces].score = 0.62f;
+            nfaces++;
+        }
+
+        snprintf(dir, sizeof(dir), REPLAY_FRAME_DIR_FMT, seq, (unsigned int)f);
+        if (make_dir(dir) != 0) {
+            return -1;
+        }
+        make_detection(list, nfaces);
+        if (write_file(dir, REPLAY_NN_RGB_FILE, dummy_test_nn_rgb, DUMMY_TEST_NN_RGB_SIZE) != 0 ||
+            host_npu_save_outputs(dir, &NN_Instance_face_detection, fd_data) != 0 ||
+            (recognized > 0 &&
+             write_file(dir, REPLAY_EMBEDDINGS_FILE, embeddings,
+                        (size_t)recognized * EMBEDDING_SIZE * sizeof(float)) != 0)) {
+            return -1;
+        }
+    }
+
+    printf("Wrote %u frame replay sequence to %s\n", (unsigned int)frames, seq);
+    return 0;
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "-s") == 0) {
+        uint32_t frames = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : SEQ_DEFAULT_FRAMES;
+        return (write_sequence(argv[2], frames) == 0) ? 0 : 1;
+    }
+
+    if (argc < 2 || argv[1][0] == '-') {
+        fprintf(stderr, "usage: %s <dir> [faces 0..%d]\n"
+                        "       %s -s <seq_dir> [frames]\n", argv[0], MAX_FACES, argv[0]);
+        return 2;
+    }
+
+    int nfaces = (argc > 2) ? atoi(argv[2]) : 1;
+    if (nfaces < 0 || nfaces > MAX_FACES) {
+        fprintf(stderr, "faces must be 0..%d\n", MAX_FACES);
+        return 2;
+    }
+    return (write_canned(argv[1], nfaces) == 0) ? 0 : 1;
+}
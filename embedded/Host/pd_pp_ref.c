@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ * @file    pd_pp_ref.c
+ * @author  PeleAB
+ * @brief   Host tools: reference CenterFace decode and NMS
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Kept as lib_vision_models_pp shipped it, so the optimized decoder in
+ * pd_pp_model.c can be checked against it box for box. Only the grid size
+ * and stride, fixed at 32x32 and 4 in the original, come from the
+ * parameters.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "pd_pp_ref.h"
+
+#define REF_MIN(x, y) ((x) < (y) ? (x) : (y))
+#define REF_MAX(x, y) ((x) > (y) ? (x) : (y))
+
+static int comparator(const void *arg1, const void *arg2)
+{
+    const pd_pp_box_t *box1 = arg1;
+    const pd_pp_box_t *box2 = arg2;
+
+    if (box1->prob < box2->prob) {
+        return 1;
+    }
+    if (box1->prob > box2->prob) {
+        return -1;
+    }
+    return 0;
+}
+
+static float compute_iou(const pd_pp_box_t *box0, const pd_pp_box_t *box1)
+{
+    const pd_pp_box_t *box[2] = { box0, box1 };
+    float xmin[2], xmax[2], ymin[2], ymax[2], area[2];
+    float intersect_area;
+
+    for (int i = 0; i < 2; i++) {
+        float x0 = box[i]->x_center - box[i]->width / 2;
+        float y0 = box[i]->y_center - box[i]->height / 2;
+        float x1 = box[i]->x_center + box[i]->width / 2;
+        float y1 = box[i]->y_center + box[i]->height / 2;
+
+        xmin[i] = REF_MIN(x0, x1);
+        xmax[i] = REF_MAX(x0, x1);
+        ymin[i] = REF_MIN(y0, y1);
+        ymax[i] = REF_MAX(y0, y1);
+        area[i] = (ymax[i] - ymin[i]) * (xmax[i] - xmin[i]);
+    }
+    if (area[0] <= 0 || area[1] <= 0) {
+        return 0;
+    }
+
+    intersect_area = REF_MAX(REF_MIN(ymax[0], ymax[1]) - REF_MAX(ymin[0], ymin[1]), 0.0f) *
+                     REF_MAX(REF_MIN(xmax[0], xmax[1]) - REF_MAX(xmin[0], xmin[1]), 0.0f);
+    return intersect_area / (area[0] + area[1] - intersect_area);
+}
+
+static void decode(pd_model_pp_in_t *pInput, pd_postprocess_out_t *pOutput,
+                   pd_model_pp_static_param_t *param)
+{
+    pd_pp_box_t *pBoxes = pOutput->pOutData;
+    float width = param->width;
+    float height = param->height;
+    const int grid_w = (int)param->grid_width;
+    const int grid_h = (int)param->grid_height;
+    const float stride = param->stride;
+    size_t box_nb = 0;
+
+    pOutput->box_nb = 0;
+    for (int y = 0; y < grid_h; y++) {
+        for (int x = 0; x < grid_w; x++) {
+            int index_h = y * grid_w + x;
+            float score = pInput->pHeatmap[index_h];
+
+            if (score > param->conf_threshold) {
+                float s0 = expf(pInput->pScale[index_h * 2 + 0]) * stride;
+                float s1 = expf(pInput->pScale[index_h * 2 + 1]) * stride;
+                float o0 = pInput->pOffset[index_h * 2 + 0];
+                float o1 = pInput->pOffset[index_h * 2 + 1];
+                float x1 = (x + o1 + 0.5f) * stride - s1 / 2.0f;
+                float y1 = (y + o0 + 0.5f) * stride - s0 / 2.0f;
+                pd_pp_box_t *pBox = &pBoxes[box_nb];
+
+                if (x1 < 0) x1 = 0;
+                if (y1 < 0) y1 = 0;
+                float x2 = x1 + s1;
+                float y2 = y1 + s0;
+
+                pBox->prob = score;
+                pBox->x_center = ((x1 + x2) * 0.5f) / width;
+                pBox->y_center = ((y1 + y2) * 0.5f) / height;
+                pBox->width = s1 / width;
+                pBox->height = s0 / height;
+                for (uint32_t j = 0; j < param->nb_keypoints; j++) {
+                    float lm_y = pInput->pLms[index_h * param->nb_keypoints * 2 + j * 2 + 0];
+                    float lm_x = pInput->pLms[index_h * param->nb_keypoints * 2 + j * 2 + 1];
+
+                    pBox->pKps[j].x = (lm_x * s1 + x1) / width;
+                    pBox->pKps[j].y = (lm_y * s0 + y1) / height;
+                }
+                pBox->nb_kps = param->nb_keypoints;
+
+                box_nb++;
+                if (box_nb >= param->max_boxes_limit) {
+                    pOutput->box_nb = box_nb;
+                    return;
+                }
+            }
+        }
+    }
+    pOutput->box_nb = box_nb;
+}
+
+static void nms(pd_postprocess_out_t *pOutput, pd_model_pp_static_param_t *param)
+{
+    pd_pp_box_t *boxes = pOutput->pOutData;
+    uint32_t kept = 0;
+
+    qsort(boxes, pOutput->box_nb, sizeof(pd_pp_box_t), comparator);
+    for (uint32_t i = 0; i < pOutput->box_nb; i++) {
+        int skip = 0;
+
+        for (uint32_t j = 0; j < kept; j++) {
+            if (compute_iou(&boxes[i], &boxes[j]) >= param->iou_threshold) {
+                skip = 1;
+                break;
+            }
+        }
+        if (!skip) {
+            boxes[kept++] = boxes[i];
+        }
+    }
+    pOutput->box_nb = kept;
+}
+
+int32_t pd_pp_ref_process(pd_model_pp_in_t *pInput, pd_postprocess_out_t *pOutput,
+                          pd_model_pp_static_param_t *pInput_static_param)
+{
+    decode(pInput, pOutput, pInput_static_param);
+    nms(pOutput, pInput_static_param);
+    return AI_PD_POSTPROCESS_ERROR_NO;
+}
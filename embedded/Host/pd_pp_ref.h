@@ -0,0 +1,21 @@
+/**
+ ******************************************************************************
+ * @file    pd_pp_ref.h
+ * @author  PeleAB
+ * @brief   Host tools: reference CenterFace decode and NMS
+ ******************************************************************************
+ */
+
+#ifndef HOST_PD_PP_REF_H
+#define HOST_PD_PP_REF_H
+
+#include "pd_model_pp_if.h"
+
+/**
+ * @brief The original pd_model_pp_process: scalar raster scan of the
+ *        heatmap stopping at max_boxes_limit, qsort, then pairwise IoU NMS
+ */
+int32_t pd_pp_ref_process(pd_model_pp_in_t *pInput, pd_postprocess_out_t *pOutput,
+                          pd_model_pp_static_param_t *pInput_static_param);
+
+#endif /* HOST_PD_PP_REF_H */
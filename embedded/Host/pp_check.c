@@ -0,0 +1,444 @@
+/**
+ ******************************************************************************
+ * @file    pp_check.c
+ * @author  PeleAB
+ * @brief   Host tool: compare the face detection post-processing with its
+ *          reference
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: pp_check
+ *
+ * pd_model_pp_process (lib_vision_models_pp) runs on synthetic CenterFace
+ * outputs and must return the boxes and keypoints of the reference in
+ * pd_pp_ref.c, bit for bit and in the same order. The reference takes the
+ * first max_boxes_limit cells in raster order, the decoder the
+ * max_boxes_limit highest-scoring ones: the reference is run on a heatmap
+ * where the cells after those are cleared; in AI_PD_PP_DECODE_PEAKS mode the
+ * cells that are not 3x3 maxima are cleared first. Boxes below
+ * kps_conf_threshold must have no keypoints. The
+ * heatmaps cover no detection, isolated faces, dense activations that hit
+ * max_boxes_limit, scores equal to the threshold, flat maxima and hits in
+ * the last cells, on the output grids of 128 to 256 pixel and non-square
+ * inputs.
+ * app_postprocess_init() must take the grid and stride from the
+ * face_detection output descriptors, and reject descriptors that do not
+ * fit the decoder or the NN input size. The Makefile
+ * builds it twice: pp_check on the scalar decoder, pp_check_mve with
+ * -DAI_PD_PP_MVEF_OPTIM on the Helium emulation (stubs/arm_mve_emul.h).
+ * Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "app_config.h"
+#include "app_postprocess.h"
+#include "ll_aton_NN_interface.h"
+#include "pd_pp_ref.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define MAX_CELLS                           (64 * 64)
+#define NB_KEYPOINTS                        5
+#define CONF_THRESHOLD                      0.5f
+#define IOU_THRESHOLD                       0.3f
+#define SEEDS                               3
+
+/** @brief Output grid of a detector input size (stride 4) */
+typedef struct {
+    uint16_t width, height;                 /**< Cells */
+} grid_t;
+
+typedef void (*heatmap_gen_t)(float *heatmap, const grid_t *g, uint32_t seed);
+
+typedef struct {
+    const char *name;
+    heatmap_gen_t gen;
+    uint32_t max_boxes_limit;               /**< 0: one box per cell */
+    uint32_t decode_mode;
+    float kps_conf_threshold;               /**< Keypoints decoded from this score on */
+} pp_case_t;
+
+/** @brief Detection output buffers: boxes with their own keypoint arrays */
+typedef struct {
+    pd_pp_box_t boxes[MAX_CELLS];
+    pd_pp_point_t kps[MAX_CELLS][NB_KEYPOINTS];
+    pd_postprocess_out_t out;
+} pp_result_t;
+
+/* 128, 160, 192 and 256 pixel inputs, non-square, and a size whose cell
+ * count is not a multiple of the vector length */
+static const grid_t grids[] = {
+    { 32, 32 }, { 40, 40 }, { 48, 48 }, { 64, 64 }, { 64, 48 }, { 25, 19 },
+};
+
+static float scale[MAX_CELLS * 2];
+static float offset[MAX_CELLS * 2];
+static float lms[MAX_CELLS * NB_KEYPOINTS * 2];
+static float heatmap[MAX_CELLS];
+static float ref_heatmap[MAX_CELLS];
+static pd_pp_candidate_t candidates[MAX_CELLS];
+static pp_result_t got, exp_res;
+static pd_pp_candidate_t scratch[MAX_CELLS];
+static pd_pp_nms_box_t nms_scratch[MAX_CELLS];
+
+/* ========================================================================= */
+/* SYNTHETIC OUTPUTS                                                         */
+/* ========================================================================= */
+
+static uint32_t rng_state;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float)(rng_state >> 8) / 16777216.0f;
+}
+
+static uint32_t cells(const grid_t *g)
+{
+    return (uint32_t)g->width * g->height;
+}
+
+static void gen_empty(float *h, const grid_t *g, uint32_t seed)
+{
+    rng_state = seed;
+    for (uint32_t i = 0; i < cells(g); i++) {
+        h[i] = rnd() * CONF_THRESHOLD;
+    }
+}
+
+/* A few faces: a peak and a decaying 5x5 blob of activations around it */
+static void gen_faces(float *h, const grid_t *g, uint32_t seed)
+{
+    gen_empty(h, g, seed);
+    for (uint32_t f = 0; f < 4; f++) {
+        int cx = 2 + (int)(rnd() * (g->width - 4));
+        int cy = 2 + (int)(rnd() * (g->height - 4));
+
+        for (int dy = -2; dy <= 2; dy++) {
+            for (int dx = -2; dx <= 2; dx++) {
+                float v = 0.95f - 0.12f * (float)(abs(dx) + abs(dy)) + 0.02f * rnd();
+
+                h[(cy + dy) * g->width + cx + dx] = v;
+            }
+        }
+    }
+}
+
+static void gen_dense(float *h, const grid_t *g, uint32_t seed)
+{
+    rng_state = seed;
+    for (uint32_t i = 0; i < cells(g); i++) {
+        h[i] = rnd();
+    }
+}
+
+/* Scores on either side of the threshold by one ulp, and equal to it */
+static void gen_ties(float *h, const grid_t *g, uint32_t seed)
+{
+    gen_empty(h, g, seed);
+    for (uint32_t i = 0; i < cells(g); i += 7) {
+        h[i] = (i % 3 == 0) ? CONF_THRESHOLD :
+               (i % 3 == 1) ? nextafterf(CONF_THRESHOLD, 1.0f) : nextafterf(CONF_THRESHOLD, 0.0f);
+    }
+}
+
+static void gen_tail(float *h, const grid_t *g, uint32_t seed)
+{
+    gen_empty(h, g, seed);
+    h[cells(g) - 1] = 0.9f;
+    h[cells(g) - 3] = 0.8f;
+    h[0] = 0.7f;
+}
+
+/* Flat 2x3 tops, one of them next to a higher cell */
+static void gen_plateaus(float *h, const grid_t *g, uint32_t seed)
+{
+    gen_empty(h, g, seed);
+    for (uint32_t p = 0; p < 6; p++) {
+        uint32_t cx = (uint32_t)(rnd() * (g->width - 3));
+        uint32_t cy = (uint32_t)(rnd() * (g->height - 2));
+
+        for (uint32_t dy = 0; dy < 2; dy++) {
+            for (uint32_t dx = 0; dx < 3; dx++) {
+                h[(cy + dy) * g->width + cx + dx] = 0.8f;
+            }
+        }
+        if (p == 0) {
+            h[cy * g->width + cx + 3] = 0.85f;
+        }
+    }
+}
+
+static const pp_case_t pp_cases[] = {
+    { "no detection", gen_empty, 10, AI_PD_PP_DECODE_THRESHOLD },
+    { "faces", gen_faces, 10, AI_PD_PP_DECODE_THRESHOLD },
+    { "faces, no box limit", gen_faces, 0, AI_PD_PP_DECODE_THRESHOLD },
+    { "dense", gen_dense, 10, AI_PD_PP_DECODE_THRESHOLD },
+    { "dense, limit 37", gen_dense, 37, AI_PD_PP_DECODE_THRESHOLD },
+    { "dense, no box limit", gen_dense, 0, AI_PD_PP_DECODE_THRESHOLD },
+    { "threshold ties", gen_ties, 0, AI_PD_PP_DECODE_THRESHOLD },
+    { "last cells", gen_tail, 10, AI_PD_PP_DECODE_THRESHOLD },
+    { "peaks: faces", gen_faces, 10, AI_PD_PP_DECODE_PEAKS },
+    { "peaks: faces, no limit", gen_faces, 0, AI_PD_PP_DECODE_PEAKS },
+    { "peaks: dense, no limit", gen_dense, 0, AI_PD_PP_DECODE_PEAKS },
+    { "peaks: plateaus", gen_plateaus, 0, AI_PD_PP_DECODE_PEAKS },
+    { "peaks: threshold ties", gen_ties, 0, AI_PD_PP_DECODE_PEAKS },
+    { "peaks: last cells", gen_tail, 10, AI_PD_PP_DECODE_PEAKS },
+    { "landmarks from 0.85", gen_faces, 10, AI_PD_PP_DECODE_THRESHOLD, 0.85f },
+    { "landmarks from 0.85, all", gen_faces, 0, AI_PD_PP_DECODE_THRESHOLD, 0.85f },
+};
+
+/* Best first, earlier cell first on equal scores */
+static int cell_order(const void *a, const void *b)
+{
+    const pd_pp_candidate_t *ca = a, *cb = b;
+
+    if (ca->prob != cb->prob) {
+        return (ca->prob < cb->prob) ? 1 : -1;
+    }
+    return (ca->index > cb->index) - (ca->index < cb->index);
+}
+
+/* No neighbour, the grid border excluded, is higher */
+static int is_peak(const float *h, const grid_t *g, uint32_t i)
+{
+    int x = (int)(i % g->width), y = (int)(i / g->width);
+
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (x + dx >= 0 && x + dx < g->width && y + dy >= 0 && y + dy < g->height &&
+                h[(y + dy) * g->width + x + dx] > h[i]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Copy of @p h with only the @p limit best candidate cells above the
+ *        threshold (3x3 maxima only with @p peaks)
+ * @return Number of candidate cells in @p h
+ */
+static uint32_t keep_best_cells(const float *h, float *dst, const grid_t *g, uint32_t limit,
+                                int peaks)
+{
+    uint32_t nb = 0;
+
+    for (uint32_t i = 0; i < cells(g); i++) {
+        dst[i] = (!peaks || is_peak(h, g, i)) ? h[i] : 0.0f;
+        if (dst[i] > CONF_THRESHOLD) {
+            candidates[nb].prob = h[i];
+            candidates[nb++].index = i;
+        }
+    }
+    qsort(candidates, nb, sizeof(candidates[0]), cell_order);
+    for (uint32_t k = limit; k < nb; k++) {
+        dst[candidates[k].index] = 0.0f;
+    }
+    return nb;
+}
+
+/* ========================================================================= */
+/* NETWORK OUTPUT DESCRIPTORS                                                */
+/* ========================================================================= */
+
+/* What app_postprocess_init() reads: scale, landmarks, heatmap, offset */
+static uint32_t fd_mem_shape[4][4];
+static LL_Buffer_InfoTypeDef fd_outputs[5];
+
+static void set_outputs(const grid_t *g, uint32_t heatmap_channels)
+{
+    const uint32_t channels[4] = { 2, 2 * NB_KEYPOINTS, heatmap_channels, 2 };
+
+    memset(fd_outputs, 0, sizeof(fd_outputs));
+    for (int i = 0; i < 4; i++) {
+        fd_mem_shape[i][0] = 1;
+        fd_mem_shape[i][1] = g->height;
+        fd_mem_shape[i][2] = g->width;
+        fd_mem_shape[i][3] = channels[i];
+        fd_outputs[i].name = "out";
+        fd_outputs[i].offset_end = cells(g) * channels[i] * sizeof(float);
+        fd_outputs[i].mem_shape = fd_mem_shape[i];
+        fd_outputs[i].mem_ndims = 4;
+        fd_outputs[i].type = DataType_FLOAT;
+    }
+}
+
+const LL_Buffer_InfoTypeDef *LL_ATON_Output_Buffers_Info_face_detection(void)
+{
+    return fd_outputs;
+}
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+static void reset_result(pp_result_t *r)
+{
+    memset(r, 0, sizeof(*r));
+    for (uint32_t i = 0; i < MAX_CELLS; i++) {
+        r->boxes[i].pKps = r->kps[i];
+        r->boxes[i].nb_kps = UINT32_MAX;    /* Left from a previous frame */
+    }
+    r->out.pOutData = r->boxes;
+}
+
+/* NMS must leave every output slot with its own keypoint array, or boxes
+ * decoded next frame would share one */
+static int kps_distinct(const pp_result_t *r, uint32_t nb)
+{
+    static uint8_t seen[MAX_CELLS];
+
+    memset(seen, 0, sizeof(seen));
+    for (uint32_t i = 0; i < nb; i++) {
+        size_t k = (size_t)(r->boxes[i].pKps - r->kps[0]) / NB_KEYPOINTS;
+
+        if (k >= MAX_CELLS || seen[k]++) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Boxes scoring below the threshold have no keypoints */
+static void skip_keypoints(pp_result_t *r, float kps_conf_threshold)
+{
+    for (uint32_t i = 0; i < r->out.box_nb; i++) {
+        if (r->boxes[i].prob < kps_conf_threshold) {
+            r->boxes[i].nb_kps = 0;
+        }
+    }
+}
+
+static int same_box(const pd_pp_box_t *a, const pd_pp_box_t *b)
+{
+    if (a->prob != b->prob || a->x_center != b->x_center || a->y_center != b->y_center ||
+        a->width != b->width || a->height != b->height || a->nb_kps != b->nb_kps) {
+        return 0;
+    }
+    for (uint32_t j = 0; j < a->nb_kps; j++) {
+        if (a->pKps[j].x != b->pKps[j].x || a->pKps[j].y != b->pKps[j].y) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_case(const pp_case_t *c, const grid_t *g)
+{
+    pd_model_pp_static_param_t param = {
+        .width = g->width * 4U, .height = g->height * 4U, .nb_keypoints = NB_KEYPOINTS,
+        .conf_threshold = CONF_THRESHOLD, .iou_threshold = IOU_THRESHOLD,
+        .nb_total_boxes = cells(g), .max_boxes_limit = c->max_boxes_limit ? c->max_boxes_limit : cells(g),
+        .grid_width = g->width, .grid_height = g->height, .stride = 4.0f,
+        .pTmpBuff = scratch, .pTmpNmsBuff = nms_scratch, .decode_mode = c->decode_mode,
+        .kps_conf_threshold = c->kps_conf_threshold,
+    };
+    pd_model_pp_static_param_t ref_param = param;
+    pd_model_pp_in_t in = { scale, lms, heatmap, offset };
+    pd_model_pp_in_t ref_in = { scale, lms, ref_heatmap, offset };
+    uint32_t boxes = 0, cands = 0;
+    int ok = pd_model_pp_reset(&param) == AI_PD_POSTPROCESS_ERROR_NO;
+
+    ref_param.max_boxes_limit = cells(g);
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        c->gen(heatmap, g, seed);
+        cands += keep_best_cells(heatmap, ref_heatmap, g, param.max_boxes_limit,
+                                 c->decode_mode == AI_PD_PP_DECODE_PEAKS);
+        reset_result(&got);
+        reset_result(&exp_res);
+        ok &= pd_model_pp_process(&in, &got.out, &param) == AI_PD_POSTPROCESS_ERROR_NO;
+        (void)pd_pp_ref_process(&ref_in, &exp_res.out, &ref_param);
+        skip_keypoints(&exp_res, c->kps_conf_threshold);
+
+        ok &= got.out.box_nb == exp_res.out.box_nb && kps_distinct(&got, param.max_boxes_limit);
+        for (uint32_t i = 0; ok && i < got.out.box_nb; i++) {
+            ok &= same_box(&got.boxes[i], &exp_res.boxes[i]);
+        }
+        boxes += exp_res.out.box_nb;
+    }
+
+    printf("   %-26s %2ux%-2u  %5u cells %5u boxes  %s\n", c->name, (unsigned int)g->width,
+           (unsigned int)g->height, (unsigned int)cands, (unsigned int)boxes, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+/**
+ * @brief app_postprocess_init() on the output descriptors of @p g
+ * @param expect_ok Whether the grid fits the NN_WIDTH x NN_HEIGHT input
+ */
+static int check_init(const grid_t *g, uint32_t heatmap_channels, int expect_ok)
+{
+    pd_model_pp_static_param_t param;
+    int ret, ok;
+
+    memset(&param, 0, sizeof(param));
+    set_outputs(g, heatmap_channels);
+    ret = app_postprocess_init(&param);
+    ok = expect_ok ? (ret == AI_PD_POSTPROCESS_ERROR_NO && param.grid_width == g->width &&
+                      param.grid_height == g->height && param.nb_total_boxes == cells(g) &&
+                      param.stride == (float)(NN_WIDTH / g->width))
+                   : (ret != AI_PD_POSTPROCESS_ERROR_NO);
+
+    printf("   %2ux%-2u heatmap x%u  %-8s %s\n", (unsigned int)g->width, (unsigned int)g->height,
+           (unsigned int)heatmap_channels, expect_ok ? "accepted" : "rejected", ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(void)
+{
+    static const grid_t nn_grid = { NN_WIDTH / 4, NN_HEIGHT / 4 };
+    static const grid_t fine_grid = { NN_WIDTH / 2, NN_HEIGHT / 2 };
+    static const grid_t uneven_grid = { NN_WIDTH / 4 + 1, NN_HEIGHT / 4 };
+    static const grid_t stretched_grid = { NN_WIDTH / 4, NN_HEIGHT / 2 };
+    int failed = 0;
+
+    rng_state = 12345U;
+    for (uint32_t i = 0; i < MAX_CELLS * 2; i++) {
+        scale[i] = rnd() * 4.0f - 1.0f;
+        offset[i] = rnd();
+    }
+    for (uint32_t i = 0; i < MAX_CELLS * NB_KEYPOINTS * 2; i++) {
+        lms[i] = rnd() * 1.2f - 0.1f;
+    }
+
+#ifdef AI_PD_PP_MVEF_OPTIM
+    printf("Face detection post-processing (Helium) against the reference:\n");
+#else
+    printf("Face detection post-processing (scalar) against the reference:\n");
+#endif
+    for (size_t g = 0; g < sizeof(grids) / sizeof(grids[0]); g++) {
+        for (size_t c = 0; c < sizeof(pp_cases) / sizeof(pp_cases[0]); c++) {
+            failed += !check_case(&pp_cases[c], &grids[g]);
+        }
+    }
+
+    printf("Output grid from the face_detection buffers (%ux%u input):\n",
+           (unsigned int)NN_WIDTH, (unsigned int)NN_HEIGHT);
+    failed += !check_init(&nn_grid, 1, 1);
+    failed += !check_init(&fine_grid, 1, 1);
+    failed += !check_init(&nn_grid, 2, 0);
+    failed += !check_init(&uneven_grid, 1, 0);
+    failed += !check_init(&stretched_grid, 1, 0);
+
+    printf("%d failed\n", failed);
+    return failed;
+}
@@ -0,0 +1,715 @@
+/**
+ ******************************************************************************
+ * @file    replay.c
+ * @author  PeleAB
+ * @brief   Host tool: deterministic frame replay with golden comparison
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: replay [-r] [-g golden] [-b box_tol] [-s sim_tol] [-S] [-i inputs.txt]
+ *               [-o timing.csv] [-T baseline.csv] [-l max_regress_pct] <seq_dir>
+ *
+ *   -r   record: write the golden file from this run instead of comparing
+ *   -g   golden file (default <seq_dir>/golden.txt)
+ *   -b   tolerance on normalized box and landmark coordinates (default 1e-3)
+ *   -s   tolerance on similarities (default 1e-3)
+ *   -S   serial recognition: stage each face only once the previous one is
+ *        embedded, instead of while the NPU runs
+ *   -i   also record (-r) or compare a digest of every recognition network
+ *        input, in run order
+ *   -o   write the per-stage timing summary as CSV
+ *   -T   compare stage means against a CSV written by -o; with -l, fail when
+ *        a stage is more than max_regress_pct slower
+ *
+ * Each frame of the sequence (layout in host.h) is pushed through the
+ * firmware pipeline: its NN and display frames go through the camera double
+ * buffer, its detection tensors and per-face embeddings are returned by the
+ * NPU stand-in. The detection input must be exactly the frame (converted to
+ * float CHW, or as is with DETECTION_INPUT_UINT8_HWC), whatever the capture
+ * pitch. Faces, landmarks, similarities and the voting state are then
+ * compared with the golden. The pipeline state (voting history, LED timeout)
+ * carries over between frames exactly as on the board, so a sequence is only
+ * meaningful when replayed from its first frame.
+ *
+ * Recorded with -S -r, a golden and its input digests are the reference for
+ * the overlapped recognition: replayed without -S, with tolerances at the
+ * file precision (1e-6), it must run the same inputs in the same order and
+ * give the same faces (make replay-overlap).
+ *
+ * Exit status: 0 when everything matches, 1 on mismatch or regression,
+ * 2 on usage or I/O errors.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "crop_img.h"
+#include "dummy_dual_buffer.h"
+#include "pipeline_profiler.h"
+#include "target_embedding.h"
+
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_detection);
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define REPLAY_MAX_EMBEDDINGS               AI_PD_MODEL_PP_MAX_BOXES_LIMIT
+#define REPLAY_MAX_REPORTED                 20      /**< Mismatch lines printed */
+#define REPLAY_DET_OUTPUTS                  4
+
+static const char *const stage_names[PIPELINE_STAGE_COUNT + 1] = {
+    "capture", "preprocess", "detection", "tracking", "recognition",
+    "postprocess", "output", "system", "frame"
+};
+
+/* ========================================================================= */
+/* PRIVATE DATA                                                              */
+/* ========================================================================= */
+
+/** @brief Inputs of the frame being replayed */
+typedef struct {
+    uint8_t nn_rgb[DUMMY_TEST_NN_RGB_SIZE];
+    uint16_t display[HOST_CAMERA_WIDTH * HOST_CAMERA_HEIGHT];
+    uint8_t *det[REPLAY_DET_OUTPUTS];
+    float embeddings[REPLAY_MAX_EMBEDDINGS][EMBEDDING_SIZE];
+    uint32_t embedding_nb;
+    uint32_t embedding_next;                /**< Next recognition run of the frame */
+    uint32_t input_digest[REPLAY_MAX_EMBEDDINGS]; /**< Recognition inputs, in run order */
+    int input_ok;                           /**< Detection was given exactly nn_rgb */
+} replay_frame_t;
+
+static replay_frame_t frame;
+
+static float box_tol = 1e-3f;
+static float sim_tol = 1e-3f;
+static uint32_t mismatches;
+
+/* ========================================================================= */
+/* SEQUENCE LOADING                                                          */
+/* ========================================================================= */
+
+/**
+ * @brief Read a whole file into @p dst
+ * @return Bytes read, negative if the file is missing or larger than @p max
+ */
+static long read_file(const char *dir, const char *name, void *dst, size_t max)
+{
+    char path[512];
+    FILE *f;
+    size_t got;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "rb");
+    if (!f) {
+        return -1;
+    }
+    got = fread(dst, 1, max, f);
+    if (got == max && fgetc(f) != EOF) {
+        fclose(f);
+        fprintf(stderr, "%s: larger than %lu bytes\n", path, (unsigned long)max);
+        return -2;
+    }
+    fclose(f);
+    return (long)got;
+}
+
+static int load_frame(const char *seq, uint32_t index, const LL_Buffer_InfoTypeDef *det_info)
+{
+    char dir[512];
+    long n;
+
+    snprintf(dir, sizeof(dir), REPLAY_FRAME_DIR_FMT, seq, (unsigned int)index);
+
+    n = read_file(dir, REPLAY_NN_RGB_FILE, frame.nn_rgb, sizeof(frame.nn_rgb));
+    if (n == -1) {
+        return 1; /* End of sequence */
+    }
+    if (n != (long)sizeof(frame.nn_rgb)) {
+        fprintf(stderr, "%s/%s: expected %lu bytes\n", dir, REPLAY_NN_RGB_FILE,
+                (unsigned long)sizeof(frame.nn_rgb));
+        return -1;
+    }
+
+    n = read_file(dir, REPLAY_DISPLAY_FILE, frame.display, sizeof(frame.display));
+    if (n == -1) {
+        memcpy(frame.display, dummy_test_img_buffer, sizeof(frame.display));
+    } else if (n != (long)sizeof(frame.display)) {
+        fprintf(stderr, "%s/%s: expected %lu bytes\n", dir, REPLAY_DISPLAY_FILE,
+                (unsigned long)sizeof(frame.display));
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < REPLAY_DET_OUTPUTS; i++) {
+        char name[64];
+        uint32_t len = LL_Buffer_len(&det_info[i]);
+
+        snprintf(name, sizeof(name), "face_detection_out%u.bin", (unsigned int)i);
+        if (!frame.det[i]) {
+            frame.det[i] = malloc(len);
+            if (!frame.det[i]) {
+                return -1;
+            }
+        }
+        if (read_file(dir, name, frame.det[i], len) != (long)len) {
+            fprintf(stderr, "%s/%s: missing or not %u bytes\n", dir, name, (unsigned int)len);
+            return -1;
+        }
+    }
+
+    n = read_file(dir, REPLAY_EMBEDDINGS_FILE, frame.embeddings, sizeof(frame.embeddings));
+    if (n < -1) {
+        return -1;
+    }
+    frame.embedding_nb = (n > 0) ? (uint32_t)n / (EMBEDDING_SIZE * sizeof(float)) : 0;
+    frame.embedding_next = 0;
+
+    return 0;
+}
+
+static int enroll(const char *seq)
+{
+    static float emb[EMBEDDING_BANK_SIZE][EMBEDDING_SIZE];
+    long n = read_file(seq, REPLAY_ENROLL_FILE, emb, sizeof(emb));
+
+    if (n < -1) {
+        return -1;
+    }
+    for (long i = 0; i < n / (long)(EMBEDDING_SIZE * sizeof(float)); i++) {
+        embeddings_bank_add(emb[i]);
+    }
+    return embeddings_bank_count();
+}
+
+/**
+ * @brief Check that capture and preprocessing delivered exactly the frame
+ */
+static int detection_input_matches(const LL_Buffer_InfoTypeDef *input)
+{
+#ifdef DETECTION_INPUT_UINT8_HWC
+    return memcmp(LL_Buffer_addr_start(input), frame.nn_rgb, sizeof(frame.nn_rgb)) == 0;
+#else
+    static float32_t chw[DUMMY_TEST_NN_RGB_SIZE];
+
+    img_rgb_to_chw_float_ref(frame.nn_rgb, chw, NN_WIDTH * NN_BPP, NN_WIDTH, NN_HEIGHT);
+    return LL_Buffer_len(input) == sizeof(chw) &&
+           memcmp(LL_Buffer_addr_start(input), chw, sizeof(chw)) == 0;
+#endif
+}
+
+/**
+ * @brief FNV-1a digest of a network input
+ */
+static uint32_t input_digest(const LL_Buffer_InfoTypeDef *input)
+{
+    const uint8_t *p = LL_Buffer_addr_start(input);
+    uint32_t h = 2166136261U;
+
+    for (uint32_t i = 0; i < LL_Buffer_len(input); i++) {
+        h = (h ^ p[i]) * 16777619U;
+    }
+    return h;
+}
+
+/**
+ * @brief NPU output source: the current frame's tensors, embeddings in run order
+ */
+static int replay_outputs(const NN_Instance_TypeDef *inst, const LL_Buffer_InfoTypeDef *inputs,
+                          const LL_Buffer_InfoTypeDef *outputs, void *arg)
+{
+    (void)arg;
+
+    if (strcmp(inst->network_name, "face_detection") == 0) {
+        /* Before the outputs: on target they share memory with the input */
+        frame.input_ok = detection_input_matches(&inputs[0]);
+        for (uint32_t i = 0; i < REPLAY_DET_OUTPUTS; i++) {
+            memcpy(LL_Buffer_addr_start(&outputs[i]), frame.det[i], LL_Buffer_len(&outputs[i]));
+        }
+        return 0;
+    }
+
+    if (frame.embedding_next < REPLAY_MAX_EMBEDDINGS) {
+        frame.input_digest[frame.embedding_next] = input_digest(&inputs[0]);
+    }
+    if (frame.embedding_next >= frame.embedding_nb) {
+        frame.embedding_next++;
+        return -1; /* Recorded sequence has no embedding for this run: zeros */
+    }
+    memcpy(LL_Buffer_addr_start(&outputs[0]), frame.embeddings[frame.embedding_next++],
+           EMBEDDING_SIZE * sizeof(float));
+    return 0;
+}
+
+/* ========================================================================= */
+/* GOLDEN FILE                                                               */
+/* ========================================================================= */
+/*
+ * frame <n> faces <k> detected <0|1> this <0|1> target <0|1> verified <0|1> best <sim>
+ * face <i> <score> <x_center> <y_center> <width> <height> <k> <x0> <y0> ... <x(k-1)> <y(k-1)>
+ */
+
+static void golden_write(FILE *out, uint32_t index, const host_frame_result_t *res)
+{
+    fprintf(out, "frame %u faces %u detected %u this %u target %u verified %u best %.6f\n",
+            (unsigned int)index, (unsigned int)res->face_nb, res->face_detected,
+            res->target_this_frame, res->target_detected, res->face_verified,
+            (double)res->best_similarity);
+    for (uint32_t i = 0; i < res->face_nb; i++) {
+        const host_face_t *f = &res->faces[i];
+
+        fprintf(out, "face %u %.6f %.6f %.6f %.6f %.6f %u", (unsigned int)i, (double)f->score,
+                (double)f->x_center, (double)f->y_center, (double)f->width, (double)f->height,
+                (unsigned int)f->nb_kps);
+        for (uint32_t k = 0; k < f->nb_kps; k++) {
+            fprintf(out, " %.6f %.6f", (double)f->kps[k][0], (double)f->kps[k][1]);
+        }
+        fputc('\n', out);
+    }
+}
+
+static int golden_read(FILE *in, uint32_t index, host_frame_result_t *exp)
+{
+    unsigned int n, faces, det, this_frame, target, verified;
+
+    memset(exp, 0, sizeof(*exp));
+    if (fscanf(in, " frame %u faces %u detected %u this %u target %u verified %u best %f",
+               &n, &faces, &det, &this_frame, &target, &verified, &exp->best_similarity) != 7 ||
+        n != index || faces > AI_PD_MODEL_PP_MAX_BOXES_LIMIT) {
+        return -1;
+    }
+    exp->face_nb = faces;
+    exp->face_detected = (uint8_t)det;
+    exp->target_this_frame = (uint8_t)this_frame;
+    exp->target_detected = (uint8_t)target;
+    exp->face_verified = (uint8_t)verified;
+
+    for (uint32_t i = 0; i < faces; i++) {
+        host_face_t *f = &exp->faces[i];
+        unsigned int fi, nb_kps;
+
+        if (fscanf(in, " face %u %f %f %f %f %f %u", &fi, &f->score, &f->x_center,
+                   &f->y_center, &f->width, &f->height, &nb_kps) != 7 || fi != i ||
+            nb_kps > AI_PD_MODEL_PP_NB_KEYPOINTS) {
+            return -1;
+        }
+        f->nb_kps = nb_kps;
+        for (uint32_t k = 0; k < f->nb_kps; k++) {
+            if (fscanf(in, " %f %f", &f->kps[k][0], &f->kps[k][1]) != 2) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * frame <n> runs <k> <digest 0> ... <digest k-1>
+ */
+
+static void inputs_write(FILE *out, uint32_t index)
+{
+    const uint32_t runs = (frame.embedding_next < REPLAY_MAX_EMBEDDINGS) ?
+                          frame.embedding_next : REPLAY_MAX_EMBEDDINGS;
+
+    fprintf(out, "frame %u runs %u", (unsigned int)index, (unsigned int)runs);
+    for (uint32_t r = 0; r < runs; r++) {
+        fprintf(out, " %08x", (unsigned int)frame.input_digest[r]);
+    }
+    fputc('\n', out);
+}
+
+/**
+ * @return Number of recognition runs whose input differs from the file
+ *         (every run if the run count differs), negative if malformed
+ */
+static int inputs_compare(FILE *in, uint32_t index)
+{
+    const uint32_t runs = (frame.embedding_next < REPLAY_MAX_EMBEDDINGS) ?
+                          frame.embedding_next : REPLAY_MAX_EMBEDDINGS;
+    unsigned int n, exp_runs;
+    int differ = 0;
+
+    if (fscanf(in, " frame %u runs %u", &n, &exp_runs) != 2 || n != index ||
+        exp_runs > REPLAY_MAX_EMBEDDINGS) {
+        return -1;
+    }
+    for (uint32_t r = 0; r < exp_runs; r++) {
+        unsigned int digest;
+
+        if (fscanf(in, " %x", &digest) != 1) {
+            return -1;
+        }
+        differ += (r >= runs || digest != frame.input_digest[r]);
+    }
+    return (exp_runs == runs) ? differ : (int)(runs > exp_runs ? runs : exp_runs);
+}
+
+/* ========================================================================= */
+/* COMPARISON                                                                */
+/* ========================================================================= */
+
+static void report(uint32_t index, const char *what, double got, double exp)
+{
+    if (mismatches < REPLAY_MAX_REPORTED) {
+        printf("   frame %u: %s = %.6f, expected %.6f\n", (unsigned int)index, what, got, exp);
+    } else if (mismatches == REPLAY_MAX_REPORTED) {
+        printf("   ... further mismatches not shown\n");
+    }
+    mismatches++;
+}
+
+static void check_flag(uint32_t index, const char *what, uint32_t got, uint32_t exp)
+{
+    if (got != exp) {
+        report(index, what, got, exp);
+    }
+}
+
+static void check_value(uint32_t index, const char *what, float got, float exp, float tol)
+{
+    if (!(fabsf(got - exp) <= tol)) {
+        report(index, what, got, exp);
+    }
+}
+
+static void compare(uint32_t index, const host_frame_result_t *res, const host_frame_result_t *exp)
+{
+    char what[64];
+
+    check_flag(index, "faces", res->face_nb, exp->face_nb);
+    check_flag(index, "face_detected", res->face_detected, exp->face_detected);
+    check_flag(index, "target_this_frame", res->target_this_frame, exp->target_this_frame);
+    check_flag(index, "target_detected", res->target_detected, exp->target_detected);
+    check_flag(index, "face_verified", res->face_verified, exp->face_verified);
+    check_value(index, "best_similarity", res->best_similarity, exp->best_similarity, sim_tol);
+
+    for (uint32_t i = 0; i < res->face_nb && i < exp->face_nb; i++) {
+        const host_face_t *g = &res->faces[i];
+        const host_face_t *e = &exp->faces[i];
+
+        snprintf(what, sizeof(what), "face %u score", (unsigned int)i);
+        check_value(index, what, g->score, e->score, sim_tol);
+        snprintf(what, sizeof(what), "face %u x_center", (unsigned int)i);
+        check_value(index, what, g->x_center, e->x_center, box_tol);
+        snprintf(what, sizeof(what), "face %u y_center", (unsigned int)i);
+        check_value(index, what, g->y_center, e->y_center, box_tol);
+        snprintf(what, sizeof(what), "face %u width", (unsigned int)i);
+        check_value(index, what, g->width, e->width, box_tol);
+        snprintf(what, sizeof(what), "face %u height", (unsigned int)i);
+        check_value(index, what, g->height, e->height, box_tol);
+        snprintf(what, sizeof(what), "face %u landmarks", (unsigned int)i);
+        check_flag(index, what, g->nb_kps, e->nb_kps);
+        for (uint32_t k = 0; k < g->nb_kps && k < e->nb_kps; k++) {
+            snprintf(what, sizeof(what), "face %u landmark %u x", (unsigned int)i, (unsigned int)k);
+            check_value(index, what, g->kps[k][0], e->kps[k][0], box_tol);
+            snprintf(what, sizeof(what), "face %u landmark %u y", (unsigned int)i, (unsigned int)k);
+            check_value(index, what, g->kps[k][1], e->kps[k][1], box_tol);
+        }
+    }
+}
+
+/* ========================================================================= */
+/* TIMING                                                                    */
+/* ========================================================================= */
+
+typedef struct {
+    double mean_us[PIPELINE_STAGE_COUNT + 1];
+    double p95_us[PIPELINE_STAGE_COUNT + 1];
+} timing_summary_t;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Summarize @p frames rows of per-stage ticks (last column: frame total)
+ */
+static void timing_summarize(uint32_t *ticks, uint32_t frames, timing_summary_t *sum)
+{
+    static uint32_t column[8192];
+    double us_per_tick = 1e6 / (double)profiler_tick_rate();
+    uint32_t n = (frames < 8192U) ? frames : 8192U;
+
+    memset(sum, 0, sizeof(*sum));
+    for (uint32_t s = 0; s <= PIPELINE_STAGE_COUNT; s++) {
+        uint64_t total = 0;
+
+        for (uint32_t f = 0; f < n; f++) {
+            column[f] = ticks[f * (PIPELINE_STAGE_COUNT + 1) + s];
+            total += column[f];
+        }
+        if (n == 0) {
+            continue;
+        }
+        qsort(column, n, sizeof(column[0]), cmp_u32);
+        sum->mean_us[s] = (double)total * us_per_tick / n;
+        sum->p95_us[s] = (double)column[(n * 95U) / 100U] * us_per_tick;
+    }
+}
+
+static int timing_write(const char *path, const timing_summary_t *sum)
+{
+    FILE *f = fopen(path, "w");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "stage,mean_us,p95_us\n");
+    for (uint32_t s = 0; s <= PIPELINE_STAGE_COUNT; s++) {
+        fprintf(f, "%s,%.2f,%.2f\n", stage_names[s], sum->mean_us[s], sum->p95_us[s]);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int timing_read(const char *path, timing_summary_t *sum)
+{
+    FILE *f = fopen(path, "r");
+    char line[128];
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    memset(sum, 0, sizeof(*sum));
+    while (fgets(line, sizeof(line), f)) {
+        char name[32];
+        double mean, p95;
+
+        if (sscanf(line, "%31[^,],%lf,%lf", name, &mean, &p95) != 3) {
+            continue;
+        }
+        for (uint32_t s = 0; s <= PIPELINE_STAGE_COUNT; s++) {
+            if (strcmp(name, stage_names[s]) == 0) {
+                sum->mean_us[s] = mean;
+                sum->p95_us[s] = p95;
+            }
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * @brief Print the summary, with the change against @p base when given
+ * @return Number of stages slower than @p limit_pct (if >= 0)
+ */
+static uint32_t timing_print(const timing_summary_t *sum, const timing_summary_t *base, double limit_pct)
+{
+    uint32_t regressions = 0;
+
+    printf("Stage timing (us):\n");
+    printf("   %-12s %10s %10s", "stage", "mean", "p95");
+    if (base) {
+        printf(" %10s %8s", "base mean", "change");
+    }
+    printf("\n");
+
+    for (uint32_t s = 0; s <= PIPELINE_STAGE_COUNT; s++) {
+        if (sum->mean_us[s] == 0.0 && (!base || base->mean_us[s] == 0.0)) {
+            continue; /* Stage not instrumented */
+        }
+        printf("   %-12s %10.1f %10.1f", stage_names[s], sum->mean_us[s], sum->p95_us[s]);
+        if (base && base->mean_us[s] > 0.0) {
+            double change = 100.0 * (sum->mean_us[s] - base->mean_us[s]) / base->mean_us[s];
+            int slow = (limit_pct >= 0.0 && change > limit_pct);
+
+            printf(" %10.1f %+7.1f%%%s", base->mean_us[s], change, slow ? "  REGRESSION" : "");
+            regressions += slow;
+        }
+        printf("\n");
+    }
+    return regressions;
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+static int usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-r] [-g golden] [-b box_tol] [-s sim_tol] [-S] [-i inputs.txt]\n"
+                    "       [-o timing.csv] [-T baseline.csv] [-l max_regress_pct] <seq_dir>\n", prog);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    const LL_Buffer_InfoTypeDef *det_info = LL_ATON_Output_Buffers_Info_face_detection();
+    const char *seq = NULL;
+    const char *golden_path = NULL;
+    const char *timing_path = NULL;
+    const char *baseline_path = NULL;
+    const char *inputs_path = NULL;
+    double limit_pct = -1.0;
+    int record = 0;
+    int serial = 0;
+    char default_golden[512];
+    FILE *golden;
+    FILE *inputs = NULL;
+    uint32_t *ticks = NULL;
+    uint32_t frames = 0;
+    uint32_t failed_frames = 0;
+    timing_summary_t sum, base;
+    uint32_t regressions = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0) {
+            record = 1;
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            box_tol = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            sim_tol = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-S") == 0) {
+            serial = 1;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            inputs_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            timing_path = argv[++i];
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            limit_pct = strtod(argv[++i], NULL);
+        } else if (argv[i][0] != '-' && !seq) {
+            seq = argv[i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (!seq) {
+        return usage(argv[0]);
+    }
+    if (!golden_path) {
+        snprintf(default_golden, sizeof(default_golden), "%s/%s", seq, REPLAY_GOLDEN_FILE);
+        golden_path = default_golden;
+    }
+
+    golden = fopen(golden_path, record ? "w" : "r");
+    if (!golden) {
+        perror(golden_path);
+        return 2;
+    }
+
+    if (inputs_path) {
+        inputs = fopen(inputs_path, record ? "w" : "r");
+        if (!inputs) {
+            perror(inputs_path);
+            return 2;
+        }
+    }
+
+    host_npu_set_output_source(replay_outputs, NULL);
+    if (host_pipeline_init() != 0) {
+        fprintf(stderr, "pipeline init failed\n");
+        return 2;
+    }
+    host_pipeline_set_overlap(!serial);
+    if (enroll(seq) < 0) {
+        return 2;
+    }
+
+    for (;;) {
+        host_frame_result_t res, exp;
+        int ret = load_frame(seq, frames, det_info);
+
+        if (ret > 0) {
+            break;
+        }
+        if (ret < 0) {
+            return 2;
+        }
+
+        frame.input_ok = 0;
+        host_camera_push_frame(frame.nn_rgb, frame.display);
+        if (host_pipeline_run_frame() != 0) {
+            failed_frames++;
+        }
+        host_pipeline_get_result(&res);
+        if (!frame.input_ok) {
+            printf("   frame %u: detection input differs from the captured frame\n",
+                   (unsigned int)frames);
+            mismatches++;
+        }
+        if (frame.embedding_next != frame.embedding_nb && frame.embedding_nb != 0) {
+            printf("   frame %u: %u recognition runs for %u recorded embeddings\n",
+                   (unsigned int)frames, (unsigned int)frame.embedding_next,
+                   (unsigned int)frame.embedding_nb);
+        }
+
+        if (record) {
+            golden_write(golden, frames, &res);
+        } else if (golden_read(golden, frames, &exp) != 0) {
+            printf("   frame %u: missing or malformed in %s\n", (unsigned int)frames, golden_path);
+            mismatches++;
+        } else {
+            compare(frames, &res, &exp);
+        }
+        if (inputs && record) {
+            inputs_write(inputs, frames);
+        } else if (inputs) {
+            int differ = inputs_compare(inputs, frames);
+
+            if (differ < 0) {
+                printf("   frame %u: missing or malformed in %s\n", (unsigned int)frames, inputs_path);
+                mismatches++;
+            } else if (differ > 0) {
+                printf("   frame %u: %d recognition inputs differ from %s\n", (unsigned int)frames,
+                       differ, inputs_path);
+                mismatches += (uint32_t)differ;
+            }
+        }
+
+        ticks = realloc(ticks, (size_t)(frames + 1) * (PIPELINE_STAGE_COUNT + 1) * sizeof(*ticks));
+        if (!ticks) {
+            return 2;
+        }
+        memcpy(&ticks[frames * (PIPELINE_STAGE_COUNT + 1)], res.timing.stage_times,
+               sizeof(res.timing.stage_times));
+        ticks[frames * (PIPELINE_STAGE_COUNT + 1) + PIPELINE_STAGE_COUNT] = res.timing.total_time;
+        frames++;
+    }
+    fclose(golden);
+    if (inputs) {
+        fclose(inputs);
+    }
+
+    timing_summarize(ticks, frames, &sum);
+    if (baseline_path && timing_read(baseline_path, &base) != 0) {
+        return 2;
+    }
+    printf("\n");
+    regressions = timing_print(&sum, baseline_path ? &base : NULL, limit_pct);
+    if (timing_path && timing_write(timing_path, &sum) != 0) {
+        return 2;
+    }
+    free(ticks);
+
+    printf("\nReplayed %u frames from %s (%u failed in a stage)\n", (unsigned int)frames, seq,
+           (unsigned int)failed_frames);
+    if (record) {
+        printf("Golden written to %s\n", golden_path);
+        return 0;
+    }
+    printf("%u mismatches against %s (box tol %g, similarity tol %g), %u timing regressions\n",
+           (unsigned int)mismatches, golden_path, (double)box_tol, (double)sim_tol,
+           (unsigned int)regressions);
+    return (mismatches == 0 && regressions == 0 && failed_frames == 0) ? 0 : 1;
+}
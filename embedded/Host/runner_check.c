@@ -0,0 +1,176 @@
+/**
+ ******************************************************************************
+ * @file    runner_check.c
+ * @author  PeleAB
+ * @brief   Host tool: run the NPU scheduler (nn_runner.c) against the host
+ *          runtime with a configurable number of NPU waits
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: runner_check
+ *
+ * host_npu.c makes LL_ATON_RT_RunEpochBlock() report LL_ATON_RT_WFE N times
+ * per inference. For several N the check drives the firmware nn_runner.c:
+ * Start, then Poll until done, which must stay busy for exactly the N waits,
+ * run one inference and call the completion callback once; Wait; a second
+ * Start refused while a run is busy; and a resident network that is fully
+ * initialised once, only reset for each later inference, and initialised
+ * again after a release. Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include "host.h"
+#include "nn_runner.h"
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+static const uint32_t wait_cases[] = { 0, 1, 3, 17 };
+
+#define WAIT_CASES                          (sizeof(wait_cases) / sizeof(wait_cases[0]))
+
+LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(face_detection);
+
+static NN_Instance_TypeDef *const inst = &NN_Instance_face_detection;
+
+static int report(const char *name, int ok)
+{
+    printf("   %-34s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static void count_done(nn_async_run_t *run, void *user)
+{
+    (void)run;
+    (*(uint32_t *)user)++;
+}
+
+/**
+ * @brief Poll until done; number of polls that found the run busy
+ */
+static uint32_t poll_to_done(nn_async_run_t *run)
+{
+    uint32_t busy = 0;
+
+    while (RunNetworkAsync_Poll(run) == NN_RUN_BUSY && busy <= 1000U) {
+        busy++;
+    }
+    return busy;
+}
+
+static int check_poll(void)
+{
+    int ok = 1;
+
+    for (uint32_t c = 0; c < WAIT_CASES; c++) {
+        const uint32_t n = wait_cases[c];
+        const uint32_t inferences = inst->inferences;
+        nn_async_run_t run = {0};
+        uint32_t done = 0, busy;
+
+        host_npu_set_wait_polls(n);
+        ok &= (RunNetworkAsync_Start(&run, inst, count_done, &done) == 0);
+        /* Start kicks the first epoch block: busy unless nothing to wait for */
+        ok &= (run.state == (n > 0 ? NN_RUN_BUSY : NN_RUN_DONE));
+        ok &= (inst->inferences == inferences + (n > 0 ? 0U : 1U));
+        busy = poll_to_done(&run);
+        ok &= (busy == (n > 0 ? n - 1U : 0U));
+        ok &= (run.state == NN_RUN_DONE && done == 1 && inst->inferences == inferences + 1U);
+        ok &= (run.epoch_blocks == n && run.wfe_count == n);
+        /* A finished run stays finished */
+        ok &= (RunNetworkAsync_Poll(&run) == NN_RUN_DONE && done == 1 && inst->inferences == inferences + 1U);
+    }
+    return report("start, poll busy x N, done", ok);
+}
+
+static int check_wait(void)
+{
+    int ok = 1;
+
+    for (uint32_t c = 0; c < WAIT_CASES; c++) {
+        const uint32_t n = wait_cases[c];
+        const uint32_t inferences = inst->inferences;
+        nn_async_run_t run = {0};
+        uint32_t done = 0;
+
+        host_npu_set_wait_polls(n);
+        ok &= (RunNetworkAsync_Start(&run, inst, count_done, &done) == 0);
+        RunNetworkAsync_Wait(&run);
+        ok &= (run.state == NN_RUN_DONE && done == 1 && inst->inferences == inferences + 1U);
+        ok &= (run.wfe_count == n);
+    }
+    return report("wait", ok);
+}
+
+static int check_busy_start(void)
+{
+    nn_async_run_t run = {0};
+    uint32_t done = 0, inits;
+    int ok = 1;
+
+    host_npu_set_wait_polls(3);
+    ok &= (RunNetworkAsync_Start(&run, inst, count_done, &done) == 0);
+    inits = inst->inits;
+    /* The running inference is left alone */
+    ok &= (RunNetworkAsync_Start(&run, inst, count_done, &done) < 0);
+    ok &= (inst->inits == inits && run.state == NN_RUN_BUSY);
+    ok &= (poll_to_done(&run) == 2U && done == 1);
+    ok &= (RunNetworkAsync_Start(&run, inst, count_done, &done) == 0);
+    RunNetworkAsync_Wait(&run);
+    ok &= (done == 2);
+    return report("start refused while busy", ok);
+}
+
+static int check_resident(void)
+{
+    nn_network_t net;
+    const uint32_t inits = inst->inits, resets = inst->resets, inferences = inst->inferences;
+    int ok = 1;
+
+    NN_Network_Bind(&net, inst);
+    for (uint32_t c = 0; c < WAIT_CASES; c++) {
+        const uint32_t n = wait_cases[c];
+        nn_async_run_t run = {0};
+        uint32_t done = 0;
+
+        host_npu_set_wait_polls(n);
+        ok &= (RunNetworkAsync_StartResident(&run, &net, count_done, &done) == 0);
+        /* Full init the first time only, then a reset rewinds the network */
+        ok &= (inst->inits == inits + 1U && inst->resets == resets + c);
+        ok &= (net.init_count == 1 && net.reset_count == c);
+        ok &= (poll_to_done(&run) == (n > 0 ? n - 1U : 0U));
+        ok &= (done == 1 && run.wfe_count == n && inst->inferences == inferences + c + 1U);
+    }
+
+    /* Released: the next run initialises again */
+    NN_Network_Release(&net);
+    host_npu_set_wait_polls(2);
+    RunNetworkSyncResident(&net);
+    ok &= (inst->inits == inits + 2U && net.init_count == 2 && net.reset_count == WAIT_CASES - 1U);
+    ok &= (inst->inferences == inferences + WAIT_CASES + 1U);
+    return report("resident network re-prepared", ok);
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("NPU scheduler against the host runtime:\n");
+    failed += !check_poll();
+    failed += !check_wait();
+    failed += !check_busy_start();
+    failed += !check_resident();
+
+    printf("%d failed\n", failed);
+    return failed;
+}
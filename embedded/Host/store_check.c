@@ -0,0 +1,486 @@
+/**
+ ******************************************************************************
+ * @file    store_check.c
+ * @author  PeleAB
+ * @brief   Host tool: persistent gallery store checks, power cuts and boot
+ *          time
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: store_check [-f flash.bin]
+ *
+ * gallery_store (Src/gallery_store.c) runs on the host flash stand-in
+ * (host_flash.c). Its search must return exactly what an int8 face_gallery
+ * holding the same templates returns, before and after a reboot (the flash
+ * file is unmapped and mapped again). Enrolling and deleting identities over
+ * several times the store size must keep every count right while segments
+ * are compacted; a full store must refuse templates until a delete frees
+ * room; a region of random bytes must mount empty.
+ *
+ * Power cuts: the enroll/delete workload is replayed with the power cut
+ * during each of its erase and program calls in turn, after 0, 4 and 147
+ * bytes of it (nothing, the magic, all but the last CRC byte of a record).
+ * Each time the store must mount again, hold every completed operation and
+ * either all or nothing of the interrupted one, accept new templates, and
+ * mount a third time without repairs.
+ *
+ * Boot time: 1000 identities of 3 templates are written to a 16 sector file
+ * (-f, default a temporary file), which is then mapped and mounted again as
+ * at power-up; the mount and a search are timed.
+ * Exit status is the number of failed cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "gallery_store.h"
+#include "host_flash.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define SMALL_SECTORS                       GALLERY_STORE_MIN_SECTORS
+#define BOOT_SECTORS                        16U
+#define BOOT_IDENTITIES                     1000U
+#define BOOT_TEMPLATES                      3U
+#define WORKLOAD_ROUNDS                     120U    /**< Identities enrolled */
+#define WORKLOAD_TEMPLATES                  6U      /**< Templates per identity */
+#define WORKLOAD_KEPT                       3U      /**< Identities alive at a time */
+#define MAX_K                               8U
+
+static const uint32_t cut_bytes[] = { 0, 4, 147 };
+
+static gallery_store_t store;
+static uint32_t rng_state = 1U;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+/**
+ * @brief Template @p n of @p identity, the same every time
+ */
+static void make_embedding(uint32_t identity, uint32_t n, float32_t *pEmb)
+{
+    rng_state = identity * 7919U + n * 131U + 1U;
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        pEmb[d] = rnd();
+    }
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int report(const char *name, int ok)
+{
+    printf("   %-34s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/* ========================================================================= */
+/* CHECKS                                                                    */
+/* ========================================================================= */
+
+static int check_empty(void)
+{
+    face_gallery_match_t match[MAX_K];
+    float32_t query[EMBEDDING_SIZE];
+    int ok = 1;
+
+    make_embedding(0, 0, query);
+    if (host_flash_open(NULL, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE) != 0 ||
+        gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) != GALLERY_STORE_OK ||
+        store.used != 0 || gallery_store_next_identity(&store) != 0 ||
+        gallery_store_search(&store, query, match, MAX_K) != 0 || host_flash_ops() != 0) {
+        ok = 0;
+    }
+    if (gallery_store_mount(&store, &gallery_flash_host, GALLERY_STORE_MIN_SECTORS - 1U) >= 0 ||
+        gallery_store_mount(&store, &gallery_flash_host, GALLERY_STORE_MAX_SECTORS + 1U) >= 0 ||
+        gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) != GALLERY_STORE_OK) {
+        ok = 0;
+    }
+    memset(query, 0, sizeof(query));
+    if (gallery_store_add(&store, 0, query) != GALLERY_STORE_ERR_ZERO ||
+        gallery_store_add(&store, GALLERY_STORE_MAX_IDENTITIES, query) != GALLERY_STORE_ERR_ARG) {
+        ok = 0;
+    }
+    return report("erased region, rejected inputs", ok);
+}
+
+/**
+ * @brief Store search against an int8 face_gallery with the same templates
+ */
+static int same_search(face_gallery_t *pGallery, uint32_t queries)
+{
+    face_gallery_match_t match[MAX_K], ref[MAX_K];
+    float32_t query[EMBEDDING_SIZE];
+
+    for (uint32_t q = 0; q < queries; q++) {
+        const uint32_t k = 1U + q % MAX_K;
+        uint32_t nb, nb_ref;
+
+        make_embedding(1000U + q, 0, query);
+        nb = gallery_store_search(&store, query, match, k);
+        nb_ref = face_gallery_search(pGallery, query, ref, k);
+        if (nb != nb_ref) {
+            return 0;
+        }
+        for (uint32_t i = 0; i < nb; i++) {
+            if (match[i].identity != ref[i].identity || match[i].score != ref[i].score) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int check_search(const char *path)
+{
+    static int8_t templates[FACE_GALLERY_STORAGE_Q7(64)];
+    static float32_t scale[64];
+    static uint16_t owner[64];
+    face_gallery_t gallery;
+    float32_t emb[EMBEDDING_SIZE];
+    int ok = 1;
+
+    (void)face_gallery_init_q7(&gallery, templates, scale, owner, 64);
+    if (host_flash_open(path, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE) != 0 ||
+        gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) != GALLERY_STORE_OK) {
+        return report("search against face_gallery", 0);
+    }
+    for (uint32_t t = 0; t < 64; t++) {
+        const uint16_t identity = (uint16_t)((t * 7U) % 13U);
+
+        make_embedding(identity, t, emb);
+        (void)face_gallery_add(&gallery, identity, emb);
+        if (gallery_store_add(&store, identity, emb) != GALLERY_STORE_OK) {
+            ok = 0;
+        }
+    }
+    ok &= same_search(&gallery, 64);
+    ok &= (gallery_store_identity_count(&store, 3) == face_gallery_identity_count(&gallery, 3));
+    ok &= (gallery_store_next_identity(&store) == 13);
+    ok = report("search against face_gallery", ok);
+
+    /* Reboot: map the file again */
+    host_flash_close();
+    if (host_flash_open(path, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE) != 0 ||
+        gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) != GALLERY_STORE_OK ||
+        store.repaired != 0 || host_flash_ops() != 0 || !same_search(&gallery, 64) ||
+        gallery_store_next_identity(&store) != 13) {
+        return report("same search after a reboot", 0) && 0;
+    }
+    return report("same search after a reboot", 1) && ok;
+}
+
+static int check_compaction(void)
+{
+    uint32_t count[WORKLOAD_ROUNDS] = { 0 };
+    face_gallery_match_t match[MAX_K];
+    float32_t emb[EMBEDDING_SIZE];
+    int ok = 1;
+
+    (void)host_flash_open(NULL, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE);
+    (void)gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS);
+    for (uint32_t r = 0; r < WORKLOAD_ROUNDS; r++) {
+        for (uint32_t t = 0; t < WORKLOAD_TEMPLATES; t++) {
+            make_embedding(r, t, emb);
+            ok &= (gallery_store_add(&store, (uint16_t)r, emb) == GALLERY_STORE_OK);
+            count[r]++;
+        }
+        if (r >= WORKLOAD_KEPT) {
+            ok &= (gallery_store_delete(&store, (uint16_t)(r - WORKLOAD_KEPT)) == GALLERY_STORE_OK);
+            count[r - WORKLOAD_KEPT] = 0;
+        }
+    }
+    for (uint32_t r = 0; r < WORKLOAD_ROUNDS; r++) {
+        ok &= (gallery_store_identity_count(&store, (uint16_t)r) == count[r]);
+    }
+    /* Only the kept identities are found, and a template finds its own */
+    make_embedding(WORKLOAD_ROUNDS - 1U, 2, emb);
+    if (gallery_store_search(&store, emb, match, MAX_K) != WORKLOAD_KEPT ||
+        match[0].identity != WORKLOAD_ROUNDS - 1U || match[0].score < 0.99f) {
+        ok = 0;
+    }
+    for (uint32_t i = 0; i < WORKLOAD_KEPT && ok; i++) {
+        ok = (count[match[i].identity] != 0);
+    }
+    /* The ring went round: the first sectors were compacted and reused */
+    ok &= (host_flash_erases() > SMALL_SECTORS);
+    printf("   %u templates written to %u segments of %u, %u erases\n",
+           (unsigned int)(WORKLOAD_ROUNDS * WORKLOAD_TEMPLATES), (unsigned int)SMALL_SECTORS,
+           (unsigned int)(GALLERY_STORE_SLOTS - 1U), (unsigned int)host_flash_erases());
+    ok = report("delete and compaction", ok);
+
+    if (gallery_store_clear(&store) != GALLERY_STORE_OK ||
+        gallery_store_search(&store, emb, match, MAX_K) != 0 ||
+        gallery_store_next_identity(&store) != (int)WORKLOAD_ROUNDS ||
+        gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) != GALLERY_STORE_OK ||
+        gallery_store_search(&store, emb, match, MAX_K) != 0 ||
+        gallery_store_add(&store, WORKLOAD_ROUNDS - 1U, emb) != GALLERY_STORE_ERR_ARG) {
+        return report("clear", 0) && 0;
+    }
+    return report("clear", 1) && ok;
+}
+
+static int check_full(void)
+{
+    const uint32_t capacity = (SMALL_SECTORS - 2U) * (GALLERY_STORE_SLOTS - 1U);
+    float32_t emb[EMBEDDING_SIZE];
+    uint32_t added = 0;
+    int ret = GALLERY_STORE_OK;
+    int ok = 1;
+
+    (void)host_flash_open(NULL, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE);
+    (void)gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS);
+    while (ret == GALLERY_STORE_OK && added <= capacity) {
+        make_embedding(added / 10U, added, emb);
+        ret = gallery_store_add(&store, (uint16_t)(added / 10U), emb);
+        added += (ret == GALLERY_STORE_OK);
+    }
+    ok &= (ret == GALLERY_STORE_ERR_FULL && added == capacity);
+    /* A delete frees room; the tombstone fits in the slack segment */
+    ok &= (gallery_store_delete(&store, 0) == GALLERY_STORE_OK);
+    for (uint32_t t = 0; t < 10U && ok; t++) {
+        make_embedding(999, t, emb);
+        ok &= (gallery_store_add(&store, 999, emb) == GALLERY_STORE_OK);
+    }
+    make_embedding(999, 10, emb);
+    ok &= (gallery_store_add(&store, 999, emb) == GALLERY_STORE_ERR_FULL);
+    ok &= (gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) == GALLERY_STORE_OK &&
+           gallery_store_identity_count(&store, 999) == 10U &&
+           gallery_store_identity_count(&store, 0) == 0);
+    return report("full store", ok);
+}
+
+static int check_foreign(void)
+{
+    const uint32_t size = SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE;
+    face_gallery_match_t match[MAX_K];
+    float32_t emb[EMBEDDING_SIZE];
+    uint8_t *junk = malloc(size);
+    int ok = 1;
+
+    if (!junk) {
+        return report("random bytes", 0);
+    }
+    (void)host_flash_open(NULL, size);
+    rng_state = 77U;
+    for (uint32_t i = 0; i < size; i++) {
+        junk[i] = (uint8_t)(rnd() * 128.0f);
+    }
+    (void)gallery_flash_host.program(0, junk, size);
+    free(junk);
+    make_embedding(5, 0, emb);
+    ok &= (gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) == GALLERY_STORE_OK);
+    ok &= (store.used == 0 && gallery_store_search(&store, emb, match, MAX_K) == 0);
+    ok &= (gallery_store_add(&store, 5, emb) == GALLERY_STORE_OK);
+    ok &= (gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) == GALLERY_STORE_OK);
+    ok &= (gallery_store_search(&store, emb, match, MAX_K) == 1 && match[0].identity == 5);
+    return report("random bytes", ok);
+}
+
+/* ========================================================================= */
+/* POWER CUTS                                                                */
+/* ========================================================================= */
+
+/**
+ * @brief Enroll/delete workload until the power goes
+ * @param pCount Templates of each identity after the completed operations
+ * @param pCut Operation cut: identity, and its count had it completed
+ * @return 1 if the power was cut
+ */
+static int run_workload(uint32_t *pCount, int *pCutIdentity, uint32_t *pCutCount)
+{
+    float32_t emb[EMBEDDING_SIZE];
+
+    memset(pCount, 0, WORKLOAD_ROUNDS * sizeof(uint32_t));
+    (void)gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS);
+    for (uint32_t r = 0; r < WORKLOAD_ROUNDS; r++) {
+        for (uint32_t t = 0; t < WORKLOAD_TEMPLATES; t++) {
+            make_embedding(r, t, emb);
+            (void)gallery_store_add(&store, (uint16_t)r, emb);
+            if (host_flash_is_cut()) {
+                *pCutIdentity = (int)r;
+                *pCutCount = pCount[r] + 1U;
+                return 1;
+            }
+            pCount[r]++;
+        }
+        if (r >= WORKLOAD_KEPT) {
+            (void)gallery_store_delete(&store, (uint16_t)(r - WORKLOAD_KEPT));
+            if (host_flash_is_cut()) {
+                *pCutIdentity = (int)(r - WORKLOAD_KEPT);
+                *pCutCount = 0;
+                return 1;
+            }
+            pCount[r - WORKLOAD_KEPT] = 0;
+        }
+    }
+    return 0;
+}
+
+static int check_power_cuts(void)
+{
+    uint32_t count[WORKLOAD_ROUNDS];
+    face_gallery_match_t match[MAX_K];
+    float32_t emb[EMBEDDING_SIZE];
+    uint32_t total_ops, runs = 0, failed = 0, repaired = 0;
+    int cut_identity;
+    uint32_t cut_count;
+
+    (void)host_flash_open(NULL, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE);
+    host_flash_power_on();
+    (void)run_workload(count, &cut_identity, &cut_count);
+    total_ops = host_flash_ops();
+
+    for (uint32_t op = 0; op < total_ops; op++) {
+        for (size_t b = 0; b < sizeof(cut_bytes) / sizeof(cut_bytes[0]); b++) {
+            int ok = 1;
+
+            (void)host_flash_open(NULL, SMALL_SECTORS * GALLERY_STORE_SECTOR_SIZE);
+            host_flash_power_cut(op, cut_bytes[b]);
+            if (!run_workload(count, &cut_identity, &cut_count)) {
+                host_flash_power_on();
+                continue;
+            }
+            host_flash_power_on();
+            runs++;
+
+            /* Reboot */
+            if (gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) != GALLERY_STORE_OK) {
+                ok = 0;
+            }
+            repaired += store.repaired;
+            for (uint32_t r = 0; r < WORKLOAD_ROUNDS && ok; r++) {
+                const uint32_t nb = gallery_store_identity_count(&store, (uint16_t)r);
+
+                ok = (nb == count[r] || ((int)r == cut_identity && nb == cut_count));
+            }
+            /* Every match is a live identity */
+            make_embedding(WORKLOAD_ROUNDS, 0, emb);
+            for (uint32_t i = 0, nb = gallery_store_search(&store, emb, match, MAX_K); i < nb && ok; i++) {
+                ok = (gallery_store_identity_count(&store, match[i].identity) != 0);
+            }
+            /* Still writable, and clean on the next boot */
+            ok &= (gallery_store_add(&store, WORKLOAD_ROUNDS, emb) == GALLERY_STORE_OK);
+            ok &= (gallery_store_mount(&store, &gallery_flash_host, SMALL_SECTORS) == GALLERY_STORE_OK &&
+                   store.repaired == 0 &&
+                   gallery_store_identity_count(&store, WORKLOAD_ROUNDS) == 1U &&
+                   gallery_store_search(&store, emb, match, 1) == 1 &&
+                   match[0].identity == WORKLOAD_ROUNDS);
+            if (!ok && failed++ < 5) {
+                printf("   cut in flash call %u after %u bytes: FAILED\n", (unsigned int)op,
+                       (unsigned int)cut_bytes[b]);
+            }
+        }
+    }
+    printf("   %u power cuts over %u flash calls, %u torn records repaired\n",
+           (unsigned int)runs, (unsigned int)total_ops, (unsigned int)repaired);
+    return report("power cuts", failed == 0 && runs > 0);
+}
+
+/* ========================================================================= */
+/* BOOT TIME                                                                 */
+/* ========================================================================= */
+
+static int check_boot(const char *path)
+{
+    const uint32_t size = BOOT_SECTORS * GALLERY_STORE_SECTOR_SIZE;
+    face_gallery_match_t match[MAX_K];
+    float32_t emb[EMBEDDING_SIZE];
+    double t_write, t_mount = 1e30, t_search = 1e30;
+    int ok = 1;
+
+    (void)unlink(path);
+    if (host_flash_open(path, size) != 0 ||
+        gallery_store_mount(&store, &gallery_flash_host, BOOT_SECTORS) != GALLERY_STORE_OK) {
+        return report("boot", 0);
+    }
+    t_write = now_us();
+    for (uint32_t i = 0; i < BOOT_IDENTITIES; i++) {
+        for (uint32_t t = 0; t < BOOT_TEMPLATES; t++) {
+            make_embedding(i, t, emb);
+            ok &= (gallery_store_add(&store, (uint16_t)i, emb) == GALLERY_STORE_OK);
+        }
+    }
+    t_write = now_us() - t_write;
+    host_flash_close();
+
+    for (int run = 0; run < 20 && ok; run++) {
+        double t0, t1, t2;
+
+        ok &= (host_flash_open(path, size) == 0);
+        t0 = now_us();
+        ok &= (gallery_store_mount(&store, &gallery_flash_host, BOOT_SECTORS) == GALLERY_STORE_OK);
+        t1 = now_us();
+        ok &= (gallery_store_search(&store, emb, match, 1) == 1);
+        t2 = now_us();
+        if (t1 - t0 < t_mount) {
+            t_mount = t1 - t0;
+        }
+        if (t2 - t1 < t_search) {
+            t_search = t2 - t1;
+        }
+        host_flash_close();
+    }
+    ok &= (match[0].identity == BOOT_IDENTITIES - 1U && store.repaired == 0 &&
+           gallery_store_next_identity(&store) == (int)BOOT_IDENTITIES);
+    printf("   %u identities x %u templates: written in %.0f us, mount %.0f us, search %.0f us\n",
+           (unsigned int)BOOT_IDENTITIES, (unsigned int)BOOT_TEMPLATES, t_write, t_mount, t_search);
+    (void)unlink(path);
+    return report("boot", ok);
+}
+
+int main(int argc, char **argv)
+{
+    char path[64] = "/tmp/store_check_XXXXXX";
+    int failed = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-f") == 0) {
+        snprintf(path, sizeof(path), "%s", argv[2]);
+    } else if (argc == 1) {
+        const int fd = mkstemp(path);
+
+        if (fd < 0) {
+            perror(path);
+            return 1;
+        }
+        close(fd);
+    } else {
+        fprintf(stderr, "usage: %s [-f flash.bin]\n", argv[0]);
+        return 2;
+    }
+
+    printf("Gallery store on the host flash stand-in:\n");
+    failed += !check_empty();
+    failed += !check_search(path);
+    failed += !check_compaction();
+    failed += !check_full();
+    failed += !check_foreign();
+    failed += !check_power_cuts();
+    failed += !check_boot(path);
+    host_flash_close();
+
+    printf("%d failed\n", failed);
+    return failed;
+}
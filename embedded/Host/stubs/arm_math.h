@@ -0,0 +1,24 @@
+/**
+ ******************************************************************************
+ * @file    arm_math.h
+ * @brief   Minimal CMSIS-DSP stand-in for host builds
+ ******************************************************************************
+ */
+
+#ifndef HOST_ARM_MATH_H
+#define HOST_ARM_MATH_H
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+
+/* The real header pulls in arm_mve.h on Helium targets */
+#ifdef HOST_MVE_EMULATION
+#include "arm_mve_emul.h"
+#endif
+
+#endif /* HOST_ARM_MATH_H */
@@ -0,0 +1,178 @@
+/**
+ ******************************************************************************
+ * @file    arm_mve_emul.h
+ * @brief   Scalar emulation of the Helium (MVE) intrinsics used by Src/ kernels
+ ******************************************************************************
+ *
+ * Only for the host checks (Host/kernel_check.c, Host/pp_check.c and
+ * Host/gallery_check.c, built with -DHOST_MVE_EMULATION so that arm_math.h
+ * includes it): it lets the MVE code paths run lane by lane on Linux so they
+ * can be compared with the scalar references. Each intrinsic follows the ACLE definition,
+ * including zeroing of inactive lanes for the _z forms. Add intrinsics here
+ * as kernels start using them.
+ */
+
+#ifndef HOST_ARM_MVE_EMUL_H
+#define HOST_ARM_MVE_EMUL_H
+
+#include <stdint.h>
+
+typedef uint16_t mve_pred16_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+typedef struct { float v[4]; } float32x4_t;
+typedef struct { int8_t v[16]; } int8x16_t;
+
+/** @brief Predicate of the first @p n 32-bit lanes (4 bits per lane) */
+static inline mve_pred16_t vctp32q(uint32_t n)
+{
+    return (n >= 4U) ? 0xFFFFU : (mve_pred16_t)((1U << (4U * n)) - 1U);
+}
+
+static inline int mve_emul_lane32(mve_pred16_t p, int lane)
+{
+    return (p >> (4 * lane)) & 1;
+}
+
+static inline uint32x4_t vidupq_n_u32(uint32_t start, int imm)
+{
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = start + (uint32_t)(i * imm);
+    }
+    return r;
+}
+
+static inline uint32x4_t vmulq_n_u32(uint32x4_t a, uint32_t b)
+{
+    for (int i = 0; i < 4; i++) {
+        a.v[i] *= b;
+    }
+    return a;
+}
+
+static inline uint32x4_t vldrbq_gather_offset_z_u32(const uint8_t *base, uint32x4_t offset, mve_pred16_t p)
+{
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = mve_emul_lane32(p, i) ? base[offset.v[i]] : 0U;
+    }
+    return r;
+}
+
+/** @brief base[offset << 2] as float per active lane, 0 in the others */
+static inline float32x4_t vldrwq_gather_shifted_offset_z_f32(const float *base, uint32x4_t offset,
+                                                             mve_pred16_t p)
+{
+    float32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = mve_emul_lane32(p, i) ? base[offset.v[i]] : 0.0f;
+    }
+    return r;
+}
+
+static inline float32x4_t vcvtq_f32_u32(uint32x4_t a)
+{
+    float32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = (float)a.v[i];
+    }
+    return r;
+}
+
+/** @brief a * b + c per lane (fused on the target) */
+static inline float32x4_t vfmasq_n_f32(float32x4_t a, float32x4_t b, float c)
+{
+    for (int i = 0; i < 4; i++) {
+        a.v[i] = a.v[i] * b.v[i] + c;
+    }
+    return a;
+}
+
+static inline float32x4_t vdupq_n_f32(float a)
+{
+    float32x4_t r = { { a, a, a, a } };
+    return r;
+}
+
+static inline float32x4_t vldrwq_z_f32(const float *base, mve_pred16_t p)
+{
+    float32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = mve_emul_lane32(p, i) ? base[i] : 0.0f;
+    }
+    return r;
+}
+
+/** @brief Predicate of the lanes where a > b, among the lanes active in @p p */
+static inline mve_pred16_t vcmpgtq_m_n_f32(float32x4_t a, float b, mve_pred16_t p)
+{
+    mve_pred16_t r = 0;
+    for (int i = 0; i < 4; i++) {
+        if (mve_emul_lane32(p, i) && a.v[i] > b) {
+            r |= (mve_pred16_t)(0xFU << (4 * i));
+        }
+    }
+    return r;
+}
+
+static inline void vstrwq_p_f32(float *base, float32x4_t a, mve_pred16_t p)
+{
+    for (int i = 0; i < 4; i++) {
+        if (mve_emul_lane32(p, i)) {
+            base[i] = a.v[i];
+        }
+    }
+}
+
+static inline float32x4_t vldrwq_f32(const float *base)
+{
+    float32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = base[i];
+    }
+    return r;
+}
+
+static inline void vstrwq_f32(float *base, float32x4_t a)
+{
+    for (int i = 0; i < 4; i++) {
+        base[i] = a.v[i];
+    }
+}
+
+static inline float32x4_t vaddq_f32(float32x4_t a, float32x4_t b)
+{
+    for (int i = 0; i < 4; i++) {
+        a.v[i] += b.v[i];
+    }
+    return a;
+}
+
+/** @brief a + b * c per lane (fused on the target) */
+static inline float32x4_t vfmaq_n_f32(float32x4_t a, float32x4_t b, float c)
+{
+    for (int i = 0; i < 4; i++) {
+        a.v[i] += b.v[i] * c;
+    }
+    return a;
+}
+
+static inline int8x16_t vldrbq_s8(const int8_t *base)
+{
+    int8x16_t r;
+    for (int i = 0; i < 16; i++) {
+        r.v[i] = base[i];
+    }
+    return r;
+}
+
+/** @brief acc + sum of a * b over the 16 lanes */
+static inline int32_t vmladavaq_s8(int32_t acc, int8x16_t a, int8x16_t b)
+{
+    for (int i = 0; i < 16; i++) {
+        acc += (int32_t)a.v[i] * b.v[i];
+    }
+    return acc;
+}
+
+#endif /* HOST_ARM_MVE_EMUL_H */
@@ -0,0 +1,9 @@
+/* Host build stand-in for the camera middleware, see host_platform.c */
+#ifndef HOST_CMW_CAMERA_H
+#define HOST_CMW_CAMERA_H
+#include "host_hal.h"
+
+#define CMW_MODE_CONTINUOUS                 0U
+#define CMW_MODE_SNAPSHOT                   1U
+
+#endif
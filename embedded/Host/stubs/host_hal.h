@@ -0,0 +1,318 @@
+/**
+ ******************************************************************************
+ * @file    host_hal.h
+ * @author  PeleAB
+ * @brief   HAL, CMSIS and BSP stand-ins for the host (Linux) build
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Only what the CPU pipeline sources reference is provided. Cache maintenance
+ * and clock/reset macros compile to nothing; LEDs, button, UART and CRC are
+ * implemented in host_platform.c, and the DMA2D in host_dma2d.c.
+ */
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================= */
+/* CORE                                                                      */
+/* ========================================================================= */
+
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define UNUSED(x)                           ((void)(x))
+#define __BKPT(n)                           __builtin_trap()
+#define __DSB()                             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DMB()                             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB()                             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __WFE()                             do { } while (0)
+#define __disable_irq()                     do { } while (0)
+#define __enable_irq()                      do { } while (0)
+
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+
+/* Host memory is coherent: cache maintenance is a no-op */
+static inline void SCB_CleanDCache_by_Addr(volatile void *addr, int32_t size)
+{
+    (void)addr;
+    (void)size;
+}
+
+static inline void SCB_InvalidateDCache_by_Addr(volatile void *addr, int32_t size)
+{
+    (void)addr;
+    (void)size;
+}
+
+static inline void SCB_CleanInvalidateDCache_by_Addr(volatile void *addr, int32_t size)
+{
+    (void)addr;
+    (void)size;
+}
+
+/* ========================================================================= */
+/* CACHEAXI (MSP callbacks in main.c)                                        */
+/* ========================================================================= */
+
+typedef struct {
+    void *Instance;
+} CACHEAXI_HandleTypeDef;
+
+#define __HAL_RCC_CACHEAXIRAM_MEM_CLK_ENABLE()  do { } while (0)
+#define __HAL_RCC_CACHEAXIRAM_MEM_CLK_DISABLE() do { } while (0)
+#define __HAL_RCC_CACHEAXI_CLK_ENABLE()         do { } while (0)
+#define __HAL_RCC_CACHEAXI_CLK_DISABLE()        do { } while (0)
+#define __HAL_RCC_CACHEAXI_FORCE_RESET()        do { } while (0)
+#define __HAL_RCC_CACHEAXI_RELEASE_RESET()      do { } while (0)
+
+/* ========================================================================= */
+/* DCMIPP (system_utils.h prototypes only)                                   */
+/* ========================================================================= */
+
+typedef struct {
+    void *Instance;
+} DCMIPP_HandleTypeDef;
+
+/* ========================================================================= */
+/* UART / CRC (enhanced PC stream)                                           */
+/* ========================================================================= */
+
+typedef struct {
+    void *Instance;
+} UART_HandleTypeDef;
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t HwFlowCtl;
+} MX_UART_InitTypeDef;
+
+#define UART_WORDLENGTH_8B                  0U
+#define UART_STOPBITS_1                     0U
+#define UART_PARITY_NONE                    0U
+#define UART_HWCONTROL_NONE                 0U
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data,
+                                    uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data,
+                                   uint16_t size, uint32_t timeout);
+
+typedef struct {
+    uint32_t DefaultPolynomialUse;
+    uint32_t DefaultInitValueUse;
+    uint32_t CRCLength;
+    uint32_t InputDataInversionMode;
+    uint32_t OutputDataInversionMode;
+} CRC_InitTypeDef;
+
+typedef struct {
+    void *Instance;
+    CRC_InitTypeDef Init;
+    uint32_t InputDataFormat;
+} CRC_HandleTypeDef;
+
+#define CRC                                 ((void *)0)
+#define DEFAULT_POLYNOMIAL_ENABLE           0U
+#define DEFAULT_INIT_VALUE_ENABLE           0U
+#define CRC_POLYLENGTH_32B                  0U
+#define CRC_INPUTDATA_INVERSION_NONE        0U
+#define CRC_OUTPUTDATA_INVERSION_DISABLE    0U
+#define CRC_INPUTDATA_FORMAT_WORDS          0U
+#define __HAL_RCC_CRC_CLK_ENABLE()          do { } while (0)
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc);
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t *data, uint32_t words);
+
+/* ========================================================================= */
+/* DMA2D (blit_dma2d.c, emulated in host_dma2d.c)                            */
+/* ========================================================================= */
+
+typedef struct {
+    uint32_t Mode;
+    uint32_t ColorMode;
+    uint32_t OutputOffset;
+    uint32_t AlphaInverted;
+    uint32_t RedBlueSwap;
+    uint32_t BytesSwap;
+    uint32_t LineOffsetMode;
+} DMA2D_InitTypeDef;
+
+typedef struct {
+    uint32_t InputOffset;
+    uint32_t InputColorMode;
+    uint32_t AlphaMode;
+    uint32_t InputAlpha;
+    uint32_t AlphaInverted;
+    uint32_t RedBlueSwap;
+    uint32_t ChromaSubSampling;
+} DMA2D_LayerCfgTypeDef;
+
+typedef struct {
+    void *Instance;
+    DMA2D_InitTypeDef Init;
+    DMA2D_LayerCfgTypeDef LayerCfg[2];
+    uint32_t State;
+    uint32_t ErrorCode;
+} DMA2D_HandleTypeDef;
+
+#define DMA2D                               ((void *)0)
+#define DMA2D_M2M                           0x00000000U
+#define DMA2D_M2M_PFC                       0x00010000U
+#define DMA2D_M2M_BLEND                     0x00020000U
+#define DMA2D_R2M                           0x00030000U
+#define DMA2D_OUTPUT_ARGB8888               0x00000000U
+#define DMA2D_OUTPUT_RGB888                 0x00000001U
+#define DMA2D_OUTPUT_RGB565                 0x00000002U
+#define DMA2D_OUTPUT_ARGB4444               0x00000004U
+#define DMA2D_INPUT_ARGB8888                0x00000000U
+#define DMA2D_INPUT_RGB888                  0x00000001U
+#define DMA2D_INPUT_RGB565                  0x00000002U
+#define DMA2D_INPUT_ARGB4444                0x00000004U
+#define DMA2D_NO_MODIF_ALPHA                0x00000000U
+#define DMA2D_REPLACE_ALPHA                 0x00000001U
+#define DMA2D_COMBINE_ALPHA                 0x00000002U
+#define DMA2D_REGULAR_ALPHA                 0x00000000U
+#define DMA2D_RB_REGULAR                    0x00000000U
+#define DMA2D_RB_SWAP                       0x00000001U
+#define DMA2D_BYTES_REGULAR                 0x00000000U
+#define DMA2D_LOM_PIXELS                    0x00000000U
+#define DMA2D_LOM_BYTES                     0x00000040U
+#define DMA2D_NO_CSS                        0x00000000U
+#define DMA2D_BACKGROUND_LAYER              0x00000000U
+#define DMA2D_FOREGROUND_LAYER              0x00000001U
+#define __HAL_RCC_DMA2D_CLK_ENABLE()        do { } while (0)
+
+/* Addresses are uintptr_t (uint32_t in the HAL) to hold 64-bit host pointers */
+HAL_StatusTypeDef HAL_DMA2D_Init(DMA2D_HandleTypeDef *hdma2d);
+HAL_StatusTypeDef HAL_DMA2D_ConfigLayer(DMA2D_HandleTypeDef *hdma2d, uint32_t LayerIdx);
+HAL_StatusTypeDef HAL_DMA2D_Start(DMA2D_HandleTypeDef *hdma2d, uintptr_t pdata, uintptr_t DstAddress,
+                                  uint32_t Width, uint32_t Height);
+HAL_StatusTypeDef HAL_DMA2D_BlendingStart(DMA2D_HandleTypeDef *hdma2d, uintptr_t SrcAddress1,
+                                          uintptr_t SrcAddress2, uintptr_t DstAddress,
+                                          uint32_t Width, uint32_t Height);
+HAL_StatusTypeDef HAL_DMA2D_PollForTransfer(DMA2D_HandleTypeDef *hdma2d, uint32_t Timeout);
+HAL_StatusTypeDef HAL_DMA2D_Abort(DMA2D_HandleTypeDef *hdma2d);
+
+/* ========================================================================= */
+/* BSP                                                                       */
+/* ========================================================================= */
+
+typedef enum { LED1 = 0, LED2, LEDn } Led_TypeDef;
+typedef enum { BUTTON_USER1 = 0, BUTTONn } Button_TypeDef;
+typedef enum { BUTTON_MODE_GPIO = 0, BUTTON_MODE_EXTI } ButtonMode_TypeDef;
+typedef enum { COM1 = 0, COMn } COM_TypeDef;
+
+#define BSP_ERROR_NONE                      0
+
+extern UART_HandleTypeDef hcom_uart[COMn];
+
+int32_t BSP_LED_Init(Led_TypeDef led);
+int32_t BSP_LED_On(Led_TypeDef led);
+int32_t BSP_LED_Off(Led_TypeDef led);
+int32_t BSP_LED_Toggle(Led_TypeDef led);
+int32_t BSP_PB_Init(Button_TypeDef button, ButtonMode_TypeDef mode);
+int32_t BSP_PB_GetState(Button_TypeDef button);
+int32_t BSP_COM_Init(COM_TypeDef com, MX_UART_InitTypeDef *init);
+int32_t BSP_COM_SelectLogPort(COM_TypeDef com);
+
+/* ========================================================================= */
+/* LCD (display_utils.c, stm32_lcd_ex.c)                                     */
+/* ========================================================================= */
+
+typedef struct {
+    const uint8_t *table;
+    uint16_t Width;
+    uint16_t Height;
+} sFONT;
+
+typedef enum {
+    CENTER_MODE = 0x01,
+    RIGHT_MODE = 0x02,
+    LEFT_MODE = 0x03
+} Text_AlignModeTypdef;
+
+typedef struct {
+    uint32_t X0;
+    uint32_t X1;
+    uint32_t Y0;
+    uint32_t Y1;
+    uint32_t PixelFormat;
+    uint32_t Address;
+} BSP_LCD_LayerConfig_t;
+
+typedef struct {
+    void *Instance;
+} LTDC_HandleTypeDef;
+
+typedef struct {
+    int dummy;
+} LCD_UTILS_Drv_t;
+
+extern sFONT Font20;
+extern LTDC_HandleTypeDef hlcd_ltdc;
+extern const LCD_UTILS_Drv_t LCD_Driver;
+
+#define LINE(x)                             ((x) * Font20.Height)
+#define LCD_ORIENTATION_LANDSCAPE           0U
+#define LCD_PIXEL_FORMAT_ARGB4444           0x04U
+#define LCD_PIXEL_FORMAT_RGB565             0x02U
+#define LTDC_LAYER_1                        0U
+#define LTDC_LAYER_2                        1U
+#define LTDC_RELOAD_VERTICAL_BLANKING       0x02U
+
+#define UTIL_LCD_COLOR_BLUE                 0xFF0000FFUL
+#define UTIL_LCD_COLOR_GREEN                0xFF00FF00UL
+#define UTIL_LCD_COLOR_RED                  0xFFFF0000UL
+#define UTIL_LCD_COLOR_CYAN                 0xFF00FFFFUL
+#define UTIL_LCD_COLOR_MAGENTA              0xFFFF00FFUL
+#define UTIL_LCD_COLOR_YELLOW               0xFFFFFF00UL
+#define UTIL_LCD_COLOR_GRAY                 0xFF808080UL
+#define UTIL_LCD_COLOR_BLACK                0xFF000000UL
+#define UTIL_LCD_COLOR_BROWN                0xFFA52A2AUL
+#define UTIL_LCD_COLOR_ORANGE               0xFFFFA500UL
+#define UTIL_LCD_COLOR_WHITE                0xFFFFFFFFUL
+
+int32_t BSP_LCD_Init(uint32_t instance, uint32_t orientation);
+int32_t BSP_LCD_ConfigLayer(uint32_t instance, uint32_t layer, BSP_LCD_LayerConfig_t *config);
+HAL_StatusTypeDef HAL_LTDC_SetAddress_NoReload(LTDC_HandleTypeDef *hltdc, uint32_t address, uint32_t layer);
+HAL_StatusTypeDef HAL_LTDC_ReloadLayer(LTDC_HandleTypeDef *hltdc, uint32_t type, uint32_t layer);
+
+void UTIL_LCD_SetFuncDriver(const LCD_UTILS_Drv_t *driver);
+void UTIL_LCD_SetLayer(uint32_t layer);
+void UTIL_LCD_SetFont(sFONT *font);
+sFONT *UTIL_LCD_GetFont(void);
+void UTIL_LCD_SetTextColor(uint32_t color);
+void UTIL_LCD_SetBackColor(uint32_t color);
+void UTIL_LCD_Clear(uint32_t color);
+void UTIL_LCD_FillRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t color);
+void UTIL_LCD_DrawRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t color);
+void UTIL_LCD_DrawLine(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t color);
+void UTIL_LCD_SetPixel(uint32_t x, uint32_t y, uint32_t color);
+void UTIL_LCD_DisplayStringAt(uint32_t x, uint32_t y, uint8_t *text, Text_AlignModeTypdef mode);
+void UTIL_LCD_DisplayStringAtLine(uint32_t line, uint8_t *text);
+
+#endif /* HOST_HAL_H */
@@ -0,0 +1,24 @@
+/**
+ ******************************************************************************
+ * @file    ll_aton.h
+ * @author  PeleAB
+ * @brief   LL_ATON driver stand-in for the host (Linux) build
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef HOST_LL_ATON_H
+#define HOST_LL_ATON_H
+
+#include "ll_aton_runtime.h"
+
+#endif /* HOST_LL_ATON_H */
@@ -0,0 +1,139 @@
+/**
+ ******************************************************************************
+ * @file    ll_aton_NN_interface.h
+ * @author  PeleAB
+ * @brief   LL_ATON network interface stand-in for the host (Linux) build
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Buffer descriptors keep the field layout of the real runtime so that code
+ * reading shapes or quantization parameters builds unchanged. Network
+ * instances and buffers are provided by host_npu.c.
+ */
+
+#ifndef HOST_LL_ATON_NN_INTERFACE_H
+#define HOST_LL_ATON_NN_INTERFACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    DataType_UNDEFINED = 0,
+    DataType_FLOAT = 1,
+    DataType_UINT8 = 2,
+    DataType_INT8 = 3,
+    DataType_UINT16 = 4,
+    DataType_INT16 = 5,
+    DataType_INT32 = 6,
+    DataType_INT64 = 7,
+    DataType_STRING = 8,
+    DataType_BOOL = 9,
+} Buffer_DataType_TypeDef;
+
+typedef enum {
+    CHPos_UNDEFINED = 0,
+    CHPos_First = 1,
+    CHPos_Last = 2,
+    CHPos_Mixed = 3,
+} Buffer_CHPos_TypeDef;
+
+typedef enum {
+    LL_ATON_User_IO_NOERROR,
+    LL_ATON_User_IO_WRONG_ALIGN,
+    LL_ATON_User_IO_WRONG_SIZE,
+    LL_ATON_User_IO_WRONG_INDEX,
+} LL_ATON_User_IO_Result_t;
+
+typedef union {
+    unsigned char *p;
+    uintptr_t i;
+} __LL_address_t;
+
+typedef struct {
+    const char *name;
+    __LL_address_t addr_base;
+    uint32_t offset_start;
+    uint32_t offset_end;
+    uint32_t offset_limit;
+    uint8_t is_user_allocated;
+    uint8_t is_param;
+    uint16_t epoch;
+    uint32_t batch;
+    const uint32_t *mem_shape;
+    uint16_t mem_ndims;
+    Buffer_CHPos_TypeDef chpos;
+    Buffer_DataType_TypeDef type;
+    int8_t Qm;
+    int8_t Qn;
+    uint8_t Qunsigned;
+    uint8_t ndims;
+    uint8_t nbits;
+    uint8_t per_channel;
+    const uint32_t *shape;
+    const float *scale;
+    const int16_t *offset;
+} LL_Buffer_InfoTypeDef;
+
+typedef enum {
+    LL_ATON_RT_NO_WFE = 0,
+    LL_ATON_RT_WFE,
+    LL_ATON_RT_DONE,
+} LL_ATON_RT_RetValues_t;
+
+/** @brief Host network instance: the name selects the canned tensors */
+typedef struct __nn_instance_struct {
+    const char *network_name;
+    uint32_t inferences;
+    /* Execution state of the host runtime (host_npu.c) */
+    uint8_t initialized;                    /**< Init_Network called, not yet DeInit */
+    uint8_t running;                        /**< Inference started, not yet DONE */
+    uint32_t steps_left;                    /**< Epoch block starts and waits before DONE */
+    uint32_t inits;                         /**< LL_ATON_RT_Init_Network() calls */
+    uint32_t resets;                        /**< LL_ATON_RT_Reset_Network() calls */
+} NN_Instance_TypeDef;
+
+/** @brief User-allocated buffers point at the slot holding the bound address */
+static inline unsigned char *LL_Buffer_addr_base(const LL_Buffer_InfoTypeDef *buf)
+{
+    if (buf->is_user_allocated) {
+        return *(unsigned char **)buf->addr_base.p;
+    }
+    return buf->addr_base.p;
+}
+
+static inline unsigned char *LL_Buffer_addr_start(const LL_Buffer_InfoTypeDef *buf)
+{
+    return LL_Buffer_addr_base(buf) + buf->offset_start;
+}
+
+static inline unsigned char *LL_Buffer_addr_end(const LL_Buffer_InfoTypeDef *buf)
+{
+    return LL_Buffer_addr_base(buf) + buf->offset_end;
+}
+
+static inline uint32_t LL_Buffer_len(const LL_Buffer_InfoTypeDef *buf)
+{
+    return buf->offset_end - buf->offset_start;
+}
+
+#define LL_ATON_DECLARE_NAMED_NN_PROTOS(nn_name) \
+    const LL_Buffer_InfoTypeDef *LL_ATON_Input_Buffers_Info_##nn_name(void); \
+    const LL_Buffer_InfoTypeDef *LL_ATON_Output_Buffers_Info_##nn_name(void); \
+    LL_ATON_User_IO_Result_t LL_ATON_Set_User_Input_Buffer_##nn_name(uint32_t num, void *buffer, uint32_t size); \
+    void *LL_ATON_Get_User_Input_Buffer_##nn_name(uint32_t num)
+
+#define LL_ATON_DECLARE_NAMED_NN_INSTANCE_AND_INTERFACE(nn_name) \
+    LL_ATON_DECLARE_NAMED_NN_PROTOS(nn_name); \
+    extern NN_Instance_TypeDef NN_Instance_##nn_name
+
+#endif /* HOST_LL_ATON_NN_INTERFACE_H */
@@ -0,0 +1,34 @@
+/**
+ ******************************************************************************
+ * @file    ll_aton_runtime.h
+ * @author  PeleAB
+ * @brief   LL_ATON runtime stand-in for the host (Linux) build
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef HOST_LL_ATON_RUNTIME_H
+#define HOST_LL_ATON_RUNTIME_H
+
+#include "ll_aton_NN_interface.h"
+
+void LL_ATON_RT_RuntimeInit(void);
+void LL_ATON_RT_RuntimeDeInit(void);
+void LL_ATON_RT_Init_Network(NN_Instance_TypeDef *nn_instance);
+void LL_ATON_RT_DeInit_Network(NN_Instance_TypeDef *nn_instance);
+void LL_ATON_RT_Reset_Network(NN_Instance_TypeDef *nn_instance);
+LL_ATON_RT_RetValues_t LL_ATON_RT_RunEpochBlock(NN_Instance_TypeDef *nn_instance);
+
+/* Nothing raises an NPU event on the host: waiting is a no-op */
+#define LL_ATON_OSAL_WFE()                  do { } while (0)
+
+#endif /* HOST_LL_ATON_RUNTIME_H */
@@ -0,0 +1,5 @@
+/* Host build stand-in, see host_hal.h */
+#ifndef HOST_STM32N6570_DISCOVERY_BUS_H
+#define HOST_STM32N6570_DISCOVERY_BUS_H
+#include "host_hal.h"
+#endif
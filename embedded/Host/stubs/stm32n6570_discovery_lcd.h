@@ -0,0 +1,5 @@
+/* Host build stand-in, see host_hal.h */
+#ifndef HOST_STM32N6570_DISCOVERY_LCD_H
+#define HOST_STM32N6570_DISCOVERY_LCD_H
+#include "host_hal.h"
+#endif
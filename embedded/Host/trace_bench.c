@@ -0,0 +1,148 @@
+/**
+ ******************************************************************************
+ * @file    trace_bench.c
+ * @author  PeleAB
+ * @brief   Host benchmark: per-frame logging cost, printf vs trace log
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: trace_bench [frames] [faces]
+ *
+ * Replays the INFO-level messages of one main loop frame (frame start,
+ * detection, post-processing, one result per face, summaries) either through
+ * printf-style formatting or through the trace log ring. The CPU cost is
+ * measured on the host; the UART cost is modelled from the emitted bytes at
+ * the COM1 rate, since on target printf blocks on the UART inside the frame
+ * while trace records are sent during the NPU wait.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "trace_log.h"
+#include "pipeline_profiler.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+/** @brief COM1 rate used by the enhanced PC stream, in bits per second */
+#define BENCH_UART_BAUD                     (921600U * 8U)
+
+/** @brief UART bits per byte (8N1) */
+#define BENCH_UART_BITS_PER_BYTE            10U
+
+/* ========================================================================= */
+/* FRAME LOG REPLAY                                                          */
+/* ========================================================================= */
+
+static uint32_t frame_log_printf(FILE *sink, uint32_t frame, uint32_t faces)
+{
+    int bytes = 0;
+
+    bytes += fprintf(sink, "STARTING FRAME %lu PROCESSING PIPELINE\n", (unsigned long)frame);
+    bytes += fprintf(sink, "Face detection completed in %lu ms (%d outputs ready, %lu epoch blocks, %lu waits)\n",
+                     24UL, 4, 38UL, 21UL);
+    bytes += fprintf(sink, "Post-processing completed: %d faces detected\n", (int)faces);
+    for (uint32_t i = 0; i < faces; i++) {
+        bytes += fprintf(sink, "   Face %u: detection=%.1f%% -> recognition=%.1f%% (%lu us)\n",
+                         (unsigned int)(i + 1), 91.5f, 63.25f + (float)i, 7400UL + i);
+    }
+    bytes += fprintf(sink, "   Frame summary: faces=%u, target_this_frame=%s, target_detected=%s (%.1f%% best)\n",
+                     (unsigned int)faces, "YES", "NO", 65.25f);
+    bytes += fprintf(sink, "Face recognition: detected=%s, verified=%s, best_similarity=%.1f%%\n",
+                     "YES", "NO", 65.25f);
+    bytes += fprintf(sink, "Frame processing completed: %.1f FPS, %lu ms total, %lu camera frames dropped\n",
+                     17.5f, 57UL, 3UL);
+
+    return (uint32_t)bytes;
+}
+
+static void frame_log_trace(uint32_t frame, uint32_t faces)
+{
+    TLOG_INFO(TRACE_MSG_FRAME_START, frame);
+    TLOG_INFO(TRACE_MSG_DETECTION_DONE, 24U, 4, 38U, 21U);
+    TLOG_INFO(TRACE_MSG_POSTPROCESS_DONE, faces);
+    for (uint32_t i = 0; i < faces; i++) {
+        TLOG_INFO(TRACE_MSG_FACE_RESULT, i + 1, 91.5f, 63.25f + (float)i, 7400U + i);
+    }
+    TLOG_INFO(TRACE_MSG_FRAME_SUMMARY, faces, 1U, 0U, 65.25f);
+    TLOG_INFO(TRACE_MSG_RECOG_RESULT, 1U, 0U, 65.25f);
+    TLOG_INFO(TRACE_MSG_FRAME_DONE, 17.5f, 57U, 3U);
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 10000U;
+    uint32_t faces = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 3U;
+    static uint8_t chunk[4096];
+    uint64_t printf_ticks = 0, trace_ticks = 0, drain_ticks = 0;
+    uint64_t printf_bytes = 0, trace_bytes = 0;
+    FILE *sink;
+
+    if (frames == 0) {
+        frames = 1;
+    }
+
+    sink = fopen("/dev/null", "w");
+    if (!sink) {
+        perror("/dev/null");
+        return 1;
+    }
+
+    profiler_init();
+    trace_log_init();
+    trace_log_drain(chunk, sizeof(chunk));
+
+    for (uint32_t f = 0; f < frames; f++) {
+        uint32_t t0 = profiler_now();
+        printf_bytes += frame_log_printf(sink, f + 1, faces);
+        fflush(sink);
+        printf_ticks += (uint32_t)(profiler_now() - t0);
+
+        t0 = profiler_now();
+        frame_log_trace(f + 1, faces);
+        trace_ticks += (uint32_t)(profiler_now() - t0);
+
+        t0 = profiler_now();
+        uint32_t n;
+        while ((n = trace_log_drain(chunk, sizeof(chunk))) > 0) {
+            trace_bytes += n;
+        }
+        drain_ticks += (uint32_t)(profiler_now() - t0);
+    }
+    fclose(sink);
+
+    double ns_per_tick = 1e9 / (double)profiler_tick_rate();
+    double printf_ns = (double)printf_ticks * ns_per_tick / frames;
+    double trace_ns = (double)trace_ticks * ns_per_tick / frames;
+    double drain_ns = (double)drain_ticks * ns_per_tick / frames;
+    double printf_b = (double)printf_bytes / frames;
+    double trace_b = (double)trace_bytes / frames;
+    double us_per_byte = 1e6 * BENCH_UART_BITS_PER_BYTE / BENCH_UART_BAUD;
+
+    printf("Per-frame logging cost, %u frames, %u faces per frame\n",
+           (unsigned int)frames, (unsigned int)faces);
+    printf("   %-8s %12s %12s %16s %16s\n", "mode", "cpu (ns)", "bytes", "uart (us)", "in-frame (us)");
+    printf("   %-8s %12.0f %12.0f %16.1f %16.1f\n", "printf",
+           printf_ns, printf_b, printf_b * us_per_byte, printf_ns / 1000.0 + printf_b * us_per_byte);
+    printf("   %-8s %12.0f %12.0f %16.1f %16.1f\n", "trace",
+           trace_ns, trace_b, trace_b * us_per_byte, trace_ns / 1000.0);
+    printf("   drain %.0f ns per frame (runs while the NPU is busy)\n", drain_ns);
+    printf("   dropped records: %u\n", (unsigned int)trace_log_dropped());
+
+    return 0;
+}
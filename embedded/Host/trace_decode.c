@@ -0,0 +1,306 @@
+/**
+ ******************************************************************************
+ * @file    trace_decode.c
+ * @author  PeleAB
+ * @brief   Host decoder for the binary trace log
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Usage: trace_decode [-r] [-e embeddings.bin] [file]
+ *
+ *   Default input is a raw capture of COM1: DEBUG_INFO packets (type 0x09)
+ *   are extracted from the robust protocol stream and everything else
+ *   (boot printf text, frames, heartbeats) is skipped.
+ *   With -r the input is a plain sequence of records, as returned by
+ *   trace_log_drain().
+ *   With -e the face embeddings of the capture (EMBEDDING_DATA packets,
+ *   type 0x03) are also written to embeddings.bin, as raw floats in stream
+ *   order, for gallery_study.
+ *
+ * Build against the same trace_log_ids.h as the firmware that produced the
+ * capture, otherwise message IDs map to the wrong formats.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_log.h"
+
+/* ========================================================================= */
+/* PRIVATE DATA                                                              */
+/* ========================================================================= */
+
+#define ROBUST_SOF_BYTE                     0xAA
+#define ROBUST_HEADER_SIZE                  4
+#define ROBUST_MSG_HEADER_SIZE              3
+#define ROBUST_CRC_SIZE                     4
+#define ROBUST_MSG_EMBEDDING_DATA           0x03
+#define ROBUST_MSG_DEBUG_INFO               0x09
+
+static const char *const formats[TRACE_MSG_COUNT] = {
+#define TRACE_LOG_FORMAT_ENTRY(id, fmt) fmt,
+    TRACE_LOG_MESSAGES(TRACE_LOG_FORMAT_ENTRY)
+#undef TRACE_LOG_FORMAT_ENTRY
+};
+
+static const char level_tags[] = "EWID";
+
+static uint32_t clock_hz;                   /**< From TRACE_MSG_CLOCK, 0 if unknown */
+static uint64_t time_ticks;                 /**< Unwrapped timestamp */
+static uint32_t last_ts;
+static int have_ts;
+static uint32_t sync_errors;
+
+/* ========================================================================= */
+/* RENDERING                                                                 */
+/* ========================================================================= */
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief printf-like rendering of a catalog format from raw argument words
+ */
+static void render(FILE *out, const char *fmt, const uint32_t *args, uint32_t nargs)
+{
+    uint32_t next = 0;
+
+    while (*fmt) {
+        char spec[32];
+        size_t len = 0;
+        char conv;
+
+        if (*fmt != '%') {
+            fputc(*fmt++, out);
+            continue;
+        }
+        if (fmt[1] == '%') {
+            fputc('%', out);
+            fmt += 2;
+            continue;
+        }
+
+        /* Copy flags, width and precision; drop length modifiers */
+        spec[len++] = *fmt++;
+        while (*fmt && strchr("-+ #0123456789.", *fmt) && len < sizeof(spec) - 2) {
+            spec[len++] = *fmt++;
+        }
+        while (*fmt && strchr("hlLqjzt", *fmt)) {
+            fmt++;
+        }
+        conv = *fmt ? *fmt++ : 'u';
+        spec[len++] = conv;
+        spec[len] = '\0';
+
+        if (next >= nargs) {
+            fputs("<?>", out);
+            continue;
+        }
+
+        switch (conv) {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+            union { uint32_t u; float f; } c = { .u = args[next++] };
+            fprintf(out, spec, (double)c.f);
+            break;
+        }
+        case 'd': case 'i':
+            fprintf(out, spec, (int)(int32_t)args[next++]);
+            break;
+        default:
+            fprintf(out, spec, (unsigned int)args[next++]);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Decode a block of records
+ * @return Bytes consumed
+ */
+static size_t decode_records(FILE *out, const uint8_t *data, size_t size)
+{
+    size_t pos = 0;
+
+    while (pos + TRACE_LOG_HEADER_WORDS * 4 <= size) {
+        uint32_t hdr = read_u32(data + pos);
+        uint32_t nargs = TRACE_LOG_HEADER_NARGS(hdr);
+        uint32_t id = TRACE_LOG_HEADER_ID(hdr);
+        uint32_t args[TRACE_LOG_MAX_ARGS];
+        uint32_t ts;
+
+        if (TRACE_LOG_HEADER_SYNC(hdr) != TRACE_LOG_SYNC || nargs > TRACE_LOG_MAX_ARGS) {
+            sync_errors++;
+            pos += 4;
+            continue;
+        }
+        if (pos + (TRACE_LOG_HEADER_WORDS + nargs) * 4 > size) {
+            break;
+        }
+
+        ts = read_u32(data + pos + 4);
+        for (uint32_t i = 0; i < nargs; i++) {
+            args[i] = read_u32(data + pos + (TRACE_LOG_HEADER_WORDS + i) * 4);
+        }
+        pos += (TRACE_LOG_HEADER_WORDS + nargs) * 4;
+
+        if (id == TRACE_MSG_CLOCK && nargs >= 1) {
+            clock_hz = args[0];
+            time_ticks = 0;
+            have_ts = 0;
+        }
+        if (have_ts) {
+            time_ticks += (uint32_t)(ts - last_ts);
+        }
+        last_ts = ts;
+        have_ts = 1;
+
+        if (clock_hz) {
+            fprintf(out, "[%12.6f] ", (double)time_ticks / (double)clock_hz);
+        } else {
+            fprintf(out, "[%12llu] ", (unsigned long long)time_ticks);
+        }
+        fprintf(out, "%c ", level_tags[TRACE_LOG_HEADER_LEVEL(hdr) & 3U]);
+
+        if (id < TRACE_MSG_COUNT) {
+            render(out, formats[id], args, nargs);
+        } else {
+            fprintf(out, "<unknown message %u>", (unsigned int)id);
+        }
+        fputc('\n', out);
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Extract DEBUG_INFO payloads from a robust protocol byte stream, and
+ *        the embeddings to @p emb if it is not NULL
+ */
+static void decode_stream(FILE *out, FILE *emb, const uint8_t *data, size_t size)
+{
+    size_t pos = 0;
+
+    while (pos + ROBUST_HEADER_SIZE + ROBUST_MSG_HEADER_SIZE <= size) {
+        const uint8_t *h = data + pos;
+        uint32_t payload_size;
+
+        if (h[0] != ROBUST_SOF_BYTE || (h[0] ^ h[1] ^ h[2]) != h[3]) {
+            pos++;
+            continue;
+        }
+
+        payload_size = (uint32_t)h[1] | ((uint32_t)h[2] << 8);
+        if (payload_size < ROBUST_MSG_HEADER_SIZE ||
+            pos + ROBUST_HEADER_SIZE + payload_size + ROBUST_CRC_SIZE > size) {
+            pos++;
+            continue;
+        }
+
+        if (h[ROBUST_HEADER_SIZE] == ROBUST_MSG_DEBUG_INFO) {
+            decode_records(out, h + ROBUST_HEADER_SIZE + ROBUST_MSG_HEADER_SIZE,
+                           payload_size - ROBUST_MSG_HEADER_SIZE);
+        } else if (h[ROBUST_HEADER_SIZE] == ROBUST_MSG_EMBEDDING_DATA && emb &&
+                   payload_size >= ROBUST_MSG_HEADER_SIZE + 4U) {
+            /* uint32_t float count, then the floats */
+            const uint8_t *p = h + ROBUST_HEADER_SIZE + ROBUST_MSG_HEADER_SIZE;
+            const uint32_t count = read_u32(p);
+
+            if (count <= payload_size / 4U &&
+                count * 4U == payload_size - ROBUST_MSG_HEADER_SIZE - 4U) {
+                fwrite(p + 4, 4, count, emb);
+            }
+        }
+        pos += ROBUST_HEADER_SIZE + payload_size + ROBUST_CRC_SIZE;
+    }
+}
+
+/* ========================================================================= */
+/* MAIN                                                                      */
+/* ========================================================================= */
+
+int main(int argc, char **argv)
+{
+    int raw = 0;
+    const char *path = NULL;
+    const char *emb_path = NULL;
+    FILE *in;
+    FILE *emb = NULL;
+    uint8_t *data = NULL;
+    size_t size = 0;
+    size_t cap = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0) {
+            raw = 1;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            emb_path = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "usage: %s [-r] [-e embeddings.bin] [file]\n", argv[0]);
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    in = (path && strcmp(path, "-") != 0) ? fopen(path, "rb") : stdin;
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    for (;;) {
+        size_t n;
+        if (size == cap) {
+            cap = cap ? cap * 2 : 65536;
+            data = realloc(data, cap);
+            if (!data) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        n = fread(data + size, 1, cap - size, in);
+        if (n == 0) {
+            break;
+        }
+        size += n;
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    if (raw) {
+        decode_records(stdout, data, size);
+    } else {
+        if (emb_path) {
+            emb = fopen(emb_path, "wb");
+            if (!emb) {
+                perror(emb_path);
+                free(data);
+                return 1;
+            }
+        }
+        decode_stream(stdout, emb, data, size);
+        if (emb) {
+            fclose(emb);
+        }
+    }
+
+    if (sync_errors) {
+        fprintf(stderr, "%u words skipped while resynchronising\n", (unsigned int)sync_errors);
+    }
+
+    free(data);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ * @file    warp_ref.c
+ * @author  PeleAB
+ * @brief   Host tools: float reference of the aligned-crop warp
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include "warp_ref.h"
+
+static void fetch(const uint8_t *src, uint32_t stride, img_format_t format,
+                  int x, int y, float rgb[3])
+{
+    const uint8_t *row = src + (uint32_t)y * stride;
+
+    if (format == IMG_FORMAT_RGB565) {
+        uint16_t px = ((const uint16_t *)row)[x];
+        rgb[0] = (float)(((px >> 11) & 0x1F) << 3);
+        rgb[1] = (float)(((px >> 5) & 0x3F) << 2);
+        rgb[2] = (float)((px & 0x1F) << 3);
+    } else {
+        rgb[0] = row[x * 3 + 0];
+        rgb[1] = row[x * 3 + 1];
+        rgb[2] = row[x * 3 + 2];
+    }
+}
+
+static float clampf(float v, float hi)
+{
+    return (v < 0.0f) ? 0.0f : ((v > hi) ? hi : v);
+}
+
+void warp_ref_align(const uint8_t *src_image, uint32_t src_stride, img_format_t src_format,
+                    uint16_t src_width, uint16_t src_height,
+                    uint8_t *dst_img, uint16_t dst_width, uint16_t dst_height,
+                    img_sample_t sample, float x_center, float y_center,
+                    float width, float height, float left_eye_x,
+                    float left_eye_y, float right_eye_x, float right_eye_y)
+{
+    const float angle = -atan2f(right_eye_y - left_eye_y, right_eye_x - left_eye_x);
+    const float cos_a = cosf(angle);
+    const float sin_a = sinf(angle);
+    const float dst_full = (dst_width > dst_height) ? (float)dst_width : (float)dst_height;
+    const float offset_x = (dst_full - (float)dst_width) * 0.5f;
+    const float offset_y = (dst_full - (float)dst_height) * 0.5f;
+    const float x_limit = (float)(src_width - 1);
+    const float y_limit = (float)(src_height - 1);
+
+    for (int y = 0; y < dst_height; y++) {
+        const float ny = (((float)y + offset_y + 0.5f) / dst_full) - 0.5f;
+
+        for (int x = 0; x < dst_width; x++) {
+            const float nx = (((float)x + offset_x + 0.5f) / dst_full) - 0.5f;
+            float sx = x_center + nx * width * cos_a + ny * height * sin_a;
+            float sy = y_center + ny * height * cos_a - nx * width * sin_a;
+            uint8_t *out = dst_img + ((size_t)y * dst_width + x) * 3;
+            float p00[3], p01[3], p10[3], p11[3];
+
+            if (sample == IMG_SAMPLE_NEAREST) {
+                fetch(src_image, src_stride, src_format, (int)clampf(sx, x_limit),
+                      (int)clampf(sy, y_limit), p00);
+                for (int c = 0; c < 3; c++) {
+                    out[c] = (uint8_t)p00[c];
+                }
+                continue;
+            }
+
+            sx = clampf(sx - 0.5f, x_limit);
+            sy = clampf(sy - 0.5f, y_limit);
+            int ix = (int)sx, iy = (int)sy;
+            int ix1 = (ix < src_width - 1) ? ix + 1 : ix;
+            int iy1 = (iy < src_height - 1) ? iy + 1 : iy;
+            float wx = sx - (float)ix, wy = sy - (float)iy;
+
+            fetch(src_image, src_stride, src_format, ix, iy, p00);
+            fetch(src_image, src_stride, src_format, ix1, iy, p01);
+            fetch(src_image, src_stride, src_format, ix, iy1, p10);
+            fetch(src_image, src_stride, src_format, ix1, iy1, p11);
+            for (int c = 0; c < 3; c++) {
+                float top = p00[c] + (p01[c] - p00[c]) * wx;
+                float bottom = p10[c] + (p11[c] - p10[c]) * wx;
+                out[c] = (uint8_t)lrintf(top + (bottom - top) * wy);
+            }
+        }
+    }
+}
@@ -0,0 +1,27 @@
+/**
+ ******************************************************************************
+ * @file    warp_ref.h
+ * @author  PeleAB
+ * @brief   Host tools: float reference of the aligned-crop warp
+ ******************************************************************************
+ */
+
+#ifndef HOST_WARP_REF_H
+#define HOST_WARP_REF_H
+
+#include "crop_img.h"
+
+/**
+ * @brief Same mapping as img_warp_align, evaluated per pixel in float
+ *
+ * Nearest sampling is the original img_crop_align565_to_888 loop; bilinear
+ * interpolates in float with exact weights and rounds once at the end.
+ */
+void warp_ref_align(const uint8_t *src_image, uint32_t src_stride, img_format_t src_format,
+                    uint16_t src_width, uint16_t src_height,
+                    uint8_t *dst_img, uint16_t dst_width, uint16_t dst_height,
+                    img_sample_t sample, float x_center, float y_center,
+                    float width, float height, float left_eye_x,
+                    float left_eye_y, float right_eye_x, float right_eye_y);
+
+#endif /* HOST_WARP_REF_H */
@@ -18,6 +18,8 @@
 #ifndef APP_CAM
 #define APP_CAM
 
+#include "frame_dbuf.h"
+
 #define CAMERA_FPS 30
 
 void CAM_Init(uint32_t *lcd_bg_width, uint32_t *lcd_bg_height, uint32_t *pitch_nn);
@@ -26,6 +28,7 @@ void CAM_Start(void);
 void CAM_DisplayPipe_Start(uint8_t *display_pipe_dst, uint32_t cam_mode);
 void CAM_DisplayPipe_Stop(void);
 void CAM_NNPipe_Start(uint8_t *nn_pipe_dst, uint32_t cam_mode);
+void CAM_NNPipe_DoubleBufferStart(frame_dbuf_t *dbuf, uint8_t *buf0, uint8_t *buf1);
 void CAM_IspUpdate(void);
 
 #endif
@@ -68,7 +68,63 @@
 "face"}
 /* Enable or disable LCD and PC streaming features */
 #define ENABLE_LCD_DISPLAY
+/* Per-stage cycle profiler (p50/p95/p99 report); comment out to compile it out */
+#define ENABLE_PIPELINE_PROFILER
+/* Most verbose trace log level compiled in (TLOG_LEVEL_ERROR/WARN/INFO/DEBUG) */
+#ifndef TRACE_LOG_LEVEL
+#define TRACE_LOG_LEVEL TLOG_LEVEL_INFO
+#endif
 //#define ENABLE_PC_STREAM  // Disabled: using Enhanced_PC_STREAM instead
+/* Face crop sampling for recognition: IMG_SAMPLE_NEAREST, or IMG_SAMPLE_BILINEAR
+ * (less aliasing on small faces, about 4x the warp time) */
+#define CROP_ALIGN_SAMPLING IMG_SAMPLE_NEAREST
+/* Stream each aligned recognition crop to the PC ("ALN" frames). Costs an RGB888
+ * crop per face in PSRAM; without it faces are warped straight into the
+ * recognition network input */
+//#define ENABLE_ALIGNED_FACE_STREAM
+/* Feed the captured RGB888 frame to the detection network as is (no float CHW
+ * conversion). Needs face_detection regenerated by scripts/compile_model.sh with
+ * a uint8 channel-last, user-allocated input, see "Zero-copy detection input" in
+ * Doc/Build-Options.md */
+//#define DETECTION_INPUT_UINT8_HWC
+/* Stage each face in one of two recognition inputs bound to the network in turn,
+ * instead of copying it into the network's own input (150 KB per face). Needs
+ * face_recognition regenerated by scripts/compile_model.sh with a user-allocated
+ * input, see "Recognition input buffers" in Doc/Build-Options.md */
+//#define RECOGNITION_INPUT_USER_BUFFERS
+/* Pixel blitter backend (blit.h): blit_backend_dma2d runs fills and pixel format
+ * conversions on the DMA2D, blit_backend_sw keeps them on the CPU */
+#ifndef BLIT_BACKEND
+#define BLIT_BACKEND blit_backend_dma2d
+#endif
+/* Table lookups (pixel_lut.h) instead of per-pixel arithmetic for RGB565
+ * expansion, gray conversion and recognition input normalization; same output.
+ * PIXEL_LUT_CONST builds the tables as const data instead of filling them at
+ * init, see "Pixel lookup tables" in Doc/Build-Options.md */
+//#define ENABLE_PIXEL_LUT
+//#define PIXEL_LUT_CONST
+/* Store the enrolled face templates as int8 with a per-template scale (a
+ * quarter of the memory, one int8 dot product per template) instead of float,
+ * see "Face gallery" in Doc/Build-Options.md */
+//#define FACE_GALLERY_Q7
+/* Keep the enrolled templates in the free external NOR flash region instead
+ * of RAM, so they survive a reboot (gallery_store.h, int8 templates searched
+ * in place; FACE_GALLERY_Q7 is then not used), see "Persistent gallery" in
+ * Doc/Build-Options.md */
+//#define FACE_GALLERY_FLASH
+#define GALLERY_STORE_ADDRESS 0x73000000UL  /* Free region after the models */
+#define GALLERY_STORE_SECTORS 16            /* 64 KB each: 1 MB, 3570 templates */
+#ifndef GALLERY_FLASH
+#define GALLERY_FLASH gallery_flash_xspi
+#endif
+/* Also search a large gallery indexed offline (gallery_index.h, built with
+ * Host/index_study -o and programmed to the NOR flash at GALLERY_INDEX_ADDRESS);
+ * it is copied to PSRAM at boot, see "Gallery index" in Doc/Build-Options.md */
+//#define FACE_GALLERY_INDEX
+#define GALLERY_INDEX_ADDRESS 0x73100000UL  /* After the gallery store */
+#define GALLERY_INDEX_MAX_SIZE (8U * 1024U * 1024U) /* PSRAM copy, 50k templates */
+#define GALLERY_INDEX_PROBES 32             /* Lists scanned per face */
+#define GALLERY_INDEX_STEP 256              /* Templates scanned per NPU poll */
 /* Application input source configuration */
 #define INPUT_SRC_CAMERA 0
 #define INPUT_SRC_PC     1
@@ -83,14 +139,21 @@
 #define AI_OBJDETECT_YOLOV2_PP_MAX_BOXES_LIMIT   (10)
 
 
-/* CenterFace detection parameters */
+/* CenterFace detection parameters. The output grid (NN_WIDTH / 4 for the
+ * shipped model) and its stride are read from the face_detection output
+ * buffers at init */
 #define AI_PD_MODEL_PP_WIDTH              (NN_WIDTH)
 #define AI_PD_MODEL_PP_HEIGHT             (NN_HEIGHT)
 #define AI_PD_MODEL_PP_NB_KEYPOINTS       (5)
-#define AI_PD_MODEL_PP_TOTAL_DETECTIONS   (1024)
 #define AI_PD_MODEL_PP_CONF_THRESHOLD     (0.5f)
 #define AI_PD_MODEL_PP_IOU_THRESHOLD      (0.3f)
-#define AI_PD_MODEL_PP_MAX_BOXES_LIMIT    (10)
+#define AI_PD_MODEL_PP_MAX_BOXES_LIMIT    (10)    /* Highest-scoring cells kept for NMS */
+/* AI_PD_PP_DECODE_PEAKS: only 3x3 heatmap maxima are NMS candidates, one per
+ * face; AI_PD_PP_DECODE_THRESHOLD: every cell above the threshold, so a large
+ * face alone can fill the MAX_BOXES_LIMIT candidates */
+#ifndef AI_PD_MODEL_PP_DECODE_MODE
+#define AI_PD_MODEL_PP_DECODE_MODE        (AI_PD_PP_DECODE_PEAKS)
+#endif
 
 /* MediaPipe face detection */
 #define MP_FACE_PP_CONF_THRESHOLD (0.5f)
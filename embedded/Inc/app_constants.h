@@ -28,12 +28,18 @@
 /** @brief Duration for button long press detection (milliseconds) */
 #define BUTTON_LONG_PRESS_DURATION_MS       1000
 
+/** @brief Button press that deletes every enrolled identity (milliseconds) */
+#define BUTTON_CLEAR_PRESS_DURATION_MS      5000
+
 /** @brief Additional timeout for unverified face LED indication (milliseconds) */
 #define FACE_UNVERIFIED_LED_TIMEOUT_MS      1000
 
 /** @brief UART communication timeout (milliseconds) */
 #define UART_COMMUNICATION_TIMEOUT_MS       1000
 
+/** @brief Longest wait for a camera frame before capture fails (milliseconds) */
+#define CAMERA_FRAME_TIMEOUT_MS             1000
+
 /* ========================================================================= */
 /* NEURAL NETWORK CONSTANTS                                                  */
 /* ========================================================================= */
@@ -118,8 +124,13 @@
 /** @brief Align value to 32-byte boundary */
 #define ALIGN_TO_32(value)                  (((value) + 31) & ~31)
 
+/** @brief Largest NN pipe row pitch the capture buffers are sized for (bytes) */
+#ifndef DCMIPP_OUT_NN_PITCH
+#define DCMIPP_OUT_NN_PITCH                 ALIGN_TO_16(NN_WIDTH * NN_BPP)
+#endif
+
 /** @brief Calculate buffer size with alignment */
-#define DCMIPP_OUT_NN_LEN                   (ALIGN_TO_16(NN_WIDTH * NN_BPP) * NN_HEIGHT)
+#define DCMIPP_OUT_NN_LEN                   (DCMIPP_OUT_NN_PITCH * NN_HEIGHT)
 #define DCMIPP_OUT_NN_BUFF_LEN              (DCMIPP_OUT_NN_LEN + MEMORY_ALIGNMENT_BYTES - DCMIPP_OUT_NN_LEN % MEMORY_ALIGNMENT_BYTES)
 
 /** @brief Convert milliseconds to microseconds */
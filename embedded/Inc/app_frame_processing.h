@@ -75,6 +75,7 @@ typedef enum {
     PIPELINE_STAGE_RECOGNITION,              /**< Face recognition stage */
     PIPELINE_STAGE_POSTPROCESSING,           /**< Post-processing stage */
     PIPELINE_STAGE_OUTPUT,                   /**< Output stage */
+    PIPELINE_STAGE_SYSTEM_UPDATE,            /**< LED/button/heartbeat stage */
     PIPELINE_STAGE_COUNT
 } pipeline_stage_t;
 
@@ -82,9 +83,9 @@ typedef enum {
  * @brief Pipeline timing information
  */
 typedef struct {
-    uint32_t stage_times[PIPELINE_STAGE_COUNT]; /**< Individual stage times */
-    uint32_t total_time;                     /**< Total pipeline time */
-    uint32_t timestamp;                      /**< Frame timestamp */
+    uint32_t stage_times[PIPELINE_STAGE_COUNT]; /**< Individual stage times (profiler ticks) */
+    uint32_t total_time;                     /**< Total pipeline time (profiler ticks) */
+    uint32_t timestamp;                      /**< Frame start timestamp (profiler ticks) */
 } pipeline_timing_t;
 
 /* ========================================================================= */
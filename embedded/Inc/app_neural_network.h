@@ -25,6 +25,7 @@
 #include "app_config_manager.h"
 #include "app_postprocess.h"
 #include "memory_pool.h"
+#include "target_embedding.h"
 
 /* ========================================================================= */
 /* NEURAL NETWORK CONTEXT STRUCTURE                                          */
@@ -0,0 +1,130 @@
+/**
+ ******************************************************************************
+ * @file    blit.h
+ * @author  PeleAB
+ * @brief   Pixel blitter: format conversion, scaled copy, fill and blend with
+ *          a DMA2D or software backend
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Operations may be asynchronous: a call can return while the hardware is
+ * still reading the source and writing the destination. Neither may be
+ * touched by the CPU until blit_wait() returns. Starting another operation
+ * waits for the previous one. Operations a backend cannot do (L8 output,
+ * scaling on DMA2D) fall back to the software backend.
+ *
+ * Pixel conversion follows the DMA2D pixel format converter: 4/5/6-bit
+ * channels expand to 8 bits by repeating their top bits, and narrowing
+ * truncates. RGB888 is stored R, G, B in memory as elsewhere in this
+ * application. L8 is a gray level, (30 R + 59 G + 11 B) / 100.
+ */
+
+#ifndef BLIT_H
+#define BLIT_H
+
+#include <stdint.h>
+
+/* ========================================================================= */
+/* TYPES                                                                     */
+/* ========================================================================= */
+
+/** @brief Return codes (negative on error) */
+#define BLIT_OK                             0
+#define BLIT_ERR_ARG                        (-1)    /**< Bad surface or size mismatch */
+#define BLIT_ERR_UNSUPPORTED                (-2)    /**< Backend cannot do it (dispatcher falls back) */
+#define BLIT_ERR_HW                         (-3)    /**< Transfer error or timeout */
+
+/** @brief Pixel formats */
+typedef enum {
+    BLIT_FMT_ARGB8888 = 0,
+    BLIT_FMT_RGB888,                        /**< R, G, B bytes */
+    BLIT_FMT_RGB565,
+    BLIT_FMT_ARGB4444,
+    BLIT_FMT_L8,                            /**< Gray; software output only */
+    BLIT_FMT_COUNT
+} blit_format_t;
+
+/** @brief A rectangle of pixels in memory */
+typedef struct {
+    void *data;                             /**< First pixel */
+    uint32_t stride;                        /**< Bytes from one row to the next */
+    uint16_t width;
+    uint16_t height;
+    blit_format_t format;
+} blit_surface_t;
+
+/**
+ * @brief Backend operations
+ *
+ * Called with validated surfaces. Any operation may return
+ * BLIT_ERR_UNSUPPORTED to have the software backend do it instead.
+ */
+typedef struct {
+    const char *name;
+    int (*init)(void);
+    /** Same size, format conversion */
+    int (*convert)(const blit_surface_t *dst, const blit_surface_t *src);
+    /** Nearest neighbour resize, format conversion */
+    int (*scale_copy)(const blit_surface_t *dst, const blit_surface_t *src);
+    /** Solid color given as ARGB8888 */
+    int (*fill)(const blit_surface_t *dst, uint32_t argb);
+    /** fg over bg; fg pixel alpha is scaled by @p alpha (255 = as is) */
+    int (*blend)(const blit_surface_t *dst, const blit_surface_t *fg,
+                 const blit_surface_t *bg, uint8_t alpha);
+    /** Block until the last operation has completed */
+    int (*wait)(void);
+} blit_backend_t;
+
+extern const blit_backend_t blit_backend_sw;
+extern const blit_backend_t blit_backend_dma2d;
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Select and initialize the backend used by the blit_* calls
+ * @param backend Backend, NULL for software
+ * @return BLIT_OK, or the backend init error (software is used then)
+ */
+int blit_init(const blit_backend_t *backend);
+
+/** @brief Backend selected by blit_init() */
+const blit_backend_t *blit_get_backend(void);
+
+/** @brief Bytes per pixel of @p format */
+uint32_t blit_format_bpp(blit_format_t format);
+
+/**
+ * @brief Surface describing a rectangle of another one
+ * @return BLIT_OK, BLIT_ERR_ARG if the rectangle does not fit
+ */
+int blit_sub_surface(const blit_surface_t *parent, uint16_t x, uint16_t y,
+                     uint16_t width, uint16_t height, blit_surface_t *sub);
+
+/** @brief Copy @p src to @p dst (same size) converting the pixel format */
+int blit_convert(const blit_surface_t *dst, const blit_surface_t *src);
+
+/** @brief Resize @p src into @p dst (nearest neighbour) converting the pixel format */
+int blit_scale_copy(const blit_surface_t *dst, const blit_surface_t *src);
+
+/** @brief Fill @p dst with an ARGB8888 color */
+int blit_fill(const blit_surface_t *dst, uint32_t argb);
+
+/** @brief Blend @p fg over @p bg into @p dst (all the same size) */
+int blit_blend(const blit_surface_t *dst, const blit_surface_t *fg,
+               const blit_surface_t *bg, uint8_t alpha);
+
+/** @brief Wait for the last operation; returns its error, if any */
+int blit_wait(void);
+
+#endif /* BLIT_H */
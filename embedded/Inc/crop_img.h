@@ -20,23 +20,66 @@
 #include "arm_math.h"
 #include "app_config.h"
 
-/* Image processing function prototypes */
+/* Source pixel formats of the aligned-crop warp */
+typedef enum {
+  IMG_FORMAT_RGB888 = 0,
+  IMG_FORMAT_RGB565
+} img_format_t;
 
+/* Sampling of the aligned-crop warp */
+typedef enum {
+  IMG_SAMPLE_NEAREST = 0,   /* Source pixel under the sample point */
+  IMG_SAMPLE_BILINEAR       /* Interpolated between the four closest pixels */
+} img_sample_t;
+
+/* Image processing function prototypes. src_stride is the source row pitch,
+ * which may include padding (DCMIPP pads rows to 16 bytes): in bytes for
+ * RGB888 sources, in pixels for the RGB565 crops. */
+
+/* RGB888 (HWC) to planar float (CHW). Helium (MVE) implementation when the
+ * target has it, otherwise the scalar reference. */
 void img_rgb_to_chw_float(uint8_t *src_image, float32_t *dst_img,
                           const uint32_t src_stride, const uint16_t width,
                           const uint16_t height);
 
+/* Same, normalized to [-1, 1]: pixel / 127.5 - 1 */
 void img_rgb_to_chw_float_norm(uint8_t *src_image, float32_t *dst_img,
                           const uint32_t src_stride, const uint16_t width,
                           const uint16_t height);
 
-void img_crop_resize(uint8_t *src_image, uint8_t *dst_img,
+/* Scalar references of the two kernels above */
+void img_rgb_to_chw_float_ref(uint8_t *src_image, float32_t *dst_img,
+                              const uint32_t src_stride, const uint16_t width,
+                              const uint16_t height);
+
+void img_rgb_to_chw_float_norm_ref(uint8_t *src_image, float32_t *dst_img,
+                                   const uint32_t src_stride, const uint16_t width,
+                                   const uint16_t height);
+
+/* Normalization read from the pixel_lut_norm table (pixel_lut.h), same
+ * output. img_rgb_to_chw_float_norm uses it when ENABLE_PIXEL_LUT is defined. */
+void img_rgb_to_chw_float_norm_lut(uint8_t *src_image, float32_t *dst_img,
+                                   const uint32_t src_stride, const uint16_t width,
+                                   const uint16_t height);
+
+void img_crop_resize(uint8_t *src_image, const uint32_t src_stride, uint8_t *dst_img,
                      const uint16_t src_width, const uint16_t src_height,
                      const uint16_t dst_width, const uint16_t dst_height,
                      const uint16_t bpp, int x0, int y0,
                      int crop_width, int crop_height);
 
-void img_crop_align(uint8_t *src_image, uint8_t *dst_img,
+/* Eye-aligned crop of any supported source format into RGB888 (dst_width x
+ * dst_height). Q16 fixed-point stepping along rows; rows fully inside the
+ * source skip clamping. src_stride is in bytes. */
+void img_warp_align(const uint8_t *src_image, uint32_t src_stride, img_format_t src_format,
+                    const uint16_t src_width, const uint16_t src_height,
+                    uint8_t *dst_img, const uint16_t dst_width, const uint16_t dst_height,
+                    img_sample_t sample, float x_center, float y_center,
+                    float width, float height, float left_eye_x,
+                    float left_eye_y, float right_eye_x, float right_eye_y);
+
+/* img_warp_align wrappers with CROP_ALIGN_SAMPLING (app_config.h) */
+void img_crop_align(uint8_t *src_image, const uint32_t src_stride, uint8_t *dst_img,
                     const uint16_t src_width, const uint16_t src_height,
                     const uint16_t dst_width, const uint16_t dst_height,
                     const uint16_t bpp, float x_center, float y_center,
@@ -51,4 +94,14 @@ void img_crop_align565_to_888(uint8_t *src_image, uint16_t src_stride,
                               float width, float height, float left_eye_x,
                               float left_eye_y, float right_eye_x, float right_eye_y);
 
+/* Fused img_crop_align565_to_888 + img_rgb_to_chw_float_norm: writes the
+ * normalized planar float crop directly, without the RGB888 intermediate */
+void img_crop_align565_to_chw_float_norm(uint8_t *src_image, uint16_t src_stride,
+                                         float32_t *dst_img,
+                                         const uint16_t src_width, const uint16_t src_height,
+                                         const uint16_t dst_width, const uint16_t dst_height,
+                                         float x_center, float y_center,
+                                         float width, float height, float left_eye_x,
+                                         float left_eye_y, float right_eye_x, float right_eye_y);
+
 #endif /* CROP_IMG */
@@ -23,6 +23,7 @@ extern uint8_t lcd_fg_buffer[2][LCD_FG_WIDTH * LCD_FG_HEIGHT * 2];
 void LCD_init(void);
 void Display_WelcomeScreen(void);
 void Display_NetworkOutput(pd_postprocess_out_t *p_postprocess, uint32_t total_frame_time_ms, uint32_t boottime_ms, const void *ctx);
+void Display_ClearOverlayStart(void);
 
 
 
@@ -31,6 +31,8 @@ typedef struct {
     uint32_t frame_count;           /* Total processed frames */
     uint32_t detection_count;       /* Total detections */
     uint32_t recognition_count;     /* Total recognitions */
+    uint32_t frames_dropped;        /* Camera frames superseded before processing */
+    uint32_t nn_setup_cycles_saved; /* NPU init cycles avoided this frame by resident networks */
 } performance_metrics_t;
 
 /**
@@ -99,6 +101,14 @@ bool Enhanced_PC_STREAM_SendPerformanceMetrics(const performance_metrics_t *metr
  */
 void Enhanced_PC_STREAM_SendHeartbeat(void);
 
+/**
+ * @brief Send a block of binary trace log records
+ * @param records Records drained from the trace log
+ * @param size Size in bytes
+ * @return true if successful, false otherwise
+ */
+bool Enhanced_PC_STREAM_SendDebugInfo(const uint8_t *records, uint32_t size);
+
 /**
  * @brief Get protocol statistics
  * @param stats Pointer to statistics structure to fill
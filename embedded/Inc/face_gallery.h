@@ -0,0 +1,179 @@
+/**
+ ******************************************************************************
+ * @file    face_gallery.h
+ * @author  PeleAB
+ * @brief   Enrolled face templates of several identities and top-K search
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * A gallery holds unit-norm templates (normalized when added), each owned by
+ * an identity; an identity may have several. Templates are stored in blocks
+ * of FACE_GALLERY_LANES, element-interleaved: element d of the templates
+ * 4b..4b+3 is at pTemplates[(b * EMBEDDING_SIZE + d) * 4 + lane]. One pass
+ * over a block multiplies each query element with a vector of four template
+ * elements, so the search scores four templates per pass with no horizontal
+ * sum. The score of an identity is the best cosine over its templates.
+ * Since templates are unit-norm, a query normalized once when it leaves the
+ * network (face_gallery_normalize) is scored by dot products alone
+ * (face_gallery_search_unit).
+ *
+ * Templates can instead be stored as int8 (face_gallery_init_q7), a quarter
+ * of the memory: one row of EMBEDDING_SIZE values per template, each scaled
+ * so that its largest element is +/-127, and a per-template float scale,
+ * 1 / |row|, that turns the integer dot product into a cosine. The query is
+ * quantized the same way once per search, and each template is scored with
+ * one int8 dot product whose multiply-accumulates reduce across the vector
+ * (vmladavaq_s8, as in arm_dot_prod_q7), so no interleaving is needed.
+ *
+ * The caller owns the storage, so the firmware gallery (target_embedding.c)
+ * and the host benchmarks use the same code at different sizes. Stores that
+ * keep int8 templates elsewhere (gallery_store.h, in flash) score them with
+ * face_gallery_quantize, face_gallery_dot_q7 and face_gallery_offer.
+ */
+
+#ifndef FACE_GALLERY_H
+#define FACE_GALLERY_H
+
+#include <stdint.h>
+#include "arm_math.h"
+
+/* ========================================================================= */
+/* CONSTANTS                                                                 */
+/* ========================================================================= */
+
+/** @brief Face recognition embedding length */
+#define EMBEDDING_SIZE                      128
+
+/** @brief Templates scored per pass (one 32-bit vector) */
+#define FACE_GALLERY_LANES                  4
+
+/** @brief Floats of template storage for @p n templates */
+#define FACE_GALLERY_STORAGE_FLOATS(n)      ((((n) + FACE_GALLERY_LANES - 1) / FACE_GALLERY_LANES) * \
+                                             FACE_GALLERY_LANES * EMBEDDING_SIZE)
+
+/** @brief Bytes of int8 template storage for @p n templates */
+#define FACE_GALLERY_STORAGE_Q7(n)          ((n) * EMBEDDING_SIZE)
+
+/* ========================================================================= */
+/* TYPES                                                                     */
+/* ========================================================================= */
+
+typedef struct {
+    float32_t *pTemplates;                  /**< FACE_GALLERY_STORAGE_FLOATS(capacity), NULL for int8 */
+    int8_t *pTemplatesQ7;                   /**< FACE_GALLERY_STORAGE_Q7(capacity), NULL for float */
+    float32_t *pScale;                      /**< int8: 1 / |row| of each template */
+    uint16_t *pIdentity;                    /**< Owner of each template, capacity entries */
+    uint32_t capacity;                      /**< Templates the storage holds */
+    uint32_t count;                         /**< Templates stored */
+} face_gallery_t;
+
+typedef struct {
+    uint16_t identity;
+    float32_t score;                        /**< Cosine similarity, -1.0 to 1.0 */
+} face_gallery_match_t;
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Attach storage to an empty gallery
+ * @param pGallery Gallery
+ * @param pTemplates FACE_GALLERY_STORAGE_FLOATS(capacity) floats
+ * @param pIdentity capacity entries
+ * @param capacity Templates the storage holds
+ * @return 0 on success, negative on error
+ */
+int face_gallery_init(face_gallery_t *pGallery, float32_t *pTemplates,
+                      uint16_t *pIdentity, uint32_t capacity);
+
+/**
+ * @brief Attach int8 storage to an empty gallery
+ * @param pTemplates FACE_GALLERY_STORAGE_Q7(capacity) bytes
+ * @param pScale capacity entries
+ * @param pIdentity capacity entries
+ * @param capacity Templates the storage holds
+ * @return 0 on success, negative on error
+ */
+int face_gallery_init_q7(face_gallery_t *pGallery, int8_t *pTemplates, float32_t *pScale,
+                         uint16_t *pIdentity, uint32_t capacity);
+
+/**
+ * @brief Remove every template
+ */
+void face_gallery_reset(face_gallery_t *pGallery);
+
+/**
+ * @brief Add a template to an identity
+ * @param embedding EMBEDDING_SIZE floats, normalized (float) or quantized
+ *        (int8) before it is stored
+ * @return Number of templates in the gallery, negative if it is full or the
+ *         embedding is zero
+ */
+int face_gallery_add(face_gallery_t *pGallery, uint16_t identity, const float32_t *embedding);
+
+/**
+ * @brief Number of templates owned by an identity
+ */
+uint32_t face_gallery_identity_count(const face_gallery_t *pGallery, uint16_t identity);
+
+/**
+ * @brief Best-matching identities
+ * @param query EMBEDDING_SIZE floats, any norm
+ * @param pMatch Up to k matches, best first, one per identity
+ * @param k Matches wanted
+ * @return Number of matches written (0 if the gallery is empty or the query
+ *         is zero)
+ */
+uint32_t face_gallery_search(const face_gallery_t *pGallery, const float32_t *query,
+                             face_gallery_match_t *pMatch, uint32_t k);
+
+/**
+ * @brief Same search for a unit-norm query (face_gallery_normalize): each
+ *        float template costs its dot product only
+ */
+uint32_t face_gallery_search_unit(const face_gallery_t *pGallery, const float32_t *query,
+                                  face_gallery_match_t *pMatch, uint32_t k);
+
+/**
+ * @brief Scale an embedding to unit norm
+ * @param pSrc EMBEDDING_SIZE floats
+ * @param pDst EMBEDDING_SIZE floats, may be pSrc; all zero if pSrc is
+ * @return Norm of pSrc
+ */
+float32_t face_gallery_normalize(const float32_t *pSrc, float32_t *pDst);
+
+/**
+ * @brief Quantize a vector to int8, largest element at +/-127
+ * @param pSrc EMBEDDING_SIZE floats
+ * @param pDst EMBEDDING_SIZE int8 values
+ * @return 1 / |pDst| (the norm of the int8 vector), 0 if pSrc is zero
+ */
+float32_t face_gallery_quantize(const float32_t *pSrc, int8_t *pDst);
+
+/**
+ * @brief int8 dot product of two quantized vectors (EMBEDDING_SIZE each)
+ */
+int32_t face_gallery_dot_q7(const int8_t *pRow, const int8_t *query);
+
+/**
+ * @brief Insert a template score into a best-first match list
+ *
+ * An identity appears once, with the best score of its templates; on equal
+ * scores the identity found first stays ahead.
+ * @param pMatch k entries, the first *pNb in use
+ * @param pNb Matches in the list, updated
+ */
+void face_gallery_offer(face_gallery_match_t *pMatch, uint32_t *pNb, uint32_t k,
+                        uint16_t identity, float32_t score);
+
+#endif /* FACE_GALLERY_H */
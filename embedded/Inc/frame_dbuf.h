@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ * @file    frame_dbuf.h
+ * @author  PeleAB
+ * @brief   Double-buffered frame handoff between DCMIPP and the NN pipeline
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef FRAME_DBUF_H
+#define FRAME_DBUF_H
+
+#include <stdint.h>
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+/** @brief Number of capture buffers (DCMIPP double buffer mode) */
+#define FRAME_DBUF_COUNT                    2
+
+/** @brief Index value meaning "no buffer" */
+#define FRAME_DBUF_NONE                     (-1)
+
+/* ========================================================================= */
+/* TYPES                                                                     */
+/* ========================================================================= */
+
+/**
+ * @brief Hooks used to stall the capture pipe while the CPU holds the next
+ *        hardware target buffer
+ * @note  All hooks are optional. They are called from frame_dbuf_acquire()
+ *        and frame_dbuf_release() with interrupts masked and must not wait:
+ *        suspend only requests that no capture starts after the current
+ *        frame
+ */
+typedef struct {
+    int (*suspend)(void *arg);              /**< Request no capture after the current frame */
+    int (*resume)(void *arg);               /**< Restart a suspended capture */
+    int (*frame_pending)(void *arg);        /**< Nonzero if a completed frame's event is not handled yet */
+    void *arg;                              /**< User argument passed to hooks */
+} frame_dbuf_hooks_t;
+
+/**
+ * @brief Frame handoff statistics
+ */
+typedef struct {
+    uint32_t frames_captured;               /**< Frames completed by the hardware */
+    uint32_t frames_consumed;               /**< Frames acquired by the CPU */
+    uint32_t frames_dropped;                /**< Ready frames overwritten before being acquired */
+    uint32_t stalls;                        /**< Times the pipe stopped on a held buffer */
+} frame_dbuf_stats_t;
+
+/**
+ * @brief Double buffer state shared between the frame ISR and the main loop
+ */
+typedef struct {
+    uint8_t *buffers[FRAME_DBUF_COUNT];     /**< Capture buffers, in hardware order */
+    volatile int8_t hw_index;               /**< Buffer the hardware writes next */
+    volatile int8_t ready_index;            /**< Latest complete frame, or FRAME_DBUF_NONE */
+    volatile int8_t held_index;             /**< Buffer owned by the CPU, or FRAME_DBUF_NONE */
+    volatile uint8_t suspended;             /**< Capture request dropped until the release */
+    volatile uint32_t sequence;             /**< Sequence number of the last complete frame */
+    volatile uint32_t ready_sequence;       /**< Sequence number of the ready frame */
+    volatile frame_dbuf_stats_t stats;      /**< Handoff statistics */
+    frame_dbuf_hooks_t hooks;               /**< Pipe control hooks */
+} frame_dbuf_t;
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Initialize the double buffer
+ * @param db Double buffer state
+ * @param buf0 First capture buffer (written first by the hardware)
+ * @param buf1 Second capture buffer
+ * @param hooks Pipe control hooks, may be NULL
+ * @return 0 on success, negative on error
+ */
+int frame_dbuf_init(frame_dbuf_t *db, uint8_t *buf0, uint8_t *buf1,
+                    const frame_dbuf_hooks_t *hooks);
+
+/**
+ * @brief Signal that the hardware completed a frame
+ * @param db Double buffer state
+ * @note  Must be called from the DCMIPP frame event callback. If the previous
+ *        ready frame was never acquired it is counted as dropped (latest
+ *        frame wins). If the next hardware target is held by the CPU, the
+ *        pipe has been suspended by frame_dbuf_acquire() and stops here
+ *        until frame_dbuf_release().
+ */
+void frame_dbuf_on_frame_event(frame_dbuf_t *db);
+
+/**
+ * @brief Take ownership of the latest complete frame
+ * @param db Double buffer state
+ * @param sequence Optional output for the frame sequence number
+ * @return Frame buffer, or NULL if no new frame is ready, a frame is still
+ *         held, or a frame event is pending (retry once it is handled)
+ * @note  The hardware writes the acquired buffer next after its current
+ *        frame, so the capture is suspended before the frame is handed
+ *        out: it stops after the current frame unless the frame is
+ *        released first. A pending frame event means that frame has already
+ *        ended and the next capture may be under way into the ready buffer,
+ *        so nothing is acquired until the event has been handled.
+ */
+uint8_t *frame_dbuf_acquire(frame_dbuf_t *db, uint32_t *sequence);
+
+/**
+ * @brief Return the held frame to the hardware
+ * @param db Double buffer state
+ * @return 0 on success, negative if no frame was held
+ */
+int frame_dbuf_release(frame_dbuf_t *db);
+
+/**
+ * @brief Get a consistent snapshot of the handoff statistics
+ * @param db Double buffer state
+ * @param stats Output statistics
+ */
+void frame_dbuf_get_stats(const frame_dbuf_t *db, frame_dbuf_stats_t *stats);
+
+#endif /* FRAME_DBUF_H */
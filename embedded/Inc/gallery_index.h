@@ -0,0 +1,168 @@
+/**
+ ******************************************************************************
+ * @file    gallery_index.h
+ * @author  PeleAB
+ * @brief   Approximate face gallery search for large galleries: inverted
+ *          lists over coarse centroids, product-quantized templates and an
+ *          exact int8 re-rank of the shortlist
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * The index is an image built offline (Host/index_build.c) and searched in
+ * place, from PSRAM on the board. Each template (unit norm) belongs to the
+ * list of its nearest coarse centroid c. Its residual x - c is split into
+ * GALLERY_INDEX_SUBSPACES sub-vectors of GALLERY_INDEX_SUBDIM elements, each
+ * stored as the index of the nearest of GALLERY_INDEX_CODES sub-centroids:
+ * one byte per sub-vector, 16 bytes per template instead of 128.
+ *
+ * A search ranks the centroids by their dot product with the query and scans
+ * the lists of the best few (the probes). q.x = q.c + q.(x - c), and the
+ * second term is approximated by a sum of one table lookup per sub-vector;
+ * the table of q against every sub-centroid is filled once per query. The
+ * best GALLERY_INDEX_SHORTLIST templates of that approximation are then
+ * scored exactly, as face_gallery_search does on int8 templates, from the
+ * int8 rows kept in the image. A template that reaches the shortlist thus
+ * gets the very score the exhaustive int8 search gives it.
+ *
+ * The scan can be spread over several calls (gallery_index_search_step with
+ * a budget of templates), so the caller decides how much of a frame it
+ * takes.
+ */
+
+#ifndef GALLERY_INDEX_H
+#define GALLERY_INDEX_H
+
+#include <stdint.h>
+#include "face_gallery.h"
+
+/* ========================================================================= */
+/* CONSTANTS                                                                 */
+/* ========================================================================= */
+
+#define GALLERY_INDEX_SUBSPACES             16      /**< Code bytes per template */
+#define GALLERY_INDEX_SUBDIM                (EMBEDDING_SIZE / GALLERY_INDEX_SUBSPACES)
+#define GALLERY_INDEX_CODES                 256     /**< Sub-centroids per sub-vector */
+#define GALLERY_INDEX_MAX_LISTS             4096
+#define GALLERY_INDEX_MAX_PROBES            64
+#define GALLERY_INDEX_SHORTLIST             64      /**< Templates re-ranked exactly */
+
+#define GALLERY_INDEX_MAGIC                 0x58564947U     /**< "GIVX" */
+#define GALLERY_INDEX_VERSION               1U
+
+/** @brief Return codes (negative on error) */
+#define GALLERY_INDEX_OK                    0
+#define GALLERY_INDEX_ERR_ARG               (-1)    /**< Bad argument, or zero query */
+#define GALLERY_INDEX_ERR_IMAGE             (-2)    /**< Not an index, or corrupt */
+
+/* ========================================================================= */
+/* TYPES                                                                     */
+/* ========================================================================= */
+
+/**
+ * @brief Image header; each section starts at its offset from the header,
+ *        4-byte aligned
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                          /**< Whole image, header included */
+    uint32_t crc;                           /**< CRC-32 of the bytes after the header */
+    uint32_t lists;
+    uint32_t templates;
+    uint32_t centroids;                     /**< float32_t[lists][EMBEDDING_SIZE], unit norm */
+    uint32_t codebooks;                     /**< float32_t[SUBSPACES][CODES][SUBDIM] */
+    uint32_t list_start;                    /**< uint32_t[lists + 1], templates in list order */
+    uint32_t codes;                         /**< uint8_t[templates][SUBSPACES] */
+    uint32_t identity;                      /**< uint16_t[templates] */
+    uint32_t scale;                         /**< float32_t[templates], as face_gallery int8 */
+    uint32_t rows;                          /**< int8_t[templates][EMBEDDING_SIZE] */
+} gallery_index_header_t;
+
+typedef struct {
+    const gallery_index_header_t *pHeader;
+    const float32_t *pCentroids;
+    const float32_t *pCodebooks;
+    const uint32_t *pListStart;
+    const uint8_t *pCodes;
+    const uint16_t *pIdentity;
+    const float32_t *pScale;
+    const int8_t *pRows;
+    uint32_t lists;
+    uint32_t templates;
+    uint32_t identity_min;                  /**< Identity range of the templates */
+    uint32_t identity_max;
+} gallery_index_t;
+
+/** @brief State of one search, kept by the caller between steps */
+typedef struct {
+    int8_t query_q7[EMBEDDING_SIZE];
+    float32_t query_scale;
+    float32_t table[GALLERY_INDEX_SUBSPACES][GALLERY_INDEX_CODES]; /**< q . sub-centroid */
+    uint16_t probe[GALLERY_INDEX_MAX_PROBES]; /**< Lists to scan, best centroid first */
+    float32_t probe_dot[GALLERY_INDEX_MAX_PROBES]; /**< q . centroid */
+    uint32_t probes;
+    uint32_t next_probe;
+    uint32_t next_template;                 /**< Within the list being scanned */
+    uint32_t shortlist[GALLERY_INDEX_SHORTLIST];
+    float32_t shortlist_dot[GALLERY_INDEX_SHORTLIST]; /**< Approximate, best first */
+    uint32_t shortlisted;
+    uint32_t scanned;                       /**< Templates scored from their codes */
+} gallery_index_search_t;
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Attach an image, after checking its header, layout and CRC, and
+ *        note the range of its identities
+ * @param pImage 4-byte aligned, kept by the caller
+ * @param size Bytes available at pImage
+ * @return GALLERY_INDEX_OK or a negative error
+ */
+int gallery_index_open(gallery_index_t *pIndex, const void *pImage, uint32_t size);
+
+/**
+ * @brief Start a search: quantize the query, fill the sub-centroid table
+ *        and choose the lists to scan
+ * @param query EMBEDDING_SIZE floats, unit norm (face_gallery_normalize)
+ * @param probes Lists to scan, clipped to 1..GALLERY_INDEX_MAX_PROBES and the
+ *        number of lists
+ * @return GALLERY_INDEX_OK or a negative error
+ */
+int gallery_index_search_begin(const gallery_index_t *pIndex, gallery_index_search_t *pSearch,
+                               const float32_t *query, uint32_t probes);
+
+/**
+ * @brief Scan up to @p budget more templates of the chosen lists
+ * @return 1 while templates remain to scan, 0 once done
+ */
+int gallery_index_search_step(const gallery_index_t *pIndex, gallery_index_search_t *pSearch,
+                              uint32_t budget);
+
+/**
+ * @brief Score the shortlist exactly
+ * @param pMatch Up to k matches, best first, one per identity
+ * @return Number of matches written
+ */
+uint32_t gallery_index_search_end(const gallery_index_t *pIndex, const gallery_index_search_t *pSearch,
+                                  face_gallery_match_t *pMatch, uint32_t k);
+
+/**
+ * @brief The three steps above in one call
+ * @return Number of matches written, 0 on error
+ */
+uint32_t gallery_index_search(const gallery_index_t *pIndex, gallery_index_search_t *pSearch,
+                              const float32_t *query, uint32_t probes,
+                              face_gallery_match_t *pMatch, uint32_t k);
+
+#endif /* GALLERY_INDEX_H */
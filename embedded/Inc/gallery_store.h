@@ -0,0 +1,171 @@
+/**
+ ******************************************************************************
+ * @file    gallery_store.h
+ * @author  PeleAB
+ * @brief   Persistent face gallery: append-only log of int8 templates in NOR
+ *          flash, searched in place through the memory-mapped window
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * The region is a ring of erase sectors (segments). Slot 0 of a segment holds
+ * its header and sequence number; the other slots hold one record each,
+ * appended in order and never rewritten: a template (int8 row and its scale,
+ * as in face_gallery.h) or a tombstone that deletes every template of an
+ * identity. Each record ends with a CRC-32, written last, so a record torn by
+ * a power cut fails its check and is ignored. Identities are never reused
+ * while a record of theirs remains, so a tombstone holds wherever it sits.
+ *
+ * When the newest segment is full and only the reserve segment is left, the
+ * oldest one is compacted: its live records are appended again (a record
+ * already copied by an interrupted compaction is skipped), then it is retired
+ * (header cleared) and becomes free; a free sector is erased when it is next
+ * used. The reserve segment guarantees room for the copies.
+ *
+ * Templates are never copied to RAM: the search reads the rows straight from
+ * the memory-mapped flash. Mount walks the records once to find the newest
+ * segment, check the CRCs and note the deleted identities; writes go through
+ * a gallery_flash_t backend (gallery_flash_xspi on the board, an mmap'd file
+ * on the host, Host/host_flash.c).
+ */
+
+#ifndef GALLERY_STORE_H
+#define GALLERY_STORE_H
+
+#include <stdint.h>
+#include "face_gallery.h"
+
+/* ========================================================================= */
+/* CONSTANTS                                                                 */
+/* ========================================================================= */
+
+#define GALLERY_STORE_SECTOR_SIZE           (64U * 1024U)   /**< NOR erase unit */
+#define GALLERY_STORE_SLOT_SIZE             256U            /**< NOR page, one record */
+#define GALLERY_STORE_SLOTS                 (GALLERY_STORE_SECTOR_SIZE / GALLERY_STORE_SLOT_SIZE)
+#define GALLERY_STORE_MIN_SECTORS           3               /**< Oldest, newest and reserve */
+#define GALLERY_STORE_MAX_SECTORS           64
+#define GALLERY_STORE_MAX_IDENTITIES        4096
+
+/** @brief Return codes (negative on error) */
+#define GALLERY_STORE_OK                    0
+#define GALLERY_STORE_ERR_ARG               (-1)    /**< Bad argument or unknown identity */
+#define GALLERY_STORE_ERR_FULL              (-2)    /**< No room left after compaction */
+#define GALLERY_STORE_ERR_ZERO              (-3)    /**< Zero embedding */
+#define GALLERY_STORE_ERR_FLASH             (-4)    /**< Erase or program failed */
+
+/* ========================================================================= */
+/* TYPES                                                                     */
+/* ========================================================================= */
+
+#define GALLERY_RECORD_MAGIC                0x47524C46U
+
+/** @brief Record types */
+#define GALLERY_RECORD_SEGMENT              1U      /**< Slot 0: uid is the segment sequence */
+#define GALLERY_RECORD_TEMPLATE             2U
+#define GALLERY_RECORD_TOMBSTONE            3U
+
+/** @brief One record, at the start of its slot; the rest of the slot stays erased */
+typedef struct {
+    uint32_t magic;                         /**< GALLERY_RECORD_MAGIC, 0 once invalidated */
+    uint16_t type;
+    uint16_t identity;
+    uint32_t uid;                           /**< Record id, kept by compaction copies */
+    float32_t scale;                        /**< Template: 1 / |row| */
+    int8_t row[EMBEDDING_SIZE];             /**< Template: quantized embedding */
+    uint32_t crc;                           /**< CRC-32 of the bytes above */
+} gallery_record_t;
+
+/**
+ * @brief Flash backend
+ *
+ * Offsets are from the start of the region. program() can only clear bits,
+ * as on NOR: each byte becomes the AND of the old and the new one, which is
+ * how a record is invalidated in place. Both return 0 on success.
+ */
+typedef struct {
+    const char *name;
+    /** Memory-mapped start of the region, NULL if the flash cannot be used */
+    const uint8_t *(*map)(uint32_t size);
+    /** Erase the GALLERY_STORE_SECTOR_SIZE bytes at @p offset */
+    int (*erase)(uint32_t offset);
+    int (*program)(uint32_t offset, const void *pData, uint32_t size);
+} gallery_flash_t;
+
+extern const gallery_flash_t gallery_flash_xspi;
+extern const gallery_flash_t gallery_flash_host;   /**< Host/host_flash.c */
+
+typedef struct {
+    const gallery_flash_t *pFlash;
+    const uint8_t *pBase;                   /**< Memory-mapped region */
+    uint32_t sectors;
+    uint8_t order[GALLERY_STORE_MAX_SECTORS]; /**< Segments in use, oldest first */
+    uint32_t used;                          /**< Entries of order */
+    uint32_t head_slot;                     /**< Next free slot of the newest segment */
+    uint32_t next_seq;
+    uint32_t next_uid;
+    uint32_t next_identity;
+    uint32_t templates;                     /**< Template records of identities not deleted */
+    uint32_t repaired;                      /**< Torn records invalidated by the last mount */
+    uint32_t deleted[GALLERY_STORE_MAX_IDENTITIES / 32]; /**< Tombstoned identities */
+} gallery_store_t;
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Open the store; an erased or foreign region opens empty (a sector
+ *        is erased when the store first uses it)
+ * @param pFlash Backend
+ * @param sectors Region size in sectors, GALLERY_STORE_MIN_SECTORS to
+ *        GALLERY_STORE_MAX_SECTORS
+ * @return GALLERY_STORE_OK or a negative error
+ */
+int gallery_store_mount(gallery_store_t *pStore, const gallery_flash_t *pFlash, uint32_t sectors);
+
+/**
+ * @brief Identity that the next new person should be enrolled as
+ */
+int gallery_store_next_identity(const gallery_store_t *pStore);
+
+/**
+ * @brief Append a template, quantized as in face_gallery_init_q7
+ * @param identity Below GALLERY_STORE_MAX_IDENTITIES, not deleted
+ * @return GALLERY_STORE_OK or a negative error
+ */
+int gallery_store_add(gallery_store_t *pStore, uint16_t identity, const float32_t *embedding);
+
+/**
+ * @brief Append a tombstone for every template of @p identity
+ * @return GALLERY_STORE_OK or a negative error
+ */
+int gallery_store_delete(gallery_store_t *pStore, uint16_t identity);
+
+/**
+ * @brief Delete every identity
+ * @return GALLERY_STORE_OK or a negative error
+ */
+int gallery_store_clear(gallery_store_t *pStore);
+
+/**
+ * @brief Number of templates of an identity (0 once deleted)
+ */
+uint32_t gallery_store_identity_count(const gallery_store_t *pStore, uint16_t identity);
+
+/**
+ * @brief Best-matching identities, as face_gallery_search on int8 templates
+ * @param query EMBEDDING_SIZE floats, any norm
+ * @return Number of matches written
+ */
+uint32_t gallery_store_search(const gallery_store_t *pStore, const float32_t *query,
+                              face_gallery_match_t *pMatch, uint32_t k);
+
+#endif /* GALLERY_STORE_H */
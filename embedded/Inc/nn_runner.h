@@ -3,6 +3,98 @@
 
 #include "ll_aton_runtime.h"
 
+/* Asynchronous run state */
+typedef enum
+{
+  NN_RUN_IDLE = 0,  /* No inference started */
+  NN_RUN_BUSY,      /* Inference in progress, keep polling */
+  NN_RUN_DONE       /* Inference finished, outputs valid */
+} nn_run_state_t;
+
+typedef struct nn_async_run nn_async_run_t;
+
+/* Called once from RunNetworkAsync_Poll() when the inference completes */
+typedef void (*nn_run_done_cb_t)(nn_async_run_t *run, void *user);
+
+struct nn_async_run
+{
+  NN_Instance_TypeDef *inst;
+  volatile nn_run_state_t state;
+  nn_run_done_cb_t on_done;
+  void *user;
+  uint32_t epoch_blocks;   /* RunEpochBlock calls that advanced the network */
+  uint32_t wfe_count;      /* Polls that found the NPU still busy */
+};
+
+/* Network kept resident across inferences. Costs are in profiler_now() ticks
+ * (core cycles on target) */
+typedef struct
+{
+  NN_Instance_TypeDef *inst;
+  uint8_t initialized;
+  uint32_t init_count;     /* Full LL_ATON_RT_Init_Network() calls */
+  uint32_t reset_count;    /* Inferences that only needed LL_ATON_RT_Reset_Network() */
+  uint32_t init_cycles;    /* Measured cost of the last full init */
+  uint32_t reset_cycles;   /* Measured cost of the last reset */
+  uint32_t saved_cycles;   /* Sum of (init - reset) cost over all resets */
+} nn_network_t;
+
 void RunNetworkSync(NN_Instance_TypeDef *inst);
+void RunNetworkSyncResident(nn_network_t *net);
+
+/**
+ * @brief  Bind a resident network to its instance
+ */
+void NN_Network_Bind(nn_network_t *net, NN_Instance_TypeDef *inst);
+
+/**
+ * @brief  Make @p net ready for a new inference
+ * @note   The first call runs the full LL_ATON_RT_Init_Network(), including the
+ *         one-time epoch controller setup. Later calls only rewind the execution
+ *         state with LL_ATON_RT_Reset_Network().
+ */
+void NN_Network_Prepare(nn_network_t *net);
+
+/**
+ * @brief  De-initialise @p net; the next Prepare does a full init again
+ */
+void NN_Network_Release(nn_network_t *net);
+
+/**
+ * @brief  Ticks (cycles on target) saved so far by resetting instead of
+ *         re-initialising
+ */
+uint32_t NN_Network_SavedCycles(const nn_network_t *net);
+
+/**
+ * @brief  Initialise @p inst and start its first epoch block
+ * @param  run Run context, owned by the caller until the run is done
+ * @param  inst Network instance
+ * @param  on_done Optional completion callback
+ * @param  user Argument passed to @p on_done
+ * @retval 0 on success, negative if @p run is still busy
+ */
+int RunNetworkAsync_Start(nn_async_run_t *run, NN_Instance_TypeDef *inst,
+                          nn_run_done_cb_t on_done, void *user);
+
+/**
+ * @brief  Same as RunNetworkAsync_Start() for a resident network
+ */
+int RunNetworkAsync_StartResident(nn_async_run_t *run, nn_network_t *net,
+                                  nn_run_done_cb_t on_done, void *user);
+
+/**
+ * @brief  Advance the network without blocking
+ * @note   Steps through every epoch block that is ready and returns as soon as
+ *         the NPU has to be waited for, so the caller can do CPU work between
+ *         polls.
+ * @retval Current run state
+ */
+nn_run_state_t RunNetworkAsync_Poll(nn_async_run_t *run);
+
+/**
+ * @brief  Block (with WFE) until the run completes
+ */
+void RunNetworkAsync_Wait(nn_async_run_t *run);
 
 #endif /* NN_RUNNER_H */
@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * @file    pipeline_profiler.h
+ * @author  PeleAB
+ * @brief   Per-stage cycle profiler for the frame processing pipeline
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef PIPELINE_PROFILER_H
+#define PIPELINE_PROFILER_H
+
+#include <stdint.h>
+#include "app_frame_processing.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+/** @brief Number of most recent frames kept per stage for percentiles */
+#define PROFILER_WINDOW_SIZE                128
+
+/* ========================================================================= */
+/* TYPES                                                                     */
+/* ========================================================================= */
+
+/**
+ * @brief Percentile summary of one stage over the rolling window
+ */
+typedef struct {
+    uint32_t p50_us;                        /**< Median */
+    uint32_t p95_us;                        /**< 95th percentile */
+    uint32_t p99_us;                        /**< 99th percentile */
+    uint32_t max_us;                        /**< Worst case in window */
+    uint32_t samples;                       /**< Samples in window */
+} profiler_summary_t;
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Initialize the profiler and its time source
+ * @note  On target the time source is the DWT cycle counter, on host builds
+ *        it is clock_gettime(CLOCK_MONOTONIC) in nanoseconds. The time source
+ *        is usable even when ENABLE_PIPELINE_PROFILER is not defined.
+ */
+void profiler_init(void);
+
+/**
+ * @brief Read the profiler time source
+ * @return Current time in profiler ticks (wraps)
+ */
+uint32_t profiler_now(void);
+
+/**
+ * @brief Get the profiler time source frequency
+ * @return Ticks per second (core clock on target, 1 GHz on host)
+ */
+uint32_t profiler_tick_rate(void);
+
+/**
+ * @brief Convert profiler ticks to microseconds
+ * @param ticks Tick delta
+ * @return Microseconds
+ */
+uint32_t profiler_ticks_to_us(uint32_t ticks);
+
+/**
+ * @brief Start timing a new frame
+ */
+void profiler_frame_begin(void);
+
+/**
+ * @brief Start timing a stage
+ * @param stage Pipeline stage
+ */
+void profiler_stage_begin(pipeline_stage_t stage);
+
+/**
+ * @brief Stop timing a stage; repeated begin/end pairs in a frame accumulate
+ * @param stage Pipeline stage
+ */
+void profiler_stage_end(pipeline_stage_t stage);
+
+/**
+ * @brief Close the frame and push its stage times into the rolling window
+ * @param timing Optional output for this frame's timing
+ */
+void profiler_frame_end(pipeline_timing_t *timing);
+
+/**
+ * @brief Compute percentiles of a stage over the rolling window
+ * @param stage Pipeline stage, or PIPELINE_STAGE_COUNT for the whole frame
+ * @param summary Output summary
+ * @return 0 on success, negative on error
+ */
+int profiler_get_summary(pipeline_stage_t stage, profiler_summary_t *summary);
+
+/**
+ * @brief Print the p50/p95/p99 table for every stage
+ */
+void profiler_report(void);
+
+/* ========================================================================= */
+/* INSTRUMENTATION MACROS                                                    */
+/* ========================================================================= */
+
+#ifdef ENABLE_PIPELINE_PROFILER
+#define PROFILER_FRAME_BEGIN()              profiler_frame_begin()
+#define PROFILER_STAGE_BEGIN(stage)         profiler_stage_begin(stage)
+#define PROFILER_STAGE_END(stage)           profiler_stage_end(stage)
+#define PROFILER_FRAME_END(timing)          profiler_frame_end(timing)
+#define PROFILER_REPORT()                   profiler_report()
+#else
+#define PROFILER_FRAME_BEGIN()              do { } while (0)
+#define PROFILER_STAGE_BEGIN(stage)         do { (void)(stage); } while (0)
+#define PROFILER_STAGE_END(stage)           do { (void)(stage); } while (0)
+#define PROFILER_FRAME_END(timing)          do { (void)(timing); } while (0)
+#define PROFILER_REPORT()                   do { } while (0)
+#endif
+
+#endif /* PIPELINE_PROFILER_H */
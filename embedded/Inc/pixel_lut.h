@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @file    pixel_lut.h
+ * @author  PeleAB
+ * @brief   Lookup tables for RGB565 expansion, gray conversion and input
+ *          normalization
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Each table holds exactly what the arithmetic it replaces computes, so the
+ * kernels produce the same output with ENABLE_PIXEL_LUT on or off:
+ * - pixel_lut_565_r / _g: 5/6-bit channel to 8 bits by left shift, as the
+ *   aligned crop warp does (blue uses the 5-bit table)
+ * - pixel_lut_gray_r / _g / _b: weighted 8-bit channel of the blitter gray
+ *   conversion, (30 R + 59 G + 11 B) / 100, channels expanded by bit
+ *   replication; gray = (r + g + b) / 100
+ * - pixel_lut_norm: recognition input normalization, p / 127.5 - 1
+ *
+ * Tables are in RAM and filled by pixel_lut_init() unless PIXEL_LUT_CONST
+ * is defined, in which case they are const data built by the compiler.
+ */
+
+#ifndef PIXEL_LUT_H
+#define PIXEL_LUT_H
+
+#include <stdint.h>
+#include "app_config.h"
+
+/* ========================================================================= */
+/* TABLES                                                                    */
+/* ========================================================================= */
+
+#ifdef PIXEL_LUT_CONST
+#define PIXEL_LUT_QUALIFIER                 const
+#else
+#define PIXEL_LUT_QUALIFIER
+#endif
+
+extern PIXEL_LUT_QUALIFIER uint8_t pixel_lut_565_r[32];
+extern PIXEL_LUT_QUALIFIER uint8_t pixel_lut_565_g[64];
+
+extern PIXEL_LUT_QUALIFIER uint16_t pixel_lut_gray_r[32];
+extern PIXEL_LUT_QUALIFIER uint16_t pixel_lut_gray_g[64];
+extern PIXEL_LUT_QUALIFIER uint16_t pixel_lut_gray_b[32];
+
+extern PIXEL_LUT_QUALIFIER float pixel_lut_norm[256];
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Fill the tables (nothing to do with PIXEL_LUT_CONST)
+ *
+ * Must run before any kernel reads them: called from app_init().
+ */
+void pixel_lut_init(void);
+
+#endif /* PIXEL_LUT_H */
@@ -3,18 +3,33 @@
 
 #include "arm_math.h"
 #include "app_config.h"
+#include "face_gallery.h"
 
-/* Target embedding constants */
-#define EMBEDDING_SIZE 128
-#define EMBEDDING_BANK_SIZE 10
+/* Enrollment constants */
+#define EMBEDDING_BANK_SIZE 10              /* Templates per identity */
+#define EMBEDDING_BANK_IDENTITIES 8
 
-/* Global target embedding */
-extern float target_embedding[EMBEDDING_SIZE];
-
-/* Target embedding function prototypes */
+/* Enrollment function prototypes: templates are added to the identity being
+ * enrolled until embeddings_bank_next_identity() starts the next one;
+ * embeddings_bank_reset() deletes every identity, persisted ones included */
 void embeddings_bank_init(void);
 int  embeddings_bank_add(const float *embedding);
+int  embeddings_bank_next_identity(void);
 void embeddings_bank_reset(void);
 int  embeddings_bank_count(void);
+int  embeddings_bank_identity(void);
+
+/* Best-matching enrolled identities for a unit-norm embedding (in RAM, or in
+ * the flash store with FACE_GALLERY_FLASH), and with FACE_GALLERY_INDEX the
+ * identities of the offline index as well */
+uint32_t embeddings_bank_search(const float32_t *embedding, face_gallery_match_t *pMatch, uint32_t k);
+
+/* The same search in parts, one at a time: begin copies the embedding, each
+ * step scans up to budget more index templates (1 while some remain, so the
+ * caller can spread the scan over NPU waits), end finishes the scan and
+ * returns the matches. Without FACE_GALLERY_INDEX a step has nothing to do */
+void     embeddings_bank_search_begin(const float32_t *embedding);
+int      embeddings_bank_search_step(uint32_t budget);
+uint32_t embeddings_bank_search_end(face_gallery_match_t *pMatch, uint32_t k);
 
 #endif /* TARGET_EMBEDDING_H */
@@ -0,0 +1,181 @@
+/**
+ ******************************************************************************
+ * @file    trace_log.h
+ * @author  PeleAB
+ * @brief   Deferred binary trace log (message ID + raw arguments ring buffer)
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stdint.h>
+#include "trace_log_ids.h"
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+/** @brief Log levels, lower is more severe */
+#define TLOG_LEVEL_ERROR                    0
+#define TLOG_LEVEL_WARN                     1
+#define TLOG_LEVEL_INFO                     2
+#define TLOG_LEVEL_DEBUG                    3
+
+/** @brief Most verbose level compiled in; calls above it generate no code */
+#ifndef TRACE_LOG_LEVEL
+#define TRACE_LOG_LEVEL                     TLOG_LEVEL_INFO
+#endif
+
+/** @brief Ring size in 32-bit words (power of two) */
+#ifndef TRACE_LOG_RING_WORDS
+#define TRACE_LOG_RING_WORDS                2048
+#endif
+
+/** @brief Maximum number of arguments per message */
+#define TRACE_LOG_MAX_ARGS                  6
+
+/** @brief Header and timestamp words in front of the arguments */
+#define TRACE_LOG_HEADER_WORDS              2
+
+/** @brief Marker in the top byte of every record header */
+#define TRACE_LOG_SYNC                      0xA5U
+
+/*
+ * Record layout, little-endian 32-bit words:
+ *   word 0  [31:24] TRACE_LOG_SYNC  [23:20] level  [19:16] nargs  [15:0] id
+ *   word 1  timestamp in profiler ticks (see TRACE_MSG_CLOCK)
+ *   word 2+ arguments, floats as their IEEE-754 bit pattern
+ */
+#define TRACE_LOG_HEADER(level, nargs, id) \
+    ((TRACE_LOG_SYNC << 24) | (((uint32_t)(level) & 0xFU) << 20) | \
+     (((uint32_t)(nargs) & 0xFU) << 16) | ((uint32_t)(id) & 0xFFFFU))
+#define TRACE_LOG_HEADER_SYNC(hdr)          (((hdr) >> 24) & 0xFFU)
+#define TRACE_LOG_HEADER_LEVEL(hdr)         (((hdr) >> 20) & 0xFU)
+#define TRACE_LOG_HEADER_NARGS(hdr)         (((hdr) >> 16) & 0xFU)
+#define TRACE_LOG_HEADER_ID(hdr)            ((hdr) & 0xFFFFU)
+
+/* ========================================================================= */
+/* FUNCTION PROTOTYPES                                                       */
+/* ========================================================================= */
+
+/**
+ * @brief Reset the ring and log the timestamp clock rate (TRACE_MSG_CLOCK)
+ * @note  Call after profiler_init() so the time source is running
+ */
+void trace_log_init(void);
+
+/**
+ * @brief Append one record to the ring
+ * @param level Log level
+ * @param id Message identifier
+ * @param nargs Number of argument words
+ * @param args Argument words
+ * @note  Single producer: call from the main loop only. When the ring is
+ *        full the record is dropped and counted, the caller never blocks.
+ */
+void trace_log_write(uint32_t level, uint32_t id, uint32_t nargs, const uint32_t *args);
+
+/**
+ * @brief Move whole records out of the ring
+ * @param dst Output buffer
+ * @param max_bytes Output buffer size
+ * @return Number of bytes written (a multiple of 4, 0 if the ring is empty)
+ */
+uint32_t trace_log_drain(uint8_t *dst, uint32_t max_bytes);
+
+/**
+ * @brief Get the number of bytes waiting in the ring
+ * @return Pending bytes
+ */
+uint32_t trace_log_pending(void);
+
+/**
+ * @brief Get the number of records dropped because the ring was full
+ * @return Dropped record count since trace_log_init()
+ */
+uint32_t trace_log_dropped(void);
+
+/* ========================================================================= */
+/* ARGUMENT PACKING                                                          */
+/* ========================================================================= */
+
+static inline uint32_t trace_log_arg_u32(uint32_t v)
+{
+    return v;
+}
+
+static inline uint32_t trace_log_arg_f32(float v)
+{
+    union { float f; uint32_t u; } c = { .f = v };
+    return c.u;
+}
+
+static inline uint32_t trace_log_arg_f64(double v)
+{
+    return trace_log_arg_f32((float)v);
+}
+
+#define TLOG_ARG(x) _Generic((x), \
+    float: trace_log_arg_f32, \
+    double: trace_log_arg_f64, \
+    default: trace_log_arg_u32)(x)
+
+#define TLOG_CAT_(a, b)                     a##b
+#define TLOG_CAT(a, b)                      TLOG_CAT_(a, b)
+#define TLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define TLOG_NARGS(...)                     TLOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+
+#define TLOG_MAP_0()
+#define TLOG_MAP_1(a)                       TLOG_ARG(a),
+#define TLOG_MAP_2(a, b)                    TLOG_MAP_1(a) TLOG_ARG(b),
+#define TLOG_MAP_3(a, b, c)                 TLOG_MAP_2(a, b) TLOG_ARG(c),
+#define TLOG_MAP_4(a, b, c, d)              TLOG_MAP_3(a, b, c) TLOG_ARG(d),
+#define TLOG_MAP_5(a, b, c, d, e)           TLOG_MAP_4(a, b, c, d) TLOG_ARG(e),
+#define TLOG_MAP_6(a, b, c, d, e, f)        TLOG_MAP_5(a, b, c, d, e) TLOG_ARG(f),
+
+#define TLOG_EMIT(level, id, ...) \
+    trace_log_write((level), (id), TLOG_NARGS(__VA_ARGS__), \
+                    (const uint32_t[TRACE_LOG_MAX_ARGS + 1]) { \
+                        TLOG_CAT(TLOG_MAP_, TLOG_NARGS(__VA_ARGS__))(__VA_ARGS__) 0 })
+
+/* ========================================================================= */
+/* LOGGING MACROS                                                            */
+/* ========================================================================= */
+/* Arguments of a compiled-out level are not evaluated.                      */
+
+#if TRACE_LOG_LEVEL >= TLOG_LEVEL_ERROR
+#define TLOG_ERROR(id, ...)                 TLOG_EMIT(TLOG_LEVEL_ERROR, id, ##__VA_ARGS__)
+#else
+#define TLOG_ERROR(id, ...)                 do { } while (0)
+#endif
+
+#if TRACE_LOG_LEVEL >= TLOG_LEVEL_WARN
+#define TLOG_WARN(id, ...)                  TLOG_EMIT(TLOG_LEVEL_WARN, id, ##__VA_ARGS__)
+#else
+#define TLOG_WARN(id, ...)                  do { } while (0)
+#endif
+
+#if TRACE_LOG_LEVEL >= TLOG_LEVEL_INFO
+#define TLOG_INFO(id, ...)                  TLOG_EMIT(TLOG_LEVEL_INFO, id, ##__VA_ARGS__)
+#else
+#define TLOG_INFO(id, ...)                  do { } while (0)
+#endif
+
+#if TRACE_LOG_LEVEL >= TLOG_LEVEL_DEBUG
+#define TLOG_DEBUG(id, ...)                 TLOG_EMIT(TLOG_LEVEL_DEBUG, id, ##__VA_ARGS__)
+#else
+#define TLOG_DEBUG(id, ...)                 do { } while (0)
+#endif
+
+#endif /* TRACE_LOG_H */
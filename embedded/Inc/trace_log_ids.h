@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @file    trace_log_ids.h
+ * @author  PeleAB
+ * @brief   Message catalog for the binary trace log
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef TRACE_LOG_IDS_H
+#define TRACE_LOG_IDS_H
+
+/*
+ * Format strings never reach the firmware image: a record only carries the
+ * message ID and its raw 32-bit arguments. The host decoder includes this
+ * same file, so it must be rebuilt whenever the catalog changes.
+ *
+ * Rules for formats:
+ *  - integer conversions take 32-bit values (use %lu/%ld/%lx or %u/%d/%x)
+ *  - floating conversions (%f, %e, %g) take float values
+ *  - no %s, %c or %p: strings are not copied into the ring
+ *  - at most TRACE_LOG_MAX_ARGS arguments
+ *
+ * Append new messages at the end so that IDs of older captures stay valid.
+ */
+#define TRACE_LOG_MESSAGES(X) \
+    X(TRACE_MSG_CLOCK,              "Trace clock %lu Hz") \
+    X(TRACE_MSG_DROPPED,            "Trace log overflow: %lu records dropped") \
+    X(TRACE_MSG_FRAME_START,        "STARTING FRAME %lu PROCESSING PIPELINE") \
+    X(TRACE_MSG_STAGE,              "PIPELINE STAGE %lu") \
+    X(TRACE_MSG_CAPTURE_FAILED,     "Frame capture failed") \
+    X(TRACE_MSG_PREPROCESS_DONE,    "Frame captured and preprocessed (%lux%lu -> %lu bytes)") \
+    X(TRACE_MSG_DETECTION_DONE,     "Face detection completed in %lu ms (%lu outputs ready, %lu epoch blocks, %lu waits)") \
+    X(TRACE_MSG_POSTPROCESS_FAILED, "Post-processing failed") \
+    X(TRACE_MSG_PP_BOX,             "   Face %lu: confidence=%.3f, center=(%.2f,%.2f), size=%.2fx%.2f") \
+    X(TRACE_MSG_POSTPROCESS_DONE,   "Post-processing completed: %lu faces detected") \
+    X(TRACE_MSG_RECOG_BATCH,        "   Running face recognition on %lu detected faces") \
+    X(TRACE_MSG_FACE_SKIPPED,       "   Face %lu: detection=%.1f%% (too low, skipping recognition)") \
+    X(TRACE_MSG_RECOG_INIT_FAILED,  "Face recognition network lazy initialization failed") \
+    X(TRACE_MSG_FACE_RESULT,        "   Face %lu: detection=%.1f%% -> recognition=%.1f%% (%lu us)") \
+    X(TRACE_MSG_FRAME_SUMMARY,      "   Frame summary: faces=%lu, target_this_frame=%lu, target_detected=%lu (%.1f%% best)") \
+    X(TRACE_MSG_RECOG_RESULT,       "Face recognition: detected=%lu, verified=%lu, best_similarity=%.1f%%") \
+    X(TRACE_MSG_NO_FACE,            "No faces above threshold detected") \
+    X(TRACE_MSG_FRAME_DONE,         "Frame processing completed: %.1f FPS, %lu ms total, %lu camera frames dropped") \
+    X(TRACE_MSG_NPU_SAVED,          "NPU setup saved this frame: %lu cycles (%lu resets vs %lu full inits)")
+
+/**
+ * @brief Trace message identifiers
+ */
+typedef enum {
+#define TRACE_LOG_ENUM_ENTRY(id, fmt) id,
+    TRACE_LOG_MESSAGES(TRACE_LOG_ENUM_ENTRY)
+#undef TRACE_LOG_ENUM_ENTRY
+    TRACE_MSG_COUNT
+} trace_msg_id_t;
+
+#endif /* TRACE_LOG_IDS_H */
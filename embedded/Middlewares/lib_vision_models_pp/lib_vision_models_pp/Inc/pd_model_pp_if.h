@@ -25,6 +25,10 @@
 
 #include "pd_pp_output_if.h"
 
+/* Heatmap cells that become NMS candidates (decode_mode) */
+#define AI_PD_PP_DECODE_THRESHOLD   (0)   /* every cell above conf_threshold */
+#define AI_PD_PP_DECODE_PEAKS       (1)   /* 3x3 local maxima above conf_threshold */
+
 typedef struct {
   float32_t x;
   float32_t y;
@@ -41,6 +45,26 @@ typedef struct pd_model_pp_in
   float32_t *pOffset;
 } pd_model_pp_in_t;
 
+/* Candidate cell: heatmap score and cell index */
+typedef struct {
+  float32_t prob;
+  uint32_t index;
+} pd_pp_candidate_t;
+
+/* Box of a candidate in input pixels (top-left corner, size), and the
+ * normalized corners and area NMS compares */
+typedef struct {
+  float32_t x1;
+  float32_t y1;
+  float32_t s0;
+  float32_t s1;
+  float32_t xmin;
+  float32_t ymin;
+  float32_t xmax;
+  float32_t ymax;
+  float32_t area;
+} pd_pp_nms_box_t;
+
 typedef struct pd_model_static_param {
   uint32_t width;
   uint32_t height;
@@ -50,6 +74,13 @@ typedef struct pd_model_static_param {
   uint32_t nb_total_boxes;
   uint32_t max_boxes_limit;
   pd_anchor_t *pAnchors;
+  uint32_t grid_width;       /* Output map size, in cells */
+  uint32_t grid_height;
+  float32_t stride;          /* Input pixels per cell */
+  pd_pp_candidate_t *pTmpBuff; /* Must be an array of max_boxes_limit elements */
+  pd_pp_nms_box_t *pTmpNmsBuff; /* Must be an array of max_boxes_limit elements */
+  uint32_t decode_mode;      /* AI_PD_PP_DECODE_THRESHOLD or AI_PD_PP_DECODE_PEAKS */
+  float32_t kps_conf_threshold; /* Lower-scoring boxes get no keypoints (nb_kps 0) */
 } pd_model_pp_static_param_t;
 
 
@@ -42,6 +42,7 @@ typedef struct {
   float32_t width;
   float32_t height;
   pd_pp_point_t *pKps; //[PD_KPS_NB];
+  uint32_t nb_kps;     /* Keypoints decoded in pKps, 0 if none */
 } pd_pp_box_t;
 
 
@@ -20,155 +20,302 @@
 #include "pd_pp_loc.h"
 
 
-static int32_t pd_pp_nms_comparator(const void *arg1, const void *arg2)
-{
-  const pd_pp_box_t *box1 = arg1;
-  const pd_pp_box_t *box2 = arg2;
-
-  if (box1->prob < box2->prob)
-    return 1;
+#define PD_PP_BATCH                 (16)
 
-  if (box1->prob > box2->prob)
-    return -1;
+/* Candidate selection: the max_boxes_limit best cells are kept in a min-heap,
+ * worst on top. Scores tie-break on raster order, so the selection and the
+ * final order are those of a stable sort of all the cells by score. */
 
-  return 0;
+static inline int pd_pp_cand_worse(const pd_pp_candidate_t *a, const pd_pp_candidate_t *b)
+{
+  return (a->prob < b->prob) || ((a->prob == b->prob) && (a->index > b->index));
 }
 
-static void pd_pp_compute_opposite_corners_from_box(pd_pp_box_t *box, pd_pp_point_t corners[2])
+static void pd_pp_heap_sift_down(pd_pp_candidate_t *pHeap, uint32_t nb, uint32_t i)
 {
-  corners[0].x = box->x_center - box->width / 2;
-  corners[0].y = box->y_center - box->height / 2;
-  corners[1].x = box->x_center + box->width / 2;
-  corners[1].y = box->y_center + box->height / 2;
+  pd_pp_candidate_t cand = pHeap[i];
+
+  for (;;) {
+    uint32_t child = 2 * i + 1;
+
+    if (child >= nb)
+      break;
+    if (child + 1 < nb && pd_pp_cand_worse(&pHeap[child + 1], &pHeap[child]))
+      child++;
+    if (!pd_pp_cand_worse(&pHeap[child], &cand))
+      break;
+    pHeap[i] = pHeap[child];
+    i = child;
+  }
+  pHeap[i] = cand;
 }
 
-static float pd_pp_compute_iou(pd_pp_box_t *box0, pd_pp_box_t *box1)
+/* Cells must come in raster order: a later cell never wins a tie */
+static inline void pd_pp_heap_push(pd_pp_candidate_t *pHeap, uint32_t *pNb, uint32_t max_nb,
+                                   float32_t prob, uint32_t index)
 {
-  pd_pp_point_t corners[2][2];
-  float32_t intersect_xmin;
-  float32_t intersect_ymin;
-  float32_t intersect_xmax;
-  float32_t intersect_ymax;
-  float32_t intersect_area;
-  float32_t area[2];
-  float32_t xmin[2];
-  float32_t xmax[2];
-  float32_t ymin[2];
-  float32_t ymax[2];
-  int i;
-
-  pd_pp_compute_opposite_corners_from_box(box0, corners[0]);
-  pd_pp_compute_opposite_corners_from_box(box1, corners[1]);
-
-  for (i = 0; i < 2; i++) {
-    xmin[i] = MIN(corners[i][0].x, corners[i][1].x);
-    xmax[i] = MAX(corners[i][0].x, corners[i][1].x);
-    ymin[i] = MIN(corners[i][0].y, corners[i][1].y);
-    ymax[i] = MAX(corners[i][0].y, corners[i][1].y);
-  }
+  if (*pNb < max_nb) {
+    uint32_t i = (*pNb)++;
 
-  for (i = 0; i < 2; i++) {
-    area[i] = (ymax[i] - ymin[i]) * (xmax[i] - xmin[i]);
+    while (i > 0 && pHeap[(i - 1) / 2].prob >= prob) {
+      pHeap[i] = pHeap[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+    pHeap[i].prob = prob;
+    pHeap[i].index = index;
+  } else if (prob > pHeap[0].prob) {
+    pHeap[0].prob = prob;
+    pHeap[0].index = index;
+    pd_pp_heap_sift_down(pHeap, max_nb, 0);
   }
-  if (area[0] <= 0 || area[1] <= 0)
-    return 0;
-
-  intersect_xmin = MAX(xmin[0], xmin[1]);
-  intersect_ymin = MAX(ymin[0], ymin[1]);
-  intersect_xmax = MIN(xmax[0], xmax[1]);
-  intersect_ymax = MIN(ymax[0], ymax[1]);
+}
 
-  intersect_area = MAX(intersect_ymax - intersect_ymin, 0.0f) * MAX(intersect_xmax - intersect_xmin, 0.0f);
+/* Heap to best-first order, in place */
+static void pd_pp_heap_sort(pd_pp_candidate_t *pHeap, uint32_t nb)
+{
+  while (nb > 1) {
+    pd_pp_candidate_t worst = pHeap[0];
 
-  return intersect_area / (area[0] + area[1] - intersect_area);
+    pHeap[0] = pHeap[--nb];
+    pHeap[nb] = worst;
+    pd_pp_heap_sift_down(pHeap, nb, 0);
+  }
 }
-static int32_t pd_pp_decode(pd_model_pp_in_t *pInput,
-                                     pd_postprocess_out_t *pOutput,
-                                     pd_model_pp_static_param_t *pInput_static_param) {
 
-  pOutput->box_nb = 0;
+/* Box of heatmap cell index_h, computed as the original decoder and IoU
+ * computed it */
+static void pd_pp_decode_geometry(pd_model_pp_in_t *pInput,
+                                  pd_model_pp_static_param_t *pInput_static_param,
+                                  pd_pp_nms_box_t *pNms, uint32_t cell)
+{
+  float32_t width  = pInput_static_param->width;
+  float32_t height = pInput_static_param->height;
+  float32_t *pScale = pInput->pScale;
+  float32_t *pOffset = pInput->pOffset;
+  float32_t stride = pInput_static_param->stride;
+  int index_h = (int)cell;
+  int x = index_h % (int)pInput_static_param->grid_width;
+  int y = index_h / (int)pInput_static_param->grid_width;
+
+  float32_t s0 = expf(pScale[(index_h * 2) + 0]) * stride;
+  float32_t s1 = expf(pScale[(index_h * 2) + 1]) * stride;
+  float32_t o0 = pOffset[(index_h * 2) + 0];
+  float32_t o1 = pOffset[(index_h * 2) + 1];
+
+  float32_t x1 = (x + o1 + 0.5f) * stride - s1 / 2.0f;
+  float32_t y1 = (y + o0 + 0.5f) * stride - s0 / 2.0f;
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+
+  float32_t x_center = ((x1 + (x1 + s1)) * 0.5f) / width;
+  float32_t y_center = ((y1 + (y1 + s0)) * 0.5f) / height;
+  float32_t w = s1 / width;
+  float32_t h = s0 / height;
+  float32_t cx0 = x_center - w / 2;
+  float32_t cy0 = y_center - h / 2;
+  float32_t cx1 = x_center + w / 2;
+  float32_t cy1 = y_center + h / 2;
+
+  pNms->x1 = x1;
+  pNms->y1 = y1;
+  pNms->s0 = s0;
+  pNms->s1 = s1;
+  pNms->xmin = MIN(cx0, cx1);
+  pNms->xmax = MAX(cx0, cx1);
+  pNms->ymin = MIN(cy0, cy1);
+  pNms->ymax = MAX(cy0, cy1);
+  pNms->area = (pNms->ymax - pNms->ymin) * (pNms->xmax - pNms->xmin);
+}
 
-  pd_pp_box_t *pBoxes = (pd_pp_box_t *)pOutput->pOutData;
+/* Output box of a kept candidate. Keypoints are only decoded when the score
+ * reaches kps_conf_threshold, otherwise the box has none (nb_kps 0). */
+static void pd_pp_output_box(pd_model_pp_in_t *pInput,
+                             pd_model_pp_static_param_t *pInput_static_param,
+                             pd_pp_box_t *pBox, const pd_pp_candidate_t *pCand,
+                             const pd_pp_nms_box_t *pNms)
+{
   float32_t width  = pInput_static_param->width;
   float32_t height = pInput_static_param->height;
-  const int grid = 32;
-  size_t box_nb = 0;
+  const uint32_t nb_kps = pInput_static_param->nb_keypoints;
+  const float32_t *pLms = &pInput->pLms[pCand->index * nb_kps * 2];
+  float32_t x1 = pNms->x1;
+  float32_t y1 = pNms->y1;
+  float32_t x2 = x1 + pNms->s1;
+  float32_t y2 = y1 + pNms->s0;
+
+  pBox->prob = pCand->prob;
+  pBox->x_center = ((x1 + x2) * 0.5f) / width;
+  pBox->y_center = ((y1 + y2) * 0.5f) / height;
+  pBox->width  = pNms->s1 / width;
+  pBox->height = pNms->s0 / height;
+
+  if (pCand->prob < pInput_static_param->kps_conf_threshold) {
+    pBox->nb_kps = 0;
+    return;
+  }
+  pBox->nb_kps = nb_kps;
+  for (uint32_t j = 0; j < nb_kps; j++) {
+    float32_t lm_y = pLms[j * 2 + 0];
+    float32_t lm_x = pLms[j * 2 + 1];
+    pBox->pKps[j].x = (lm_x * pNms->s1 + x1) / width;
+    pBox->pKps[j].y = (lm_y * pNms->s0 + y1) / height;
+  }
+}
 
-  float32_t *pScale = pInput->pScale;
-  float32_t *pLms = pInput->pLms;
+/* Whether cell index_h is a 3x3 maximum of the heatmap, as CenterFace's
+ * max-pooling decode finds them: cells outside the grid are ignored and
+ * equal neighbours are all maxima */
+static int pd_pp_is_peak(const float32_t *pHeatmap, uint32_t index_h,
+                         uint32_t grid_w, uint32_t grid_h)
+{
+  const float32_t score = pHeatmap[index_h];
+  const uint32_t x = index_h % grid_w;
+  const uint32_t y = index_h / grid_w;
+  const uint32_t x0 = (x > 0) ? x - 1 : x;
+  const uint32_t x1 = (x + 1 < grid_w) ? x + 1 : x;
+  const uint32_t y0 = (y > 0) ? y - 1 : y;
+  const uint32_t y1 = (y + 1 < grid_h) ? y + 1 : y;
+
+  for (uint32_t yy = y0; yy <= y1; yy++) {
+    for (uint32_t xx = x0; xx <= x1; xx++) {
+      if (pHeatmap[yy * grid_w + xx] > score)
+        return 0;
+    }
+  }
+  return 1;
+}
+
+#ifdef AI_PD_PP_MVEF_OPTIM
+/* Heatmap cells above the threshold from index *pStart on, in raster order:
+ * four cells per compare, stops after max_idx hits. Returns the hit count,
+ * *pStart is where the scan resumes. */
+static uint32_t pd_pp_scan_heatmap(const float32_t *pHeatmap, uint32_t nb_cells,
+                                   float32_t threshold, uint32_t *pStart,
+                                   uint16_t *pIdx, uint32_t max_idx)
+{
+  uint32_t nb = 0;
+  uint32_t i = *pStart;
+
+  while (i < nb_cells && nb < max_idx) {
+    mve_pred16_t p = vctp32q(nb_cells - i);
+    float32x4_t f32x4_score = vldrwq_z_f32(&pHeatmap[i], p);
+    mve_pred16_t hit = vcmpgtq_m_n_f32(f32x4_score, threshold, p);
+
+    /* Resume inside this vector if the batch fills up before its last hit */
+    while (hit != 0 && nb < max_idx) {
+      uint32_t lane = (uint32_t)__builtin_ctz(hit) / 4U;
+      pIdx[nb++] = (uint16_t)(i + lane);
+      hit &= (mve_pred16_t)~(0xFU << (lane * 4U));
+    }
+    i = (hit != 0) ? pIdx[nb - 1] + 1U : i + 4U;
+  }
+  *pStart = i;
+  return nb;
+}
+
+static uint32_t pd_pp_scan(pd_model_pp_in_t *pInput,
+                           pd_model_pp_static_param_t *pInput_static_param)
+{
+  const uint32_t grid_w = pInput_static_param->grid_width;
+  const uint32_t grid_h = pInput_static_param->grid_height;
+  const uint32_t nb_cells = grid_w * grid_h;
+  const int peaks = (pInput_static_param->decode_mode == AI_PD_PP_DECODE_PEAKS);
+  pd_pp_candidate_t *pCand = pInput_static_param->pTmpBuff;
   float32_t *pHeatmap = pInput->pHeatmap;
-  float32_t *pOffset = pInput->pOffset;
+  uint16_t idx[PD_PP_BATCH];
+  uint32_t start = 0;
+  uint32_t cand_nb = 0;
+  uint32_t nb;
+
+  while ((nb = pd_pp_scan_heatmap(pHeatmap, nb_cells, pInput_static_param->conf_threshold,
+                                  &start, idx, PD_PP_BATCH)) != 0) {
+    for (uint32_t k = 0; k < nb; k++) {
+      if (peaks && !pd_pp_is_peak(pHeatmap, idx[k], grid_w, grid_h))
+        continue;
+      pd_pp_heap_push(pCand, &cand_nb, pInput_static_param->max_boxes_limit,
+                      pHeatmap[idx[k]], idx[k]);
+    }
+  }
+  return cand_nb;
+}
+#else
+static uint32_t pd_pp_scan(pd_model_pp_in_t *pInput,
+                           pd_model_pp_static_param_t *pInput_static_param)
+{
+  const uint32_t grid_w = pInput_static_param->grid_width;
+  const uint32_t grid_h = pInput_static_param->grid_height;
+  const uint32_t nb_cells = grid_w * grid_h;
+  const float32_t threshold = pInput_static_param->conf_threshold;
+  const int peaks = (pInput_static_param->decode_mode == AI_PD_PP_DECODE_PEAKS);
+  pd_pp_candidate_t *pCand = pInput_static_param->pTmpBuff;
+  float32_t *pHeatmap = pInput->pHeatmap;
+  uint32_t cand_nb = 0;
 
-  for (int y = 0; y < grid; y++) {
-    for (int x = 0; x < grid; x++) {
-      int index_h = (y * grid + x);
-      float32_t score = pHeatmap[index_h];
-      if (score > pInput_static_param->conf_threshold) {
-        float32_t s0 = expf(pScale[(index_h * 2) + 0]) * 4.0f;
-        float32_t s1 = expf(pScale[(index_h * 2) + 1]) * 4.0f;
-        float32_t o0 = pOffset[(index_h * 2) + 0];
-        float32_t o1 = pOffset[(index_h * 2) + 1];
-
-        float32_t x1 = (x + o1 + 0.5f) * 4.0f - s1 / 2.0f;
-        float32_t y1 = (y + o0 + 0.5f) * 4.0f - s0 / 2.0f;
-        if (x1 < 0) x1 = 0;
-        if (y1 < 0) y1 = 0;
-        float32_t x2 = x1 + s1;
-        float32_t y2 = y1 + s0;
-
-        pd_pp_box_t *pBox = &pBoxes[box_nb];
-        pBox->prob = score;
-        pBox->x_center = ((x1 + x2) * 0.5f) / width;
-        pBox->y_center = ((y1 + y2) * 0.5f) / height;
-        pBox->width  = s1 / width;
-        pBox->height = s0 / height;
-
-        for (uint32_t j = 0; j < pInput_static_param->nb_keypoints; j++) {
-          float32_t lm_y = pLms[index_h * pInput_static_param->nb_keypoints * 2 + j * 2 + 0];
-          float32_t lm_x = pLms[index_h * pInput_static_param->nb_keypoints * 2 + j * 2 + 1];
-          pBox->pKps[j].x = (lm_x * s1 + x1) / width;
-          pBox->pKps[j].y = (lm_y * s0 + y1) / height;
-        }
-
-        box_nb++;
-        if (box_nb >= pInput_static_param->max_boxes_limit) {
-          pOutput->box_nb = box_nb;
-          return AI_PD_POSTPROCESS_ERROR_NO;
-        }
-      }
+  for (uint32_t index_h = 0; index_h < nb_cells; index_h++) {
+    float32_t score = pHeatmap[index_h];
+    if (score > threshold && (!peaks || pd_pp_is_peak(pHeatmap, index_h, grid_w, grid_h))) {
+      pd_pp_heap_push(pCand, &cand_nb, pInput_static_param->max_boxes_limit, score, index_h);
     }
   }
+  return cand_nb;
+}
+#endif
+
+/* Candidates best first, with their box geometry only */
+static int32_t pd_pp_decode(pd_model_pp_in_t *pInput,
+                            pd_postprocess_out_t *pOutput,
+                            pd_model_pp_static_param_t *pInput_static_param)
+{
+  pd_pp_candidate_t *pCand = pInput_static_param->pTmpBuff;
+  uint32_t box_nb = pd_pp_scan(pInput, pInput_static_param);
+
+  pd_pp_heap_sort(pCand, box_nb);
+
+  for (uint32_t k = 0; k < box_nb; k++) {
+    pd_pp_decode_geometry(pInput, pInput_static_param, &pInput_static_param->pTmpNmsBuff[k],
+                          pCand[k].index);
+  }
 
   pOutput->box_nb = box_nb;
   return AI_PD_POSTPROCESS_ERROR_NO;
 }
 
+/* Whether kept box pKept suppresses pCand: iou(pCand, pKept) >= threshold */
+static inline int pd_pp_suppresses(const pd_pp_nms_box_t *pCand, const pd_pp_nms_box_t *pKept,
+                                   float32_t iou_threshold)
+{
+  float32_t intersect_area;
+  float32_t iou = 0;
+
+  if (pCand->area > 0 && pKept->area > 0) {
+    intersect_area = MAX(MIN(pCand->ymax, pKept->ymax) - MAX(pCand->ymin, pKept->ymin), 0.0f) *
+                     MAX(MIN(pCand->xmax, pKept->xmax) - MAX(pCand->xmin, pKept->xmin), 0.0f);
+    /* Disjoint boxes: no divide */
+    if (intersect_area > 0)
+      iou = intersect_area / (pCand->area + pKept->area - intersect_area);
+  }
+  return iou >= iou_threshold;
+}
+
+/* Candidates are already best first: keep each one no kept box overlaps */
 static int pd_pp_nms(pd_postprocess_out_t *pOutput,
                      pd_model_pp_static_param_t *pInput_static_param)
 {
-  int hand_nb = 0;
-  int skip_box;
-  float iou;
-  pd_pp_box_t *pd_boxes = (pd_pp_box_t *)pOutput->pOutData;
-  size_t box_nb =  pOutput->box_nb;
-
-  /* first sort boxes by higher probability */
-  qsort(pd_boxes, box_nb, sizeof(pd_pp_box_t), pd_pp_nms_comparator);
-
-  /* then apply iou to filter them */
-  for (size_t i = 0; i < box_nb; i++) {
-    skip_box = 0;
-    for (int j = 0; j < hand_nb; j++) {
-      iou = pd_pp_compute_iou(&pd_boxes[i], &pd_boxes[j]);
-      if (iou >= pInput_static_param->iou_threshold) {
-        skip_box = 1;
-        break;
-      }
-    }
-    if (skip_box)
+  pd_pp_candidate_t *pCand = pInput_static_param->pTmpBuff;
+  pd_pp_nms_box_t *pNms = pInput_static_param->pTmpNmsBuff;
+  const float32_t iou_threshold = pInput_static_param->iou_threshold;
+  uint32_t hand_nb = 0;
+
+  for (uint32_t i = 0; i < pOutput->box_nb; i++) {
+    uint32_t j = 0;
+
+    while (j < hand_nb && !pd_pp_suppresses(&pNms[i], &pNms[j], iou_threshold))
+      j++;
+    if (j < hand_nb)
       continue;
 
-    pd_boxes[hand_nb++] = pd_boxes[i];
+    pCand[hand_nb] = pCand[i];
+    pNms[hand_nb++] = pNms[i];
   }
 
   /* update the output count to reflect the filtered detections */
@@ -176,8 +323,19 @@ static int pd_pp_nms(pd_postprocess_out_t *pOutput,
 
   return hand_nb;
 }
+
 int32_t pd_model_pp_reset(pd_model_pp_static_param_t *pInput_static_param)
 {
+  /* Cell indices are kept on 16 bits */
+  if (pInput_static_param->grid_width == 0 || pInput_static_param->grid_height == 0 ||
+      pInput_static_param->grid_width * pInput_static_param->grid_height > 65536U ||
+      !(pInput_static_param->stride > 0.0f) ||
+      pInput_static_param->max_boxes_limit == 0 || pInput_static_param->pTmpBuff == NULL ||
+      pInput_static_param->pTmpNmsBuff == NULL ||
+      (pInput_static_param->decode_mode != AI_PD_PP_DECODE_THRESHOLD &&
+       pInput_static_param->decode_mode != AI_PD_PP_DECODE_PEAKS)) {
+    return AI_PD_POSTPROCESS_ERROR;
+  }
   return AI_PD_POSTPROCESS_ERROR_NO;
 }
 
@@ -197,5 +355,11 @@ int32_t pd_model_pp_process(pd_model_pp_in_t *pInput,
   pd_pp_nms(pOutput,
             pInput_static_param);
 
+  /* Boxes and keypoints for the kept candidates only */
+  for (uint32_t k = 0; k < pOutput->box_nb; k++) {
+    pd_pp_output_box(pInput, pInput_static_param, &pOutput->pOutData[k],
+                     &pInput_static_param->pTmpBuff[k], &pInput_static_param->pTmpNmsBuff[k]);
+  }
+
   return ret;
 }
@@ -28,6 +28,7 @@
 #define AI_OD_YOLOV8_PP_MVEF_OPTIM
 #define AI_SPE_MOVENET_PP_MVEF_OPTIM
 #define AI_SSEG_DEEPLAB_PP_MVEF_OPTIM
+#define AI_PD_PP_MVEF_OPTIM
 //#define AI_MPE_YOLOV8_PP_MVEF_OPTIM
 #endif
 #ifdef ARM_MATH_MVEI
@@ -21,6 +21,7 @@
 #include "app_cam.h"
 #include "app_config.h"
 #include "crop_img.h"
+#include "frame_dbuf.h"
 
 #if defined(USE_IMX335_SENSOR)
   #define GAMMA_CONVERSION 0
@@ -32,6 +33,9 @@
 
 extern int32_t cameraFrameReceived;
 
+/* Double buffer fed by the NN pipe frame events, NULL in snapshot mode */
+static frame_dbuf_t *nn_pipe_dbuf;
+
 static void DCMIPP_PipeInitDisplay(CMW_CameraInit_t *camConf, uint32_t *bg_width, uint32_t *bg_height)
 {
   CMW_Aspect_Ratio_Mode_t aspect_ratio;
@@ -164,6 +168,72 @@ void CAM_NNPipe_Start(uint8_t *nn_pipe_dst, uint32_t cam_mode)
   assert(ret == CMW_ERROR_NONE);
 }
 
+/**
+  * @brief  Stop the NN pipe after the current frame
+  * @note   Called by frame_dbuf_acquire with interrupts masked, where
+  *         HAL_DCMIPP_PIPE_Suspend could not wait for CPTACT against
+  *         HAL_GetTick(). Only the capture request is dropped: the frame
+  *         under way completes, and the next one does not start
+  */
+static int CAM_NNPipe_Suspend(void *arg)
+{
+  DCMIPP_HandleTypeDef *hdcmipp = CMW_CAMERA_GetDCMIPPHandle();
+
+  (void)arg;
+  if (hdcmipp->PipeState[DCMIPP_PIPE2] != HAL_DCMIPP_PIPE_STATE_BUSY)
+  {
+    return -1;
+  }
+  CLEAR_BIT(hdcmipp->Instance->P2FCTCR, DCMIPP_P2FCTCR_CPTREQ);
+  /* HAL_DCMIPP_PIPE_Resume (CMW_CAMERA_Resume) restarts it from this state */
+  hdcmipp->PipeState[DCMIPP_PIPE2] = HAL_DCMIPP_PIPE_STATE_SUSPEND;
+  return 0;
+}
+
+static int CAM_NNPipe_Resume(void *arg)
+{
+  (void)arg;
+  return CMW_CAMERA_Resume(DCMIPP_PIPE2);
+}
+
+/**
+  * @brief  Check for an NN pipe frame whose event has not been handled yet
+  * @note   The end of frame flag is cleared by the DCMIPP IRQ handler just
+  *         before it calls CMW_CAMERA_PIPE_FrameEventCallback
+  */
+static int CAM_NNPipe_FramePending(void *arg)
+{
+  DCMIPP_HandleTypeDef *hdcmipp = CMW_CAMERA_GetDCMIPPHandle();
+
+  (void)arg;
+  return __HAL_DCMIPP_GET_FLAG(hdcmipp, DCMIPP_FLAG_PIPE2_FRAME) != 0U;
+}
+
+/**
+  * @brief  Start the NN pipe in continuous double buffer mode
+  * @param  dbuf double buffer state, initialized here
+  * @param  buf0 first capture buffer
+  * @param  buf1 second capture buffer
+  * @retval None
+  */
+void CAM_NNPipe_DoubleBufferStart(frame_dbuf_t *dbuf, uint8_t *buf0, uint8_t *buf1)
+{
+  const frame_dbuf_hooks_t hooks = {
+    .suspend = CAM_NNPipe_Suspend,
+    .resume = CAM_NNPipe_Resume,
+    .frame_pending = CAM_NNPipe_FramePending,
+    .arg = NULL,
+  };
+  int ret;
+
+  ret = frame_dbuf_init(dbuf, buf0, buf1, &hooks);
+  assert(ret == 0);
+  nn_pipe_dbuf = dbuf;
+
+  ret = CMW_CAMERA_DoubleBufferStart(DCMIPP_PIPE2, buf0, buf1, CMW_MODE_CONTINUOUS);
+  assert(ret == CMW_ERROR_NONE);
+}
+
 void CAM_DisplayPipe_Stop()
 {
   int ret;
@@ -188,6 +258,10 @@ int CMW_CAMERA_PIPE_FrameEventCallback(uint32_t pipe)
   switch (pipe)
   {
     case DCMIPP_PIPE2 :
+      if (nn_pipe_dbuf != NULL)
+      {
+        frame_dbuf_on_frame_event(nn_pipe_dbuf);
+      }
       cameraFrameReceived++;
       break;
   }
@@ -1,11 +1,57 @@
 #include "app_postprocess.h"
 #include "app_config.h"
+#include "app_constants.h"
 #include "ll_aton_NN_interface.h"
 #include <assert.h>
 #include <string.h>
 
+LL_ATON_DECLARE_NAMED_NN_PROTOS(face_detection);
+
 static pd_pp_box_t out_detections[AI_PD_MODEL_PP_MAX_BOXES_LIMIT];
 static pd_pp_point_t out_keyPoints[AI_PD_MODEL_PP_MAX_BOXES_LIMIT][AI_PD_MODEL_PP_NB_KEYPOINTS];
+static pd_pp_candidate_t pp_candidates[AI_PD_MODEL_PP_MAX_BOXES_LIMIT];
+static pd_pp_nms_box_t pp_nms_boxes[AI_PD_MODEL_PP_MAX_BOXES_LIMIT];
+
+/**
+ * @brief Take the CenterFace output grid from the face_detection buffers
+ *
+ * Outputs are scale (2 channels), landmarks (2 per keypoint), heatmap (1)
+ * and offset (2), each stored N, H, W, C (mem_shape). All must have the
+ * same grid, and the input size must be a whole number of cells in both
+ * directions with the same stride.
+ */
+static int32_t app_postprocess_grid(pd_model_pp_static_param_t *params)
+{
+  const LL_Buffer_InfoTypeDef *out = LL_ATON_Output_Buffers_Info_face_detection();
+  const uint32_t channels[4] = { 2, 2 * params->nb_keypoints, 1, 2 };
+  uint32_t grid_h, grid_w;
+
+  if (!out || !out[2].name || !out[2].mem_shape || out[2].mem_ndims != 4) {
+    return AI_PD_POSTPROCESS_ERROR;
+  }
+  grid_h = out[2].mem_shape[1];
+  grid_w = out[2].mem_shape[2];
+
+  for (int i = 0; i < 4; i++) {
+    const uint32_t *shape = out[i].mem_shape;
+
+    if (!out[i].name || !shape || out[i].mem_ndims != 4 || out[i].type != DataType_FLOAT ||
+        shape[1] != grid_h || shape[2] != grid_w || shape[3] != channels[i] ||
+        LL_Buffer_len(&out[i]) != grid_h * grid_w * channels[i] * sizeof(float32_t)) {
+      return AI_PD_POSTPROCESS_ERROR;
+    }
+  }
+  if (grid_w == 0 || grid_h == 0 || params->width % grid_w != 0 || params->height % grid_h != 0 ||
+      params->width / grid_w != params->height / grid_h) {
+    return AI_PD_POSTPROCESS_ERROR;
+  }
+
+  params->grid_width = grid_w;
+  params->grid_height = grid_h;
+  params->stride = (float32_t)(params->width / grid_w);
+  params->nb_total_boxes = grid_w * grid_h;
+  return AI_PD_POSTPROCESS_ERROR_NO;
+}
 
 int32_t app_postprocess_init(void *params_postprocess)
 {
@@ -15,9 +61,16 @@ int32_t app_postprocess_init(void *params_postprocess)
   params->nb_keypoints = AI_PD_MODEL_PP_NB_KEYPOINTS;
   params->conf_threshold = AI_PD_MODEL_PP_CONF_THRESHOLD;
   params->iou_threshold = AI_PD_MODEL_PP_IOU_THRESHOLD;
-  params->nb_total_boxes = AI_PD_MODEL_PP_TOTAL_DETECTIONS;
   params->max_boxes_limit = AI_PD_MODEL_PP_MAX_BOXES_LIMIT;
   params->pAnchors = NULL;
+  params->pTmpBuff = pp_candidates;
+  params->pTmpNmsBuff = pp_nms_boxes;
+  params->decode_mode = AI_PD_MODEL_PP_DECODE_MODE;
+  /* Landmarks are only needed to align the faces sent to recognition */
+  params->kps_conf_threshold = FACE_DETECTION_CONFIDENCE_THRESHOLD;
+  if (app_postprocess_grid(params) != AI_PD_POSTPROCESS_ERROR_NO) {
+    return AI_PD_POSTPROCESS_ERROR;
+  }
   for (int i = 0; i < AI_PD_MODEL_PP_MAX_BOXES_LIMIT; i++)
   {
     out_detections[i].pKps = &out_keyPoints[i][0];
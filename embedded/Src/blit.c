@@ -0,0 +1,346 @@
+/**
+ ******************************************************************************
+ * @file    blit.c
+ * @author  PeleAB
+ * @brief   Pixel blitter dispatch and software backend
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "blit.h"
+#include "pixel_lut.h"
+#include <stddef.h>
+#include <string.h>
+
+static const blit_backend_t *blit_active = &blit_backend_sw;
+
+/* ========================================================================= */
+/* PIXEL FORMATS                                                             */
+/* ========================================================================= */
+
+static const uint8_t blit_bpp[BLIT_FMT_COUNT] = { 4, 3, 2, 2, 1 };
+
+uint32_t blit_format_bpp(blit_format_t format)
+{
+    return (format < BLIT_FMT_COUNT) ? blit_bpp[format] : 0U;
+}
+
+/** @brief Read one pixel as ARGB8888 */
+static inline uint32_t blit_read_px(const uint8_t *p, blit_format_t format)
+{
+    uint32_t v, r, g, b, a;
+
+    switch (format) {
+    case BLIT_FMT_ARGB8888:
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    case BLIT_FMT_RGB888:
+        return 0xFF000000U | ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    case BLIT_FMT_RGB565:
+        v = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+        r = (v >> 11) & 0x1FU;
+        g = (v >> 5) & 0x3FU;
+        b = v & 0x1FU;
+        return 0xFF000000U | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+    case BLIT_FMT_ARGB4444:
+        v = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+        a = ((v >> 12) & 0xFU) * 0x11U;
+        r = ((v >> 8) & 0xFU) * 0x11U;
+        g = ((v >> 4) & 0xFU) * 0x11U;
+        b = (v & 0xFU) * 0x11U;
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    case BLIT_FMT_L8:
+    default:
+        return 0xFF000000U | ((uint32_t)p[0] * 0x010101U);
+    }
+}
+
+/** @brief Encode an ARGB8888 color into @p p (blit_bpp[format] bytes) */
+static inline void blit_write_px(uint8_t *p, blit_format_t format, uint32_t argb)
+{
+    uint32_t a = argb >> 24;
+    uint32_t r = (argb >> 16) & 0xFFU;
+    uint32_t g = (argb >> 8) & 0xFFU;
+    uint32_t b = argb & 0xFFU;
+    uint32_t v;
+
+    switch (format) {
+    case BLIT_FMT_ARGB8888:
+        p[0] = (uint8_t)b;
+        p[1] = (uint8_t)g;
+        p[2] = (uint8_t)r;
+        p[3] = (uint8_t)a;
+        break;
+    case BLIT_FMT_RGB888:
+        p[0] = (uint8_t)r;
+        p[1] = (uint8_t)g;
+        p[2] = (uint8_t)b;
+        break;
+    case BLIT_FMT_RGB565:
+        v = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        break;
+    case BLIT_FMT_ARGB4444:
+        v = ((a >> 4) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        break;
+    case BLIT_FMT_L8:
+    default:
+        p[0] = (uint8_t)((r * 30U + g * 59U + b * 11U) / 100U);
+        break;
+    }
+}
+
+static inline uint8_t *blit_row(const blit_surface_t *s, uint32_t y)
+{
+    return (uint8_t *)s->data + y * s->stride;
+}
+
+/* ========================================================================= */
+/* SOFTWARE BACKEND                                                          */
+/* ========================================================================= */
+
+#ifdef ENABLE_PIXEL_LUT
+/** @brief RGB565 to gray row, the weighted channels read from pixel_lut_gray_* */
+static void blit_sw_row_565_to_l8(uint8_t *d, const uint8_t *s, uint32_t dst_w, uint32_t src_w)
+{
+    for (uint32_t x = 0; x < dst_w; x++) {
+        const uint8_t *p = s + (x * src_w / dst_w) * 2U;
+        uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+
+        d[x] = (uint8_t)((pixel_lut_gray_r[v >> 11] + pixel_lut_gray_g[(v >> 5) & 0x3FU] +
+                          pixel_lut_gray_b[v & 0x1FU]) / 100U);
+    }
+}
+#endif
+
+static int blit_sw_scale_copy(const blit_surface_t *dst, const blit_surface_t *src)
+{
+    const uint32_t dbpp = blit_bpp[dst->format];
+    const uint32_t sbpp = blit_bpp[src->format];
+
+    for (uint32_t y = 0; y < dst->height; y++) {
+        const uint8_t *s = blit_row(src, y * src->height / dst->height);
+        uint8_t *d = blit_row(dst, y);
+
+        if (dst->format == src->format && dst->width == src->width) {
+            memcpy(d, s, (size_t)dst->width * dbpp);
+            continue;
+        }
+#ifdef ENABLE_PIXEL_LUT
+        if (src->format == BLIT_FMT_RGB565 && dst->format == BLIT_FMT_L8) {
+            blit_sw_row_565_to_l8(d, s, dst->width, src->width);
+            continue;
+        }
+#endif
+        for (uint32_t x = 0; x < dst->width; x++) {
+            uint32_t sx = x * src->width / dst->width;
+            blit_write_px(d + x * dbpp, dst->format, blit_read_px(s + sx * sbpp, src->format));
+        }
+    }
+    return BLIT_OK;
+}
+
+static int blit_sw_convert(const blit_surface_t *dst, const blit_surface_t *src)
+{
+    return blit_sw_scale_copy(dst, src);
+}
+
+static int blit_sw_fill(const blit_surface_t *dst, uint32_t argb)
+{
+    const uint32_t bpp = blit_bpp[dst->format];
+    uint8_t px[4];
+    int uniform;
+
+    blit_write_px(px, dst->format, argb);
+    uniform = (bpp == 1U) || (px[0] == px[1] && (bpp == 2U || (px[1] == px[2] && (bpp == 3U || px[2] == px[3]))));
+
+    for (uint32_t y = 0; y < dst->height; y++) {
+        uint8_t *d = blit_row(dst, y);
+
+        if (uniform) {
+            memset(d, px[0], (size_t)dst->width * bpp);
+            continue;
+        }
+        for (uint32_t x = 0; x < dst->width; x++) {
+            memcpy(d + x * bpp, px, bpp);
+        }
+    }
+    return BLIT_OK;
+}
+
+static int blit_sw_blend(const blit_surface_t *dst, const blit_surface_t *fg,
+                         const blit_surface_t *bg, uint8_t alpha)
+{
+    const uint32_t dbpp = blit_bpp[dst->format];
+    const uint32_t fbpp = blit_bpp[fg->format];
+    const uint32_t bbpp = blit_bpp[bg->format];
+
+    for (uint32_t y = 0; y < dst->height; y++) {
+        const uint8_t *f = blit_row(fg, y);
+        const uint8_t *b = blit_row(bg, y);
+        uint8_t *d = blit_row(dst, y);
+
+        for (uint32_t x = 0; x < dst->width; x++) {
+            uint32_t cf = blit_read_px(f + x * fbpp, fg->format);
+            uint32_t cb = blit_read_px(b + x * bbpp, bg->format);
+            /* DMA2D blender: fg alpha combined with the layer alpha */
+            uint32_t af = (cf >> 24) * alpha / 255U;
+            uint32_t ab = cb >> 24;
+            uint32_t am = af * ab / 255U;
+            uint32_t ao = af + ab - am;
+            uint32_t out = ao << 24;
+
+            if (ao != 0U) {
+                for (uint32_t sh = 0; sh < 24U; sh += 8U) {
+                    uint32_t c = (((cf >> sh) & 0xFFU) * af + ((cb >> sh) & 0xFFU) * (ab - am)) / ao;
+                    out |= c << sh;
+                }
+            }
+            blit_write_px(d + x * dbpp, dst->format, out);
+        }
+    }
+    return BLIT_OK;
+}
+
+static int blit_sw_wait(void)
+{
+    return BLIT_OK;
+}
+
+const blit_backend_t blit_backend_sw = {
+    .name = "software",
+    .init = NULL,
+    .convert = blit_sw_convert,
+    .scale_copy = blit_sw_scale_copy,
+    .fill = blit_sw_fill,
+    .blend = blit_sw_blend,
+    .wait = blit_sw_wait,
+};
+
+/* ========================================================================= */
+/* DISPATCH                                                                  */
+/* ========================================================================= */
+
+static int blit_check_surface(const blit_surface_t *s)
+{
+    if (!s || !s->data || s->width == 0U || s->height == 0U || s->format >= BLIT_FMT_COUNT ||
+        s->stride < (uint32_t)s->width * blit_bpp[s->format]) {
+        return BLIT_ERR_ARG;
+    }
+    return BLIT_OK;
+}
+
+static int blit_same_size(const blit_surface_t *a, const blit_surface_t *b)
+{
+    return a->width == b->width && a->height == b->height;
+}
+
+/**
+ * @brief Let the software backend do what the active one cannot
+ *
+ * The active backend may still be writing memory the fallback reads, so
+ * it is drained first.
+ */
+static int blit_fallback(int ret)
+{
+    if (ret == BLIT_ERR_UNSUPPORTED) {
+        (void)blit_active->wait();
+    }
+    return ret == BLIT_ERR_UNSUPPORTED;
+}
+
+int blit_init(const blit_backend_t *backend)
+{
+    int ret = BLIT_OK;
+
+    blit_active = &blit_backend_sw;
+    if (backend && backend->init) {
+        ret = backend->init();
+    }
+    if (backend && ret == BLIT_OK) {
+        blit_active = backend;
+    }
+    return ret;
+}
+
+const blit_backend_t *blit_get_backend(void)
+{
+    return blit_active;
+}
+
+int blit_sub_surface(const blit_surface_t *parent, uint16_t x, uint16_t y,
+                     uint16_t width, uint16_t height, blit_surface_t *sub)
+{
+    if (blit_check_surface(parent) != BLIT_OK || !sub ||
+        (uint32_t)x + width > parent->width || (uint32_t)y + height > parent->height) {
+        return BLIT_ERR_ARG;
+    }
+    *sub = *parent;
+    sub->data = blit_row(parent, y) + (uint32_t)x * blit_bpp[parent->format];
+    sub->width = width;
+    sub->height = height;
+    return BLIT_OK;
+}
+
+int blit_convert(const blit_surface_t *dst, const blit_surface_t *src)
+{
+    int ret;
+
+    if (blit_check_surface(dst) != BLIT_OK || blit_check_surface(src) != BLIT_OK ||
+        !blit_same_size(dst, src)) {
+        return BLIT_ERR_ARG;
+    }
+    ret = blit_active->convert(dst, src);
+    return blit_fallback(ret) ? blit_sw_convert(dst, src) : ret;
+}
+
+int blit_scale_copy(const blit_surface_t *dst, const blit_surface_t *src)
+{
+    int ret;
+
+    if (blit_check_surface(dst) != BLIT_OK || blit_check_surface(src) != BLIT_OK) {
+        return BLIT_ERR_ARG;
+    }
+    ret = blit_active->scale_copy(dst, src);
+    return blit_fallback(ret) ? blit_sw_scale_copy(dst, src) : ret;
+}
+
+int blit_fill(const blit_surface_t *dst, uint32_t argb)
+{
+    int ret;
+
+    if (blit_check_surface(dst) != BLIT_OK) {
+        return BLIT_ERR_ARG;
+    }
+    ret = blit_active->fill(dst, argb);
+    return blit_fallback(ret) ? blit_sw_fill(dst, argb) : ret;
+}
+
+int blit_blend(const blit_surface_t *dst, const blit_surface_t *fg,
+               const blit_surface_t *bg, uint8_t alpha)
+{
+    int ret;
+
+    if (blit_check_surface(dst) != BLIT_OK || blit_check_surface(fg) != BLIT_OK ||
+        blit_check_surface(bg) != BLIT_OK || !blit_same_size(dst, fg) || !blit_same_size(dst, bg)) {
+        return BLIT_ERR_ARG;
+    }
+    ret = blit_active->blend(dst, fg, bg, alpha);
+    return blit_fallback(ret) ? blit_sw_blend(dst, fg, bg, alpha) : ret;
+}
+
+int blit_wait(void)
+{
+    return blit_active->wait();
+}
@@ -0,0 +1,238 @@
+/**
+ ******************************************************************************
+ * @file    blit_dma2d.c
+ * @author  PeleAB
+ * @brief   Pixel blitter backend on the DMA2D (Chrom-ART) accelerator
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * Transfers are started and left running; the CPU only waits in blit_wait()
+ * or when the next transfer is started. The peripheral is shared with the
+ * BSP LCD utilities (UTIL_LCD_* drawing), so blit_wait() must be called
+ * before drawing with them.
+ *
+ * DMA2D cannot resize or write L8, and reads L8 as a palette index: those
+ * requests return BLIT_ERR_UNSUPPORTED and are done in software. Offsets
+ * are given in bytes (DMA2D_LOM_BYTES) so RGB888 rows of any stride work.
+ */
+
+#include "blit.h"
+#include "stm32n6xx_hal.h"
+#include <stddef.h>
+
+/* ========================================================================= */
+/* CONFIGURATION                                                             */
+/* ========================================================================= */
+
+#define BLIT_DMA2D_TIMEOUT_MS               100U
+#define BLIT_DMA2D_MAX_WIDTH                0x3FFFU     /**< NLR.PL */
+#define BLIT_DMA2D_MAX_OFFSET               0x3FFFU     /**< Line offset registers */
+
+static DMA2D_HandleTypeDef hblit_dma2d;
+
+/** @brief Transfer in flight: destination range to invalidate once done */
+static struct {
+    uint8_t *dst;
+    uint32_t len;
+    uint8_t busy;
+} blit_dma2d_job;
+
+static const uint32_t blit_dma2d_in_mode[BLIT_FMT_COUNT] = {
+    DMA2D_INPUT_ARGB8888, DMA2D_INPUT_RGB888, DMA2D_INPUT_RGB565, DMA2D_INPUT_ARGB4444, 0U,
+};
+
+static const uint32_t blit_dma2d_out_mode[BLIT_FMT_COUNT] = {
+    DMA2D_OUTPUT_ARGB8888, DMA2D_OUTPUT_RGB888, DMA2D_OUTPUT_RGB565, DMA2D_OUTPUT_ARGB4444, 0U,
+};
+
+/* ========================================================================= */
+/* HELPER FUNCTIONS                                                          */
+/* ========================================================================= */
+
+/** @brief Whether DMA2D can read or write @p s */
+static int blit_dma2d_surface_ok(const blit_surface_t *s)
+{
+    const uint32_t bpp = blit_format_bpp(s->format);
+
+    if (s->format == BLIT_FMT_L8 || s->width > BLIT_DMA2D_MAX_WIDTH ||
+        s->stride - (uint32_t)s->width * bpp > BLIT_DMA2D_MAX_OFFSET) {
+        return 0;
+    }
+    /* 16/32-bit pixels must be naturally aligned */
+    return (bpp == 3U) || ((((uint32_t)(uintptr_t)s->data | s->stride) & (bpp - 1U)) == 0U);
+}
+
+static uint32_t blit_dma2d_span(const blit_surface_t *s)
+{
+    return (s->height - 1U) * s->stride + (uint32_t)s->width * blit_format_bpp(s->format);
+}
+
+static uint32_t blit_dma2d_offset(const blit_surface_t *s)
+{
+    return s->stride - (uint32_t)s->width * blit_format_bpp(s->format);
+}
+
+/* RGB888 is R, G, B in memory; DMA2D natively stores B, G, R */
+static uint32_t blit_dma2d_rb_swap(const blit_surface_t *s)
+{
+    return (s->format == BLIT_FMT_RGB888) ? DMA2D_RB_SWAP : DMA2D_RB_REGULAR;
+}
+
+static int blit_dma2d_wait(void)
+{
+    int ret = BLIT_OK;
+
+    if (!blit_dma2d_job.busy) {
+        return BLIT_OK;
+    }
+    if (HAL_DMA2D_PollForTransfer(&hblit_dma2d, BLIT_DMA2D_TIMEOUT_MS) != HAL_OK) {
+        (void)HAL_DMA2D_Abort(&hblit_dma2d);
+        ret = BLIT_ERR_HW;
+    }
+    /* Drop lines the CPU may have speculatively fetched during the transfer */
+    SCB_InvalidateDCache_by_Addr(blit_dma2d_job.dst, (int32_t)blit_dma2d_job.len);
+    blit_dma2d_job.busy = 0;
+    return ret;
+}
+
+/**
+ * @brief Program the output stage for a transfer into @p dst
+ */
+static int blit_dma2d_setup(uint32_t mode, const blit_surface_t *dst, uint32_t rb_swap)
+{
+    (void)blit_dma2d_wait();
+
+    hblit_dma2d.Instance = DMA2D;
+    hblit_dma2d.Init.Mode = mode;
+    hblit_dma2d.Init.ColorMode = blit_dma2d_out_mode[dst->format];
+    hblit_dma2d.Init.OutputOffset = blit_dma2d_offset(dst);
+    hblit_dma2d.Init.AlphaInverted = DMA2D_REGULAR_ALPHA;
+    hblit_dma2d.Init.RedBlueSwap = rb_swap;
+    hblit_dma2d.Init.BytesSwap = DMA2D_BYTES_REGULAR;
+    hblit_dma2d.Init.LineOffsetMode = DMA2D_LOM_BYTES;
+    if (HAL_DMA2D_Init(&hblit_dma2d) != HAL_OK) {
+        return BLIT_ERR_HW;
+    }
+
+    /* No dirty line may be evicted over what the DMA2D writes */
+    SCB_CleanInvalidateDCache_by_Addr(dst->data, (int32_t)blit_dma2d_span(dst));
+    return BLIT_OK;
+}
+
+/**
+ * @brief Program an input layer to read @p src
+ */
+static int blit_dma2d_layer(uint32_t layer, const blit_surface_t *src,
+                            uint32_t alpha_mode, uint8_t alpha)
+{
+    DMA2D_LayerCfgTypeDef *cfg = &hblit_dma2d.LayerCfg[layer];
+
+    cfg->InputOffset = blit_dma2d_offset(src);
+    cfg->InputColorMode = blit_dma2d_in_mode[src->format];
+    cfg->AlphaMode = alpha_mode;
+    cfg->InputAlpha = alpha;
+    cfg->AlphaInverted = DMA2D_REGULAR_ALPHA;
+    cfg->RedBlueSwap = blit_dma2d_rb_swap(src);
+    cfg->ChromaSubSampling = DMA2D_NO_CSS;
+    if (HAL_DMA2D_ConfigLayer(&hblit_dma2d, layer) != HAL_OK) {
+        return BLIT_ERR_HW;
+    }
+
+    SCB_CleanDCache_by_Addr(src->data, (int32_t)blit_dma2d_span(src));
+    return BLIT_OK;
+}
+
+static int blit_dma2d_started(HAL_StatusTypeDef status, const blit_surface_t *dst)
+{
+    if (status != HAL_OK) {
+        return BLIT_ERR_HW;
+    }
+    blit_dma2d_job.dst = dst->data;
+    blit_dma2d_job.len = blit_dma2d_span(dst);
+    blit_dma2d_job.busy = 1;
+    return BLIT_OK;
+}
+
+/* ========================================================================= */
+/* BACKEND OPERATIONS                                                        */
+/* ========================================================================= */
+
+static int blit_dma2d_init(void)
+{
+    __HAL_RCC_DMA2D_CLK_ENABLE();
+    blit_dma2d_job.busy = 0;
+    return BLIT_OK;
+}
+
+static int blit_dma2d_convert(const blit_surface_t *dst, const blit_surface_t *src)
+{
+    if (!blit_dma2d_surface_ok(dst) || !blit_dma2d_surface_ok(src)) {
+        return BLIT_ERR_UNSUPPORTED;
+    }
+    if (blit_dma2d_setup(DMA2D_M2M_PFC, dst, blit_dma2d_rb_swap(dst)) != BLIT_OK ||
+        blit_dma2d_layer(DMA2D_FOREGROUND_LAYER, src, DMA2D_NO_MODIF_ALPHA, 0xFF) != BLIT_OK) {
+        return BLIT_ERR_HW;
+    }
+    return blit_dma2d_started(HAL_DMA2D_Start(&hblit_dma2d, (uintptr_t)src->data,
+                                              (uintptr_t)dst->data, dst->width, dst->height), dst);
+}
+
+static int blit_dma2d_scale_copy(const blit_surface_t *dst, const blit_surface_t *src)
+{
+    if (dst->width != src->width || dst->height != src->height) {
+        return BLIT_ERR_UNSUPPORTED;
+    }
+    return blit_dma2d_convert(dst, src);
+}
+
+static int blit_dma2d_fill(const blit_surface_t *dst, uint32_t argb)
+{
+    if (!blit_dma2d_surface_ok(dst)) {
+        return BLIT_ERR_UNSUPPORTED;
+    }
+    /* The register color is stored as is: swap for R, G, B memory order */
+    if (dst->format == BLIT_FMT_RGB888) {
+        argb = (argb & 0xFF00FF00U) | ((argb >> 16) & 0xFFU) | ((argb & 0xFFU) << 16);
+    }
+    if (blit_dma2d_setup(DMA2D_R2M, dst, DMA2D_RB_REGULAR) != BLIT_OK) {
+        return BLIT_ERR_HW;
+    }
+    return blit_dma2d_started(HAL_DMA2D_Start(&hblit_dma2d, argb, (uintptr_t)dst->data,
+                                              dst->width, dst->height), dst);
+}
+
+static int blit_dma2d_blend(const blit_surface_t *dst, const blit_surface_t *fg,
+                            const blit_surface_t *bg, uint8_t alpha)
+{
+    if (!blit_dma2d_surface_ok(dst) || !blit_dma2d_surface_ok(fg) || !blit_dma2d_surface_ok(bg)) {
+        return BLIT_ERR_UNSUPPORTED;
+    }
+    if (blit_dma2d_setup(DMA2D_M2M_BLEND, dst, blit_dma2d_rb_swap(dst)) != BLIT_OK ||
+        blit_dma2d_layer(DMA2D_FOREGROUND_LAYER, fg, DMA2D_COMBINE_ALPHA, alpha) != BLIT_OK ||
+        blit_dma2d_layer(DMA2D_BACKGROUND_LAYER, bg, DMA2D_NO_MODIF_ALPHA, 0xFF) != BLIT_OK) {
+        return BLIT_ERR_HW;
+    }
+    return blit_dma2d_started(HAL_DMA2D_BlendingStart(&hblit_dma2d, (uintptr_t)fg->data,
+                                                      (uintptr_t)bg->data,
+                                                      (uintptr_t)dst->data,
+                                                      dst->width, dst->height), dst);
+}
+
+const blit_backend_t blit_backend_dma2d = {
+    .name = "DMA2D",
+    .init = blit_dma2d_init,
+    .convert = blit_dma2d_convert,
+    .scale_copy = blit_dma2d_scale_copy,
+    .fill = blit_dma2d_fill,
+    .blend = blit_dma2d_blend,
+    .wait = blit_dma2d_wait,
+};
@@ -20,14 +20,26 @@
 #include <math.h>
 #include <string.h>
 #include "dummy_dual_buffer.h"
+#include "pixel_lut.h"
+
+/* Helium paths for the RGB888 -> planar float kernels: float vector
+ * arithmetic, so MVE with floating point (ARM_MATH_MVEF). The host kernel
+ * check builds them against a scalar emulation of the intrinsics (arm_math.h
+ * includes it). */
+#if defined(ARM_MATH_MVEF) || defined(HOST_MVE_EMULATION)
+#define CROP_IMG_USE_MVE
+#endif
+
+/* Destination pixels warped per chunk by the fused crop + normalize kernel */
+#define CROP_ALIGN_CHUNK_PIXELS 64
 
 /* ========================================================================= */
 /* IMPLEMENTATION FUNCTIONS                                                 */
 /* ========================================================================= */
 
-void img_rgb_to_chw_float(uint8_t *src_image, float32_t *dst_img,
-                          const uint32_t src_stride, const uint16_t width,
-                          const uint16_t height)
+void img_rgb_to_chw_float_ref(uint8_t *src_image, float32_t *dst_img,
+                              const uint32_t src_stride, const uint16_t width,
+                              const uint16_t height)
 {
   /* CHW layout: channel-first order */
   /* Optimized: use channel pointers to reduce address calculations */
@@ -52,9 +64,9 @@ void img_rgb_to_chw_float(uint8_t *src_image, float32_t *dst_img,
   }
 }
 
-void img_rgb_to_chw_float_norm(uint8_t *src_image, float32_t *dst_img,
-                          const uint32_t src_stride, const uint16_t width,
-                          const uint16_t height)
+void img_rgb_to_chw_float_norm_ref(uint8_t *src_image, float32_t *dst_img,
+                                   const uint32_t src_stride, const uint16_t width,
+                                   const uint16_t height)
 {
   /* CHW layout: channel-first order */
   /* Optimized: precompute constants and unroll inner loop */
@@ -81,7 +93,160 @@ void img_rgb_to_chw_float_norm(uint8_t *src_image, float32_t *dst_img,
   }
 }
 
-void img_crop_resize(uint8_t *src_image, uint8_t *dst_img,
+/**
+ * @brief De-interleave one RGB888 row into three float planes, out = in * scale + bias
+ *
+ * MVE has no VLD3, so each channel is read with a byte gather at offsets
+ * {0, 3, 6, 9}, which also widens to 32 bits for VCVT. Four pixels per
+ * iteration; the tail is predicated, so any width works.
+ *
+ * With scale 1 and bias 0 the FMA is exact and the result equals
+ * img_rgb_to_chw_float_ref. For the normalized variant the reference
+ * expression is contracted to VFMA by GCC (default -ffp-contract=fast), so
+ * the fused form here is bit-exact with it on the target.
+ */
+static void rgb_row_to_planes(const uint8_t *pIn, float32_t *r_channel,
+                              float32_t *g_channel, float32_t *b_channel,
+                              const uint16_t width, const float32_t scale,
+                              const float32_t bias)
+{
+#ifdef CROP_IMG_USE_MVE
+  const uint32x4_t offsets = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+  const float32x4_t scale_f32x4 = vdupq_n_f32(scale);
+  int32_t remaining = width;
+
+  while (remaining > 0)
+  {
+    mve_pred16_t p = vctp32q((uint32_t)remaining);
+    float32x4_t r = vcvtq_f32_u32(vldrbq_gather_offset_z_u32(pIn + 0, offsets, p));
+    float32x4_t g = vcvtq_f32_u32(vldrbq_gather_offset_z_u32(pIn + 1, offsets, p));
+    float32x4_t b = vcvtq_f32_u32(vldrbq_gather_offset_z_u32(pIn + 2, offsets, p));
+
+    vstrwq_p_f32(r_channel, vfmasq_n_f32(r, scale_f32x4, bias), p);
+    vstrwq_p_f32(g_channel, vfmasq_n_f32(g, scale_f32x4, bias), p);
+    vstrwq_p_f32(b_channel, vfmasq_n_f32(b, scale_f32x4, bias), p);
+
+    pIn += 12;
+    r_channel += 4;
+    g_channel += 4;
+    b_channel += 4;
+    remaining -= 4;
+  }
+#else
+  for (uint16_t x = 0; x < width; x++)
+  {
+    r_channel[x] = ((float32_t)pIn[0]) * scale + bias;
+    g_channel[x] = ((float32_t)pIn[1]) * scale + bias;
+    b_channel[x] = ((float32_t)pIn[2]) * scale + bias;
+    pIn += 3;
+  }
+#endif
+}
+
+/**
+ * @brief rgb_row_to_planes normalized through pixel_lut_norm
+ *
+ * On Helium the byte gather feeds a word gather from the table instead of
+ * VCVT + VFMA. The table holds the arithmetic results, so the output is
+ * the same either way.
+ */
+static void rgb_row_to_planes_lut(const uint8_t *pIn, float32_t *r_channel,
+                                  float32_t *g_channel, float32_t *b_channel,
+                                  const uint16_t width)
+{
+  const float32_t *lut = pixel_lut_norm;
+#ifdef CROP_IMG_USE_MVE
+  const uint32x4_t offsets = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+  int32_t remaining = width;
+
+  while (remaining > 0)
+  {
+    mve_pred16_t p = vctp32q((uint32_t)remaining);
+    uint32x4_t r = vldrbq_gather_offset_z_u32(pIn + 0, offsets, p);
+    uint32x4_t g = vldrbq_gather_offset_z_u32(pIn + 1, offsets, p);
+    uint32x4_t b = vldrbq_gather_offset_z_u32(pIn + 2, offsets, p);
+
+    vstrwq_p_f32(r_channel, vldrwq_gather_shifted_offset_z_f32(lut, r, p), p);
+    vstrwq_p_f32(g_channel, vldrwq_gather_shifted_offset_z_f32(lut, g, p), p);
+    vstrwq_p_f32(b_channel, vldrwq_gather_shifted_offset_z_f32(lut, b, p), p);
+
+    pIn += 12;
+    r_channel += 4;
+    g_channel += 4;
+    b_channel += 4;
+    remaining -= 4;
+  }
+#else
+  for (uint16_t x = 0; x < width; x++)
+  {
+    r_channel[x] = lut[pIn[0]];
+    g_channel[x] = lut[pIn[1]];
+    b_channel[x] = lut[pIn[2]];
+    pIn += 3;
+  }
+#endif
+}
+
+void img_rgb_to_chw_float_norm_lut(uint8_t *src_image, float32_t *dst_img,
+                                   const uint32_t src_stride, const uint16_t width,
+                                   const uint16_t height)
+{
+  const uint32_t channel_size = height * width;
+
+  for (uint16_t y = 0; y < height; y++)
+  {
+    const uint32_t row_offset = y * width;
+
+    rgb_row_to_planes_lut(src_image + y * src_stride, dst_img + row_offset,
+                          dst_img + channel_size + row_offset,
+                          dst_img + 2 * channel_size + row_offset, width);
+  }
+}
+
+#ifdef CROP_IMG_USE_MVE
+static void img_rgb_to_chw_float_mve(const uint8_t *src_image, float32_t *dst_img,
+                                     const uint32_t src_stride, const uint16_t width,
+                                     const uint16_t height, const float32_t scale,
+                                     const float32_t bias)
+{
+  const uint32_t channel_size = height * width;
+
+  for (uint16_t y = 0; y < height; y++)
+  {
+    const uint32_t row_offset = y * width;
+
+    rgb_row_to_planes(src_image + y * src_stride, dst_img + row_offset,
+                      dst_img + channel_size + row_offset,
+                      dst_img + 2 * channel_size + row_offset, width, scale, bias);
+  }
+}
+#endif /* CROP_IMG_USE_MVE */
+
+void img_rgb_to_chw_float(uint8_t *src_image, float32_t *dst_img,
+                          const uint32_t src_stride, const uint16_t width,
+                          const uint16_t height)
+{
+#ifdef CROP_IMG_USE_MVE
+  img_rgb_to_chw_float_mve(src_image, dst_img, src_stride, width, height, 1.0f, 0.0f);
+#else
+  img_rgb_to_chw_float_ref(src_image, dst_img, src_stride, width, height);
+#endif
+}
+
+void img_rgb_to_chw_float_norm(uint8_t *src_image, float32_t *dst_img,
+                          const uint32_t src_stride, const uint16_t width,
+                          const uint16_t height)
+{
+#if defined(ENABLE_PIXEL_LUT)
+  img_rgb_to_chw_float_norm_lut(src_image, dst_img, src_stride, width, height);
+#elif defined(CROP_IMG_USE_MVE)
+  img_rgb_to_chw_float_mve(src_image, dst_img, src_stride, width, height, 1.0f / 127.5f, -1.0f);
+#else
+  img_rgb_to_chw_float_norm_ref(src_image, dst_img, src_stride, width, height);
+#endif
+}
+
+void img_crop_resize(uint8_t *src_image, const uint32_t src_stride, uint8_t *dst_img,
                      const uint16_t src_width, const uint16_t src_height,
                      const uint16_t dst_width, const uint16_t dst_height,
                      const uint16_t bpp, int x0, int y0,
@@ -97,7 +262,7 @@ void img_crop_resize(uint8_t *src_image, uint8_t *dst_img,
     if (src_y < 0) src_y = 0;
     if (src_y > src_height_limit) src_y = src_height_limit;
     
-    const uint8_t *src_row = src_image + src_y * src_width * bpp;
+    const uint8_t *src_row = src_image + src_y * src_stride;
     uint8_t *dst_row = dst_img + y * dst_width * bpp;
     
     for (int x = 0; x < dst_width; x++)
@@ -115,56 +280,235 @@ void img_crop_resize(uint8_t *src_image, uint8_t *dst_img,
   }
 }
 
-void img_crop_align(uint8_t *src_image, uint8_t *dst_img,
-                    const uint16_t src_width, const uint16_t src_height,
-                    const uint16_t dst_width, const uint16_t dst_height,
-                    const uint16_t bpp, float x_center, float y_center,
-                    float width, float height, float left_eye_x,
-                    float left_eye_y, float right_eye_x, float right_eye_y)
+/* ========================================================================= */
+/* ALIGNED-CROP WARP ENGINE                                                  */
+/* ========================================================================= */
+/*
+ * Destination pixel (x, y) of the aligned crop maps to the source through an
+ * affine transform (rotation by the eye angle, scale to the box). Along a
+ * destination row the source position moves by a constant step, so it is
+ * computed once per row in float, converted to Q16 and stepped with integer
+ * adds. Because the path is a straight line, checking both ends of a row
+ * tells whether every sample (and its bilinear neighbours) lies inside the
+ * image; only rows that cross an edge pay for clamping.
+ *
+ * Pixel centers are at +0.5: nearest takes floor(src), bilinear interpolates
+ * at src - 0.5 between the four surrounding pixels with 8-bit weights.
+ */
+
+#define WARP_Q                  16
+#define WARP_ONE                (1 << WARP_Q)
+
+/** @brief Per-crop constants of the warp (destination -> source mapping) */
+typedef struct {
+  const uint8_t *src;
+  uint32_t src_stride;                      /* Bytes per source row */
+  img_format_t format;
+  img_sample_t sample;
+  int32_t src_width, src_height;
+  /* Source position (float) of destination pixel (0, 0) and its steps */
+  float origin_x, origin_y;
+  float step_x_row, step_y_row;             /* Per destination row */
+  int32_t q_step_x, q_step_y;               /* Per destination column, Q16 */
+} align_warp_t;
+
+static void align_warp_init(align_warp_t *w, const uint8_t *src, uint32_t src_stride,
+                            img_format_t format, img_sample_t sample,
+                            const uint16_t src_width, const uint16_t src_height,
+                            const uint16_t dst_width, const uint16_t dst_height,
+                            float x_center, float y_center,
+                            float width, float height, float left_eye_x,
+                            float left_eye_y, float right_eye_x, float right_eye_y)
 {
-  /* Optimized: precompute all constants outside loops */
   const float angle = -atan2f(right_eye_y - left_eye_y, right_eye_x - left_eye_x);
   const float cos_a = cosf(angle);
   const float sin_a = sinf(angle);
   const float dst_full = (dst_width > dst_height) ? (float)dst_width : (float)dst_height;
-  const float offset_x = (dst_full - (float)dst_width) * 0.5f;
-  const float offset_y = (dst_full - (float)dst_height) * 0.5f;
   const float inv_dst_full = 1.0f / dst_full;
-  const float width_cos = width * cos_a;
-  const float width_sin = width * sin_a;
-  const float height_cos = height * cos_a;
-  const float height_sin = height * sin_a;
-  const float src_width_limit = (float)(src_width - 1);
-  const float src_height_limit = (float)(src_height - 1);
+  /* Normalized position of destination pixel (0, 0), in [-0.5, 0.5] */
+  const float nx0 = (((dst_full - (float)dst_width) * 0.5f + 0.5f) * inv_dst_full) - 0.5f;
+  const float ny0 = (((dst_full - (float)dst_height) * 0.5f + 0.5f) * inv_dst_full) - 0.5f;
 
-  for (uint16_t y = 0; y < dst_height; y++)
+  w->src = src;
+  w->src_stride = src_stride;
+  w->format = format;
+  w->sample = sample;
+  w->src_width = src_width;
+  w->src_height = src_height;
+
+  w->step_x_row = height * sin_a * inv_dst_full;
+  w->step_y_row = height * cos_a * inv_dst_full;
+  w->origin_x = x_center + nx0 * width * cos_a + ny0 * height * sin_a;
+  w->origin_y = y_center + ny0 * height * cos_a - nx0 * width * sin_a;
+
+  w->q_step_x = (int32_t)lrintf(width * cos_a * inv_dst_full * (float)WARP_ONE);
+  w->q_step_y = (int32_t)lrintf(-width * sin_a * inv_dst_full * (float)WARP_ONE);
+}
+
+/** @brief Read one source pixel as RGB888 (@p format is a constant after inlining) */
+static inline void warp_fetch(const align_warp_t *w, img_format_t format,
+                              int32_t sx, int32_t sy, uint32_t rgb[3])
+{
+  const uint8_t *row = w->src + (uint32_t)sy * w->src_stride;
+
+  if (format == IMG_FORMAT_RGB565)
   {
-    const float ny = (((float)y + offset_y + 0.5f) * inv_dst_full) - 0.5f;
-    const float ny_height_cos = ny * height_cos;
-    const float ny_height_sin = ny * height_sin;
-    uint8_t *dst_row = dst_img + y * dst_width * bpp;
-    
-    for (uint16_t x = 0; x < dst_width; x++)
+    const uint16_t px = ((const uint16_t *)row)[sx];
+#ifdef ENABLE_PIXEL_LUT
+    rgb[0] = pixel_lut_565_r[px >> 11];
+    rgb[1] = pixel_lut_565_g[(px >> 5) & 0x3F];
+    rgb[2] = pixel_lut_565_r[px & 0x1F];
+#else
+    rgb[0] = ((px >> 11) & 0x1F) << 3;
+    rgb[1] = ((px >> 5) & 0x3F) << 2;
+    rgb[2] = (px & 0x1F) << 3;
+#endif
+  }
+  else
+  {
+    const uint8_t *px = row + sx * 3;
+    rgb[0] = px[0];
+    rgb[1] = px[1];
+    rgb[2] = px[2];
+  }
+}
+
+static inline int32_t warp_clamp(int32_t v, int32_t hi)
+{
+  return (v < 0) ? 0 : ((v > hi) ? hi : v);
+}
+
+/**
+ * @brief Inner loop of align_warp_row for one source format and sampling mode
+ *
+ * Called with constant @p format and @p bilinear so that each combination
+ * compiles to its own loop without per-pixel dispatch.
+ */
+static inline void align_warp_span(const align_warp_t *w, img_format_t format, int32_t bilinear,
+                                   int32_t qx, int32_t qy, int32_t inside, uint16_t count,
+                                   uint8_t *pOut)
+{
+  const int32_t x_hi = (w->src_width - 1) * WARP_ONE;
+  const int32_t y_hi = (w->src_height - 1) * WARP_ONE;
+  uint32_t p00[3], p01[3], p10[3], p11[3];
+
+  for (uint16_t n = 0; n < count; n++)
+  {
+    int32_t cx = qx, cy = qy;
+
+    if (!inside)
     {
-      const float nx = (((float)x + offset_x + 0.5f) * inv_dst_full) - 0.5f;
-      float src_x = x_center + (nx * width_cos) + ny_height_sin;
-      float src_y = y_center + ny_height_cos - (nx * width_sin);
-      
-      /* Clamp with precomputed limits */
-      if (src_x < 0.0f) src_x = 0.0f;
-      if (src_x > src_width_limit) src_x = src_width_limit;
-      if (src_y < 0.0f) src_y = 0.0f;
-      if (src_y > src_height_limit) src_y = src_height_limit;
-      
-      const uint8_t *pIn = src_image + ((uint32_t)src_y * src_width + (uint32_t)src_x) * bpp;
-      uint8_t *pOut = dst_row + x * bpp;
-      
-      /* Use memcpy for pixel copy */
-      memcpy(pOut, pIn, bpp);
+      /* Edge rows: clamp to the image as the original float code did */
+      cx = warp_clamp(cx, x_hi);
+      cy = warp_clamp(cy, y_hi);
+    }
+
+    const int32_t ix = cx >> WARP_Q;
+    const int32_t iy = cy >> WARP_Q;
+
+    if (!bilinear)
+    {
+      warp_fetch(w, format, ix, iy, p00);
+      pOut[0] = (uint8_t)p00[0];
+      pOut[1] = (uint8_t)p00[1];
+      pOut[2] = (uint8_t)p00[2];
+    }
+    else
+    {
+      const uint32_t wx = ((uint32_t)cx >> (WARP_Q - 8)) & 0xFF;
+      const uint32_t wy = ((uint32_t)cy >> (WARP_Q - 8)) & 0xFF;
+      const int32_t ix1 = (inside || ix < w->src_width - 1) ? ix + 1 : ix;
+      const int32_t iy1 = (inside || iy < w->src_height - 1) ? iy + 1 : iy;
+
+      warp_fetch(w, format, ix, iy, p00);
+      warp_fetch(w, format, ix1, iy, p01);
+      warp_fetch(w, format, ix, iy1, p10);
+      warp_fetch(w, format, ix1, iy1, p11);
+      for (uint32_t c = 0; c < 3; c++)
+      {
+        const uint32_t top = p00[c] * (256 - wx) + p01[c] * wx;
+        const uint32_t bottom = p10[c] * (256 - wx) + p11[c] * wx;
+        pOut[c] = (uint8_t)((top * (256 - wy) + bottom * wy + 32768) >> 16);
+      }
     }
+
+    pOut += 3;
+    qx += w->q_step_x;
+    qy += w->q_step_y;
+  }
+}
+
+/**
+ * @brief Sample @p count pixels of destination row @p y starting at column @p x0 into RGB888
+ */
+static void align_warp_row(const align_warp_t *w, uint16_t y, uint16_t x0, uint16_t count,
+                           uint8_t *pOut)
+{
+  const int32_t bilinear = (w->sample == IMG_SAMPLE_BILINEAR);
+  const int32_t bias = bilinear ? (WARP_ONE / 2) : 0;
+  const float fx = w->origin_x + (float)y * w->step_x_row;
+  const float fy = w->origin_y + (float)y * w->step_y_row;
+  /* Q16 sample positions, stepped from the row start so that any split of a
+   * row into chunks samples the same pixels; bilinear works on pixel-center
+   * coordinates */
+  const int32_t qx = (int32_t)lrintf(fx * (float)WARP_ONE) - bias + (int32_t)x0 * w->q_step_x;
+  const int32_t qy = (int32_t)lrintf(fy * (float)WARP_ONE) - bias + (int32_t)x0 * w->q_step_y;
+  const int32_t qx_end = qx + (int32_t)(count - 1) * w->q_step_x;
+  const int32_t qy_end = qy + (int32_t)(count - 1) * w->q_step_y;
+  /* Highest position whose sample (and right / lower neighbour) is in the image */
+  const int32_t qx_max = bilinear ? (w->src_width - 1) * WARP_ONE - 1 : w->src_width * WARP_ONE - 1;
+  const int32_t qy_max = bilinear ? (w->src_height - 1) * WARP_ONE - 1 : w->src_height * WARP_ONE - 1;
+  const int32_t inside = qx >= 0 && qx_end >= 0 && qx <= qx_max && qx_end <= qx_max &&
+                         qy >= 0 && qy_end >= 0 && qy <= qy_max && qy_end <= qy_max;
+
+  if (w->format == IMG_FORMAT_RGB565)
+  {
+    if (bilinear)
+      align_warp_span(w, IMG_FORMAT_RGB565, 1, qx, qy, inside, count, pOut);
+    else
+      align_warp_span(w, IMG_FORMAT_RGB565, 0, qx, qy, inside, count, pOut);
+  }
+  else
+  {
+    if (bilinear)
+      align_warp_span(w, IMG_FORMAT_RGB888, 1, qx, qy, inside, count, pOut);
+    else
+      align_warp_span(w, IMG_FORMAT_RGB888, 0, qx, qy, inside, count, pOut);
   }
 }
 
+void img_warp_align(const uint8_t *src_image, uint32_t src_stride, img_format_t src_format,
+                    const uint16_t src_width, const uint16_t src_height,
+                    uint8_t *dst_img, const uint16_t dst_width, const uint16_t dst_height,
+                    img_sample_t sample, float x_center, float y_center,
+                    float width, float height, float left_eye_x,
+                    float left_eye_y, float right_eye_x, float right_eye_y)
+{
+  align_warp_t w;
+
+  align_warp_init(&w, src_image, src_stride, src_format, sample, src_width, src_height,
+                  dst_width, dst_height, x_center, y_center, width, height,
+                  left_eye_x, left_eye_y, right_eye_x, right_eye_y);
+
+  for (uint16_t y = 0; y < dst_height; y++)
+  {
+    align_warp_row(&w, y, 0, dst_width, dst_img + y * dst_width * 3);
+  }
+}
+
+void img_crop_align(uint8_t *src_image, const uint32_t src_stride, uint8_t *dst_img,
+                    const uint16_t src_width, const uint16_t src_height,
+                    const uint16_t dst_width, const uint16_t dst_height,
+                    const uint16_t bpp, float x_center, float y_center,
+                    float width, float height, float left_eye_x,
+                    float left_eye_y, float right_eye_x, float right_eye_y)
+{
+  assert(bpp == 3);
+  img_warp_align(src_image, src_stride, IMG_FORMAT_RGB888, src_width, src_height,
+                 dst_img, dst_width, dst_height, CROP_ALIGN_SAMPLING, x_center, y_center,
+                 width, height, left_eye_x, left_eye_y, right_eye_x, right_eye_y);
+}
+
 void img_crop_align565_to_888(uint8_t *src_image, uint16_t src_stride,
                               uint8_t *dst_img,
                               const uint16_t src_width, const uint16_t src_height,
@@ -173,53 +517,55 @@ void img_crop_align565_to_888(uint8_t *src_image, uint16_t src_stride,
                               float width, float height, float left_eye_x,
                               float left_eye_y, float right_eye_x, float right_eye_y)
 {
-  /* Optimized: precompute all constants and reduce redundant calculations */
-  const float angle = -atan2f(right_eye_y - left_eye_y, right_eye_x - left_eye_x);
-  const float cos_a = cosf(angle);
-  const float sin_a = sinf(angle);
-  const float dst_full = (dst_width > dst_height) ? (float)dst_width : (float)dst_height;
-  const float offset_x = (dst_full - (float)dst_width) * 0.5f;
-  const float offset_y = (dst_full - (float)dst_height) * 0.5f;
-  const float inv_dst_full = 1.0f / dst_full;
-  const float width_cos = width * cos_a;
-  const float width_sin = width * sin_a;
-  const float height_cos = height * cos_a;
-  const float height_sin = height * sin_a;
-  const float src_width_limit = (float)(src_width - 1);
-  const float src_height_limit = (float)(src_height - 1);
-  const uint16_t *src_base = (const uint16_t *)src_image;
+  img_warp_align(src_image, src_stride * 2U, IMG_FORMAT_RGB565, src_width, src_height,
+                 dst_img, dst_width, dst_height, CROP_ALIGN_SAMPLING, x_center, y_center,
+                 width, height, left_eye_x, left_eye_y, right_eye_x, right_eye_y);
+#ifdef DUMMY_INPUT_BUFFER
+  memcpy(dst_img, dummy_cropped_face_rgb, dst_width * dst_height * 3);
+#endif
+}
+
+void img_crop_align565_to_chw_float_norm(uint8_t *src_image, uint16_t src_stride,
+                                         float32_t *dst_img,
+                                         const uint16_t src_width, const uint16_t src_height,
+                                         const uint16_t dst_width, const uint16_t dst_height,
+                                         float x_center, float y_center,
+                                         float width, float height, float left_eye_x,
+                                         float left_eye_y, float right_eye_x, float right_eye_y)
+{
+#ifdef DUMMY_INPUT_BUFFER
+  (void)src_image; (void)src_stride; (void)src_width; (void)src_height;
+  (void)x_center; (void)y_center; (void)width; (void)height;
+  (void)left_eye_x; (void)left_eye_y; (void)right_eye_x; (void)right_eye_y;
+  img_rgb_to_chw_float_norm((uint8_t *)dummy_cropped_face_rgb, dst_img, dst_width * 3,
+                            dst_width, dst_height);
+#else
+  /* Each row is warped into a small RGB888 chunk that stays in cache, then
+   * expanded straight into the planes: no full-size intermediate crop. */
+  uint8_t chunk[CROP_ALIGN_CHUNK_PIXELS * 3];
+  const uint32_t channel_size = dst_height * dst_width;
+  align_warp_t w;
+
+  align_warp_init(&w, src_image, src_stride * 2U, IMG_FORMAT_RGB565, CROP_ALIGN_SAMPLING,
+                  src_width, src_height, dst_width, dst_height, x_center, y_center,
+                  width, height, left_eye_x, left_eye_y, right_eye_x, right_eye_y);
 
   for (uint16_t y = 0; y < dst_height; y++)
   {
-    const float ny = (((float)y + offset_y + 0.5f) * inv_dst_full) - 0.5f;
-    const float ny_height_cos = ny * height_cos;
-    const float ny_height_sin = ny * height_sin;
-    uint8_t *dst_row = dst_img + y * dst_width * 3;
-    
-    for (uint16_t x = 0; x < dst_width; x++)
+    for (uint16_t x0 = 0; x0 < dst_width; x0 += CROP_ALIGN_CHUNK_PIXELS)
     {
-      const float nx = (((float)x + offset_x + 0.5f) * inv_dst_full) - 0.5f;
-      float src_x = x_center + (nx * width_cos) + ny_height_sin;
-      float src_y = y_center + ny_height_cos - (nx * width_sin);
-      
-      /* Clamp with precomputed limits */
-      if (src_x < 0.0f) src_x = 0.0f;
-      if (src_x > src_width_limit) src_x = src_width_limit;
-      if (src_y < 0.0f) src_y = 0.0f;
-      if (src_y > src_height_limit) src_y = src_height_limit;
-      
-      const uint16_t *pIn = src_base + ((uint32_t)src_y * src_stride + (uint32_t)src_x);
-      uint8_t *pOut = dst_row + x * 3;
-      
-      /* Optimized RGB565 to RGB888 conversion with bit operations */
-      const uint16_t px = *pIn;
-      pOut[0] = (uint8_t)(((px >> 11) & 0x1F) << 3);
-      pOut[1] = (uint8_t)(((px >> 5) & 0x3F) << 2);
-      pOut[2] = (uint8_t)((px & 0x1F) << 3);
+      const uint16_t count = (dst_width - x0 < CROP_ALIGN_CHUNK_PIXELS) ?
+                             (uint16_t)(dst_width - x0) : CROP_ALIGN_CHUNK_PIXELS;
+      float32_t *pOut = dst_img + y * dst_width + x0;
+
+      align_warp_row(&w, y, x0, count, chunk);
+#ifdef ENABLE_PIXEL_LUT
+      rgb_row_to_planes_lut(chunk, pOut, pOut + channel_size, pOut + 2 * channel_size, count);
+#else
+      rgb_row_to_planes(chunk, pOut, pOut + channel_size, pOut + 2 * channel_size, count,
+                        1.0f / 127.5f, -1.0f);
+#endif
     }
   }
-#ifdef DUMMY_INPUT_BUFFER
-  memcpy(dst_img, dummy_cropped_face_rgb, dst_width * dst_height * 3);
 #endif
 }
-
@@ -7,6 +7,7 @@
 #include "pd_model_pp_if.h"
 #include "pd_pp_output_if.h"
 #include "app_constants.h"
+#include "blit.h"
 #include <math.h>
 #ifdef ENABLE_LCD_DISPLAY
 #include "stm32n6570_discovery_lcd.h"
@@ -56,16 +57,30 @@ __attribute__ ((section (".psram_bss")))
 __attribute__ ((aligned (32)))
 uint8_t lcd_fg_buffer[2][LCD_FG_WIDTH * LCD_FG_HEIGHT * 2];
 static int lcd_fg_buffer_rd_idx;
+static int lcd_fg_clear_idx = -1;           /* Buffer with a blitter clear in flight */
 static BSP_LCD_LayerConfig_t LayerConfig = {0};
 /* Removed global tracker reference - now passed as parameter */
 
 #define SIMILARITY_COLOR_THRESHOLD 0.7f
 
+/* Finish the clear started by Display_ClearOverlayStart(), or clear now. The
+ * blitter must be idle before UTIL_LCD drawing, which uses the DMA2D too */
+static void ClearOverlay(void)
+{
+  if (lcd_fg_clear_idx != lcd_fg_buffer_rd_idx) {
+    Display_ClearOverlayStart();
+  }
+  if (blit_wait() != BLIT_OK || lcd_fg_clear_idx != lcd_fg_buffer_rd_idx) {
+    UTIL_LCD_FillRect(lcd_fg_area.X0, lcd_fg_area.Y0, lcd_fg_area.XSize,
+                      lcd_fg_area.YSize, 0x00000000);
+  }
+  lcd_fg_clear_idx = -1;
+}
+
 static void DrawPDBoundingBoxes(const pd_pp_box_t *boxes, uint32_t nb,
                                 const void *ctx)
 {
-  UTIL_LCD_FillRect(lcd_fg_area.X0, lcd_fg_area.Y0, lcd_fg_area.XSize,
-                    lcd_fg_area.YSize, 0x00000000);
+  ClearOverlay();
   for (uint32_t i = 0; i < nb; i++) {
     uint32_t x0 = (uint32_t)((boxes[i].x_center - boxes[i].width / 2) *
                               ((float)lcd_bg_area.XSize)) + lcd_bg_area.X0;
@@ -83,7 +98,7 @@ static void DrawPDBoundingBoxes(const pd_pp_box_t *boxes, uint32_t nb,
     UTIL_LCD_DrawRect(x0, y0, width, height, colors[color_idx]);
     
     /* Draw alignment region visualization with rotation (shows actual crop area) */
-    if (boxes[i].prob >= SIMILARITY_COLOR_THRESHOLD) {
+    if (boxes[i].prob >= SIMILARITY_COLOR_THRESHOLD && boxes[i].nb_kps >= 2) {
       /* Get eye positions for rotation calculation */
       float left_eye_x = boxes[i].pKps[0].x * lcd_bg_area.XSize + lcd_bg_area.X0;
       float left_eye_y = boxes[i].pKps[0].y * lcd_bg_area.YSize;
@@ -148,10 +163,11 @@ static void DrawPDBoundingBoxes(const pd_pp_box_t *boxes, uint32_t nb,
   (void)ctx;  /* Context parameter unused in simplified version */
 }
 
-static void DrawPdLandmarks(const pd_pp_box_t *boxes, uint32_t nb, uint32_t nb_kp)
+/* Only the keypoints the decoder produced: low-scoring boxes have none */
+static void DrawPdLandmarks(const pd_pp_box_t *boxes, uint32_t nb)
 {
   for (uint32_t i = 0; i < nb; i++) {
-    for (uint32_t j = 0; j < nb_kp; j++) {
+    for (uint32_t j = 0; j < boxes[i].nb_kps; j++) {
       uint32_t x = (uint32_t)(boxes[i].pKps[j].x * ((float)lcd_bg_area.XSize)) + lcd_bg_area.X0;
       uint32_t y = (uint32_t)(boxes[i].pKps[j].y * ((float)lcd_bg_area.YSize));
       x = x < lcd_bg_area.X0 + lcd_bg_area.XSize ? x : lcd_bg_area.X0 + lcd_bg_area.XSize - 1;
@@ -176,8 +192,10 @@ static void PrintInfo(uint32_t nb_rois, uint32_t total_frame_time_ms, uint32_t b
 {
   UTIL_LCD_SetBackColor(0x40000000);
 //  UTIL_LCDEx_PrintfAt(0, LINE(2), CENTER_MODE, "Objects %u", nb_rois);
-  UTIL_LCDEx_PrintfAt(0, LINE(20), CENTER_MODE, "FPS: %u", 1000/total_frame_time_ms);
-  UTIL_LCDEx_PrintfAt(0, LINE(21), CENTER_MODE, "Embeddings: %d/%d", embeddings_bank_count(), EMBEDDING_BANK_SIZE);
+  UTIL_LCDEx_PrintfAt(0, LINE(20), CENTER_MODE, "FPS: %u",
+                      total_frame_time_ms ? 1000 / total_frame_time_ms : 0);
+  UTIL_LCDEx_PrintfAt(0, LINE(21), CENTER_MODE, "Identity %d: %d/%d", embeddings_bank_identity() + 1,
+                      embeddings_bank_count(), EMBEDDING_BANK_SIZE);
   UTIL_LCDEx_PrintfAt(0, LINE(22), CENTER_MODE, "Boot time: %ums", boottime_ms);
   UTIL_LCD_SetBackColor(0);
   Display_WelcomeScreen();
@@ -188,17 +206,11 @@ void Display_NetworkOutput(pd_postprocess_out_t *p_postprocess, uint32_t total_f
 {
 #ifdef ENABLE_LCD_DISPLAY
   int ret = HAL_LTDC_SetAddress_NoReload(&hlcd_ltdc,
-                                         (uint32_t)lcd_fg_buffer[lcd_fg_buffer_rd_idx],
+                                         (uint32_t)(uintptr_t)lcd_fg_buffer[lcd_fg_buffer_rd_idx],
                                          LTDC_LAYER_2);
   assert(ret == HAL_OK);
   DrawPDBoundingBoxes(p_postprocess->pOutData, p_postprocess->box_nb, ctx);
-  DrawPdLandmarks(p_postprocess->pOutData, p_postprocess->box_nb, AI_PD_MODEL_PP_NB_KEYPOINTS);
-  
-  /* Display cropped face if available - access via external global variables */
-  extern uint8_t fr_rgb[];
-  extern bool g_cropped_face_valid;
-  extern float g_current_similarity;
-  
+  DrawPdLandmarks(p_postprocess->pOutData, p_postprocess->box_nb);
 #endif
 #ifdef ENABLE_PC_STREAM
   StreamOutputPd(p_postprocess);
@@ -217,6 +229,24 @@ void Display_NetworkOutput(pd_postprocess_out_t *p_postprocess, uint32_t total_f
 }
 
 #ifdef ENABLE_LCD_DISPLAY
+/**
+ * @brief Start clearing the overlay buffer of the next Display_NetworkOutput()
+ *
+ * Runs on the blitter while the CPU does post-processing and recognition.
+ */
+void Display_ClearOverlayStart(void)
+{
+  blit_surface_t fg = {
+    .data = lcd_fg_buffer[lcd_fg_buffer_rd_idx],
+    .stride = LCD_FG_WIDTH * 2,
+    .width = LCD_FG_WIDTH,
+    .height = LCD_FG_HEIGHT,
+    .format = BLIT_FMT_ARGB4444,
+  };
+
+  lcd_fg_clear_idx = (blit_fill(&fg, 0x00000000) == BLIT_OK) ? lcd_fg_buffer_rd_idx : -1;
+}
+
 void LCD_init(void)
 {
   BSP_LCD_Init(0, LCD_ORIENTATION_LANDSCAPE);
@@ -226,7 +256,7 @@ void LCD_init(void)
   LayerConfig.X1          = lcd_bg_area.X0 + lcd_bg_area.XSize;
   LayerConfig.Y1          = lcd_bg_area.Y0 + lcd_bg_area.YSize;
   LayerConfig.PixelFormat = LCD_PIXEL_FORMAT_RGB565;
-  LayerConfig.Address     = (uint32_t)img_buffer;
+  LayerConfig.Address     = (uint32_t)(uintptr_t)img_buffer;
 
   BSP_LCD_ConfigLayer(0, LTDC_LAYER_1, &LayerConfig);
 
@@ -235,7 +265,7 @@ void LCD_init(void)
   LayerConfig.X1 = lcd_fg_area.X0 + lcd_fg_area.XSize;
   LayerConfig.Y1 = lcd_fg_area.Y0 + lcd_fg_area.YSize;
   LayerConfig.PixelFormat = LCD_PIXEL_FORMAT_ARGB4444;
-  LayerConfig.Address = (uint32_t)lcd_fg_buffer;
+  LayerConfig.Address = (uint32_t)(uintptr_t)lcd_fg_buffer;
 
   BSP_LCD_ConfigLayer(0, LTDC_LAYER_2, &LayerConfig);
   UTIL_LCD_SetFuncDriver(&LCD_Driver);
@@ -262,6 +292,10 @@ void Display_WelcomeScreen(void)
 
 
 #else
+void Display_ClearOverlayStart(void)
+{
+}
+
 void LCD_init(void)
 {
 }
@@ -11,6 +11,7 @@
 #include "stm32n6xx_hal_uart.h"
 #include "stm32n6xx_hal_crc.h"
 #include "app_config.h"
+#include "blit.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
@@ -174,26 +175,6 @@ static uint16_t get_next_sequence_id(robust_message_type_t msg_type)
     return 0;
 }
 
-
-/**
- * @brief Convert RGB565 to grayscale
- */
-static uint8_t rgb565_to_gray(uint16_t pixel)
-{
-    uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-    uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-    uint8_t b = (pixel & 0x1F) << 3;
-    return (uint8_t)((r * 30 + g * 59 + b * 11) / 100);
-}
-
-/**
- * @brief Convert RGB888 to grayscale
- */
-static uint8_t rgb888_to_gray(uint8_t r, uint8_t g, uint8_t b)
-{
-    return (uint8_t)((r * 30 + g * 59 + b * 11) / 100);
-}
-
 /* ========================================================================= */
 /* CORE PROTOCOL FUNCTIONS                                                   */
 /* ========================================================================= */
@@ -352,21 +333,23 @@ bool Enhanced_PC_STREAM_SendFrame(const uint8_t *frame, uint32_t width, uint32_t
     if (output_width > 320) output_width = 320;   // Max width limit
     if (output_height > 240) output_height = 240; // Max height limit
     
-    // Convert to grayscale and send raw data
-    for (uint32_t y = 0; y < output_height; y++) {
-        const uint8_t *line = frame + (y * scale_factor) * width * bpp;
-        for (uint32_t x = 0; x < output_width; x++) {
-            if (bpp == 2) {
-                const uint16_t *line16 = (const uint16_t *)line;
-                uint16_t px = line16[x * scale_factor];
-                stream_buffer[y * output_width + x] = rgb565_to_gray(px);
-            } else if (bpp == 3) {
-                const uint8_t *px = line + x * scale_factor * 3;
-                stream_buffer[y * output_width + x] = rgb888_to_gray(px[0], px[1], px[2]);
-            } else {
-                stream_buffer[y * output_width + x] = line[x * scale_factor];
-            }
-        }
+    // Convert to grayscale, keeping every scale_factor-th pixel of the covered area
+    blit_surface_t src = {
+        .data = (void *)frame,
+        .stride = width * bpp,
+        .width = (uint16_t)(output_width * scale_factor),
+        .height = (uint16_t)(output_height * scale_factor),
+        .format = (bpp == 2) ? BLIT_FMT_RGB565 : (bpp == 3) ? BLIT_FMT_RGB888 : BLIT_FMT_L8,
+    };
+    blit_surface_t gray = {
+        .data = stream_buffer,
+        .stride = output_width,
+        .width = (uint16_t)output_width,
+        .height = (uint16_t)output_height,
+        .format = BLIT_FMT_L8,
+    };
+    if (blit_scale_copy(&gray, &src) != BLIT_OK || blit_wait() != BLIT_OK) {
+        return false;
     }
     
     // Prepare frame data header
@@ -519,6 +502,18 @@ void Enhanced_PC_STREAM_SendHeartbeat(void)
     g_protocol_ctx.last_heartbeat_time = timestamp;
 }
 
+/**
+ * @brief Send a block of binary trace log records
+ */
+bool Enhanced_PC_STREAM_SendDebugInfo(const uint8_t *records, uint32_t size)
+{
+    if (!records || size == 0) {
+        return false;
+    }
+    
+    return robust_send_message(ROBUST_MSG_DEBUG_INFO, records, size);
+}
+
 /**
  * @brief Get protocol statistics
  */
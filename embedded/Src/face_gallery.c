@@ -0,0 +1,335 @@
+/**
+ ******************************************************************************
+ * @file    face_gallery.c
+ * @author  PeleAB
+ * @brief   Enrolled face templates of several identities and top-K search
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "face_gallery.h"
+#include <math.h>
+#include <stddef.h>
+
+/* Helium paths for the float and int8 dot products. The host gallery check
+ * builds them against a scalar emulation of the intrinsics (arm_math.h
+ * includes it). */
+#if defined(ARM_MATH_MVEF) || defined(HOST_MVE_EMULATION)
+#define FACE_GALLERY_USE_MVE
+#endif
+
+/* ========================================================================= */
+/* IMPLEMENTATION FUNCTIONS                                                  */
+/* ========================================================================= */
+
+/**
+ * @brief Dot products of the query with the four templates of a block
+ *
+ * Even and odd elements go to separate accumulators so that consecutive
+ * multiply-accumulates do not wait on each other; the scalar path sums in
+ * the same order and gives the same scores.
+ */
+static void face_gallery_dot4(const float32_t *pBlock, const float32_t *query, float32_t *pDot)
+{
+#ifdef FACE_GALLERY_USE_MVE
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d += 2) {
+        acc0 = vfmaq_n_f32(acc0, vldrwq_f32(&pBlock[d * FACE_GALLERY_LANES]), query[d]);
+        acc1 = vfmaq_n_f32(acc1, vldrwq_f32(&pBlock[(d + 1) * FACE_GALLERY_LANES]), query[d + 1]);
+    }
+    vstrwq_f32(pDot, vaddq_f32(acc0, acc1));
+#else
+    float32_t acc0[FACE_GALLERY_LANES] = { 0.0f };
+    float32_t acc1[FACE_GALLERY_LANES] = { 0.0f };
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d += 2) {
+        const float32_t *p0 = &pBlock[d * FACE_GALLERY_LANES];
+        const float32_t *p1 = p0 + FACE_GALLERY_LANES;
+
+        for (uint32_t l = 0; l < FACE_GALLERY_LANES; l++) {
+            acc0[l] += p0[l] * query[d];
+            acc1[l] += p1[l] * query[d + 1];
+        }
+    }
+    for (uint32_t l = 0; l < FACE_GALLERY_LANES; l++) {
+        pDot[l] = acc0[l] + acc1[l];
+    }
+#endif
+}
+
+float32_t face_gallery_quantize(const float32_t *pSrc, int8_t *pDst)
+{
+    float32_t max = 0.0f;
+    int32_t norm = 0;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        const float32_t a = fabsf(pSrc[d]);
+
+        if (a > max) {
+            max = a;
+        }
+    }
+    if (max == 0.0f) {
+        return 0.0f;
+    }
+    max = 127.0f / max;
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        pDst[d] = (int8_t)lrintf(pSrc[d] * max);
+        norm += (int32_t)pDst[d] * pDst[d];
+    }
+    return 1.0f / sqrtf((float32_t)norm);
+}
+
+/* Exact in 32 bits: 128 products of at most 127 * 127 */
+int32_t face_gallery_dot_q7(const int8_t *pRow, const int8_t *query)
+{
+#ifdef FACE_GALLERY_USE_MVE
+    int32_t acc = 0;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d += 16) {
+        acc = vmladavaq_s8(acc, vldrbq_s8(&pRow[d]), vldrbq_s8(&query[d]));
+    }
+    return acc;
+#else
+    int32_t acc = 0;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        acc += (int32_t)pRow[d] * query[d];
+    }
+    return acc;
+#endif
+}
+
+void face_gallery_offer(face_gallery_match_t *pMatch, uint32_t *pNb, uint32_t k,
+                        uint16_t identity, float32_t score)
+{
+    uint32_t nb = *pNb;
+    uint32_t pos;
+
+    for (pos = 0; pos < nb; pos++) {
+        if (pMatch[pos].identity == identity) {
+            break;
+        }
+    }
+    if (pos < nb) {
+        if (score <= pMatch[pos].score) {
+            return;
+        }
+        nb--; /* Moves up: remove it and insert again */
+    } else if (nb < k) {
+        pos = nb;
+    } else if (score > pMatch[k - 1].score) {
+        pos = k - 1;
+        nb--;
+    } else {
+        return;
+    }
+    /* pos is a free slot; shift the lower scores down into it */
+    while (pos > 0 && pMatch[pos - 1].score < score) {
+        pMatch[pos] = pMatch[pos - 1];
+        pos--;
+    }
+    pMatch[pos].identity = identity;
+    pMatch[pos].score = score;
+    *pNb = nb + 1;
+}
+
+int face_gallery_init(face_gallery_t *pGallery, float32_t *pTemplates,
+                      uint16_t *pIdentity, uint32_t capacity)
+{
+    if (!pGallery || !pTemplates || !pIdentity || capacity == 0) {
+        return -1;
+    }
+    pGallery->pTemplates = pTemplates;
+    pGallery->pTemplatesQ7 = NULL;
+    pGallery->pScale = NULL;
+    pGallery->pIdentity = pIdentity;
+    pGallery->capacity = capacity;
+    pGallery->count = 0;
+    return 0;
+}
+
+int face_gallery_init_q7(face_gallery_t *pGallery, int8_t *pTemplates, float32_t *pScale,
+                         uint16_t *pIdentity, uint32_t capacity)
+{
+    if (!pGallery || !pTemplates || !pScale || !pIdentity || capacity == 0) {
+        return -1;
+    }
+    pGallery->pTemplates = NULL;
+    pGallery->pTemplatesQ7 = pTemplates;
+    pGallery->pScale = pScale;
+    pGallery->pIdentity = pIdentity;
+    pGallery->capacity = capacity;
+    pGallery->count = 0;
+    return 0;
+}
+
+void face_gallery_reset(face_gallery_t *pGallery)
+{
+    pGallery->count = 0;
+}
+
+int face_gallery_add(face_gallery_t *pGallery, uint16_t identity, const float32_t *embedding)
+{
+    const uint32_t t = pGallery->count;
+    float32_t *pDst;
+    float32_t norm = 0.0f;
+
+    if (t >= pGallery->capacity) {
+        return -1;
+    }
+    if (pGallery->pTemplatesQ7) {
+        const float32_t scale = face_gallery_quantize(embedding,
+                                                      &pGallery->pTemplatesQ7[t * EMBEDDING_SIZE]);
+
+        if (scale == 0.0f) {
+            return -2;
+        }
+        pGallery->pScale[t] = scale;
+        pGallery->pIdentity[t] = identity;
+        pGallery->count = t + 1;
+        return (int)pGallery->count;
+    }
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        norm += embedding[d] * embedding[d];
+    }
+    norm = sqrtf(norm);
+    if (norm == 0.0f) {
+        return -2;
+    }
+
+    pDst = &pGallery->pTemplates[(t / FACE_GALLERY_LANES) * FACE_GALLERY_LANES * EMBEDDING_SIZE +
+                                 t % FACE_GALLERY_LANES];
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        pDst[d * FACE_GALLERY_LANES] = embedding[d] / norm;
+    }
+    pGallery->pIdentity[t] = identity;
+    pGallery->count = t + 1;
+    return (int)pGallery->count;
+}
+
+uint32_t face_gallery_identity_count(const face_gallery_t *pGallery, uint16_t identity)
+{
+    uint32_t nb = 0;
+
+    for (uint32_t t = 0; t < pGallery->count; t++) {
+        nb += (pGallery->pIdentity[t] == identity);
+    }
+    return nb;
+}
+
+/**
+ * @brief face_gallery_search() on int8 templates: the query is quantized
+ *        once, then each template costs one int8 dot product
+ */
+static uint32_t face_gallery_search_q7(const face_gallery_t *pGallery, const float32_t *query,
+                                       face_gallery_match_t *pMatch, uint32_t k)
+{
+    int8_t query_q7[EMBEDDING_SIZE];
+    const float32_t query_scale = face_gallery_quantize(query, query_q7);
+    uint32_t nb = 0;
+
+    if (query_scale == 0.0f) {
+        return 0;
+    }
+    for (uint32_t t = 0; t < pGallery->count; t++) {
+        const int32_t dot = face_gallery_dot_q7(&pGallery->pTemplatesQ7[t * EMBEDDING_SIZE], query_q7);
+        const float32_t score = (float32_t)dot * query_scale * pGallery->pScale[t];
+
+        if (nb == k && score <= pMatch[k - 1].score) {
+            continue;
+        }
+        face_gallery_offer(pMatch, &nb, k, pGallery->pIdentity[t], score);
+    }
+    return nb;
+}
+
+/**
+ * @brief face_gallery_search() on float templates, dot products scaled by
+ *        @p scale (1 / |query|, or 1 for a unit query)
+ */
+static uint32_t face_gallery_search_f32(const face_gallery_t *pGallery, const float32_t *query,
+                                        float32_t scale, face_gallery_match_t *pMatch, uint32_t k)
+{
+    const float32_t *pBlock = pGallery->pTemplates;
+    float32_t dot[FACE_GALLERY_LANES];
+    uint32_t nb = 0;
+
+    for (uint32_t t = 0; t < pGallery->count; t += FACE_GALLERY_LANES) {
+        const uint32_t lanes = (pGallery->count - t < FACE_GALLERY_LANES) ?
+                               pGallery->count - t : FACE_GALLERY_LANES;
+
+        face_gallery_dot4(pBlock, query, dot);
+        pBlock += FACE_GALLERY_LANES * EMBEDDING_SIZE;
+
+        for (uint32_t l = 0; l < lanes; l++) {
+            const float32_t score = dot[l] * scale;
+
+            if (nb == k && score <= pMatch[k - 1].score) {
+                continue;
+            }
+            face_gallery_offer(pMatch, &nb, k, pGallery->pIdentity[t + l], score);
+        }
+    }
+    return nb;
+}
+
+float32_t face_gallery_normalize(const float32_t *pSrc, float32_t *pDst)
+{
+    float32_t norm = 0.0f;
+
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        norm += pSrc[d] * pSrc[d];
+    }
+    norm = sqrtf(norm);
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        pDst[d] = (norm != 0.0f) ? pSrc[d] / norm : 0.0f;
+    }
+    return norm;
+}
+
+uint32_t face_gallery_search(const face_gallery_t *pGallery, const float32_t *query,
+                             face_gallery_match_t *pMatch, uint32_t k)
+{
+    float32_t norm = 0.0f;
+
+    if (k == 0) {
+        return 0;
+    }
+    if (pGallery->pTemplatesQ7) {
+        return face_gallery_search_q7(pGallery, query, pMatch, k);
+    }
+    for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+        norm += query[d] * query[d];
+    }
+    if (norm == 0.0f) {
+        return 0;
+    }
+    /* Templates are unit-norm: scale the dot products by 1 / |query| */
+    return face_gallery_search_f32(pGallery, query, 1.0f / sqrtf(norm), pMatch, k);
+}
+
+uint32_t face_gallery_search_unit(const face_gallery_t *pGallery, const float32_t *query,
+                                  face_gallery_match_t *pMatch, uint32_t k)
+{
+    if (k == 0) {
+        return 0;
+    }
+    /* int8: after rounding the quantized query is no longer unit-norm, its
+     * 1 / |query| scale is applied with the template one */
+    if (pGallery->pTemplatesQ7) {
+        return face_gallery_search_q7(pGallery, query, pMatch, k);
+    }
+    return face_gallery_search_f32(pGallery, query, 1.0f, pMatch, k);
+}
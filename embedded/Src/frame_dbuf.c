@@ -0,0 +1,151 @@
+/**
+ ******************************************************************************
+ * @file    frame_dbuf.c
+ * @author  PeleAB
+ * @brief   Double-buffered frame handoff between DCMIPP and the NN pipeline
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "frame_dbuf.h"
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================= */
+/* CRITICAL SECTION                                                          */
+/* ========================================================================= */
+/* The main loop side must not race with the frame ISR. On target this masks */
+/* interrupts; host builds have no ISR and may provide their own macros.     */
+
+#ifndef FRAME_DBUF_CRITICAL_ENTER
+#if defined(__ARM_ARCH)
+#include "stm32n6xx.h"
+#define FRAME_DBUF_CRITICAL_ENTER()  uint32_t primask_ = __get_PRIMASK(); __disable_irq()
+#define FRAME_DBUF_CRITICAL_EXIT()   __set_PRIMASK(primask_)
+#else
+#define FRAME_DBUF_CRITICAL_ENTER()  do { } while (0)
+#define FRAME_DBUF_CRITICAL_EXIT()   do { } while (0)
+#endif
+#endif
+
+/* ========================================================================= */
+/* IMPLEMENTATION FUNCTIONS                                                  */
+/* ========================================================================= */
+
+int frame_dbuf_init(frame_dbuf_t *db, uint8_t *buf0, uint8_t *buf1,
+                    const frame_dbuf_hooks_t *hooks)
+{
+    if (!db || !buf0 || !buf1 || buf0 == buf1) {
+        return -1;
+    }
+
+    memset(db, 0, sizeof(*db));
+    db->buffers[0] = buf0;
+    db->buffers[1] = buf1;
+    db->hw_index = 0;
+    db->ready_index = FRAME_DBUF_NONE;
+    db->held_index = FRAME_DBUF_NONE;
+    if (hooks) {
+        db->hooks = *hooks;
+    }
+
+    return 0;
+}
+
+void frame_dbuf_on_frame_event(frame_dbuf_t *db)
+{
+    int8_t completed = db->hw_index;
+
+    db->stats.frames_captured++;
+    db->sequence++;
+
+    /* DCMIPP alternates buffers on every frame */
+    db->hw_index = (int8_t)(completed ^ 1);
+
+    /* Latest frame wins: an unconsumed ready frame is superseded */
+    if (db->ready_index != FRAME_DBUF_NONE) {
+        db->stats.frames_dropped++;
+    }
+    db->ready_index = completed;
+    db->ready_sequence = db->sequence;
+
+    /* The capture request was dropped when the buffer the hardware now
+     * points at was acquired: the pipe stops here until it is released */
+    if (db->suspended) {
+        db->stats.stalls++;
+    }
+}
+
+uint8_t *frame_dbuf_acquire(frame_dbuf_t *db, uint32_t *sequence)
+{
+    uint8_t *frame = NULL;
+
+    FRAME_DBUF_CRITICAL_ENTER();
+    if (db->held_index == FRAME_DBUF_NONE && db->ready_index != FRAME_DBUF_NONE) {
+        /* The hardware writes the other buffer and this one next: drop the
+         * capture request before checking that the current frame is still
+         * under way, so no capture can start into the frame handed out */
+        if (db->hooks.suspend) {
+            db->hooks.suspend(db->hooks.arg);
+        }
+        if (db->hooks.frame_pending && db->hooks.frame_pending(db->hooks.arg)) {
+            /* It has ended: the next frame may be going into the ready
+             * buffer, which its event supersedes */
+            if (db->hooks.resume) {
+                db->hooks.resume(db->hooks.arg);
+            }
+        } else {
+            db->held_index = db->ready_index;
+            db->ready_index = FRAME_DBUF_NONE;
+            db->suspended = 1;
+            db->stats.frames_consumed++;
+            frame = db->buffers[db->held_index];
+            if (sequence) {
+                *sequence = db->ready_sequence;
+            }
+        }
+    }
+    FRAME_DBUF_CRITICAL_EXIT();
+
+    return frame;
+}
+
+int frame_dbuf_release(frame_dbuf_t *db)
+{
+    int ret = 0;
+
+    FRAME_DBUF_CRITICAL_ENTER();
+    if (db->held_index == FRAME_DBUF_NONE) {
+        ret = -1;
+    } else {
+        db->held_index = FRAME_DBUF_NONE;
+        if (db->suspended) {
+            db->suspended = 0;
+            if (db->hooks.resume) {
+                db->hooks.resume(db->hooks.arg);
+            }
+        }
+    }
+    FRAME_DBUF_CRITICAL_EXIT();
+
+    return ret;
+}
+
+void frame_dbuf_get_stats(const frame_dbuf_t *db, frame_dbuf_stats_t *stats)
+{
+    FRAME_DBUF_CRITICAL_ENTER();
+    stats->frames_captured = db->stats.frames_captured;
+    stats->frames_consumed = db->stats.frames_consumed;
+    stats->frames_dropped = db->stats.frames_dropped;
+    stats->stalls = db->stats.stalls;
+    FRAME_DBUF_CRITICAL_EXIT();
+}
@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ * @file    gallery_flash_xspi.c
+ * @author  PeleAB
+ * @brief   Gallery store backend on the XSPI NOR flash
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * The NOR flash stays in memory-mapped mode (App_SystemInit), so the store
+ * reads its records in place at GALLERY_STORE_ADDRESS. An erase or program
+ * leaves that mode for the command and enters it again; nothing may read the
+ * flash meanwhile, the NPU included (main.c writes between inferences). The
+ * code runs from internal RAM. The data cache lines of the written range are
+ * invalidated so that the next reads see the flash.
+ */
+
+#include "gallery_store.h"
+#include "app_config.h"
+#include "stm32n6570_discovery_xspi.h"
+
+/* ========================================================================= */
+/* CONSTANTS                                                                 */
+/* ========================================================================= */
+
+#define XSPI_NOR_MAPPED_BASE                0x70000000UL    /**< XSPI2 memory-mapped window */
+#define GALLERY_FLASH_OFFSET                (GALLERY_STORE_ADDRESS - XSPI_NOR_MAPPED_BASE)
+#define CACHE_LINE                          32U
+
+/* ========================================================================= */
+/* IMPLEMENTATION FUNCTIONS                                                  */
+/* ========================================================================= */
+
+static void xspi_invalidate(uint32_t offset, uint32_t size)
+{
+    const uint32_t start = (GALLERY_STORE_ADDRESS + offset) & ~(CACHE_LINE - 1U);
+    const uint32_t end = GALLERY_STORE_ADDRESS + offset + size;
+
+    SCB_InvalidateDCache_by_Addr((volatile void *)start, (int32_t)(end - start));
+}
+
+static const uint8_t *xspi_map(uint32_t size)
+{
+    if (GALLERY_FLASH_OFFSET + size > MX66UW1G45G_FLASH_SIZE) {
+        return NULL;
+    }
+    return (const uint8_t *)GALLERY_STORE_ADDRESS;
+}
+
+static int xspi_erase(uint32_t offset)
+{
+    int32_t ret;
+
+    if (BSP_XSPI_NOR_DisableMemoryMappedMode(0) != BSP_ERROR_NONE) {
+        return -1;
+    }
+    ret = BSP_XSPI_NOR_Erase_Block(0, GALLERY_FLASH_OFFSET + offset, BSP_XSPI_NOR_ERASE_64K);
+    /* The erase runs in the flash; its status turns ready when it is done */
+    while (ret == BSP_ERROR_NONE && (ret = BSP_XSPI_NOR_GetStatus(0)) == BSP_ERROR_BUSY) {
+    }
+    if (BSP_XSPI_NOR_EnableMemoryMappedMode(0) != BSP_ERROR_NONE) {
+        ret = BSP_ERROR_COMPONENT_FAILURE;
+    }
+    xspi_invalidate(offset, GALLERY_STORE_SECTOR_SIZE);
+    return (ret == BSP_ERROR_NONE) ? 0 : -1;
+}
+
+static int xspi_program(uint32_t offset, const void *pData, uint32_t size)
+{
+    int32_t ret;
+
+    if (BSP_XSPI_NOR_DisableMemoryMappedMode(0) != BSP_ERROR_NONE) {
+        return -1;
+    }
+    /* Split in pages, each waited for */
+    ret = BSP_XSPI_NOR_Write(0, (const uint8_t *)pData, GALLERY_FLASH_OFFSET + offset, size);
+    if (BSP_XSPI_NOR_EnableMemoryMappedMode(0) != BSP_ERROR_NONE) {
+        ret = BSP_ERROR_COMPONENT_FAILURE;
+    }
+    xspi_invalidate(offset, size);
+    return (ret == BSP_ERROR_NONE) ? 0 : -1;
+}
+
+const gallery_flash_t gallery_flash_xspi = {
+    .name = "xspi",
+    .map = xspi_map,
+    .erase = xspi_erase,
+    .program = xspi_program,
+};
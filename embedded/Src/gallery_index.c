@@ -0,0 +1,305 @@
+/**
+ ******************************************************************************
+ * @file    gallery_index.c
+ * @author  PeleAB
+ * @brief   Approximate face gallery search for large galleries: inverted
+ *          lists over coarse centroids, product-quantized templates and an
+ *          exact int8 re-rank of the shortlist
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "gallery_index.h"
+#include <stddef.h>
+#include "app_constants.h"
+
+/* ========================================================================= */
+/* IMAGE                                                                     */
+/* ========================================================================= */
+
+/** Bytes per template over all sections, to bound the counts before sizes */
+#define TEMPLATE_BYTES                      (GALLERY_INDEX_SUBSPACES + sizeof(uint16_t) + \
+                                             sizeof(float32_t) + EMBEDDING_SIZE)
+
+static uint32_t crc_table[256];             /**< Filled by the first open */
+
+static void gallery_index_crc_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ PROTOCOL_CRC32_POLYNOMIAL : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+}
+
+/* Same CRC-32 as config_manager_calculate_crc, a table lookup per byte */
+static uint32_t gallery_index_crc(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ crc_table[(crc ^ data[i]) & 0xFFU];
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+/**
+ * @brief Section of @p bytes at @p offset lies after the header, within the
+ *        image, 4-byte aligned
+ */
+static int section_ok(const gallery_index_header_t *pHeader, uint32_t offset, uint32_t bytes)
+{
+    return (offset % 4U) == 0 && offset >= sizeof(gallery_index_header_t) &&
+           offset <= pHeader->size && bytes <= pHeader->size - offset;
+}
+
+int gallery_index_open(gallery_index_t *pIndex, const void *pImage, uint32_t size)
+{
+    const gallery_index_header_t *h = pImage;
+    const uint8_t *base = pImage;
+    uint32_t lists, templates;
+
+    if (!pIndex) {
+        return GALLERY_INDEX_ERR_ARG;
+    }
+    pIndex->pHeader = NULL;
+    if (!pImage || ((uintptr_t)pImage % 4U) != 0 || size < sizeof(gallery_index_header_t)) {
+        return GALLERY_INDEX_ERR_ARG;
+    }
+    if (h->magic != GALLERY_INDEX_MAGIC || h->version != GALLERY_INDEX_VERSION ||
+        h->size < sizeof(gallery_index_header_t) || h->size > size) {
+        return GALLERY_INDEX_ERR_IMAGE;
+    }
+    lists = h->lists;
+    templates = h->templates;
+    if (lists == 0 || lists > GALLERY_INDEX_MAX_LISTS || templates == 0 ||
+        templates > h->size / TEMPLATE_BYTES) {
+        return GALLERY_INDEX_ERR_IMAGE;
+    }
+    if (!section_ok(h, h->centroids, lists * EMBEDDING_SIZE * sizeof(float32_t)) ||
+        !section_ok(h, h->codebooks, GALLERY_INDEX_SUBSPACES * GALLERY_INDEX_CODES *
+                                     GALLERY_INDEX_SUBDIM * sizeof(float32_t)) ||
+        !section_ok(h, h->list_start, (lists + 1U) * sizeof(uint32_t)) ||
+        !section_ok(h, h->codes, templates * GALLERY_INDEX_SUBSPACES) ||
+        !section_ok(h, h->identity, templates * sizeof(uint16_t)) ||
+        !section_ok(h, h->scale, templates * sizeof(float32_t)) ||
+        !section_ok(h, h->rows, templates * EMBEDDING_SIZE)) {
+        return GALLERY_INDEX_ERR_IMAGE;
+    }
+    if (crc_table[1] == 0) {
+        gallery_index_crc_init();
+    }
+    if (gallery_index_crc(base + sizeof(gallery_index_header_t),
+                          h->size - sizeof(gallery_index_header_t)) != h->crc) {
+        return GALLERY_INDEX_ERR_IMAGE;
+    }
+
+    /* Lists follow each other and cover every template */
+    pIndex->pListStart = (const uint32_t *)(base + h->list_start);
+    if (pIndex->pListStart[0] != 0 || pIndex->pListStart[lists] != templates) {
+        return GALLERY_INDEX_ERR_IMAGE;
+    }
+    for (uint32_t l = 0; l < lists; l++) {
+        if (pIndex->pListStart[l + 1] < pIndex->pListStart[l]) {
+            return GALLERY_INDEX_ERR_IMAGE;
+        }
+    }
+
+    pIndex->pCentroids = (const float32_t *)(base + h->centroids);
+    pIndex->pCodebooks = (const float32_t *)(base + h->codebooks);
+    pIndex->pCodes = base + h->codes;
+    pIndex->pIdentity = (const uint16_t *)(base + h->identity);
+    pIndex->pScale = (const float32_t *)(base + h->scale);
+    pIndex->pRows = (const int8_t *)(base + h->rows);
+    pIndex->lists = lists;
+    pIndex->templates = templates;
+    /* The caller keeps these apart from the identities it enrolls itself */
+    pIndex->identity_min = UINT16_MAX;
+    pIndex->identity_max = 0;
+    for (uint32_t t = 0; t < templates; t++) {
+        if (pIndex->pIdentity[t] < pIndex->identity_min) {
+            pIndex->identity_min = pIndex->pIdentity[t];
+        }
+        if (pIndex->pIdentity[t] > pIndex->identity_max) {
+            pIndex->identity_max = pIndex->pIdentity[t];
+        }
+    }
+    pIndex->pHeader = h;
+    return GALLERY_INDEX_OK;
+}
+
+/* ========================================================================= */
+/* SEARCH                                                                    */
+/* ========================================================================= */
+
+/**
+ * @brief Keep @p template if its approximate dot product is among the best
+ *        GALLERY_INDEX_SHORTLIST so far
+ */
+static void shortlist_offer(gallery_index_search_t *pSearch, uint32_t template, float32_t dot)
+{
+    uint32_t pos;
+
+    if (pSearch->shortlisted < GALLERY_INDEX_SHORTLIST) {
+        pos = pSearch->shortlisted++;
+    } else if (dot > pSearch->shortlist_dot[GALLERY_INDEX_SHORTLIST - 1]) {
+        pos = GALLERY_INDEX_SHORTLIST - 1;
+    } else {
+        return;
+    }
+    while (pos > 0 && pSearch->shortlist_dot[pos - 1] < dot) {
+        pSearch->shortlist[pos] = pSearch->shortlist[pos - 1];
+        pSearch->shortlist_dot[pos] = pSearch->shortlist_dot[pos - 1];
+        pos--;
+    }
+    pSearch->shortlist[pos] = template;
+    pSearch->shortlist_dot[pos] = dot;
+}
+
+int gallery_index_search_begin(const gallery_index_t *pIndex, gallery_index_search_t *pSearch,
+                               const float32_t *query, uint32_t probes)
+{
+    if (!pIndex || !pIndex->pHeader || !pSearch || !query) {
+        return GALLERY_INDEX_ERR_ARG;
+    }
+    pSearch->probes = 0;
+    pSearch->next_probe = 0;
+    pSearch->next_template = 0;
+    pSearch->shortlisted = 0;
+    pSearch->scanned = 0;
+    pSearch->query_scale = face_gallery_quantize(query, pSearch->query_q7);
+    if (pSearch->query_scale == 0.0f) {
+        return GALLERY_INDEX_ERR_ARG;
+    }
+
+    /* Dot product of each query sub-vector with each sub-centroid */
+    for (uint32_t m = 0; m < GALLERY_INDEX_SUBSPACES; m++) {
+        const float32_t *q = &query[m * GALLERY_INDEX_SUBDIM];
+        const float32_t *pCode = &pIndex->pCodebooks[m * GALLERY_INDEX_CODES * GALLERY_INDEX_SUBDIM];
+
+        for (uint32_t c = 0; c < GALLERY_INDEX_CODES; c++, pCode += GALLERY_INDEX_SUBDIM) {
+            float32_t dot = 0.0f;
+
+            for (uint32_t d = 0; d < GALLERY_INDEX_SUBDIM; d++) {
+                dot += q[d] * pCode[d];
+            }
+            pSearch->table[m][c] = dot;
+        }
+    }
+
+    /* Best centroids, kept sorted; on equal dot products the first list stays ahead */
+    if (probes > GALLERY_INDEX_MAX_PROBES) {
+        probes = GALLERY_INDEX_MAX_PROBES;
+    }
+    if (probes > pIndex->lists) {
+        probes = pIndex->lists;
+    }
+    if (probes == 0) {
+        probes = 1;
+    }
+    for (uint32_t l = 0; l < pIndex->lists; l++) {
+        const float32_t *c = &pIndex->pCentroids[l * EMBEDDING_SIZE];
+        float32_t dot = 0.0f;
+        uint32_t pos;
+
+        for (uint32_t d = 0; d < EMBEDDING_SIZE; d++) {
+            dot += query[d] * c[d];
+        }
+        if (pSearch->probes < probes) {
+            pos = pSearch->probes++;
+        } else if (dot > pSearch->probe_dot[probes - 1]) {
+            pos = probes - 1;
+        } else {
+            continue;
+        }
+        while (pos > 0 && pSearch->probe_dot[pos - 1] < dot) {
+            pSearch->probe[pos] = pSearch->probe[pos - 1];
+            pSearch->probe_dot[pos] = pSearch->probe_dot[pos - 1];
+            pos--;
+        }
+        pSearch->probe[pos] = (uint16_t)l;
+        pSearch->probe_dot[pos] = dot;
+    }
+    return GALLERY_INDEX_OK;
+}
+
+int gallery_index_search_step(const gallery_index_t *pIndex, gallery_index_search_t *pSearch,
+                              uint32_t budget)
+{
+    while (budget > 0 && pSearch->next_probe < pSearch->probes) {
+        const uint32_t list = pSearch->probe[pSearch->next_probe];
+        const uint32_t start = pIndex->pListStart[list] + pSearch->next_template;
+        const uint32_t left = pIndex->pListStart[list + 1] - start;
+        const uint32_t n = (left < budget) ? left : budget;
+        const float32_t base = pSearch->probe_dot[pSearch->next_probe];
+        const uint8_t *pCode = &pIndex->pCodes[start * GALLERY_INDEX_SUBSPACES];
+
+        /* q . x = q . c + the table entries of the residual's codes */
+        for (uint32_t t = start; t < start + n; t++, pCode += GALLERY_INDEX_SUBSPACES) {
+            float32_t dot = base;
+
+            for (uint32_t m = 0; m < GALLERY_INDEX_SUBSPACES; m++) {
+                dot += pSearch->table[m][pCode[m]];
+            }
+            if (pSearch->shortlisted == GALLERY_INDEX_SHORTLIST &&
+                dot <= pSearch->shortlist_dot[GALLERY_INDEX_SHORTLIST - 1]) {
+                continue;
+            }
+            shortlist_offer(pSearch, t, dot);
+        }
+        pSearch->scanned += n;
+        budget -= n;
+        if (n == left) {
+            pSearch->next_probe++;
+            pSearch->next_template = 0;
+        } else {
+            pSearch->next_template += n;
+        }
+    }
+    return pSearch->next_probe < pSearch->probes;
+}
+
+uint32_t gallery_index_search_end(const gallery_index_t *pIndex, const gallery_index_search_t *pSearch,
+                                  face_gallery_match_t *pMatch, uint32_t k)
+{
+    uint32_t nb = 0;
+
+    if (k == 0) {
+        return 0;
+    }
+    /* Same score as face_gallery_search on int8 templates */
+    for (uint32_t i = 0; i < pSearch->shortlisted; i++) {
+        const uint32_t t = pSearch->shortlist[i];
+        const int32_t dot = face_gallery_dot_q7(&pIndex->pRows[t * EMBEDDING_SIZE], pSearch->query_q7);
+        const float32_t score = (float32_t)dot * pSearch->query_scale * pIndex->pScale[t];
+
+        if (nb == k && score <= pMatch[k - 1].score) {
+            continue;
+        }
+        face_gallery_offer(pMatch, &nb, k, pIndex->pIdentity[t], score);
+    }
+    return nb;
+}
+
+uint32_t gallery_index_search(const gallery_index_t *pIndex, gallery_index_search_t *pSearch,
+                              const float32_t *query, uint32_t probes,
+                              face_gallery_match_t *pMatch, uint32_t k)
+{
+    if (gallery_index_search_begin(pIndex, pSearch, query, probes) != GALLERY_INDEX_OK) {
+        return 0;
+    }
+    (void)gallery_index_search_step(pIndex, pSearch, UINT32_MAX);
+    return gallery_index_search_end(pIndex, pSearch, pMatch, k);
+}
@@ -0,0 +1,533 @@
+/**
+ ******************************************************************************
+ * @file    gallery_store.c
+ * @author  PeleAB
+ * @brief   Persistent face gallery: append-only log of int8 templates in NOR
+ *          flash, searched in place through the memory-mapped window
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "gallery_store.h"
+#include <stddef.h>
+#include <string.h>
+#include "app_constants.h"
+
+/* ========================================================================= */
+/* RECORDS                                                                   */
+/* ========================================================================= */
+
+#define RECORD_CRC_BYTES                    offsetof(gallery_record_t, crc)
+#define RECORD_WORDS                        (sizeof(gallery_record_t) / sizeof(uint32_t))
+
+static uint32_t crc_table[256];             /**< Filled by the first mount */
+
+static void gallery_store_crc_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ PROTOCOL_CRC32_POLYNOMIAL : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+}
+
+/* Same CRC-32 as config_manager_calculate_crc, a table lookup per byte */
+static uint32_t gallery_store_crc(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ crc_table[(crc ^ data[i]) & 0xFFU];
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static uint32_t slot_offset(uint32_t segment, uint32_t slot)
+{
+    return segment * GALLERY_STORE_SECTOR_SIZE + slot * GALLERY_STORE_SLOT_SIZE;
+}
+
+static const gallery_record_t *slot_record(const gallery_store_t *pStore, uint32_t segment,
+                                           uint32_t slot)
+{
+    return (const gallery_record_t *)(pStore->pBase + slot_offset(segment, slot));
+}
+
+/**
+ * @brief Nothing was programmed in the slot (a torn write may leave the
+ *        magic erased and later bytes programmed)
+ */
+static int record_erased(const gallery_record_t *pRecord)
+{
+    const uint32_t *p = (const uint32_t *)pRecord;
+
+    for (uint32_t w = 0; w < RECORD_WORDS; w++) {
+        if (p[w] != 0xFFFFFFFFU) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int record_valid(const gallery_record_t *pRecord)
+{
+    return pRecord->magic == GALLERY_RECORD_MAGIC &&
+           pRecord->crc == gallery_store_crc((const uint8_t *)pRecord, RECORD_CRC_BYTES);
+}
+
+static int identity_deleted(const gallery_store_t *pStore, uint32_t identity)
+{
+    if (identity >= GALLERY_STORE_MAX_IDENTITIES) {
+        return 1;
+    }
+    return (pStore->deleted[identity / 32U] >> (identity % 32U)) & 1U;
+}
+
+/**
+ * @brief Slots in use in the @p i-th oldest segment
+ */
+static uint32_t segment_fill(const gallery_store_t *pStore, uint32_t i)
+{
+    return (i + 1U == pStore->used) ? pStore->head_slot : GALLERY_STORE_SLOTS;
+}
+
+/**
+ * @brief A valid record of @p type matches in a segment newer than the oldest
+ * @param uid Record id to find, or any if @p identity is given
+ */
+static int newer_record(const gallery_store_t *pStore, uint16_t type, uint32_t uid, int identity)
+{
+    for (uint32_t i = 1; i < pStore->used; i++) {
+        const uint32_t fill = segment_fill(pStore, i);
+
+        for (uint32_t slot = 1; slot < fill; slot++) {
+            const gallery_record_t *r = slot_record(pStore, pStore->order[i], slot);
+
+            if (r->magic != GALLERY_RECORD_MAGIC || r->type != type) {
+                continue;
+            }
+            if ((identity < 0 && r->uid == uid) || (identity >= 0 && r->identity == identity)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Template records of the identities not deleted
+ */
+static uint32_t count_templates(const gallery_store_t *pStore)
+{
+    uint32_t nb = 0;
+
+    for (uint32_t i = 0; i < pStore->used; i++) {
+        const uint32_t fill = segment_fill(pStore, i);
+
+        for (uint32_t slot = 1; slot < fill; slot++) {
+            const gallery_record_t *r = slot_record(pStore, pStore->order[i], slot);
+
+            nb += (r->magic == GALLERY_RECORD_MAGIC && r->type == GALLERY_RECORD_TEMPLATE &&
+                   !identity_deleted(pStore, r->identity));
+        }
+    }
+    return nb;
+}
+
+/* ========================================================================= */
+/* LOG                                                                       */
+/* ========================================================================= */
+
+static void record_seal(gallery_record_t *pRecord)
+{
+    pRecord->magic = GALLERY_RECORD_MAGIC;
+    pRecord->crc = gallery_store_crc((const uint8_t *)pRecord, RECORD_CRC_BYTES);
+}
+
+/**
+ * @brief Erase a free sector and make it the newest segment
+ */
+static int open_segment(gallery_store_t *pStore)
+{
+    gallery_record_t header;
+    uint32_t segment = pStore->used ? pStore->order[pStore->used - 1U] : 0;
+
+    if (pStore->used >= pStore->sectors) {
+        return GALLERY_STORE_ERR_FULL;
+    }
+    /* Next free sector after the newest, so erases go round the region */
+    for (;;) {
+        uint32_t i;
+
+        segment = (segment + 1U) % pStore->sectors;
+        for (i = 0; i < pStore->used && pStore->order[i] != segment; i++) {
+        }
+        if (i == pStore->used) {
+            break;
+        }
+    }
+
+    memset(&header, 0xFF, sizeof(header));
+    header.type = GALLERY_RECORD_SEGMENT;
+    header.identity = 0;
+    header.uid = pStore->next_seq++;
+    record_seal(&header);
+    if (pStore->pFlash->erase(slot_offset(segment, 0)) != 0 ||
+        pStore->pFlash->program(slot_offset(segment, 0), &header, sizeof(header)) != 0) {
+        return GALLERY_STORE_ERR_FLASH;
+    }
+    pStore->order[pStore->used++] = (uint8_t)segment;
+    pStore->head_slot = 1;
+    return GALLERY_STORE_OK;
+}
+
+/**
+ * @brief Append a sealed record, opening a segment if the newest is full
+ * @param pRecord In RAM: the flash is not readable while it is programmed
+ */
+static int append(gallery_store_t *pStore, const gallery_record_t *pRecord)
+{
+    const uint32_t zero = 0;
+    uint32_t offset;
+    int ret;
+
+    if (pStore->head_slot >= GALLERY_STORE_SLOTS) {
+        ret = open_segment(pStore);
+        if (ret != GALLERY_STORE_OK) {
+            return ret;
+        }
+    }
+    /* The slot is used even if programming fails: it is no longer erased.
+     * Whatever landed is invalidated, as the mount does after a power cut. */
+    offset = slot_offset(pStore->order[pStore->used - 1U], pStore->head_slot++);
+    if (pStore->pFlash->program(offset, pRecord, sizeof(*pRecord)) != 0) {
+        (void)pStore->pFlash->program(offset, &zero, sizeof(zero));
+        return GALLERY_STORE_ERR_FLASH;
+    }
+    return GALLERY_STORE_OK;
+}
+
+/**
+ * @brief Copy the live records of the oldest segment to the newest, then
+ *        retire it
+ *
+ * Templates of deleted identities are dropped, and so are tombstones once no
+ * template of their identity is left elsewhere. A record already copied
+ * before a power cut is not copied again.
+ */
+static int compact(gallery_store_t *pStore)
+{
+    const uint32_t segment = pStore->order[0];
+    const uint32_t zero = 0;
+    gallery_record_t record;
+    int ret;
+
+    for (uint32_t slot = 1; slot < GALLERY_STORE_SLOTS; slot++) {
+        const gallery_record_t *r = slot_record(pStore, segment, slot);
+
+        if (r->magic != GALLERY_RECORD_MAGIC) {
+            continue; /* Erased or invalidated */
+        }
+        if (r->type == GALLERY_RECORD_TEMPLATE && identity_deleted(pStore, r->identity)) {
+            continue;
+        }
+        if (r->type == GALLERY_RECORD_TOMBSTONE &&
+            !newer_record(pStore, GALLERY_RECORD_TEMPLATE, 0, r->identity)) {
+            continue;
+        }
+        if (newer_record(pStore, r->type, r->uid, -1)) {
+            continue;
+        }
+        memcpy(&record, r, sizeof(record));
+        ret = append(pStore, &record);
+        if (ret != GALLERY_STORE_OK) {
+            return ret;
+        }
+    }
+
+    if (pStore->pFlash->program(slot_offset(segment, 0), &zero, sizeof(zero)) != 0) {
+        return GALLERY_STORE_ERR_FLASH;
+    }
+    pStore->used--;
+    memmove(&pStore->order[0], &pStore->order[1], pStore->used);
+    pStore->templates = count_templates(pStore);
+    return GALLERY_STORE_OK;
+}
+
+/**
+ * @brief Make sure a record can be appended without using the reserve
+ *        segment, compacting the oldest segments as needed
+ */
+static int make_room(gallery_store_t *pStore)
+{
+    for (uint32_t pass = 0; pass < pStore->sectors; pass++) {
+        int ret;
+
+        /* Every sector in use: a compaction was cut, finish it first */
+        if (pStore->used < pStore->sectors &&
+            (pStore->head_slot < GALLERY_STORE_SLOTS || pStore->used + 1U < pStore->sectors)) {
+            return GALLERY_STORE_OK;
+        }
+        ret = compact(pStore);
+        if (ret != GALLERY_STORE_OK) {
+            return ret;
+        }
+    }
+    return GALLERY_STORE_ERR_FULL;
+}
+
+/* ========================================================================= */
+/* IMPLEMENTATION FUNCTIONS                                                  */
+/* ========================================================================= */
+
+int gallery_store_mount(gallery_store_t *pStore, const gallery_flash_t *pFlash, uint32_t sectors)
+{
+    uint32_t seq[GALLERY_STORE_MAX_SECTORS];
+    const uint32_t zero = 0;
+
+    if (!pStore || !pFlash || sectors < GALLERY_STORE_MIN_SECTORS ||
+        sectors > GALLERY_STORE_MAX_SECTORS) {
+        return GALLERY_STORE_ERR_ARG;
+    }
+    if (crc_table[1] == 0) {
+        gallery_store_crc_init();
+    }
+    memset(pStore, 0, sizeof(*pStore));
+    pStore->pFlash = pFlash;
+    pStore->sectors = sectors;
+    pStore->pBase = pFlash->map(sectors * GALLERY_STORE_SECTOR_SIZE);
+    if (!pStore->pBase) {
+        return GALLERY_STORE_ERR_FLASH;
+    }
+
+    /* Segments in use, oldest first; a sector without a valid header is free */
+    for (uint32_t s = 0; s < sectors; s++) {
+        const gallery_record_t *h = slot_record(pStore, s, 0);
+        uint32_t i;
+
+        if (!record_valid(h) || h->type != GALLERY_RECORD_SEGMENT) {
+            continue;
+        }
+        for (i = pStore->used; i > 0 && seq[i - 1U] > h->uid; i--) {
+            seq[i] = seq[i - 1U];
+            pStore->order[i] = pStore->order[i - 1U];
+        }
+        seq[i] = h->uid;
+        pStore->order[i] = (uint8_t)s;
+        pStore->used++;
+        if (h->uid >= pStore->next_seq) {
+            pStore->next_seq = h->uid + 1U;
+        }
+    }
+
+    /* Records: the newest segment ends at its first erased slot. A record
+     * torn by a power cut is invalidated so that the search, which only looks
+     * at the magic, skips it. */
+    pStore->head_slot = GALLERY_STORE_SLOTS;
+    for (uint32_t i = 0; i < pStore->used; i++) {
+        for (uint32_t slot = 1; slot < GALLERY_STORE_SLOTS; slot++) {
+            const gallery_record_t *r = slot_record(pStore, pStore->order[i], slot);
+
+            if (record_erased(r)) {
+                if (i + 1U == pStore->used) {
+                    pStore->head_slot = slot;
+                }
+                break;
+            }
+            if (r->magic != GALLERY_RECORD_MAGIC) {
+                continue;
+            }
+            if (!record_valid(r) || r->identity >= GALLERY_STORE_MAX_IDENTITIES) {
+                (void)pFlash->program(slot_offset(pStore->order[i], slot), &zero, sizeof(zero));
+                pStore->repaired++;
+                continue;
+            }
+            if (r->identity >= pStore->next_identity) {
+                pStore->next_identity = r->identity + 1U;
+            }
+            if (r->uid >= pStore->next_uid) {
+                pStore->next_uid = r->uid + 1U;
+            }
+            if (r->type == GALLERY_RECORD_TOMBSTONE) {
+                pStore->deleted[r->identity / 32U] |= 1U << (r->identity % 32U);
+            }
+        }
+    }
+    pStore->templates = count_templates(pStore);
+    return GALLERY_STORE_OK;
+}
+
+int gallery_store_next_identity(const gallery_store_t *pStore)
+{
+    return (pStore->next_identity < GALLERY_STORE_MAX_IDENTITIES) ? (int)pStore->next_identity :
+                                                                     GALLERY_STORE_ERR_FULL;
+}
+
+int gallery_store_add(gallery_store_t *pStore, uint16_t identity, const float32_t *embedding)
+{
+    gallery_record_t record;
+    int ret;
+
+    if (!pStore->pBase || identity_deleted(pStore, identity)) {
+        return GALLERY_STORE_ERR_ARG;
+    }
+    memset(&record, 0xFF, sizeof(record));
+    record.scale = face_gallery_quantize(embedding, record.row);
+    if (record.scale == 0.0f) {
+        return GALLERY_STORE_ERR_ZERO;
+    }
+    /* One segment of slack for tombstones and interrupted copies */
+    if (pStore->templates >= (pStore->sectors - 2U) * (GALLERY_STORE_SLOTS - 1U)) {
+        return GALLERY_STORE_ERR_FULL;
+    }
+    ret = make_room(pStore);
+    if (ret != GALLERY_STORE_OK) {
+        return ret;
+    }
+    record.type = GALLERY_RECORD_TEMPLATE;
+    record.identity = identity;
+    record.uid = pStore->next_uid++;
+    record_seal(&record);
+    ret = append(pStore, &record);
+    if (ret != GALLERY_STORE_OK) {
+        return ret;
+    }
+    if (identity >= pStore->next_identity) {
+        pStore->next_identity = identity + 1U;
+    }
+    pStore->templates++;
+    return GALLERY_STORE_OK;
+}
+
+int gallery_store_delete(gallery_store_t *pStore, uint16_t identity)
+{
+    const uint32_t templates = gallery_store_identity_count(pStore, identity);
+    gallery_record_t record;
+    int ret;
+
+    if (!pStore->pBase || identity >= GALLERY_STORE_MAX_IDENTITIES) {
+        return GALLERY_STORE_ERR_ARG;
+    }
+    if (templates == 0) {
+        return GALLERY_STORE_OK; /* Nothing to delete, or already deleted */
+    }
+    ret = make_room(pStore);
+    if (ret != GALLERY_STORE_OK) {
+        return ret;
+    }
+    memset(&record, 0xFF, sizeof(record));
+    record.type = GALLERY_RECORD_TOMBSTONE;
+    record.identity = identity;
+    record.uid = pStore->next_uid++;
+    record_seal(&record);
+    ret = append(pStore, &record);
+    if (ret != GALLERY_STORE_OK) {
+        return ret;
+    }
+    pStore->deleted[identity / 32U] |= 1U << (identity % 32U);
+    pStore->templates = count_templates(pStore);
+    return GALLERY_STORE_OK;
+}
+
+int gallery_store_clear(gallery_store_t *pStore)
+{
+    for (;;) {
+        int identity = -1;
+        int ret;
+
+        /* Oldest live template; deleting may compact, so look again each time */
+        for (uint32_t i = 0; i < pStore->used && identity < 0; i++) {
+            const uint32_t fill = segment_fill(pStore, i);
+
+            for (uint32_t slot = 1; slot < fill; slot++) {
+                const gallery_record_t *r = slot_record(pStore, pStore->order[i], slot);
+
+                if (r->magic == GALLERY_RECORD_MAGIC && r->type == GALLERY_RECORD_TEMPLATE &&
+                    !identity_deleted(pStore, r->identity)) {
+                    identity = r->identity;
+                    break;
+                }
+            }
+        }
+        if (identity < 0) {
+            return GALLERY_STORE_OK;
+        }
+        ret = gallery_store_delete(pStore, (uint16_t)identity);
+        if (ret != GALLERY_STORE_OK) {
+            return ret;
+        }
+    }
+}
+
+uint32_t gallery_store_identity_count(const gallery_store_t *pStore, uint16_t identity)
+{
+    uint32_t nb = 0;
+
+    if (identity_deleted(pStore, identity)) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < pStore->used; i++) {
+        const uint32_t fill = segment_fill(pStore, i);
+
+        for (uint32_t slot = 1; slot < fill; slot++) {
+            const gallery_record_t *r = slot_record(pStore, pStore->order[i], slot);
+
+            if (r->magic != GALLERY_RECORD_MAGIC || r->type != GALLERY_RECORD_TEMPLATE ||
+                r->identity != identity) {
+                continue;
+            }
+            /* A copy left by an interrupted compaction counts once */
+            nb += (i == 0) ? !newer_record(pStore, GALLERY_RECORD_TEMPLATE, r->uid, -1) : 1U;
+        }
+    }
+    return nb;
+}
+
+uint32_t gallery_store_search(const gallery_store_t *pStore, const float32_t *query,
+                              face_gallery_match_t *pMatch, uint32_t k)
+{
+    int8_t query_q7[EMBEDDING_SIZE];
+    float32_t query_scale;
+    uint32_t nb = 0;
+
+    if (k == 0 || !pStore->pBase) {
+        return 0;
+    }
+    query_scale = face_gallery_quantize(query, query_q7);
+    if (query_scale == 0.0f) {
+        return 0;
+    }
+    /* Rows are read in place from the memory-mapped flash; invalidated and
+     * torn records were cleared by the mount, so the magic is enough */
+    for (uint32_t i = 0; i < pStore->used; i++) {
+        const uint32_t fill = segment_fill(pStore, i);
+
+        for (uint32_t slot = 1; slot < fill; slot++) {
+            const gallery_record_t *r = slot_record(pStore, pStore->order[i], slot);
+            float32_t score;
+
+            if (r->magic != GALLERY_RECORD_MAGIC || r->type != GALLERY_RECORD_TEMPLATE ||
+                identity_deleted(pStore, r->identity)) {
+                continue;
+            }
+            score = (float32_t)face_gallery_dot_q7(r->row, query_q7) * query_scale * r->scale;
+            if (nb == k && score <= pMatch[k - 1].score) {
+                continue;
+            }
+            face_gallery_offer(pMatch, &nb, k, r->identity, score);
+        }
+    }
+    return nb;
+}
@@ -39,16 +39,20 @@
 #include "enhanced_pc_stream.h"
 
 #include "crop_img.h"
+#include "blit.h"
+#include "pixel_lut.h"
 #include "display_utils.h"
 #include "img_buffer.h"
 #include "system_utils.h"
-#include "face_utils.h"
 #include "target_embedding.h"
 #include "app_constants.h"
 #include "app_config_manager.h"
 #include "memory_pool.h"
 #include "app_neural_network.h"
 #include "app_frame_processing.h"
+#include "frame_dbuf.h"
+#include "pipeline_profiler.h"
+#include "trace_log.h"
 
 /* Legacy compatibility - constants moved to app_constants.h */
 #define REVERIFY_INTERVAL_MS        FACE_REVERIFY_INTERVAL_MS
@@ -76,6 +80,11 @@ typedef struct {
     /* Network Instance References */
     bool detection_initialized;
     bool recognition_initialized;
+    
+    /* Resident network lifecycles (init once, reset between inferences) */
+    nn_network_t detection_net;
+    nn_network_t recognition_net;
+    uint32_t saved_cycles_reported;         /**< Saved setup cycles already reported */
 } nn_context_t;
 
 /* ========================================================================= */
@@ -89,6 +98,40 @@ typedef struct {
     float cx, cy, w, h, lx, ly, rx, ry;
 } pixel_coords_t;
 
+/* Warp faces in one pass from the display frame to recognition input form
+ * unless the RGB888 crop is needed */
+#if INPUT_SRC_MODE == INPUT_SRC_CAMERA && !defined(ENABLE_ALIGNED_FACE_STREAM)
+#define RECOGNITION_FUSED_INPUT
+#endif
+
+/**
+ * @brief A face staged for recognition
+ * @note  With RECOGNITION_FUSED_INPUT the face is warped into .input when it is
+ *        staged. Without RECOGNITION_INPUT_USER_BUFFERS both slots share
+ *        fr_input_stage, copied to the network's own input when it is loaded.
+ */
+typedef struct {
+    pixel_coords_t coords;
+    uint8_t *crop;                          /**< RGB888 aligned face (two-pass path) */
+    float32_t *input;                       /**< Float CHW face, bound or copied at load */
+} fr_stage_t;
+
+/* Recognition results of one frame, taken face by face in queue order */
+typedef struct {
+    bool target_found;
+    float highest_similarity;
+    bool best_embedding_valid;
+    float32_t best_embedding[EMBEDDING_SIZE]; /**< Embedding of the best face */
+} recognition_frame_t;
+
+/* Enrollment requested by the user button */
+typedef enum {
+    BANK_ACTION_NONE = 0,
+    BANK_ACTION_ADD,                        /* Short press: add the current embedding */
+    BANK_ACTION_NEXT,                       /* Long press: next identity */
+    BANK_ACTION_CLEAR                       /* 5 s press: delete every identity */
+} bank_action_t;
+
 /* Simplified Application State Machine - No Tracking */
 typedef enum {
     PIPE_STATE_DETECT_AND_VERIFY = 0  /* Single state: detect faces and verify immediately */
@@ -131,15 +174,19 @@ typedef struct {
     bool led_timeout_active;                /**< LED timeout status */
     
     /* Face Recognition */
-    float current_embedding[EMBEDDING_SIZE]; /**< Current face embedding */
+    float current_embedding[EMBEDDING_SIZE]; /**< Current face embedding, unit-norm */
     int embedding_valid;                    /**< Embedding validity flag */
+    bool recognition_overlap;               /**< Stage the next face while the NPU embeds
+                                                 one (false: one face after the other) */
     
     /* User Interface */
     uint32_t button_press_ts;               /**< Button press timestamp */
     int prev_button_state;                  /**< Previous button state */
+    bank_action_t bank_action;              /**< Applied once the NPU is idle */
     
     /* Performance monitoring */
     performance_metrics_t performance;      /**< Performance metrics */
+    pipeline_timing_t timing;               /**< Last frame per-stage timing */
     uint32_t frame_count;                   /**< Frame counter */
 } app_context_t;
 
@@ -159,8 +206,43 @@ __attribute__ ((section (".psram_bss")))
 __attribute__((aligned (32)))
 uint8_t fr_rgb[FR_WIDTH * FR_HEIGHT * NN_BPP];  /* 112x112x3 = 37KB */
 
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+/* Recognition network inputs, bound in turn: face i+1 is written to one while
+ * the NPU reads face i from the other (2 x 150 KB, nothing copied) */
+__attribute__((aligned (32)))
+static float32_t fr_input[2][FR_WIDTH * FR_HEIGHT * NN_BPP];
+#define FR_STAGE_INPUT(i)   fr_input[i]
+#elif defined(RECOGNITION_FUSED_INPUT)
+/* Next face warped while the NPU embeds the current one, then copied to the
+ * network's own input: 150 KB of internal RAM and a 150 KB copy per face. One
+ * buffer is enough, as a face is copied before the next one is staged. */
+__attribute__((aligned (32)))
+static float32_t fr_input_stage[FR_WIDTH * FR_HEIGHT * NN_BPP];
+#define FR_STAGE_INPUT(i)   fr_input_stage
+#else
+#define FR_STAGE_INPUT(i)   NULL
+#endif
+
+#ifdef RECOGNITION_FUSED_INPUT
+/* Two recognition staging slots: face i+1 is warped while the NPU embeds face i */
+static fr_stage_t fr_stage[2] = { { .input = FR_STAGE_INPUT(0) }, { .input = FR_STAGE_INPUT(1) } };
+#else
+__attribute__ ((section (".psram_bss")))
+__attribute__((aligned (32)))
+static uint8_t fr_rgb_pong[FR_WIDTH * FR_HEIGHT * NN_BPP];  /* Second recognition staging buffer */
+
+/* Two recognition staging slots: face i+1 is cropped while the NPU embeds face i */
+static fr_stage_t fr_stage[2] = { { .crop = fr_rgb, .input = FR_STAGE_INPUT(0) },
+                                  { .crop = fr_rgb_pong, .input = FR_STAGE_INPUT(1) } };
+#endif
+
 __attribute__ ((aligned (32)))
-uint8_t dcmipp_out_nn[DCMIPP_OUT_NN_BUFF_LEN];  /* Camera output buffer */
+uint8_t dcmipp_out_nn[FRAME_DBUF_COUNT][DCMIPP_OUT_NN_BUFF_LEN];  /* Camera NN pipe double buffer */
+
+#if INPUT_SRC_MODE == INPUT_SRC_CAMERA
+/* NN pipe handoff: DCMIPP fills one buffer while the pipeline reads the other */
+static frame_dbuf_t nn_pipe_dbuf;
+#endif
 
 #ifdef DUMMY_INPUT_BUFFER
 /* ========================================================================= */
@@ -199,12 +281,14 @@ static app_context_t g_app_ctx = {
     .embedding_valid = 0,
     .button_press_ts = 0,
     .prev_button_state = 0,
+    .bank_action = BANK_ACTION_NONE,
     .target_detection_history = {false},
     .history_index = 0,
     .history_count = 0,
     .target_detected = false,
     .last_stable_verification_ts = 0,
-    .led_timeout_active = false
+    .led_timeout_active = false,
+    .recognition_overlap = true
 };
 
 
@@ -214,21 +298,32 @@ static int nn_init_recognition_lazy(nn_context_t *nn_ctx);
 static void nn_cleanup(nn_context_t *nn_ctx);
 static int app_init(app_context_t *ctx);
 static int app_main_loop(app_context_t *ctx);
+static int app_pipeline_start(app_context_t *ctx, uint32_t *pitch_nn);
+static int app_process_frame(app_context_t *ctx, uint32_t pitch_nn, uint32_t boot_time);
 static void app_camera_init(uint32_t *pitch_nn);
 static void app_display_init(void);
 static void app_input_start(void);
-static int  app_get_frame(uint8_t *dest, uint32_t pitch_nn);
+static int  app_acquire_frame(uint8_t **frame, uint32_t *stride, uint32_t pitch_nn);
+static void app_release_frame(void);
 static void app_output(pd_postprocess_out_t *res, uint32_t total_frame_time_ms, uint32_t boot_ms, const app_context_t *ctx);
 static void handle_user_button(app_context_t *ctx);
-static float verify_box(app_context_t *ctx, const pd_pp_box_t *box);
+static void apply_bank_action(app_context_t *ctx);
 static void process_frame_detections(app_context_t *ctx, pd_pp_box_t *boxes, uint32_t box_count);
 static void update_led_status(app_context_t *ctx);
+static void app_trace_flush(void);
 static void update_target_detection_history(app_context_t *ctx, bool target_found_this_frame);
 static void compute_target_detection_status(app_context_t *ctx);
-static float run_face_recognition_on_face(app_context_t *ctx, const pd_pp_box_t *box);
+static int recognition_stage_face(const pd_pp_box_t *box, fr_stage_t *stage);
+static int recognition_load_input(app_context_t *ctx, const fr_stage_t *stage);
+static void recognition_finish_face(app_context_t *ctx, const fr_stage_t *stage);
+static void recognition_wait(nn_async_run_t *run);
+static void recognition_take_result(app_context_t *ctx, recognition_frame_t *frame, pd_pp_box_t *boxes,
+                                    uint32_t i, uint32_t stage_start, bool ran);
 static int convert_box_coordinates(const pd_pp_box_t *box, pixel_coords_t *pixel_coords);
+#ifndef RECOGNITION_FUSED_INPUT
 static int crop_face_region(const pixel_coords_t *coords, uint8_t *output_buffer);
-static float calculate_face_similarity(const float32_t *embedding, const float32_t *target_embedding, uint32_t embedding_size);
+#endif
+static float calculate_face_similarity(void);
 static void cleanup_nn_buffers(float32_t **nn_out, int32_t *nn_out_len, int number_output);
 
 /* Neural Network Instance Declarations */
@@ -254,7 +349,18 @@ static int nn_init_detection(nn_context_t *nn_ctx)
     }
     
     /* Setup detection input buffer */
+#ifdef DETECTION_INPUT_UINT8_HWC
+    /* The input is bound to each captured frame, see pipeline_stage_capture_and_preprocess */
+    if (!detection_in_info[0].is_user_allocated ||
+        LL_Buffer_len(&detection_in_info[0]) != NN_WIDTH * NN_HEIGHT * NN_BPP) {
+        printf("face_detection input is not a user-allocated %dx%dx%d uint8 tensor\n",
+               NN_WIDTH, NN_HEIGHT, NN_BPP);
+        return -1;
+    }
+    nn_ctx->detection_input_buffer = NULL;
+#else
     nn_ctx->detection_input_buffer = (uint8_t *) LL_Buffer_addr_start(&detection_in_info[0]);
+#endif
     nn_ctx->detection_input_length = LL_Buffer_len(&detection_in_info[0]);
     
     /* Setup detection output buffers */
@@ -268,10 +374,11 @@ static int nn_init_detection(nn_context_t *nn_ctx)
         nn_ctx->detection_output_count++;
     }
     
+    NN_Network_Bind(&nn_ctx->detection_net, &NN_Instance_face_detection);
     nn_ctx->detection_initialized = true;
     
     printf("Face Detection Network Ready: %lu bytes, %d outputs\n", 
-           nn_ctx->detection_input_length, nn_ctx->detection_output_count);
+           (unsigned long)nn_ctx->detection_input_length, nn_ctx->detection_output_count);
     
     return 0;
 }
@@ -296,15 +403,28 @@ static int nn_init_recognition_lazy(nn_context_t *nn_ctx)
     }
     
     /* Setup recognition buffers */
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+    /* The input is bound to each staged face, see recognition_load_input */
+    if (!recognition_in_info[0].is_user_allocated ||
+        LL_Buffer_len(&recognition_in_info[0]) != sizeof(fr_input[0])) {
+        printf("face_recognition input is not a user-allocated %dx%dx%d float tensor\n",
+               FR_WIDTH, FR_HEIGHT, NN_BPP);
+        return -3;
+    }
+    nn_ctx->recognition_input_buffer = NULL;
+#else
     nn_ctx->recognition_input_buffer = (uint8_t *) LL_Buffer_addr_start(&recognition_in_info[0]);
+#endif
     nn_ctx->recognition_input_length = LL_Buffer_len(&recognition_in_info[0]);
     nn_ctx->recognition_output_buffer = (float32_t *) LL_Buffer_addr_start(&recognition_out_info[0]);
     nn_ctx->recognition_output_length = LL_Buffer_len(&recognition_out_info[0]);
     
+    NN_Network_Bind(&nn_ctx->recognition_net, &NN_Instance_face_recognition);
     nn_ctx->recognition_initialized = true;
     
     printf("Face Recognition Network Loaded: %lu bytes -> %lu bytes\n", 
-           nn_ctx->recognition_input_length, nn_ctx->recognition_output_length);
+           (unsigned long)nn_ctx->recognition_input_length,
+           (unsigned long)nn_ctx->recognition_output_length);
     
     return 0;
 }
@@ -317,6 +437,8 @@ static void nn_cleanup(nn_context_t *nn_ctx)
 {
     if (nn_ctx && (nn_ctx->detection_initialized || nn_ctx->recognition_initialized)) {
         /* Clean up any network-specific resources if needed */
+        NN_Network_Release(&nn_ctx->detection_net);
+        NN_Network_Release(&nn_ctx->recognition_net);
         memset(nn_ctx, 0, sizeof(*nn_ctx));
         printf("🧹 Neural Networks cleaned up\n");
     }
@@ -356,33 +478,51 @@ static void app_input_start(void)
 {
 #if INPUT_SRC_MODE == INPUT_SRC_CAMERA
     CAM_DisplayPipe_Start(img_buffer, CMW_MODE_CONTINUOUS);
+    CAM_NNPipe_DoubleBufferStart(&nn_pipe_dbuf, dcmipp_out_nn[0], dcmipp_out_nn[1]);
 #endif
 }
 
 /**
- * @brief Capture frame from camera or PC stream
- * @param dest Destination buffer for frame data
+ * @brief Capture frame from camera or PC stream without copying it
+ * @param frame Set to the RGB888 frame, held until app_release_frame()
+ * @param stride Set to the frame row pitch in bytes
  * @param pitch_nn Neural network pitch value
  * @return 0 on success, non-zero on failure
  */
-static int app_get_frame(uint8_t *dest, uint32_t pitch_nn)
+static int app_acquire_frame(uint8_t **frame, uint32_t *stride, uint32_t pitch_nn)
 {
 #if INPUT_SRC_MODE == INPUT_SRC_CAMERA
     CAM_IspUpdate();
-    
-    uint8_t *capture_buffer = (pitch_nn != (NN_WIDTH * NN_BPP)) ? dcmipp_out_nn : dest;
-    CAM_NNPipe_Start(capture_buffer, CMW_MODE_SNAPSHOT);
 
-    /* Optimized frame capture - reduced blocking time */
-    while (cameraFrameReceived == 0) {
-        /* Could add a timeout here for better responsiveness */
+    /* The NN pipe runs continuously; take the latest complete frame. While
+     * the previous frame was being processed the next one was already
+     * captured into the other buffer, so this usually does not wait. The
+     * frame is read in place, DCMIPP row padding included. */
+    uint32_t start = HAL_GetTick();
+    while ((*frame = frame_dbuf_acquire(&nn_pipe_dbuf, NULL)) == NULL) {
+        /* No frame at all: the pipe has stopped or the sensor stalled */
+        if (HAL_GetTick() - start > CAMERA_FRAME_TIMEOUT_MS) {
+            return -1;
+        }
     }
     cameraFrameReceived = 0;
-    SCB_InvalidateDCache_by_Addr(dest, NN_WIDTH * NN_HEIGHT * NN_BPP);
-
+    *stride = pitch_nn;
     return 0;
 #else
-    return PC_STREAM_ReceiveImage(dest, NN_WIDTH * NN_HEIGHT * NN_BPP);
+    (void)pitch_nn;
+    *frame = nn_rgb;
+    *stride = NN_WIDTH * NN_BPP;
+    return PC_STREAM_ReceiveImage(nn_rgb, NN_WIDTH * NN_HEIGHT * NN_BPP);
+#endif
+}
+
+/**
+ * @brief Hand the frame taken by app_acquire_frame() back to the camera
+ */
+static void app_release_frame(void)
+{
+#if INPUT_SRC_MODE == INPUT_SRC_CAMERA
+    frame_dbuf_release(&nn_pipe_dbuf);
 #endif
 }
 
@@ -455,7 +595,8 @@ static void compute_target_detection_status(app_context_t *ctx)
 static int convert_box_coordinates(const pd_pp_box_t *box, 
                                   pixel_coords_t *pixel_coords)
 {
-    if (!box || !pixel_coords) {
+    /* The eyes align the crop: boxes without decoded keypoints are refused */
+    if (!box || !pixel_coords || box->nb_kps < 2) {
         return -1;
     }
     
@@ -471,6 +612,7 @@ static int convert_box_coordinates(const pd_pp_box_t *box,
     return 0;
 }
 
+#ifndef RECOGNITION_FUSED_INPUT
 /**
  * @brief Crop face region from input image
  * @param coords Pixel coordinates structure
@@ -500,7 +642,7 @@ static int crop_face_region(const pixel_coords_t *coords,
 #endif //DUMMY_INPUT_BUFFER
 
 #else
-    img_crop_align(nn_rgb, output_buffer,
+    img_crop_align(nn_rgb, NN_WIDTH * NN_BPP, output_buffer,
                    NN_WIDTH, NN_HEIGHT,
                    FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT, NN_BPP,
                    coords->cx, coords->cy, coords->w, coords->h, 
@@ -509,89 +651,189 @@ static int crop_face_region(const pixel_coords_t *coords,
     
     return 0;
 }
+#endif /* RECOGNITION_FUSED_INPUT */
 
 /**
- * @brief Calculate face similarity with target embedding
- * @param embedding Current face embedding
- * @param target_embedding Target embedding for comparison
- * @param embedding_size Size of embedding arrays
- * @return Cosine similarity score (0.0 to 1.0)
+ * @brief Finish the gallery search begun by recognition_finish_face
+ * @return Cosine similarity with the best-matching identity (0.0 if none is
+ *         enrolled or the embedding was zero)
  */
-static float calculate_face_similarity(const float32_t *embedding,
-                                      const float32_t *target_embedding,
-                                      uint32_t embedding_size)
+static float calculate_face_similarity(void)
 {
-    if (!embedding || !target_embedding || embedding_size == 0) {
+    face_gallery_match_t match;
+    
+    if (embeddings_bank_search_end(&match, 1) == 0) {
         return 0.0f;
     }
     
-    return embedding_cosine_similarity(embedding, target_embedding, embedding_size);
+    return match.score;
 }
 
 /**
- * @brief Run face recognition on a single face
- * @param ctx Application context
+ * @brief Convert a detection box and crop/align the face into a staging slot
  * @param box Bounding box of face to recognize
- * @return Similarity score (0.0 to 1.0)
+ * @param stage Staging slot (coordinates, and FR_WIDTH x FR_HEIGHT RGB888 crop
+ *              on the two-pass path; the fused path warps into stage->input)
+ * @return 0 on success, negative on error
  */
-static float run_face_recognition_on_face(app_context_t *ctx, const pd_pp_box_t *box)
+static int recognition_stage_face(const pd_pp_box_t *box, fr_stage_t *stage)
 {
-    pixel_coords_t pixel_coords;
-    float32_t embedding[EMBEDDING_SIZE];
-    
-    /* Lazy initialization of face recognition network */
-    if (!ctx->nn_ctx.recognition_initialized) {
-        if (nn_init_recognition_lazy(&ctx->nn_ctx) < 0) {
-            printf("Face recognition network lazy initialization failed\n");
-            return 0.0f;
-        }
-    }
-    
     /* Convert coordinates */
-    if (convert_box_coordinates(box, &pixel_coords) < 0) {
-        return 0.0f;
+    if (convert_box_coordinates(box, &stage->coords) < 0) {
+        return -1;
     }
     
+#ifdef RECOGNITION_FUSED_INPUT
+    /* One pass from the display frame to normalized planar float: no RGB888
+     * crop written to and read back from PSRAM */
+    const pixel_coords_t *c = &stage->coords;
+#ifdef DUMMY_INPUT_BUFFER
+    uint8_t *src = (uint8_t *)dummy_test_img_buffer;
+#else
+    uint8_t *src = img_buffer;
+#endif
+    img_crop_align565_to_chw_float_norm(src, lcd_bg_area.XSize, stage->input,
+                                        lcd_bg_area.XSize, lcd_bg_area.YSize,
+                                        FACE_RECOGNITION_WIDTH, FACE_RECOGNITION_HEIGHT,
+                                        c->cx, c->cy, c->w, c->h, c->lx, c->ly, c->rx, c->ry);
+#else
     /* Crop face region */
-    if (crop_face_region(&pixel_coords, fr_rgb) < 0) {
-        return 0.0f;
+    if (crop_face_region(&stage->coords, stage->crop) < 0) {
+        return -2;
     }
+#endif
     
-    /* Prepare input for face recognition network */
-    img_rgb_to_chw_float_norm(fr_rgb, (float32_t*)ctx->nn_ctx.recognition_input_buffer, 
+    return 0;
+}
+
+/**
+ * @brief Load a staged face into the recognition network input
+ * @param ctx Application context
+ * @param stage Staged face
+ * @return 0 on success, negative if the input could not be bound
+ * @note  Must only be called while the recognition network is idle
+ */
+static int recognition_load_input(app_context_t *ctx, const fr_stage_t *stage)
+{
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+    float32_t *input = stage->input;
+#else
+    float32_t *input = (float32_t *)ctx->nn_ctx.recognition_input_buffer;
+#endif
+    
+#ifdef RECOGNITION_FUSED_INPUT
+#ifndef RECOGNITION_INPUT_USER_BUFFERS
+    /* Warped when staged, possibly during the previous face's inference */
+    memcpy(input, stage->input, ctx->nn_ctx.recognition_input_length);
+#endif
+#else
+    img_rgb_to_chw_float_norm(stage->crop, input, 
                              FR_WIDTH * NN_BPP, FR_WIDTH, FR_HEIGHT);
+#endif
     
-    SCB_CleanInvalidateDCache_by_Addr(ctx->nn_ctx.recognition_input_buffer, 
-                                     ctx->nn_ctx.recognition_input_length);
+    SCB_CleanInvalidateDCache_by_Addr(input, ctx->nn_ctx.recognition_input_length);
     
-    /* Run face recognition inference */
-    RunNetworkSync(&NN_Instance_face_recognition);
-    SCB_InvalidateDCache_by_Addr(ctx->nn_ctx.recognition_output_buffer, 
-                                ctx->nn_ctx.recognition_output_length);
-    
-    /* Convert output to float embedding */
-    for (uint32_t i = 0; i < EMBEDDING_SIZE; i++) {
-        embedding[i] = ((float32_t)ctx->nn_ctx.recognition_output_buffer[i]);
+#ifdef RECOGNITION_INPUT_USER_BUFFERS
+    /* The other buffer is free for the next face once this one is bound */
+    if (LL_ATON_Set_User_Input_Buffer_face_recognition(0, input, ctx->nn_ctx.recognition_input_length) !=
+        LL_ATON_User_IO_NOERROR) {
+        return -1;
     }
-    
-    /* Calculate similarity */
-    float similarity = calculate_face_similarity(embedding, target_embedding, EMBEDDING_SIZE);
-    
-    /* Store embedding in context (for button press functionality) */
+#endif
+    return 0;
+}
+
+/**
+ * @brief Read the embedding of a completed inference and begin its gallery
+ *        search, finished by calculate_face_similarity
+ * @param ctx Application context
+ * @param stage Staged face the embedding belongs to (crop streamed to the PC)
+ */
+static void recognition_finish_face(app_context_t *ctx, const fr_stage_t *stage)
+{
+    /* Stored in context (for button press functionality) */
     /* The last face processed will have its embedding stored - this will be overwritten */
     /* but the process_frame_detections will ensure best face embedding is preserved */
-    for (uint32_t i = 0; i < EMBEDDING_SIZE; i++) {
-        ctx->current_embedding[i] = embedding[i];
+    float32_t *embedding = ctx->current_embedding;
+    
+    SCB_InvalidateDCache_by_Addr(ctx->nn_ctx.recognition_output_buffer, 
+                                ctx->nn_ctx.recognition_output_length);
+    
+    /* Normalized once, straight out of the output buffer: matching is then a
+     * dot product per template */
+    if (face_gallery_normalize(ctx->nn_ctx.recognition_output_buffer, embedding) != 0.0f) {
+        embeddings_bank_search_begin(embedding);
     }
     ctx->embedding_valid = 1;
     
     /* Send results via PC stream */
-    Enhanced_PC_STREAM_SendFrame(fr_rgb, FACE_RECOGNITION_WIDTH, 
+#ifndef RECOGNITION_FUSED_INPUT
+    Enhanced_PC_STREAM_SendFrame(stage->crop, FACE_RECOGNITION_WIDTH, 
                                 FACE_RECOGNITION_HEIGHT, NN_BPP, "ALN", NULL, NULL);
+#else
+    (void)stage;
+#endif
     Enhanced_PC_STREAM_SendEmbedding(embedding, EMBEDDING_SIZE);
+}
+
+/**
+ * @brief Wait for a recognition inference, scanning the gallery index for
+ *        the previous face meanwhile (FACE_GALLERY_INDEX)
+ * @param run Inference started with RunNetworkAsync_StartResident
+ */
+static void recognition_wait(nn_async_run_t *run)
+{
+    while (RunNetworkAsync_Poll(run) == NN_RUN_BUSY) {
+        if (!embeddings_bank_search_step(GALLERY_INDEX_STEP)) {
+            /* Nothing left to scan: sleep until the NPU is done */
+            RunNetworkAsync_Wait(run);
+        }
+    }
+}
+
+/**
+ * @brief Finish the recognition of a face and take its result into the frame
+ * @param ctx Application context (current_embedding still the face's)
+ * @param frame Results of the frame so far
+ * @param boxes Detected boxes, the face's score replaced by its similarity
+ * @param i Index of the face in boxes
+ * @param stage_start When the face was staged, for its latency
+ * @param ran Whether its inference ran (0.0 similarity otherwise)
+ */
+static void recognition_take_result(app_context_t *ctx, recognition_frame_t *frame, pd_pp_box_t *boxes,
+                                    uint32_t i, uint32_t stage_start, bool ran)
+{
+    float similarity = ran ? calculate_face_similarity() : 0.0f;
+    uint32_t latency_us = profiler_ticks_to_us(profiler_now() - stage_start);
+    
+    TLOG_INFO(TRACE_MSG_FACE_RESULT, i + 1, boxes[i].prob * 100.0f,
+              similarity * 100.0f, latency_us);
+    
+    /* Update the box with the recognition similarity (not detection confidence) */
+    boxes[i].prob = similarity;
     
-    LL_ATON_RT_DeInit_Network(&NN_Instance_face_recognition);
-    return similarity;
+    /* Check if this face is above threshold */
+    if (similarity >= FACE_SIMILARITY_THRESHOLD) {
+        frame->target_found = true;
+    }
+    
+    /* Track the face with highest similarity for display */
+    if (ran && similarity > frame->highest_similarity) {
+        frame->highest_similarity = similarity;
+        ctx->best_detection = boxes[i];
+        ctx->current_similarity = similarity;
+        ctx->face_detected = true;
+        
+        /* Store for LCD display */
+        g_cropped_face_valid = true;
+        g_current_similarity = similarity;
+        
+        /* Store best embedding (copy from current_embedding set by recognition_finish_face) */
+        for (uint32_t j = 0; j < EMBEDDING_SIZE; j++) {
+            frame->best_embedding[j] = ctx->current_embedding[j];
+        }
+        frame->best_embedding_valid = true;
+    }
 }
 
 /**
@@ -610,31 +852,42 @@ static void handle_user_button(app_context_t *ctx)
     else if (!current_state && ctx->prev_button_state) {
         uint32_t duration = HAL_GetTick() - ctx->button_press_ts;
         
-        if (duration >= BUTTON_LONG_PRESS_DURATION_MS) {
-            /* Long press: reset embeddings bank */
-            embeddings_bank_reset();
+        if (duration >= BUTTON_CLEAR_PRESS_DURATION_MS) {
+            ctx->bank_action = BANK_ACTION_CLEAR;
+        } else if (duration >= BUTTON_LONG_PRESS_DURATION_MS) {
+            ctx->bank_action = BANK_ACTION_NEXT;
         } else if (ctx->embedding_valid) {
-            /* Short press: add current embedding */
-            embeddings_bank_add(ctx->current_embedding);
+            ctx->bank_action = BANK_ACTION_ADD;
         }
     }
     
     ctx->prev_button_state = current_state;
 }
 
-
 /**
- * @brief Legacy verify_box function - now uses run_face_recognition_on_face
+ * @brief Apply the enrollment requested by the user button
  * @param ctx Application context
- * @param box Bounding box to verify
- * @return Similarity score (0.0 to 1.0)
+ * @note  Called while the NPU is idle: with FACE_GALLERY_FLASH, writing the
+ *        gallery store takes the NOR flash that holds the network weights
+ *        out of memory-mapped mode.
  */
-static float verify_box(app_context_t *ctx, const pd_pp_box_t *box)
+static void apply_bank_action(app_context_t *ctx)
 {
-    /* Legacy function - just call the new implementation */
-    return run_face_recognition_on_face(ctx, box);
+    if (ctx->bank_action == BANK_ACTION_NEXT) {
+        /* Start enrolling the next identity; nothing happens while the
+         * current one has no template yet or every identity is used */
+        (void)embeddings_bank_next_identity();
+    } else if (ctx->bank_action == BANK_ACTION_CLEAR) {
+        /* Only on this deliberate press: with FACE_GALLERY_FLASH it also
+         * deletes the identities enrolled before the last reboot */
+        embeddings_bank_reset();
+    } else if (ctx->bank_action == BANK_ACTION_ADD) {
+        embeddings_bank_add(ctx->current_embedding);
+    }
+    ctx->bank_action = BANK_ACTION_NONE;
 }
 
+
 /**
  * @brief Initialize application context and neural networks
  * @param ctx Application context
@@ -657,6 +910,9 @@ static int app_init(app_context_t *ctx)
     /* Critical path: System initialization */
     App_SystemInit();
     LL_ATON_RT_RuntimeInit();
+    /* Falls back to the software blitter if the backend cannot start */
+    (void)blit_init(&BLIT_BACKEND);
+    pixel_lut_init();
     
     /* Parallel initialization of independent components */
     /* Initialize embeddings bank */
@@ -678,7 +934,11 @@ static int app_init(app_context_t *ctx)
     
     /* Background initialization - can be done while other systems start */
     Enhanced_PC_STREAM_Init();
-    app_postprocess_init(&ctx->pp_params);
+    ret = app_postprocess_init(&ctx->pp_params);
+    if (ret < 0) {
+        printf("face_detection outputs do not match the CenterFace decoder: %d\n", ret);
+        return ret;
+    }
     
     return 0;
 }
@@ -700,70 +960,114 @@ static void process_frame_detections(app_context_t *ctx, pd_pp_box_t *boxes, uin
     g_cropped_face_valid = false;
     g_current_similarity = 0.0f;
     
-    bool target_found_this_frame = false;
-    float highest_similarity = 0.0f;
-    static float32_t best_embedding[EMBEDDING_SIZE];  /* Store best face embedding */
-    bool best_embedding_valid = false;
+    static recognition_frame_t frame;      /* Embedding too large for the stack */
+    frame.target_found = false;
+    frame.highest_similarity = 0.0f;
+    frame.best_embedding_valid = false;
     
     /* Reset embedding validity at start of frame */
     ctx->embedding_valid = 0;
     
     /* Run face recognition on ALL detected faces */
     if (box_count > 0) {
-        printf("   Running face recognition on %u detected faces\n", box_count);
+        TLOG_DEBUG(TRACE_MSG_RECOG_BATCH, box_count);
         
-        for (uint32_t i = 0; i < box_count; i++) {
-            /* Only run recognition on faces with sufficient detection confidence */
+        /* Only run recognition on faces with sufficient detection confidence */
+        uint32_t queue[AI_PD_MODEL_PP_MAX_BOXES_LIMIT];
+        uint32_t queue_len = 0;
+        for (uint32_t i = 0; i < box_count && queue_len < AI_PD_MODEL_PP_MAX_BOXES_LIMIT; i++) {
             if (boxes[i].prob >= FACE_DETECTION_CONFIDENCE_THRESHOLD) {
-                printf("   Face %u: detection=%.1f%% -> ", i + 1, boxes[i].prob * 100.0f);
-                
-                float similarity = run_face_recognition_on_face(ctx, &boxes[i]);
-                
-                /* Update the box with the recognition similarity (not detection confidence) */
-                boxes[i].prob = similarity;
-                
-                printf("recognition=%.1f%%\n", similarity * 100.0f);
-                
-                /* Check if this face is above threshold */
-                if (similarity >= FACE_SIMILARITY_THRESHOLD) {
-                    target_found_this_frame = true;
-                }
-                
-                /* Track the face with highest similarity for display */
-                if (similarity > highest_similarity) {
-                    highest_similarity = similarity;
-                    ctx->best_detection = boxes[i];
-                    ctx->current_similarity = similarity;
-                    ctx->face_detected = true;
-                    
-                    /* Store for LCD display */
-                    g_cropped_face_valid = true;
-                    g_current_similarity = similarity;
-                    
-                    /* Store best embedding (copy from current_embedding set by run_face_recognition_on_face) */
-                    for (uint32_t j = 0; j < EMBEDDING_SIZE; j++) {
-                        best_embedding[j] = ctx->current_embedding[j];
-                    }
-                    best_embedding_valid = true;
-                }
+                queue[queue_len++] = i;
             } else {
                 /* Face detection confidence too low - skip recognition */
-                printf("   Face %u: detection=%.1f%% (too low, skipping recognition)\n", 
-                       i + 1, boxes[i].prob * 100.0f);
+                TLOG_INFO(TRACE_MSG_FACE_SKIPPED, i + 1, boxes[i].prob * 100.0f);
                 /* Set very low similarity to indicate no recognition */
                 boxes[i].prob = 0.05f;
             }
         }
+        
+        if (queue_len > 0 && !ctx->nn_ctx.recognition_initialized &&
+            nn_init_recognition_lazy(&ctx->nn_ctx) < 0) {
+            TLOG_ERROR(TRACE_MSG_RECOG_INIT_FAILED);
+            queue_len = 0;
+        }
+        
+        /* Software pipeline: while the NPU embeds face q, the CPU stages
+         * face q+1 into the other slot (crops it on the two-pass path) and
+         * scans the gallery index for face q-1, whose result is only taken
+         * then. Results are taken in queue order, exactly as the serial path
+         * did. Without recognition_overlap the next face is only staged, and
+         * each search run to its end, once the inference is done: same slots
+         * and results, no overlap (the reference the host replay compares
+         * against). */
+        uint32_t slot = 0;
+        uint32_t stage_start[2] = {0, 0};
+        int staged = -1;
+        uint32_t pending = queue_len;       /* Face whose search is still open */
+        uint32_t pending_start = 0;
+        if (queue_len > 0) {
+            stage_start[slot] = profiler_now();
+            staged = recognition_stage_face(&boxes[queue[0]], &fr_stage[slot]);
+        }
+        
+        for (uint32_t q = 0; q < queue_len; q++) {
+            bool ran = false;
+            nn_async_run_t run = {0};
+            
+            if (staged == 0 && recognition_load_input(ctx, &fr_stage[slot]) == 0) {
+                RunNetworkAsync_StartResident(&run, &ctx->nn_ctx.recognition_net, NULL, NULL);
+                ran = true;
+            }
+            
+            /* Overlap: stage the next face while the NPU is busy */
+            if (ctx->recognition_overlap && q + 1 < queue_len) {
+                stage_start[slot ^ 1] = profiler_now();
+                staged = recognition_stage_face(&boxes[queue[q + 1]], &fr_stage[slot ^ 1]);
+            }
+            
+            if (ran) {
+                recognition_wait(&run);
+            }
+            if (pending < queue_len) {
+                recognition_take_result(ctx, &frame, boxes, queue[pending], pending_start, true);
+                pending = queue_len;
+            }
+            if (ran) {
+                recognition_finish_face(ctx, &fr_stage[slot]);
+                pending = q;
+                pending_start = stage_start[slot];
+            } else {
+                recognition_take_result(ctx, &frame, boxes, queue[q], stage_start[slot], false);
+            }
+            
+            if (!ctx->recognition_overlap) {
+                if (pending < queue_len) {
+                    recognition_take_result(ctx, &frame, boxes, queue[pending], pending_start, true);
+                    pending = queue_len;
+                }
+                if (q + 1 < queue_len) {
+                    stage_start[slot ^ 1] = profiler_now();
+                    staged = recognition_stage_face(&boxes[queue[q + 1]], &fr_stage[slot ^ 1]);
+                }
+            }
+            
+            slot ^= 1;
+        }
+        
+        /* Last face: no inference left to scan the index behind */
+        if (pending < queue_len) {
+            recognition_take_result(ctx, &frame, boxes, queue[pending], pending_start, true);
+        }
     }
     
     /* Update target detection history */
-    update_target_detection_history(ctx, target_found_this_frame);
+    update_target_detection_history(ctx, frame.target_found);
     compute_target_detection_status(ctx);
     
     /* Store best embedding for button press functionality */
-    if (best_embedding_valid) {
+    if (frame.best_embedding_valid) {
         for (uint32_t i = 0; i < EMBEDDING_SIZE; i++) {
-            ctx->current_embedding[i] = best_embedding[i];
+            ctx->current_embedding[i] = frame.best_embedding[i];
         }
         ctx->embedding_valid = 1;
     }
@@ -771,11 +1075,8 @@ static void process_frame_detections(app_context_t *ctx, pd_pp_box_t *boxes, uin
     /* Set verification status based on voting */
     ctx->face_verified = ctx->target_detected;
     
-    printf("   Frame summary: faces=%u, target_this_frame=%s, target_detected=%s (%.1f%% best)\n",
-           box_count,
-           target_found_this_frame ? "YES" : "NO",
-           ctx->target_detected ? "YES" : "NO",
-           highest_similarity * 100.0f);
+    TLOG_INFO(TRACE_MSG_FRAME_SUMMARY, box_count, frame.target_found,
+              ctx->target_detected, frame.highest_similarity * 100.0f);
 }
 
 /**
@@ -826,6 +1127,28 @@ static void cleanup_nn_buffers(float32_t **nn_out, int32_t *nn_out_len, int numb
     }
 }
 
+/**
+ * @brief Send pending trace log records to the PC as DEBUG_INFO packets
+ * @note  Called while the NPU runs detection, so the UART time overlaps
+ *        inference instead of adding to the frame
+ */
+static void app_trace_flush(void)
+{
+    static uint8_t chunk[1024];
+    static uint32_t dropped_reported;
+    uint32_t dropped = trace_log_dropped();
+    uint32_t size;
+
+    if (dropped != dropped_reported) {
+        TLOG_WARN(TRACE_MSG_DROPPED, dropped - dropped_reported);
+        dropped_reported = dropped;
+    }
+
+    while ((size = trace_log_drain(chunk, sizeof(chunk))) > 0) {
+        Enhanced_PC_STREAM_SendDebugInfo(chunk, size);
+    }
+}
+
 /**
  * @brief Main application loop
  * @param ctx Application context
@@ -884,33 +1207,60 @@ static void cleanup_nn_buffers(float32_t **nn_out, int32_t *nn_out_len, int numb
  */
 static int pipeline_stage_capture_and_preprocess(app_context_t *ctx, uint32_t pitch_nn)
 {
-    printf("PIPELINE STAGE 1: Frame Capture\n");
+    TLOG_DEBUG(TRACE_MSG_STAGE, 1);
     
+    uint8_t *frame;
+    uint32_t stride;
+
     /* Step 1.1: Capture frame from camera or PC stream */
-    if (app_get_frame(nn_rgb, pitch_nn) != 0) {
-        printf("Frame capture failed\n");
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_CAPTURE);
+    if (app_acquire_frame(&frame, &stride, pitch_nn) != 0) {
+        TLOG_ERROR(TRACE_MSG_CAPTURE_FAILED);
         return -1;
     }
-    
+    PROFILER_STAGE_END(PIPELINE_STAGE_CAPTURE);
+
 #ifdef DUMMY_INPUT_BUFFER
     /* Step 1.1.5: Override both img_buffer and nn_rgb with dummy data for testing */
     load_dual_dummy_buffers();
+    frame = nn_rgb;
+    stride = NN_WIDTH * NN_BPP;
 #endif
-    
-    /* Step 1.2: Convert RGB to neural network input format */
-    printf("   Converting RGB to CHW format for neural network...\n");
-    img_rgb_to_chw_float(nn_rgb, (float32_t *)ctx->nn_ctx.detection_input_buffer, 
-                        NN_WIDTH * NN_BPP, NN_WIDTH, NN_HEIGHT);
-    
 
+#ifdef DETECTION_INPUT_UINT8_HWC
+    /* Step 1.2: The frame is the network input: point the NPU at it */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_PREPROCESSING);
+    if (frame == nn_rgb) {
+        /* Written by the CPU (PC stream or dummy data) */
+        SCB_CleanDCache_by_Addr(nn_rgb, NN_WIDTH * NN_HEIGHT * NN_BPP);
+    }
+    if (LL_ATON_Set_User_Input_Buffer_face_detection(0, frame, ctx->nn_ctx.detection_input_length) !=
+        LL_ATON_User_IO_NOERROR) {
+        app_release_frame();
+        TLOG_ERROR(TRACE_MSG_CAPTURE_FAILED);
+        return -1;
+    }
+    ctx->nn_ctx.detection_input_buffer = frame;
+    PROFILER_STAGE_END(PIPELINE_STAGE_PREPROCESSING);
+#else
+    /* Step 1.2: Convert RGB to neural network input format, straight from
+     * the capture buffer, then hand it back so capture never stalls */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_PREPROCESSING);
+    if (frame != nn_rgb) {
+        /* Written by DCMIPP */
+        SCB_InvalidateDCache_by_Addr(frame, stride * NN_HEIGHT);
+    }
+    img_rgb_to_chw_float(frame, (float32_t *)ctx->nn_ctx.detection_input_buffer,
+                         stride, NN_WIDTH, NN_HEIGHT);
+    app_release_frame();
 
     /* Step 1.3: Prepare data for neural network (cache management) */
-    printf("   🧠 Preparing %lu bytes for neural network input...\n", ctx->nn_ctx.detection_input_length);
     SCB_CleanInvalidateDCache_by_Addr(ctx->nn_ctx.detection_input_buffer, 
                                      ctx->nn_ctx.detection_input_length);
+    PROFILER_STAGE_END(PIPELINE_STAGE_PREPROCESSING);
+#endif /* DETECTION_INPUT_UINT8_HWC */
     
-    printf("Frame captured and preprocessed (%dx%d -> %lu bytes)\n", 
-           NN_WIDTH, NN_HEIGHT, ctx->nn_ctx.detection_input_length);
+    TLOG_DEBUG(TRACE_MSG_PREPROCESS_DONE, NN_WIDTH, NN_HEIGHT, ctx->nn_ctx.detection_input_length);
     return 0;
 }
 
@@ -921,20 +1271,45 @@ static int pipeline_stage_capture_and_preprocess(app_context_t *ctx, uint32_t pi
  */
 static int pipeline_stage_face_detection(app_context_t *ctx)
 {
-    printf("🧠 PIPELINE STAGE 2: Face Detection Network\n");
+    TLOG_DEBUG(TRACE_MSG_STAGE, 2);
     
-    /* Step 2.1: Run face detection neural network */
-    printf("   Running face detection neural network inference...\n");
+    /* Step 2.1: Start face detection neural network */
+    nn_async_run_t run = {0};
     uint32_t start_time = HAL_GetTick();
-    RunNetworkSync(&NN_Instance_face_detection);
+    RunNetworkAsync_StartResident(&run, &ctx->nn_ctx.detection_net, NULL, NULL);
+
+    /* Step 2.2: Service UI and PC link while the NPU works. Neither depends
+     * on this frame's detections, so they no longer add to frame time. The
+     * previous frame's trace records go out in the same window. The profiler
+     * counts this work as system update, not detection. */
+    PROFILER_STAGE_END(PIPELINE_STAGE_DETECTION);
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_SYSTEM_UPDATE);
+    handle_user_button(ctx);
+    RunNetworkAsync_Poll(&run);
+    Enhanced_PC_STREAM_SendHeartbeat();
+    RunNetworkAsync_Poll(&run);
+    app_trace_flush();
+    PROFILER_STAGE_END(PIPELINE_STAGE_SYSTEM_UPDATE);
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_DETECTION);
+
+    RunNetworkAsync_Wait(&run);
     uint32_t inference_time = HAL_GetTick() - start_time;
     
-    /* Step 2.2: Network cleanup */
-    printf("   🧹 Cleaning up neural network resources...\n");
-    LL_ATON_RT_DeInit_Network(&NN_Instance_face_detection);
+    /* Enrollment needs the NPU idle (gallery store writes) */
+    PROFILER_STAGE_END(PIPELINE_STAGE_DETECTION);
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_SYSTEM_UPDATE);
+    apply_bank_action(ctx);
+    PROFILER_STAGE_END(PIPELINE_STAGE_SYSTEM_UPDATE);
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_DETECTION);
+#ifdef DETECTION_INPUT_UINT8_HWC
+    /* The input frame has been consumed */
+    app_release_frame();
+#endif
+    
+    /* No DeInit: the network is reset before its next inference */
     
-    printf("Face detection completed in %lu ms (%d outputs ready)\n", 
-           inference_time, ctx->nn_ctx.detection_output_count);
+    TLOG_INFO(TRACE_MSG_DETECTION_DONE, inference_time, ctx->nn_ctx.detection_output_count,
+              run.epoch_blocks, run.wfe_count);
     return 0;
 }
 
@@ -945,30 +1320,31 @@ static int pipeline_stage_face_detection(app_context_t *ctx)
  */
 static int pipeline_stage_postprocessing(app_context_t *ctx)
 {
-    printf("PIPELINE STAGE 3: Post-Processing\n");
+    TLOG_DEBUG(TRACE_MSG_STAGE, 3);
+    
+    /* Clear the display overlay on the blitter while the CPU works */
+    Display_ClearOverlayStart();
     
     /* Step 3.1: Run post-processing to extract bounding boxes */
-    printf("   Processing %d neural network outputs...\n", ctx->nn_ctx.detection_output_count);
     int32_t ret = app_postprocess_run((void **) ctx->nn_ctx.detection_output_buffers, 
                                      ctx->nn_ctx.detection_output_count, 
                                      &ctx->pp_output, &ctx->pp_params);
     if (ret != 0) {
-        printf("Post-processing failed\n");
+        TLOG_ERROR(TRACE_MSG_POSTPROCESS_FAILED);
         return -1;
     }
     
     /* Step 3.2: Extract detected faces */
     pd_pp_box_t *boxes = (pd_pp_box_t *)ctx->pp_output.pOutData;
-    printf("   Extracted %d face bounding boxes\n", ctx->pp_output.box_nb);
     
     /* Step 3.3: Log detection details for educational purposes */
     for (uint32_t i = 0; i < ctx->pp_output.box_nb && i < 3; i++) {
-        printf("   Face %d: confidence=%.3f, center=(%.2f,%.2f), size=%.2fx%.2f\n", 
-               i + 1, boxes[i].prob, boxes[i].x_center, boxes[i].y_center, 
-               boxes[i].width, boxes[i].height);
+        TLOG_DEBUG(TRACE_MSG_PP_BOX, i + 1, boxes[i].prob, boxes[i].x_center,
+                   boxes[i].y_center, boxes[i].width, boxes[i].height);
     }
+    (void)boxes;
     
-    printf("Post-processing completed: %d faces detected\n", ctx->pp_output.box_nb);
+    TLOG_INFO(TRACE_MSG_POSTPROCESS_DONE, ctx->pp_output.box_nb);
     
     return 0;
 }
@@ -980,7 +1356,7 @@ static int pipeline_stage_postprocessing(app_context_t *ctx)
  */
 static int pipeline_stage_face_recognition(app_context_t *ctx)
 {
-    printf("PIPELINE STAGE 4: Face Recognition\n");
+    TLOG_DEBUG(TRACE_MSG_STAGE, 4);
     
     /* Step 4.1: Process all detected faces with recognition */
     pd_pp_box_t *boxes = (pd_pp_box_t *)ctx->pp_output.pOutData;
@@ -988,12 +1364,10 @@ static int pipeline_stage_face_recognition(app_context_t *ctx)
     
     /* Step 4.2: Log recognition results */
     if (ctx->face_detected) {
-        printf("Face recognition: detected=%s, verified=%s, best_similarity=%.1f%%\n",
-               ctx->face_detected ? "YES" : "NO",
-               ctx->face_verified ? "YES" : "NO",
-               ctx->current_similarity * 100.0f);
+        TLOG_INFO(TRACE_MSG_RECOG_RESULT, ctx->face_detected, ctx->face_verified,
+                  ctx->current_similarity * 100.0f);
     } else {
-        printf("ℹ️ No faces above threshold detected\n");
+        TLOG_INFO(TRACE_MSG_NO_FACE);
     }
     
     return 0;
@@ -1006,18 +1380,15 @@ static int pipeline_stage_face_recognition(app_context_t *ctx)
  */
 static int pipeline_stage_system_update(app_context_t *ctx)
 {
-    printf("PIPELINE STAGE 5: System Status Update\n");
+    TLOG_DEBUG(TRACE_MSG_STAGE, 5);
     
     /* Step 5.1: Update LED status based on recognition results */
     update_led_status(ctx);
     
-    /* Step 5.2: Handle user button interactions */
-    handle_user_button(ctx);
+    /* User button, PC heartbeat, trace flush and enrollment are serviced
+     * around the detection inference (see pipeline_stage_face_detection);
+     * their time is counted in this stage */
     
-    /* Step 5.3: Send heartbeat for PC communication */
-    Enhanced_PC_STREAM_SendHeartbeat();
-    
-    printf("System status updated\n");
     return 0;
 }
 
@@ -1030,7 +1401,7 @@ static int pipeline_stage_system_update(app_context_t *ctx)
  */
 static int pipeline_stage_output_and_metrics(app_context_t *ctx, uint32_t frame_start_time, uint32_t boot_time)
 {
-    printf("PIPELINE STAGE 6: Output and Metrics\n");
+    TLOG_DEBUG(TRACE_MSG_STAGE, 6);
     
     /* Step 6.1: Calculate performance metrics */
     uint32_t frame_end_time = HAL_GetTick();
@@ -1042,6 +1413,17 @@ static int pipeline_stage_output_and_metrics(app_context_t *ctx, uint32_t frame_
     ctx->performance.frame_count = ctx->frame_count;
     ctx->performance.detection_count = ctx->pp_output.box_nb;
     
+    /* Setup cost avoided this frame by resetting instead of re-initialising */
+    uint32_t saved = NN_Network_SavedCycles(&ctx->nn_ctx.detection_net) +
+                     NN_Network_SavedCycles(&ctx->nn_ctx.recognition_net);
+    ctx->performance.nn_setup_cycles_saved = saved - ctx->nn_ctx.saved_cycles_reported;
+    ctx->nn_ctx.saved_cycles_reported = saved;
+#if INPUT_SRC_MODE == INPUT_SRC_CAMERA
+    frame_dbuf_stats_t dbuf_stats;
+    frame_dbuf_get_stats(&nn_pipe_dbuf, &dbuf_stats);
+    ctx->performance.frames_dropped = dbuf_stats.frames_dropped;
+#endif
+    
     /* Step 6.2: Display results */
     app_output(&ctx->pp_output, total_frame_time, boot_time, ctx);
     
@@ -1050,19 +1432,22 @@ static int pipeline_stage_output_and_metrics(app_context_t *ctx, uint32_t frame_
                       ctx->nn_ctx.detection_output_lengths, 
                       ctx->nn_ctx.detection_output_count);
     
-    printf("Frame processing completed: %.1f FPS, %lu ms total\n", 
-           ctx->performance.fps, total_frame_time);
-    printf("═══════════════════════════════════════════════════════════\n");
+    TLOG_INFO(TRACE_MSG_FRAME_DONE, ctx->performance.fps, total_frame_time,
+              ctx->performance.frames_dropped);
+    TLOG_DEBUG(TRACE_MSG_NPU_SAVED, ctx->performance.nn_setup_cycles_saved,
+               ctx->nn_ctx.detection_net.reset_count + ctx->nn_ctx.recognition_net.reset_count,
+               ctx->nn_ctx.detection_net.init_count + ctx->nn_ctx.recognition_net.init_count);
     
     return 0;
 }
 
 /**
- * @brief Educational Pipeline Main Loop - Clear Stage-by-Stage Processing
+ * @brief Bring up input, display, profiler and trace log before the first frame
  * @param ctx Application context
+ * @param pitch_nn Output: NN pipe line pitch in bytes
  * @return 0 on success, negative on error
  */
-static int app_main_loop(app_context_t *ctx)
+static int app_pipeline_start(app_context_t *ctx, uint32_t *pitch_nn)
 {
     /* Verify at least detection network is initialized */
     if (!ctx->nn_ctx.detection_initialized) {
@@ -1070,58 +1455,119 @@ static int app_main_loop(app_context_t *ctx)
         return -1;
     }
     
-    uint32_t pitch_nn = 0;
-
+    *pitch_nn = 0;
     
     /* Initialize camera and display systems */
     printf("Initializing Camera and Display Systems\n");
-    app_camera_init(&pitch_nn);
+    app_camera_init(pitch_nn);
+#if INPUT_SRC_MODE == INPUT_SRC_CAMERA
+    /* Kernels follow any pitch, but the capture buffers are sized for DCMIPP_OUT_NN_PITCH */
+    if (*pitch_nn < NN_WIDTH * NN_BPP || *pitch_nn > DCMIPP_OUT_NN_PITCH) {
+        printf("NN pipe pitch %lu outside %d..%d\n", (unsigned long)*pitch_nn, NN_WIDTH * NN_BPP, DCMIPP_OUT_NN_PITCH);
+        return -1;
+    }
+#ifdef DETECTION_INPUT_UINT8_HWC
+    /* Captured frames are the detection input and must be packed HWC */
+    if (*pitch_nn != NN_WIDTH * NN_BPP) {
+        printf("NN pipe pitch %lu does not match the detection input\n", *pitch_nn);
+        return -1;
+    }
+#endif
+#endif
     app_display_init();
     app_input_start();
+    profiler_init();
+    trace_log_init();
     printf("Systems initialized, starting pipeline\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
-    uint32_t boot_time = HAL_GetTick();
+    return 0;
+}
 
-    /* Main processing loop with clear pipeline stages */
-    while (1) {
-        uint32_t frame_start_time = HAL_GetTick();
-        printf("STARTING FRAME %lu PROCESSING PIPELINE\n", ctx->frame_count + 1);
+/**
+ * @brief Run the six pipeline stages on one frame
+ * @param ctx Application context
+ * @param pitch_nn Neural network pitch value
+ * @param boot_time System boot time
+ * @return 0 on success, negative if a stage failed and the frame was skipped
+ */
+static int app_process_frame(app_context_t *ctx, uint32_t pitch_nn, uint32_t boot_time)
+{
+    uint32_t frame_start_time = HAL_GetTick();
+    PROFILER_FRAME_BEGIN();
+    TLOG_INFO(TRACE_MSG_FRAME_START, ctx->frame_count + 1);
 
-        /* Stage 1: Frame Capture and Preprocessing */
-        if (pipeline_stage_capture_and_preprocess(ctx, pitch_nn) != 0) {
-            continue; /* Skip this frame on error */
-        }
-        //HINT: for dummy input the first elements of (float32_t *)ctx->nn_ctx.detection_input_buffer should look like: {206, 209, 211, 212, 213, 213, 214, 214, 214, 214, 213 <repeats 14 times>, 212, 212, 211, 208, 207, 204, 199, 193, 189, 182, 174, 163, 151, 139, 129, 119, 110, 104, 104, 106, 108, 114, 121, 126, 132, 137, 140, 141, 147, 152, 152, 152, 153, 153, 154, 154, 154, 154, 153, 151, 152, 152, 151, 150, 149, 149, 147, 146, 142, 135, 126, 114, 107, 97, 87, 73, 60, 47, 32, 19, 12, 14, 19, 26, 32, 37, 42, 52, 60, 63, 67, 70, 70, 71, 72, 72}
+    /* Stage 1: Frame Capture and Preprocessing */
+    if (pipeline_stage_capture_and_preprocess(ctx, pitch_nn) != 0) {
+        return -1; /* Skip this frame on error */
+    }
+    //HINT: for dummy input the first elements of (float32_t *)ctx->nn_ctx.detection_input_buffer should look like: {206, 209, 211, 212, 213, 213, 214, 214, 214, 214, 213 <repeats 14 times>, 212, 212, 211, 208, 207, 204, 199, 193, 189, 182, 174, 163, 151, 139, 129, 119, 110, 104, 104, 106, 108, 114, 121, 126, 132, 137, 140, 141, 147, 152, 152, 152, 153, 153, 154, 154, 154, 154, 153, 151, 152, 152, 151, 150, 149, 149, 147, 146, 142, 135, 126, 114, 107, 97, 87, 73, 60, 47, 32, 19, 12, 14, 19, 26, 32, 37, 42, 52, 60, 63, 67, 70, 70, 71, 72, 72}
 
-        /* Stage 2: Face Detection Neural Network */
-        if (pipeline_stage_face_detection(ctx) != 0) {
-            continue; /* Skip this frame on error */
-        }
-        
-        //HINT: for dummy input the first elements of ctx->nn_ctx.detection_output_buffers[0] should look like: {1.89764965, 1.77754533, 1.62140954, 1.64543045, 1.68146181, 1.68146181, 1.92167056...}
+    /* Stage 2: Face Detection Neural Network */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_DETECTION);
+    if (pipeline_stage_face_detection(ctx) != 0) {
+        return -2; /* Skip this frame on error */
+    }
+    PROFILER_STAGE_END(PIPELINE_STAGE_DETECTION);
+    
+    //HINT: for dummy input the first elements of ctx->nn_ctx.detection_output_buffers[0] should look like: {1.89764965, 1.77754533, 1.62140954, 1.64543045, 1.68146181, 1.68146181, 1.92167056...}
 
-        /* Stage 3: Post-Processing and Face Extraction */
-        if (pipeline_stage_postprocessing(ctx) != 0) {
-            continue; /* Skip this frame on error */
-        }
-        
-        //HINT: for dummy input the cctx->pp_output->pOutData.x_center = 0.5113132 ctx->pp_output->pOutData.y_center = 0.543815017
+    /* Stage 3: Post-Processing and Face Extraction */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_POSTPROCESSING);
+    if (pipeline_stage_postprocessing(ctx) != 0) {
+        return -3; /* Skip this frame on error */
+    }
+    PROFILER_STAGE_END(PIPELINE_STAGE_POSTPROCESSING);
+    
+    //HINT: for dummy input the cctx->pp_output->pOutData.x_center = 0.5113132 ctx->pp_output->pOutData.y_center = 0.543815017
 
-        /* Stage 4: Face Recognition and Verification */
-        if (pipeline_stage_face_recognition(ctx) != 0) {
-            continue; /* Skip this frame on error */
-        }
-        
-        /* Stage 5: System Status Update */
-        if (pipeline_stage_system_update(ctx) != 0) {
-            continue; /* Skip this frame on error */
-        }
-        
-        /* Stage 6: Output and Performance Metrics */
-        if (pipeline_stage_output_and_metrics(ctx, frame_start_time, boot_time) != 0) {
-            continue; /* Skip this frame on error */
-        }
+    /* Stage 4: Face Recognition and Verification */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_RECOGNITION);
+    if (pipeline_stage_face_recognition(ctx) != 0) {
+        return -4; /* Skip this frame on error */
+    }
+    PROFILER_STAGE_END(PIPELINE_STAGE_RECOGNITION);
+    
+    /* Stage 5: System Status Update */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_SYSTEM_UPDATE);
+    if (pipeline_stage_system_update(ctx) != 0) {
+        return -5; /* Skip this frame on error */
+    }
+    PROFILER_STAGE_END(PIPELINE_STAGE_SYSTEM_UPDATE);
+    
+    /* Stage 6: Output and Performance Metrics */
+    PROFILER_STAGE_BEGIN(PIPELINE_STAGE_OUTPUT);
+    if (pipeline_stage_output_and_metrics(ctx, frame_start_time, boot_time) != 0) {
+        return -6; /* Skip this frame on error */
+    }
+    PROFILER_STAGE_END(PIPELINE_STAGE_OUTPUT);
+    
+    PROFILER_FRAME_END(&ctx->timing);
+    if ((ctx->frame_count % PERFORMANCE_UPDATE_INTERVAL) == 0) {
+        PROFILER_REPORT();
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Educational Pipeline Main Loop - Clear Stage-by-Stage Processing
+ * @param ctx Application context
+ * @return 0 on success, negative on error
+ */
+static int app_main_loop(app_context_t *ctx)
+{
+    uint32_t pitch_nn;
+    
+    if (app_pipeline_start(ctx, &pitch_nn) != 0) {
+        return -1;
+    }
+    
+    uint32_t boot_time = HAL_GetTick();
+
+    /* Main processing loop with clear pipeline stages */
+    while (1) {
+        app_process_frame(ctx, pitch_nn, boot_time);
     }
     
     return 0;
@@ -1,16 +1,147 @@
 #include "nn_runner.h"
 #include "ll_aton.h"
+#include "pipeline_profiler.h"
+
+static void async_start(nn_async_run_t *run, NN_Instance_TypeDef *inst,
+                        nn_run_done_cb_t on_done, void *user)
+{
+  run->inst = inst;
+  run->on_done = on_done;
+  run->user = user;
+  run->epoch_blocks = 0;
+  run->wfe_count = 0;
+  run->state = NN_RUN_BUSY;
+
+  /* Kick the first epoch block so the NPU starts working immediately */
+  RunNetworkAsync_Poll(run);
+}
 
 void RunNetworkSync(NN_Instance_TypeDef *inst)
 {
+  nn_async_run_t run = {0};
+
+  RunNetworkAsync_Start(&run, inst, NULL, NULL);
+  RunNetworkAsync_Wait(&run);
+}
+
+void RunNetworkSyncResident(nn_network_t *net)
+{
+  nn_async_run_t run = {0};
+
+  RunNetworkAsync_StartResident(&run, net, NULL, NULL);
+  RunNetworkAsync_Wait(&run);
+}
+
+void NN_Network_Bind(nn_network_t *net, NN_Instance_TypeDef *inst)
+{
+  net->inst = inst;
+  net->initialized = 0;
+  net->init_count = 0;
+  net->reset_count = 0;
+  net->init_cycles = 0;
+  net->reset_cycles = 0;
+  net->saved_cycles = 0;
+}
+
+void NN_Network_Prepare(nn_network_t *net)
+{
+  uint32_t start = profiler_now();
+
+  if (!net->initialized)
+  {
+    LL_ATON_RT_Init_Network(net->inst);
+    net->init_cycles = profiler_now() - start;
+    net->init_count++;
+    net->initialized = 1;
+  }
+  else
+  {
+    LL_ATON_RT_Reset_Network(net->inst);
+    net->reset_cycles = profiler_now() - start;
+    net->reset_count++;
+    if (net->init_cycles > net->reset_cycles)
+    {
+      net->saved_cycles += net->init_cycles - net->reset_cycles;
+    }
+  }
+}
+
+void NN_Network_Release(nn_network_t *net)
+{
+  if (net->initialized)
+  {
+    LL_ATON_RT_DeInit_Network(net->inst);
+    net->initialized = 0;
+  }
+}
+
+uint32_t NN_Network_SavedCycles(const nn_network_t *net)
+{
+  return net->saved_cycles;
+}
+
+int RunNetworkAsync_Start(nn_async_run_t *run, NN_Instance_TypeDef *inst,
+                          nn_run_done_cb_t on_done, void *user)
+{
+  if (run->state == NN_RUN_BUSY)
+  {
+    return -1;
+  }
+
   LL_ATON_RT_Init_Network(inst);
+  async_start(run, inst, on_done, user);
+  return 0;
+}
+
+int RunNetworkAsync_StartResident(nn_async_run_t *run, nn_network_t *net,
+                                  nn_run_done_cb_t on_done, void *user)
+{
+  if (run->state == NN_RUN_BUSY)
+  {
+    return -1;
+  }
+
+  NN_Network_Prepare(net);
+  async_start(run, net->inst, on_done, user);
+  return 0;
+}
+
+nn_run_state_t RunNetworkAsync_Poll(nn_async_run_t *run)
+{
   LL_ATON_RT_RetValues_t st;
+
+  if (run->state != NN_RUN_BUSY)
+  {
+    return run->state;
+  }
+
   do
   {
-    st = LL_ATON_RT_RunEpochBlock(inst);
-    if (st == LL_ATON_RT_WFE)
+    st = LL_ATON_RT_RunEpochBlock(run->inst);
+    if (st == LL_ATON_RT_NO_WFE)
     {
-      LL_ATON_OSAL_WFE();
+      run->epoch_blocks++;
     }
-  } while (st != LL_ATON_RT_DONE);
+  } while (st == LL_ATON_RT_NO_WFE);
+
+  if (st == LL_ATON_RT_WFE)
+  {
+    run->wfe_count++;
+    return NN_RUN_BUSY;
+  }
+
+  run->state = NN_RUN_DONE;
+  if (run->on_done)
+  {
+    run->on_done(run, run->user);
+  }
+  return NN_RUN_DONE;
+}
+
+void RunNetworkAsync_Wait(nn_async_run_t *run)
+{
+  while (RunNetworkAsync_Poll(run) == NN_RUN_BUSY)
+  {
+    LL_ATON_OSAL_WFE();
+  }
 }
@@ -0,0 +1,200 @@
+/**
+ ******************************************************************************
+ * @file    pipeline_profiler.c
+ * @author  PeleAB
+ * @brief   Per-stage cycle profiler for the frame processing pipeline
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "pipeline_profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__ARM_ARCH)
+#include "stm32n6xx.h"
+#else
+#include <time.h>
+#endif
+
+/* ========================================================================= */
+/* PRIVATE DATA                                                              */
+/* ========================================================================= */
+
+/** @brief One rolling window per stage, plus one for the whole frame */
+#define PROFILER_SERIES_COUNT               (PIPELINE_STAGE_COUNT + 1)
+
+static const char *const stage_names[PROFILER_SERIES_COUNT] = {
+    "capture", "preprocess", "detection", "tracking", "recognition",
+    "postprocess", "output", "system", "frame"
+};
+
+static uint32_t window[PROFILER_SERIES_COUNT][PROFILER_WINDOW_SIZE];  /**< Rolling samples (ticks) */
+static uint32_t window_pos;                                          /**< Next write index */
+static uint32_t window_count;                                        /**< Valid samples */
+static uint32_t stage_start[PIPELINE_STAGE_COUNT];                   /**< Open stage start */
+static uint32_t stage_accum[PIPELINE_STAGE_COUNT];                   /**< Current frame totals */
+static uint32_t frame_start;                                         /**< Current frame start */
+
+/* ========================================================================= */
+/* TIME SOURCE                                                               */
+/* ========================================================================= */
+
+void profiler_init(void)
+{
+#if defined(__ARM_ARCH)
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    memset(window, 0, sizeof(window));
+    window_pos = 0;
+    window_count = 0;
+    memset(stage_accum, 0, sizeof(stage_accum));
+}
+
+uint32_t profiler_now(void)
+{
+#if defined(__ARM_ARCH)
+    return DWT->CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+uint32_t profiler_tick_rate(void)
+{
+#if defined(__ARM_ARCH)
+    return SystemCoreClock;
+#else
+    return 1000000000U;
+#endif
+}
+
+uint32_t profiler_ticks_to_us(uint32_t ticks)
+{
+    return ticks / (profiler_tick_rate() / 1000000U);
+}
+
+/* ========================================================================= */
+/* RECORDING                                                                 */
+/* ========================================================================= */
+
+void profiler_frame_begin(void)
+{
+    memset(stage_accum, 0, sizeof(stage_accum));
+    frame_start = profiler_now();
+}
+
+void profiler_stage_begin(pipeline_stage_t stage)
+{
+    if (stage < PIPELINE_STAGE_COUNT) {
+        stage_start[stage] = profiler_now();
+    }
+}
+
+void profiler_stage_end(pipeline_stage_t stage)
+{
+    if (stage < PIPELINE_STAGE_COUNT) {
+        stage_accum[stage] += profiler_now() - stage_start[stage];
+    }
+}
+
+void profiler_frame_end(pipeline_timing_t *timing)
+{
+    uint32_t total = profiler_now() - frame_start;
+
+    for (uint32_t s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        window[s][window_pos] = stage_accum[s];
+    }
+    window[PIPELINE_STAGE_COUNT][window_pos] = total;
+    window_pos = (window_pos + 1) % PROFILER_WINDOW_SIZE;
+    if (window_count < PROFILER_WINDOW_SIZE) {
+        window_count++;
+    }
+
+    if (timing) {
+        memcpy(timing->stage_times, stage_accum, sizeof(timing->stage_times));
+        timing->total_time = total;
+        timing->timestamp = frame_start;
+    }
+}
+
+/* ========================================================================= */
+/* REPORTING                                                                 */
+/* ========================================================================= */
+
+/**
+ * @brief Insertion sort; the window is small and this avoids qsort callbacks
+ */
+static void sort_u32(uint32_t *v, uint32_t n)
+{
+    for (uint32_t i = 1; i < n; i++) {
+        uint32_t key = v[i];
+        uint32_t j = i;
+        while (j > 0 && v[j - 1] > key) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = key;
+    }
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted array
+ */
+static uint32_t percentile(const uint32_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = (pct * n + 99U) / 100U;
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+int profiler_get_summary(pipeline_stage_t stage, profiler_summary_t *summary)
+{
+    static uint32_t sorted[PROFILER_WINDOW_SIZE];
+
+    if (!summary || (uint32_t)stage > PIPELINE_STAGE_COUNT) {
+        return -1;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    if (window_count == 0) {
+        return 0;
+    }
+
+    memcpy(sorted, window[stage], window_count * sizeof(uint32_t));
+    sort_u32(sorted, window_count);
+
+    summary->p50_us = profiler_ticks_to_us(percentile(sorted, window_count, 50));
+    summary->p95_us = profiler_ticks_to_us(percentile(sorted, window_count, 95));
+    summary->p99_us = profiler_ticks_to_us(percentile(sorted, window_count, 99));
+    summary->max_us = profiler_ticks_to_us(sorted[window_count - 1]);
+    summary->samples = window_count;
+    return 0;
+}
+
+void profiler_report(void)
+{
+    profiler_summary_t sum;
+
+    printf("Stage profile over last %lu frames (us):\n", (unsigned long)window_count);
+    printf("   %-12s %8s %8s %8s %8s\n", "stage", "p50", "p95", "p99", "max");
+    for (uint32_t s = 0; s < PROFILER_SERIES_COUNT; s++) {
+        if (profiler_get_summary((pipeline_stage_t)s, &sum) != 0 || sum.max_us == 0) {
+            continue; /* Stage not instrumented */
+        }
+        printf("   %-12s %8lu %8lu %8lu %8lu\n", stage_names[s],
+               (unsigned long)sum.p50_us, (unsigned long)sum.p95_us,
+               (unsigned long)sum.p99_us, (unsigned long)sum.max_us);
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ ******************************************************************************
+ * @file    pixel_lut.c
+ * @author  PeleAB
+ * @brief   Lookup tables for RGB565 expansion, gray conversion and input
+ *          normalization
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ *
+ * The linker script places .rodata and .bss in AXISRAM1 with the code, so
+ * both the const and the RAM tables are read from on-chip SRAM.
+ */
+
+#include "pixel_lut.h"
+
+/* ========================================================================= */
+/* TABLE ENTRIES                                                             */
+/* ========================================================================= */
+
+#define PIXEL_LUT_SHL3(v)                   ((uint8_t)((v) << 3))
+#define PIXEL_LUT_SHL2(v)                   ((uint8_t)((v) << 2))
+#define PIXEL_LUT_REP5(v)                   (((v) << 3) | ((v) >> 2))
+#define PIXEL_LUT_REP6(v)                   (((v) << 2) | ((v) >> 4))
+#define PIXEL_LUT_GRAY_R(v)                 ((uint16_t)(30U * PIXEL_LUT_REP5(v)))
+#define PIXEL_LUT_GRAY_G(v)                 ((uint16_t)(59U * PIXEL_LUT_REP6(v)))
+#define PIXEL_LUT_GRAY_B(v)                 ((uint16_t)(11U * PIXEL_LUT_REP5(v)))
+
+/* Rounded as crop_img.c computes it: GCC contracts p * scale - 1 to an FMA
+ * where the FPU has one, and constant folding must do the same */
+#ifdef __FP_FAST_FMAF
+#define PIXEL_LUT_NORM(v)                   __builtin_fmaf((float)(v), 1.0f / 127.5f, -1.0f)
+#else
+#define PIXEL_LUT_NORM(v)                   ((float)(v) * (1.0f / 127.5f) - 1.0f)
+#endif
+
+#ifdef PIXEL_LUT_CONST
+
+/* ========================================================================= */
+/* CONST TABLES                                                              */
+/* ========================================================================= */
+
+#define PIXEL_LUT_X4(f, v)                  f((v) + 0U), f((v) + 1U), f((v) + 2U), f((v) + 3U)
+#define PIXEL_LUT_X16(f, v)                 PIXEL_LUT_X4(f, (v) + 0U), PIXEL_LUT_X4(f, (v) + 4U), \
+                                            PIXEL_LUT_X4(f, (v) + 8U), PIXEL_LUT_X4(f, (v) + 12U)
+#define PIXEL_LUT_X32(f)                    PIXEL_LUT_X16(f, 0U), PIXEL_LUT_X16(f, 16U)
+#define PIXEL_LUT_X64(f)                    PIXEL_LUT_X32(f), PIXEL_LUT_X16(f, 32U), PIXEL_LUT_X16(f, 48U)
+#define PIXEL_LUT_X256(f)                   PIXEL_LUT_X64(f), \
+                                            PIXEL_LUT_X16(f, 64U), PIXEL_LUT_X16(f, 80U), \
+                                            PIXEL_LUT_X16(f, 96U), PIXEL_LUT_X16(f, 112U), \
+                                            PIXEL_LUT_X16(f, 128U), PIXEL_LUT_X16(f, 144U), \
+                                            PIXEL_LUT_X16(f, 160U), PIXEL_LUT_X16(f, 176U), \
+                                            PIXEL_LUT_X16(f, 192U), PIXEL_LUT_X16(f, 208U), \
+                                            PIXEL_LUT_X16(f, 224U), PIXEL_LUT_X16(f, 240U)
+
+const uint8_t pixel_lut_565_r[32] = { PIXEL_LUT_X32(PIXEL_LUT_SHL3) };
+const uint8_t pixel_lut_565_g[64] = { PIXEL_LUT_X64(PIXEL_LUT_SHL2) };
+
+const uint16_t pixel_lut_gray_r[32] = { PIXEL_LUT_X32(PIXEL_LUT_GRAY_R) };
+const uint16_t pixel_lut_gray_g[64] = { PIXEL_LUT_X64(PIXEL_LUT_GRAY_G) };
+const uint16_t pixel_lut_gray_b[32] = { PIXEL_LUT_X32(PIXEL_LUT_GRAY_B) };
+
+const float pixel_lut_norm[256] = { PIXEL_LUT_X256(PIXEL_LUT_NORM) };
+
+void pixel_lut_init(void)
+{
+}
+
+#else /* !PIXEL_LUT_CONST */
+
+/* ========================================================================= */
+/* RAM TABLES                                                                */
+/* ========================================================================= */
+
+uint8_t pixel_lut_565_r[32];
+uint8_t pixel_lut_565_g[64];
+
+uint16_t pixel_lut_gray_r[32];
+uint16_t pixel_lut_gray_g[64];
+uint16_t pixel_lut_gray_b[32];
+
+float pixel_lut_norm[256];
+
+void pixel_lut_init(void)
+{
+    for (uint32_t v = 0; v < 64U; v++) {
+        pixel_lut_565_g[v] = PIXEL_LUT_SHL2(v);
+        pixel_lut_gray_g[v] = PIXEL_LUT_GRAY_G(v);
+        if (v < 32U) {
+            pixel_lut_565_r[v] = PIXEL_LUT_SHL3(v);
+            pixel_lut_gray_r[v] = PIXEL_LUT_GRAY_R(v);
+            pixel_lut_gray_b[v] = PIXEL_LUT_GRAY_B(v);
+        }
+    }
+    for (uint32_t v = 0; v < 256U; v++) {
+        pixel_lut_norm[v] = PIXEL_LUT_NORM(v);
+    }
+}
+
+#endif /* PIXEL_LUT_CONST */
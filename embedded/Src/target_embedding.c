@@ -1,97 +1,165 @@
 /**
  ******************************************************************************
  * @file    target_embedding.c
- * @brief   Target embedding management functions
+ * @brief   Enrollment of face templates into the recognition gallery
  ******************************************************************************
  */
 
 #include "target_embedding.h"
 #include <string.h>
-#include <math.h>
+#ifdef FACE_GALLERY_FLASH
+#include "gallery_store.h"
+#endif
+#ifdef FACE_GALLERY_INDEX
+#include <stdio.h>
+#include "gallery_index.h"
+#endif
 
 /* ========================================================================= */
 /* GLOBAL VARIABLES                                                          */
 /* ========================================================================= */
 
-float target_embedding[EMBEDDING_SIZE];                                /**< Current target embedding (averaged) */
-static float embedding_bank[EMBEDDING_BANK_SIZE][EMBEDDING_SIZE];     /**< Bank of stored embeddings */
-static int bank_count = 0;                                            /**< Current number of embeddings in bank */
+#define BANK_CAPACITY (EMBEDDING_BANK_SIZE * EMBEDDING_BANK_IDENTITIES)
+
+/* Identities the device can enroll itself are numbered below this */
+#ifdef FACE_GALLERY_FLASH
+#define ENROLLED_IDENTITY_LIMIT GALLERY_STORE_MAX_IDENTITIES
+#else
+#define ENROLLED_IDENTITY_LIMIT EMBEDDING_BANK_IDENTITIES
+#endif
+
+#ifdef FACE_GALLERY_FLASH
+static gallery_store_t gallery_store;                                         /**< Enrolled identities, in flash */
+#else
+static face_gallery_t face_gallery;                                           /**< Enrolled identities */
+#ifdef FACE_GALLERY_Q7
+static int8_t gallery_templates[FACE_GALLERY_STORAGE_Q7(BANK_CAPACITY)];      /**< Template storage */
+static float gallery_scale[BANK_CAPACITY];                                    /**< Scale of each template */
+#else
+static float gallery_templates[FACE_GALLERY_STORAGE_FLOATS(BANK_CAPACITY)];   /**< Template storage */
+#endif
+static uint16_t gallery_identity[BANK_CAPACITY];                              /**< Owner of each template */
+#endif /* FACE_GALLERY_FLASH */
+#ifdef FACE_GALLERY_INDEX
+static gallery_index_t gallery_index;                                         /**< Identities indexed offline */
+static int index_ready = 0;                                                   /**< Opened, identities apart */
+static gallery_index_search_t index_search;                                   /**< Its search state */
+static int index_searching = 0;                                               /**< index_search begun */
+static face_gallery_match_t index_match[GALLERY_INDEX_SHORTLIST];             /**< Its matches */
+__attribute__ ((section (".psram_bss")))
+__attribute__((aligned (32)))
+static uint8_t index_image[GALLERY_INDEX_MAX_SIZE];                           /**< Image copied from flash */
+#endif
+static float32_t search_query[EMBEDDING_SIZE];                                /**< Face being searched */
+static int search_begun = 0;                                                  /**< Not ended yet */
+static int enroll_identity = 0;                                               /**< Identity being enrolled */
+static int bank_count = 0;                                                    /**< Its number of templates */
 
 /* ========================================================================= */
 /* IMPLEMENTATION FUNCTIONS                                                  */
 /* ========================================================================= */
 
+#ifdef FACE_GALLERY_INDEX
 /**
- * @brief Compute the target embedding as average of all embeddings in bank
- * @note This function is called automatically when embeddings are added
+ * @brief Copy the index image from the NOR flash to PSRAM and open it; the
+ *        search skips the index if there is none, it is corrupt, or its
+ *        identities could be confused with enrolled ones
  */
-
-static void compute_target(void)
+static void embeddings_index_load(void)
 {
-    if (bank_count == 0)
-    {
-        memset(target_embedding, 0, sizeof(target_embedding));
+    const gallery_index_header_t *pHeader = (const gallery_index_header_t *)GALLERY_INDEX_ADDRESS;
+
+    index_ready = 0;
+    if (pHeader->magic != GALLERY_INDEX_MAGIC || pHeader->size > sizeof(index_image)) {
         return;
     }
-    float sum[EMBEDDING_SIZE];
-    memset(sum, 0, sizeof(sum));
-    for (int n = 0; n < bank_count; n++)
-    {
-        for (int i = 0; i < EMBEDDING_SIZE; i++)
-        {
-            sum[i] += embedding_bank[n][i];
-        }
-    }
-    for (int i = 0; i < EMBEDDING_SIZE; i++)
-    {
-        target_embedding[i] = sum[i] / (float)bank_count;
-    }
-    float norm = 0.f;
-    for (int i = 0; i < EMBEDDING_SIZE; i++)
-    {
-        norm += target_embedding[i] * target_embedding[i];
-    }
-    norm = sqrtf(norm);
-    if (norm > 0.f)
-    {
-        for (int i = 0; i < EMBEDDING_SIZE; i++)
-        {
-            target_embedding[i] /= norm;
-        }
+    memcpy(index_image, pHeader, pHeader->size);
+    if (gallery_index_open(&gallery_index, index_image, pHeader->size) != GALLERY_INDEX_OK)
+        return;
+    /* Matches of both galleries are merged by identity number */
+    if (gallery_index.identity_min < ENROLLED_IDENTITY_LIMIT) {
+        printf("Gallery index identities %u..%u overlap the enrolled ones (below %u): not searched\n",
+               (unsigned int)gallery_index.identity_min, (unsigned int)gallery_index.identity_max,
+               (unsigned int)ENROLLED_IDENTITY_LIMIT);
+        return;
     }
+    index_ready = 1;
 }
+#endif
 
 void embeddings_bank_init(void)
 {
+#ifdef FACE_GALLERY_FLASH
+    /* Identities enrolled before the reboot are kept; enrollment continues
+     * with a new one */
+    (void)gallery_store_mount(&gallery_store, &GALLERY_FLASH, GALLERY_STORE_SECTORS);
+    enroll_identity = gallery_store_next_identity(&gallery_store);
+#else
+#ifdef FACE_GALLERY_Q7
+    (void)face_gallery_init_q7(&face_gallery, gallery_templates, gallery_scale, gallery_identity,
+                               BANK_CAPACITY);
+#else
+    (void)face_gallery_init(&face_gallery, gallery_templates, gallery_identity, BANK_CAPACITY);
+#endif
+    enroll_identity = 0;
+#endif /* FACE_GALLERY_FLASH */
+#ifdef FACE_GALLERY_INDEX
+    embeddings_index_load();
+#endif
     bank_count = 0;
-    memset(embedding_bank, 0, sizeof(embedding_bank));
-    memset(target_embedding, 0, sizeof(target_embedding));
 }
 
 int embeddings_bank_add(const float *embedding)
 {
-    if (bank_count >= EMBEDDING_BANK_SIZE)
+    if (bank_count >= EMBEDDING_BANK_SIZE || enroll_identity < 0)
         return -1;
-    float norm = 0.f;
-    for (int i = 0; i < EMBEDDING_SIZE; i++)
-    {
-        norm += embedding[i] * embedding[i];
-    }
-    norm = sqrtf(norm);
-    if (norm == 0.f)
+#ifdef FACE_GALLERY_FLASH
+    if (gallery_store_add(&gallery_store, (uint16_t)enroll_identity, embedding) != GALLERY_STORE_OK)
         return -1;
-    for (int i = 0; i < EMBEDDING_SIZE; i++)
-    {
-        embedding_bank[bank_count][i] = embedding[i] / norm;
-    }
+#else
+    if (face_gallery_add(&face_gallery, (uint16_t)enroll_identity, embedding) < 0)
+        return -1;
+#endif
     bank_count++;
-    compute_target();
     return bank_count;
 }
 
+/**
+ * @brief Close the identity being enrolled and start the next one
+ * @return Identity now being enrolled, -1 if the current one has no template
+ *         or every identity is used
+ */
+int embeddings_bank_next_identity(void)
+{
+    if (bank_count == 0)
+        return -1;
+#ifdef FACE_GALLERY_FLASH
+    {
+        const int next = gallery_store_next_identity(&gallery_store);
+
+        if (next < 0)
+            return -1;
+        enroll_identity = next;
+    }
+#else
+    if (enroll_identity + 1 >= EMBEDDING_BANK_IDENTITIES)
+        return -1;
+    enroll_identity++;
+#endif
+    bank_count = 0;
+    return enroll_identity;
+}
+
 void embeddings_bank_reset(void)
 {
+#ifdef FACE_GALLERY_FLASH
+    /* Tombstones for every identity; their numbers are not reused */
+    (void)gallery_store_clear(&gallery_store);
+    enroll_identity = gallery_store_next_identity(&gallery_store);
+    bank_count = 0;
+#else
     embeddings_bank_init();
+#endif
 }
 
 int embeddings_bank_count(void)
@@ -99,3 +167,65 @@ int embeddings_bank_count(void)
     return bank_count;
 }
 
+int embeddings_bank_identity(void)
+{
+    return enroll_identity;
+}
+
+void embeddings_bank_search_begin(const float32_t *embedding)
+{
+    memcpy(search_query, embedding, sizeof(search_query));
+    search_begun = 1;
+#ifdef FACE_GALLERY_INDEX
+    index_searching = index_ready &&
+                      gallery_index_search_begin(&gallery_index, &index_search, search_query,
+                                                 GALLERY_INDEX_PROBES) == GALLERY_INDEX_OK;
+#endif
+}
+
+int embeddings_bank_search_step(uint32_t budget)
+{
+#ifdef FACE_GALLERY_INDEX
+    if (index_searching)
+        return gallery_index_search_step(&gallery_index, &index_search, budget);
+#else
+    (void)budget;
+#endif
+    return 0;
+}
+
+uint32_t embeddings_bank_search_end(face_gallery_match_t *pMatch, uint32_t k)
+{
+    uint32_t nb;
+
+    if (!search_begun)
+        return 0;
+#ifdef FACE_GALLERY_FLASH
+    nb = gallery_store_search(&gallery_store, search_query, pMatch, k);
+#else
+    nb = face_gallery_search_unit(&face_gallery, search_query, pMatch, k);
+#endif
+#ifdef FACE_GALLERY_INDEX
+    /* Merge in the indexed identities, numbered apart (checked at load) */
+    if (index_searching) {
+        uint32_t nb_index;
+
+        /* Whatever the steps did not get to */
+        (void)gallery_index_search_step(&gallery_index, &index_search, UINT32_MAX);
+        nb_index = gallery_index_search_end(&gallery_index, &index_search, index_match,
+                                            (k < GALLERY_INDEX_SHORTLIST) ? k : GALLERY_INDEX_SHORTLIST);
+
+        for (uint32_t i = 0; i < nb_index; i++)
+            face_gallery_offer(pMatch, &nb, k, index_match[i].identity, index_match[i].score);
+        index_searching = 0;
+    }
+#endif
+    search_begun = 0;
+    return nb;
+}
+
+uint32_t embeddings_bank_search(const float32_t *embedding, face_gallery_match_t *pMatch, uint32_t k)
+{
+    embeddings_bank_search_begin(embedding);
+    return embeddings_bank_search_end(pMatch, k);
+}
@@ -0,0 +1,116 @@
+/**
+ ******************************************************************************
+ * @file    trace_log.c
+ * @author  PeleAB
+ * @brief   Deferred binary trace log (message ID + raw arguments ring buffer)
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2023 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "trace_log.h"
+#include "pipeline_profiler.h"
+
+#if (TRACE_LOG_RING_WORDS & (TRACE_LOG_RING_WORDS - 1)) != 0
+#error "TRACE_LOG_RING_WORDS must be a power of two"
+#endif
+
+/* ========================================================================= */
+/* PRIVATE DATA                                                              */
+/* ========================================================================= */
+/* Single producer (trace_log_write) and single consumer (trace_log_drain).  */
+/* Indices are free-running word counts; each side only writes its own.     */
+
+#define RING_MASK                           (TRACE_LOG_RING_WORDS - 1U)
+
+static uint32_t ring[TRACE_LOG_RING_WORDS];  /**< Record storage */
+static uint32_t ring_head;                   /**< Next word to write (producer) */
+static uint32_t ring_tail;                   /**< Next word to read (consumer) */
+static volatile uint32_t dropped;            /**< Records lost to a full ring */
+
+/* ========================================================================= */
+/* IMPLEMENTATION FUNCTIONS                                                  */
+/* ========================================================================= */
+
+void trace_log_init(void)
+{
+    __atomic_store_n(&ring_head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring_tail, 0, __ATOMIC_RELAXED);
+    dropped = 0;
+
+    TLOG_EMIT(TLOG_LEVEL_INFO, TRACE_MSG_CLOCK, profiler_tick_rate());
+}
+
+void trace_log_write(uint32_t level, uint32_t id, uint32_t nargs, const uint32_t *args)
+{
+    uint32_t head = ring_head;
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    uint32_t need;
+
+    if (nargs > TRACE_LOG_MAX_ARGS) {
+        nargs = TRACE_LOG_MAX_ARGS;
+    }
+    need = TRACE_LOG_HEADER_WORDS + nargs;
+
+    if (TRACE_LOG_RING_WORDS - (head - tail) < need) {
+        dropped++;
+        return;
+    }
+
+    ring[head & RING_MASK] = TRACE_LOG_HEADER(level, nargs, id);
+    ring[(head + 1U) & RING_MASK] = profiler_now();
+    for (uint32_t i = 0; i < nargs; i++) {
+        ring[(head + TRACE_LOG_HEADER_WORDS + i) & RING_MASK] = args[i];
+    }
+
+    /* Publish the record only once it is complete */
+    __atomic_store_n(&ring_head, head + need, __ATOMIC_RELEASE);
+}
+
+uint32_t trace_log_drain(uint8_t *dst, uint32_t max_bytes)
+{
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring_tail;
+    uint32_t written = 0;
+
+    while (tail != head) {
+        uint32_t words = TRACE_LOG_HEADER_WORDS + TRACE_LOG_HEADER_NARGS(ring[tail & RING_MASK]);
+
+        if (written + words * 4U > max_bytes) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < words; i++) {
+            uint32_t w = ring[(tail + i) & RING_MASK];
+            dst[written++] = (uint8_t)(w & 0xFFU);
+            dst[written++] = (uint8_t)((w >> 8) & 0xFFU);
+            dst[written++] = (uint8_t)((w >> 16) & 0xFFU);
+            dst[written++] = (uint8_t)((w >> 24) & 0xFFU);
+        }
+        tail += words;
+    }
+
+    __atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+    return written;
+}
+
+uint32_t trace_log_pending(void)
+{
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+
+    return (head - tail) * 4U;
+}
+
+uint32_t trace_log_dropped(void)
+{
+    return dropped;
+}
@@ -197,6 +197,12 @@ create_neural_art_config() {
     
     # Get model configuration from main config
     local options=$(python3 -c "import json; config=json.load(open('$CONFIG_FILE')); print(config['models']['$model_type']['stedgeai_options'])")
+    local user_inputs=$(python3 -c "import json; config=json.load(open('$CONFIG_FILE')); print(str(config['models']['$model_type'].get('user_allocated_inputs', False)).lower())")
+    
+    # Inputs left to the application (bound at run time, e.g. to a camera buffer)
+    if [ "$user_inputs" = "true" ]; then
+        options="$options --no-inputs-allocation"
+    fi
     
     cat > "$config_file" << EOF
 {
@@ -230,6 +236,7 @@ convert_model() {
     local output_name=$(python3 -c "import json; config=json.load(open('$CONFIG_FILE')); print(config['models']['$model_type']['name'])")
     local target=$(python3 -c "import json; config=json.load(open('$CONFIG_FILE')); print(config['models']['$model_type']['target'])")
     local input_data_type=$(python3 -c "import json; config=json.load(open('$CONFIG_FILE')); print(config['models']['$model_type']['input_data_type'])")
+    local input_layout=$(python3 -c "import json; config=json.load(open('$CONFIG_FILE')); print(config['models']['$model_type'].get('input_layout', ''))")
     
     print_status "Converting $model_type model: $(basename "$model_file")"
     print_status "Output directory: $output_dir"
@@ -247,6 +254,11 @@ convert_model() {
         "--output" "$output_dir"
     )
     
+    # chlast keeps the camera's HWC layout instead of transposing on the NPU
+    if [ -n "$input_layout" ]; then
+        cmd+=("--inputs-ch-position" "$input_layout")
+    fi
+    
     print_status "Running: ${cmd[*]}"
     
     # Run STM32EdgeAI and capture output and exit code